@@ -123,6 +123,25 @@ GSignondSecurityContext *
 gsignond_access_control_manager_security_context_of_keychain (
                             GSignondAccessControlManager *self);
 
+gboolean
+gsignond_access_control_manager_lookup_identity_decision (
+                            GSignondAccessControlManager *self,
+                            const GSignondSecurityContext *peer_ctx,
+                            guint32 identity_id,
+                            guint acl_generation,
+                            gboolean *allowed);
+
+void
+gsignond_access_control_manager_cache_identity_decision (
+                            GSignondAccessControlManager *self,
+                            const GSignondSecurityContext *peer_ctx,
+                            guint32 identity_id,
+                            guint acl_generation,
+                            gboolean allowed);
+
+void
+gsignond_access_control_manager_clear_decision_cache (
+                            GSignondAccessControlManager *self);
 
 G_END_DECLS
 
@@ -89,6 +89,20 @@
 #define GSIGNOND_CONFIG_PLUGIN_TIMEOUT          GSIGNOND_CONFIG_GENERAL \
                                                 "/PluginTimeout"
 
+/**
+ * GSIGNOND_CONFIG_PLUGIN_TIMEOUT_MAX:
+ *
+ * Upper bound in seconds for adapted plugin timeouts. When it is larger than
+ * #GSIGNOND_CONFIG_PLUGIN_TIMEOUT, the timeout of each plugin type is
+ * stretched up to this value to cover the usual idle time between its
+ * requests, and plugins that are used regularly but less often than that are
+ * started again shortly before their next use is expected.
+ *
+ * Default value: 0, plugin timeouts are not adapted.
+ */
+#define GSIGNOND_CONFIG_PLUGIN_TIMEOUT_MAX      GSIGNOND_CONFIG_GENERAL \
+                                                "/PluginTimeoutMax"
+
 /**
  * GSIGNOND_CONFIG_GENERAL_KEYCHAIN_SYSCTX:
  *
@@ -101,4 +115,132 @@
 #define GSIGNOND_CONFIG_GENERAL_KEYCHAIN_SYSCTX GSIGNOND_CONFIG_GENERAL \
                                                 "/KeychainSystemContext"
 
+/**
+ * GSIGNOND_CONFIG_GENERAL_ACL_CACHE_SIZE:
+ *
+ * Maximum number of access control decisions remembered by
+ * #GSignondAccessControlManager (see
+ * gsignond_access_control_manager_cache_identity_decision()). Setting it to 0
+ * disables the cache, so that every access check is evaluated against the
+ * identity's access control list.
+ *
+ * Default value: 256.
+ */
+#define GSIGNOND_CONFIG_GENERAL_ACL_CACHE_SIZE  GSIGNOND_CONFIG_GENERAL \
+                                                "/AccessControlCacheSize"
+
+/**
+ * GSIGNOND_CONFIG_GENERAL_PLUGIN_CACHE:
+ *
+ * Path of the file where the types and mechanisms of available plugins are
+ * cached between daemon runs. Cached entries are reused as long as the
+ * plugin loader and plugin files are unchanged. Setting it to an empty value
+ * disables the cache.
+ *
+ * Default value: #GSIGNOND_CONFIG_GENERAL_STORAGE_PATH +
+ * "/gsignond-cache/plugins.cache".
+ */
+#define GSIGNOND_CONFIG_GENERAL_PLUGIN_CACHE    GSIGNOND_CONFIG_GENERAL \
+                                                "/PluginCache"
+
+/**
+ * GSIGNOND_CONFIG_GENERAL_PLUGIN_USAGE_CACHE:
+ *
+ * Path of the file where the request history of plugin types is kept
+ * between daemon runs, so that adapted plugin timeouts (see
+ * #GSIGNOND_CONFIG_PLUGIN_TIMEOUT_MAX) survive a restart. Setting it to an
+ * empty value disables the file.
+ *
+ * Default value: #GSIGNOND_CONFIG_GENERAL_STORAGE_PATH +
+ * "/gsignond-cache/plugin-usage.cache".
+ */
+#define GSIGNOND_CONFIG_GENERAL_PLUGIN_USAGE_CACHE GSIGNOND_CONFIG_GENERAL \
+                                                "/PluginUsageCache"
+
+/**
+ * GSIGNOND_CONFIG_GENERAL_PLUGIN_WORKERS:
+ *
+ * Maximum number of sessions of a single authentication method that are
+ * served concurrently. Additional plugin workers are started when requests
+ * are queued and stopped again once the queue has drained. Workers share one
+ * plugin process when its loader multiplexes sessions, otherwise each of them
+ * runs its own process. Setting it to 1 serializes all sessions of a method.
+ *
+ * Default value: 4.
+ */
+#define GSIGNOND_CONFIG_GENERAL_PLUGIN_WORKERS  GSIGNOND_CONFIG_GENERAL \
+                                                "/PluginWorkers"
+
+/**
+ * GSIGNOND_CONFIG_GENERAL_IN_PROCESS_PLUGINS:
+ *
+ * Semicolon-separated list of trusted GLib plugins that are loaded into the
+ * daemon instead of being run in a gsignond-plugind process. This avoids the
+ * process start-up and the IPC round trips for plugins that do little work.
+ * Plugins provided by other plugin loaders always run in their own
+ * processes. Setting it to an empty value runs all plugins out of process.
+ *
+ * Default value: "password;digest".
+ */
+#define GSIGNOND_CONFIG_GENERAL_IN_PROCESS_PLUGINS GSIGNOND_CONFIG_GENERAL \
+                                                "/InProcessPlugins"
+
+/**
+ * GSIGNOND_CONFIG_GENERAL_PLUGIN_STANDBY:
+ *
+ * Number of GLib plugin loader processes that are kept running before they
+ * are needed. A process in standby is connected to the daemon already and
+ * only has to load the plugin when a session starts, and it is replaced in
+ * the background once it is taken. Setting it to 0 starts a new process for
+ * every plugin.
+ *
+ * Default value: 1.
+ */
+#define GSIGNOND_CONFIG_GENERAL_PLUGIN_STANDBY  GSIGNOND_CONFIG_GENERAL \
+                                                "/PluginStandby"
+
+/**
+ * GSIGNOND_CONFIG_GENERAL_PLUGIN_ZYGOTE:
+ *
+ * Whether GLib plugin loader processes are forked from one long-lived
+ * gsignond-plugind zygote that has loaded the plugins already, instead of
+ * being started from the binary. Forked processes start faster and share
+ * memory with the zygote. Requires Linux child subreaper support. Set to 1
+ * to enable.
+ *
+ * Default value: 0.
+ */
+#define GSIGNOND_CONFIG_GENERAL_PLUGIN_ZYGOTE   GSIGNOND_CONFIG_GENERAL \
+                                                "/PluginZygote"
+
+/**
+ * GSIGNOND_CONFIG_GENERAL_SHARED_PLUGINS:
+ *
+ * Semicolon-separated list of trusted GLib plugins that share one
+ * gsignond-plugind process, each exported on an object of its own, instead
+ * of running a process per plugin. This saves memory when several plugins
+ * are in use, at the cost of isolation between them. Plugins provided by
+ * other plugin loaders always run in their own processes.
+ *
+ * Default value: "".
+ */
+#define GSIGNOND_CONFIG_GENERAL_SHARED_PLUGINS  GSIGNOND_CONFIG_GENERAL \
+                                                "/SharedPlugins"
+
+/**
+ * GSIGNOND_CONFIG_GENERAL_FRAMED_LOADERS:
+ *
+ * Semicolon-separated list of plugin loader file names, such as
+ * "gsignond-plugind", that are talked to with length-prefixed binary frames
+ * instead of D-Bus. This saves the D-Bus marshalling overhead on each
+ * request, but each plugin process serves a single session then, and
+ * plugins of those loaders are not shared (see
+ * #GSIGNOND_CONFIG_GENERAL_SHARED_PLUGINS). Only loaders that implement the
+ * <systemitem>--framed</systemitem> command line option may be listed.
+ *
+ * Default value: "".
+ */
+#define GSIGNOND_CONFIG_GENERAL_FRAMED_LOADERS  GSIGNOND_CONFIG_GENERAL \
+                                                "/FramedPluginLoaders"
+
 #endif /* __GSIGNOND_GENERAL_CONFIG_H_ */
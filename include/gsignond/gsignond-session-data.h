@@ -49,6 +49,12 @@ typedef enum {
     GSIGNOND_UI_POLICY_VALIDATION
 } GSignondUiPolicy;
 
+typedef enum {
+    GSIGNOND_PROCESS_PRIORITY_BACKGROUND = 0,
+    GSIGNOND_PROCESS_PRIORITY_NORMAL,
+    GSIGNOND_PROCESS_PRIORITY_INTERACTIVE
+} GSignondProcessPriority;
+
 
 const gchar *
 gsignond_session_data_get_username (GSignondSessionData *data);
@@ -123,6 +129,38 @@ void
 gsignond_session_data_set_window_id (GSignondSessionData *data,
                                      guint32 window_id);
 
+gboolean
+gsignond_session_data_get_process_timeout (GSignondSessionData *data,
+                                           guint32 *process_timeout);
+
+void
+gsignond_session_data_set_process_timeout (GSignondSessionData *data,
+                                           guint32 process_timeout);
+
+gboolean
+gsignond_session_data_get_process_priority (GSignondSessionData *data,
+                                            GSignondProcessPriority *priority);
+
+void
+gsignond_session_data_set_process_priority (GSignondSessionData *data,
+                                            GSignondProcessPriority priority);
+
+gboolean
+gsignond_session_data_get_cache_ttl (GSignondSessionData *data,
+                                     guint32 *cache_ttl);
+
+void
+gsignond_session_data_set_cache_ttl (GSignondSessionData *data,
+                                     guint32 cache_ttl);
+
+gboolean
+gsignond_session_data_get_token_expiry (GSignondSessionData *data,
+                                        gint64 *expiry);
+
+void
+gsignond_session_data_set_token_expiry (GSignondSessionData *data,
+                                        gint64 expiry);
+
 
 G_END_DECLS
 
@@ -36,9 +36,20 @@ gsignond_wipe_file (const gchar *filename);
 gboolean
 gsignond_wipe_directory (const gchar *dirname);
 
+/**
+ * GSIGNOND_NONCE_LENGTH:
+ *
+ * Length of the nonces generated by gsignond_generate_nonce(), without the
+ * terminating nul.
+ */
+#define GSIGNOND_NONCE_LENGTH 40
+
 gchar *
 gsignond_generate_nonce ();
 
+gboolean
+gsignond_generate_nonce_into (gchar *nonce);
+
 GVariant *
 gsignond_sequence_to_variant (GSequence *seq);
 
@@ -57,6 +68,18 @@ gsignond_copy_array_to_sequence (const gchar **items);
 gboolean
 gsignond_is_host_in_domain(const gchar *host, const gchar *domain);
 
+const gchar *
+gsignond_str_intern (const gchar *str);
+
+void
+gsignond_str_unintern (const gchar *str);
+
+GSequence *
+gsignond_interned_sequence_new (void);
+
+void
+gsignond_interned_sequence_insert (GSequence *seq, const gchar *str);
+
 G_END_DECLS
 
 #endif  /* _SGINOND_UTILS_H_ */
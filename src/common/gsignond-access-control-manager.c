@@ -34,6 +34,7 @@
 
 #include "gsignond/gsignond-log.h"
 #include "gsignond/gsignond-access-control-manager.h"
+#include "gsignond/gsignond-utils.h"
 
 /**
  * SECTION:gsignond-access-control-manager
@@ -63,8 +64,21 @@
 #   define GSIGNOND_BUS_TYPE G_BUS_TYPE_SESSION
 #endif
 
+#define GSIGNOND_ACL_CACHE_DEFAULT_SIZE 256
+
+/* the contexts of cached keys are interned, as many keys share them; peer
+ * contexts are looked up by value */
+typedef struct {
+    const gchar *sys_ctx;
+    const gchar *app_ctx;
+    guint32 identity_id;
+    guint acl_generation;
+} _DecisionKey;
+
 struct _GSignondAccessControlManagerPrivate
 {
+    GHashTable *decisions; /* (_DecisionKey, allowed) table */
+    gint cache_size;
 };
 
 enum
@@ -79,6 +93,59 @@ static GParamSpec *properties[N_PROPERTIES] = { NULL, };
 G_DEFINE_TYPE (GSignondAccessControlManager, gsignond_access_control_manager,
                G_TYPE_OBJECT);
 
+static guint
+_decision_key_hash (gconstpointer key)
+{
+    const _DecisionKey *dkey = (const _DecisionKey *) key;
+
+    return (g_str_hash (dkey->sys_ctx) * 31 + g_str_hash (dkey->app_ctx)) ^
+           (dkey->identity_id * 2654435761u) ^ dkey->acl_generation;
+}
+
+static gboolean
+_decision_key_equal (gconstpointer a, gconstpointer b)
+{
+    const _DecisionKey *key1 = (const _DecisionKey *) a;
+    const _DecisionKey *key2 = (const _DecisionKey *) b;
+
+    return key1->identity_id == key2->identity_id &&
+           key1->acl_generation == key2->acl_generation &&
+           (key1->sys_ctx == key2->sys_ctx ||
+            g_strcmp0 (key1->sys_ctx, key2->sys_ctx) == 0) &&
+           (key1->app_ctx == key2->app_ctx ||
+            g_strcmp0 (key1->app_ctx, key2->app_ctx) == 0);
+}
+
+static void
+_decision_key_free (gpointer key)
+{
+    _DecisionKey *dkey = (_DecisionKey *) key;
+
+    gsignond_str_unintern (dkey->sys_ctx);
+    gsignond_str_unintern (dkey->app_ctx);
+    g_slice_free (_DecisionKey, dkey);
+}
+
+static gint
+_get_cache_size (GSignondAccessControlManager *self)
+{
+    GSignondAccessControlManagerPrivate *priv = self->priv;
+
+    if (priv->cache_size < 0) {
+        if (self->config &&
+            gsignond_config_get_string (self->config,
+                                    GSIGNOND_CONFIG_GENERAL_ACL_CACHE_SIZE))
+            priv->cache_size = gsignond_config_get_integer (self->config,
+                                    GSIGNOND_CONFIG_GENERAL_ACL_CACHE_SIZE);
+        else
+            priv->cache_size = GSIGNOND_ACL_CACHE_DEFAULT_SIZE;
+        if (priv->cache_size < 0)
+            priv->cache_size = 0;
+    }
+
+    return priv->cache_size;
+}
+
 static void
 _set_property (GObject *object, guint prop_id, const GValue *value,
                GParamSpec *pspec)
@@ -122,6 +189,11 @@ _dispose (GObject *object)
         self->config = NULL;
     }
 
+    if (self->priv->decisions) {
+        g_hash_table_unref (self->priv->decisions);
+        self->priv->decisions = NULL;
+    }
+
     G_OBJECT_CLASS (gsignond_access_control_manager_parent_class)->dispose (object);
 }
 
@@ -328,8 +400,8 @@ gsignond_access_control_manager_class_init (
                                                    G_PARAM_STATIC_STRINGS);
     g_object_class_install_properties (base, N_PROPERTIES, properties);
 
-    /*g_type_class_add_private (klass,
-                              sizeof(GSignondAccessControlManagerPrivate));*/
+    g_type_class_add_private (klass,
+                              sizeof(GSignondAccessControlManagerPrivate));
 
     klass->security_context_of_peer = _security_context_of_peer;
     klass->peer_is_allowed_to_use_identity = _peer_is_allowed_to_use_identity;
@@ -341,9 +413,14 @@ gsignond_access_control_manager_class_init (
 static void
 gsignond_access_control_manager_init (GSignondAccessControlManager *self)
 {
-    /*self->priv = GSIGNOND_ACCESS_CONTROL_MANAGER_GET_PRIVATE (self);*/
+    self->priv = GSIGNOND_ACCESS_CONTROL_MANAGER_GET_PRIVATE (self);
 
     self->config = NULL;
+    self->priv->decisions = g_hash_table_new_full (_decision_key_hash,
+                                                   _decision_key_equal,
+                                                   _decision_key_free,
+                                                   NULL);
+    self->priv->cache_size = -1;
 }
 
 /**
@@ -384,6 +461,9 @@ gsignond_access_control_manager_security_context_of_peer (
  * The default implementation goes over items in @identity_acl, using 
  * gsignond_security_context_check() to check them against @peer_ctx.
  *
+ * The result of this check is not cached; see
+ * gsignond_access_control_manager_lookup_identity_decision() for that.
+ *
  * Returns: access is allowed?
  */
 gboolean
@@ -472,3 +552,124 @@ gsignond_access_control_manager_security_context_of_keychain (
         security_context_of_keychain (self);
 }
 
+
+/**
+ * gsignond_access_control_manager_lookup_identity_decision:
+ * @self: object instance.
+ * @peer_ctx: security context of the peer connection.
+ * @identity_id: id of the identity.
+ * @acl_generation: generation of the access control list and the owner of the
+ * identity; it changes every time either of them is modified.
+ * @allowed: (out): location for the cached decision.
+ *
+ * Looks up a decision previously stored with
+ * gsignond_access_control_manager_cache_identity_decision(), so that repeated
+ * checks of the same peer against the same identity do not have to go through
+ * gsignond_access_control_manager_peer_is_allowed_to_use_identity() again.
+ *
+ * A changed @acl_generation never matches an older entry, so decisions are
+ * invalidated as soon as the access control list or the owner changes.
+ *
+ * Returns: TRUE if a decision was found and stored in @allowed, FALSE otherwise.
+ */
+gboolean
+gsignond_access_control_manager_lookup_identity_decision (
+                            GSignondAccessControlManager *self,
+                            const GSignondSecurityContext *peer_ctx,
+                            guint32 identity_id,
+                            guint acl_generation,
+                            gboolean *allowed)
+{
+    _DecisionKey key;
+    gpointer value = NULL;
+
+    g_return_val_if_fail (self && GSIGNOND_IS_ACCESS_CONTROL_MANAGER (self),
+                          FALSE);
+    g_return_val_if_fail (peer_ctx != NULL, FALSE);
+
+    if (!acl_generation || !self->priv->decisions)
+        return FALSE;
+
+    key.sys_ctx = gsignond_security_context_get_system_context (peer_ctx);
+    key.app_ctx = gsignond_security_context_get_application_context (peer_ctx);
+    key.identity_id = identity_id;
+    key.acl_generation = acl_generation;
+
+    if (!g_hash_table_lookup_extended (self->priv->decisions, &key,
+                                       NULL, &value))
+        return FALSE;
+
+    if (allowed) *allowed = GPOINTER_TO_INT (value);
+
+    return TRUE;
+}
+
+/**
+ * gsignond_access_control_manager_cache_identity_decision:
+ * @self: object instance.
+ * @peer_ctx: security context of the peer connection.
+ * @identity_id: id of the identity.
+ * @acl_generation: generation of the access control list and the owner of the
+ * identity, 0 if the decision must not be cached.
+ * @allowed: result of the access check.
+ *
+ * Remembers the result of an access check of @peer_ctx against the identity.
+ * The number of remembered decisions is limited by
+ * #GSIGNOND_CONFIG_GENERAL_ACL_CACHE_SIZE; when the limit is reached the cache
+ * is emptied.
+ */
+void
+gsignond_access_control_manager_cache_identity_decision (
+                            GSignondAccessControlManager *self,
+                            const GSignondSecurityContext *peer_ctx,
+                            guint32 identity_id,
+                            guint acl_generation,
+                            gboolean allowed)
+{
+    _DecisionKey *key;
+    gint cache_size;
+
+    g_return_if_fail (self && GSIGNOND_IS_ACCESS_CONTROL_MANAGER (self));
+    g_return_if_fail (peer_ctx != NULL);
+
+    if (!acl_generation || !self->priv->decisions)
+        return;
+
+    cache_size = _get_cache_size (self);
+    if (cache_size == 0)
+        return;
+
+    if (g_hash_table_size (self->priv->decisions) >= (guint) cache_size) {
+        DBG ("ACL decision cache full, flushing");
+        g_hash_table_remove_all (self->priv->decisions);
+    }
+
+    key = g_slice_new0 (_DecisionKey);
+    key->sys_ctx = gsignond_str_intern (
+                gsignond_security_context_get_system_context (peer_ctx));
+    key->app_ctx = gsignond_str_intern (
+                gsignond_security_context_get_application_context (peer_ctx));
+    key->identity_id = identity_id;
+    key->acl_generation = acl_generation;
+
+    g_hash_table_replace (self->priv->decisions, key,
+                          GINT_TO_POINTER (allowed ? TRUE : FALSE));
+}
+
+/**
+ * gsignond_access_control_manager_clear_decision_cache:
+ * @self: object instance.
+ *
+ * Forgets all decisions remembered with
+ * gsignond_access_control_manager_cache_identity_decision(). Extensions should
+ * call this when their external access policy changes.
+ */
+void
+gsignond_access_control_manager_clear_decision_cache (
+                            GSignondAccessControlManager *self)
+{
+    g_return_if_fail (self && GSIGNOND_IS_ACCESS_CONTROL_MANAGER (self));
+
+    if (self->priv->decisions)
+        g_hash_table_remove_all (self->priv->decisions);
+}
@@ -86,7 +86,7 @@ _get_property (GObject *object,
 
     switch (property_id) {
         case PROP_TIMEOUT:
-            g_value_set_int (value, self->priv->timeout);
+            g_value_set_uint (value, self->priv->timeout);
             break;
         case PROP_AUTO_DISPOSE:
             g_value_set_boolean (value, gsignond_disposable_get_auto_dispose(self));
@@ -210,6 +210,11 @@ _update_timer (GSignondDisposable *self)
                   self->priv->keep_obj_counter, 
                   self->priv->timeout);
     if (g_atomic_int_get(&self->priv->keep_obj_counter) == 0) {
+        /* restart a running timer, e.g. when the timeout changes */
+        if (self->priv->timer_id) {
+            g_source_remove (self->priv->timer_id);
+            self->priv->timer_id = 0;
+        }
         if (self->priv->timeout) {
             DBG("Setting object timeout to %d", self->priv->timeout);
             self->priv->timer_id = g_timeout_add_seconds (self->priv->timeout,
@@ -0,0 +1,909 @@
+/* vi: set et sw=4 ts=4 cino=t0,(0: */
+/* -*- Mode: C; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This file is part of gsignond
+ *
+ * Copyright (C) 2014 Intel Corporation.
+ *
+ * Contact: Imran Zaman <imran.zaman@intel.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ */
+
+#include "config.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <glib-unix.h>
+
+#include "gsignond/gsignond-error.h"
+#include "gsignond/gsignond-log.h"
+#include "gsignond-frame-channel.h"
+
+/**
+ * SECTION:gsignond-frame-channel
+ * @short_description: framed message channel between gsignond and plugin
+ * loaders
+ *
+ * #GSignondFrameChannel exchanges messages over a connected unix stream
+ * socket, as an alternative to a D-Bus peer connection. Each frame is a
+ * fixed header followed by a serialized #GVariant:
+ * <programlisting>
+ * guint32 length of the payload
+ * guint32 request id
+ * guint32 opcode (#GSignondFrameOpcode)
+ * payload: serialized variant of type "v", or nothing
+ * </programlisting>
+ * The header is in host byte order, as both ends run on the same host.
+ *
+ * Payloads of at least gsignond_frame_channel_set_fd_threshold() bytes are
+ * not written to the socket. They are stored in a sealed memfd instead,
+ * which is passed along with the header and has the
+ * GSIGNOND_FRAME_FLAG_FD bit set in the opcode. The receiver maps it
+ * read-only and builds the payload on the mapping, so large session data
+ * is not copied through the socket.
+ *
+ * Frames sent while the main loop is busy are written in one batch. Frames
+ * received are reported with the #GSignondFrameChannel::frame signal once
+ * gsignond_frame_channel_start() is called.
+ */
+
+#define GSIGNOND_FRAME_CHANNEL_GET_PRIVATE(obj) \
+                                          (G_TYPE_INSTANCE_GET_PRIVATE ((obj),\
+                                           GSIGNOND_TYPE_FRAME_CHANNEL, \
+                                           GSignondFrameChannelPrivate))
+
+/* inline frames are small, a larger one means the stream is corrupted */
+#define GSIGNOND_FRAME_MAX_PAYLOAD (16 * 1024 * 1024)
+#define GSIGNOND_FRAME_MAX_FD_PAYLOAD (256 * 1024 * 1024)
+#define GSIGNOND_FRAME_FD_THRESHOLD (64 * 1024)
+#define GSIGNOND_FRAME_READ_SIZE 4096
+
+/* the payload is in the descriptor passed with the header */
+#define GSIGNOND_FRAME_FLAG_FD 0x80000000
+
+#if defined (HAVE_MEMFD_CREATE) && defined (F_ADD_SEALS)
+#define GSIGNOND_FRAME_USE_MEMFD 1
+#endif
+
+typedef struct {
+    guint32 length;
+    guint32 id;
+    guint32 opcode;
+} _FrameHeader;
+
+/* descriptor to pass with the byte at offset of the output queue */
+typedef struct {
+    gsize offset;
+    gint fd;
+} _OutFd;
+
+typedef struct {
+    gpointer addr;
+    gsize length;
+} _Mapping;
+
+struct _GSignondFrameChannelPrivate
+{
+    gint fd;
+    gboolean started;
+    gboolean closed;
+    gsize fd_threshold;
+    guint in_id;
+    guint out_id;
+    guint flush_id;
+
+    /* received bytes in_buf[in_start..in_len) not dispatched yet, and the
+     * descriptors received with them */
+    guint8 *in_buf;
+    gsize in_size;
+    gsize in_start;
+    gsize in_len;
+    GQueue *in_fds;
+
+    /* frames queued for writing, out_queue[out_written..] is pending */
+    GByteArray *out_queue;
+    gsize out_written;
+    GQueue *out_fds;
+};
+
+enum {
+    SIG_FRAME,
+    SIG_CLOSED,
+    SIG_MAX
+};
+
+static guint signals[SIG_MAX] = { 0 };
+
+G_DEFINE_TYPE (GSignondFrameChannel, gsignond_frame_channel, G_TYPE_OBJECT);
+
+static void
+_gsignond_frame_channel_dispose (GObject *gobject)
+{
+    GSignondFrameChannel *self = GSIGNOND_FRAME_CHANNEL (gobject);
+
+    gsignond_frame_channel_close (self);
+
+    if (self->priv->fd >= 0) {
+        close (self->priv->fd);
+        self->priv->fd = -1;
+    }
+
+    G_OBJECT_CLASS (gsignond_frame_channel_parent_class)->dispose (gobject);
+}
+
+static void
+_gsignond_frame_channel_finalize (GObject *gobject)
+{
+    GSignondFrameChannel *self = GSIGNOND_FRAME_CHANNEL (gobject);
+
+    g_free (self->priv->in_buf);
+    g_queue_free (self->priv->in_fds);
+    g_byte_array_unref (self->priv->out_queue);
+    g_queue_free (self->priv->out_fds);
+
+    G_OBJECT_CLASS (gsignond_frame_channel_parent_class)->finalize (gobject);
+}
+
+static void
+gsignond_frame_channel_class_init (GSignondFrameChannelClass *klass)
+{
+    GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+
+    gobject_class->dispose = _gsignond_frame_channel_dispose;
+    gobject_class->finalize = _gsignond_frame_channel_finalize;
+
+    g_type_class_add_private (klass, sizeof (GSignondFrameChannelPrivate));
+
+    /**
+     * GSignondFrameChannel::frame:
+     * @channel: the channel
+     * @id: request id of the frame
+     * @opcode: a #GSignondFrameOpcode
+     * @payload: (allow-none): the payload, NULL if the frame has none
+     *
+     * Emitted for each received frame.
+     */
+    signals[SIG_FRAME] = g_signal_new ("frame",
+            GSIGNOND_TYPE_FRAME_CHANNEL, G_SIGNAL_RUN_LAST, 0, NULL, NULL,
+            NULL, G_TYPE_NONE, 3, G_TYPE_UINT, G_TYPE_UINT, G_TYPE_VARIANT);
+
+    /**
+     * GSignondFrameChannel::closed:
+     * @channel: the channel
+     *
+     * Emitted when the peer closes the socket, or when the socket fails.
+     */
+    signals[SIG_CLOSED] = g_signal_new ("closed",
+            GSIGNOND_TYPE_FRAME_CHANNEL, G_SIGNAL_RUN_LAST, 0, NULL, NULL,
+            NULL, G_TYPE_NONE, 0);
+}
+
+static void
+gsignond_frame_channel_init (GSignondFrameChannel *self)
+{
+    self->priv = GSIGNOND_FRAME_CHANNEL_GET_PRIVATE (self);
+    self->priv->fd = -1;
+    self->priv->started = FALSE;
+    self->priv->closed = FALSE;
+    self->priv->fd_threshold = GSIGNOND_FRAME_FD_THRESHOLD;
+    self->priv->in_id = 0;
+    self->priv->out_id = 0;
+    self->priv->flush_id = 0;
+    self->priv->in_buf = NULL;
+    self->priv->in_size = 0;
+    self->priv->in_start = 0;
+    self->priv->in_len = 0;
+    self->priv->in_fds = g_queue_new ();
+    self->priv->out_queue = g_byte_array_new ();
+    self->priv->out_written = 0;
+    self->priv->out_fds = g_queue_new ();
+}
+
+/* the socket is unusable from now on */
+static void
+_fail (GSignondFrameChannel *self, const GError *error)
+{
+    if (self->priv->closed)
+        return;
+
+    if (error)
+        DBG ("frame channel (%p) failed: %s", self, error->message);
+    else
+        DBG ("frame channel (%p) closed by peer", self);
+    gsignond_frame_channel_close (self);
+    g_signal_emit (self, signals[SIG_CLOSED], 0);
+}
+
+static void
+_set_errno_error (GError **error, const gchar *what)
+{
+    g_set_error (error, GSIGNOND_ERROR,
+                 GSIGNOND_ERROR_INTERNAL_COMMUNICATION,
+                 "%s: %s", what, strerror (errno));
+}
+
+static GVariant *
+_decode_payload (GBytes *bytes, GError **error)
+{
+    GVariant *boxed, *payload;
+
+    boxed = g_variant_ref_sink (g_variant_new_from_bytes (
+            G_VARIANT_TYPE_VARIANT, bytes, FALSE));
+    if (!g_variant_is_normal_form (boxed)) {
+        g_set_error (error, GSIGNOND_ERROR,
+                     GSIGNOND_ERROR_INTERNAL_COMMUNICATION,
+                     "Malformed frame payload");
+        g_variant_unref (boxed);
+        return NULL;
+    }
+    payload = g_variant_get_variant (boxed);
+    g_variant_unref (boxed);
+
+    return payload;
+}
+
+#ifdef GSIGNOND_FRAME_USE_MEMFD
+
+static void
+_unmap (gpointer data)
+{
+    _Mapping *mapping = (_Mapping *) data;
+
+    munmap (mapping->addr, mapping->length);
+    g_slice_free (_Mapping, mapping);
+}
+
+/* maps the payload passed in a sealed memfd, the sender cannot change it
+ * while it is in use */
+static GVariant *
+_map_payload (gint fd, gsize length, GError **error)
+{
+    const gint required = F_SEAL_SHRINK | F_SEAL_WRITE;
+    gint seals = fcntl (fd, F_GET_SEALS);
+    struct stat st;
+    _Mapping *mapping;
+    GVariant *payload;
+    GBytes *bytes;
+
+    if (seals < 0 || (seals & required) != required) {
+        g_set_error (error, GSIGNOND_ERROR,
+                     GSIGNOND_ERROR_INTERNAL_COMMUNICATION,
+                     "Frame payload is not sealed");
+        return NULL;
+    }
+    if (fstat (fd, &st) != 0 || (gsize) st.st_size < length) {
+        g_set_error (error, GSIGNOND_ERROR,
+                     GSIGNOND_ERROR_INTERNAL_COMMUNICATION,
+                     "Frame payload is truncated");
+        return NULL;
+    }
+
+    mapping = g_slice_new (_Mapping);
+    mapping->length = length;
+    mapping->addr = mmap (NULL, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapping->addr == MAP_FAILED) {
+        _set_errno_error (error, "Failed to map frame payload");
+        g_slice_free (_Mapping, mapping);
+        return NULL;
+    }
+
+    bytes = g_bytes_new_with_free_func (mapping->addr, length, _unmap,
+                                        mapping);
+    payload = _decode_payload (bytes, error);
+    g_bytes_unref (bytes);
+
+    return payload;
+}
+
+/* returns a sealed memfd holding the serialized variant, or -1 */
+static gint
+_store_payload (GVariant *boxed, gsize length)
+{
+    gpointer addr;
+    gint fd;
+
+    fd = memfd_create ("gsignond-frame", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (fd < 0) {
+        DBG ("memfd_create failed: %s", strerror (errno));
+        return -1;
+    }
+
+    if (ftruncate (fd, length) != 0)
+        goto fail;
+    addr = mmap (NULL, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (addr == MAP_FAILED)
+        goto fail;
+    g_variant_store (boxed, addr);
+    munmap (addr, length);
+
+    if (fcntl (fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE |
+               F_SEAL_SEAL) != 0)
+        goto fail;
+
+    return fd;
+
+fail:
+    DBG ("failed to store frame payload: %s", strerror (errno));
+    close (fd);
+    return -1;
+}
+
+#else
+
+static GVariant *
+_map_payload (gint fd, gsize length, GError **error)
+{
+    g_set_error (error, GSIGNOND_ERROR,
+                 GSIGNOND_ERROR_INTERNAL_COMMUNICATION,
+                 "Frame payloads in descriptors are not supported");
+    return NULL;
+}
+
+static gint
+_store_payload (GVariant *boxed, gsize length)
+{
+    return -1;
+}
+
+#endif /* GSIGNOND_FRAME_USE_MEMFD */
+
+static void
+_close_fds (GQueue *fds)
+{
+    gpointer fd;
+
+    while ((fd = g_queue_pop_head (fds)) != NULL)
+        close (GPOINTER_TO_INT (fd) - 1);
+}
+
+/* takes the next complete frame out of the input buffer. Returns FALSE if
+ * there is none yet, or on error. */
+static gboolean
+_take_frame (
+        GSignondFrameChannel *self,
+        _FrameHeader *header,
+        GVariant **payload,
+        GError **error)
+{
+    GSignondFrameChannelPrivate *priv = self->priv;
+    gsize available = priv->in_len - priv->in_start;
+    gpointer fd;
+
+    *payload = NULL;
+    if (available < sizeof (_FrameHeader))
+        return FALSE;
+    memcpy (header, priv->in_buf + priv->in_start, sizeof (_FrameHeader));
+
+    if (header->opcode & GSIGNOND_FRAME_FLAG_FD) {
+        header->opcode &= ~GSIGNOND_FRAME_FLAG_FD;
+        priv->in_start += sizeof (_FrameHeader);
+        /* the descriptor comes with the first byte of the header */
+        fd = g_queue_pop_head (priv->in_fds);
+        if (!fd || header->length == 0 ||
+            header->length > GSIGNOND_FRAME_MAX_FD_PAYLOAD) {
+            g_set_error (error, GSIGNOND_ERROR,
+                         GSIGNOND_ERROR_INTERNAL_COMMUNICATION,
+                         "Invalid frame descriptor");
+            if (fd)
+                close (GPOINTER_TO_INT (fd) - 1);
+            return FALSE;
+        }
+        *payload = _map_payload (GPOINTER_TO_INT (fd) - 1, header->length,
+                                 error);
+        close (GPOINTER_TO_INT (fd) - 1);
+        return *payload != NULL;
+    }
+
+    if (header->length > GSIGNOND_FRAME_MAX_PAYLOAD) {
+        g_set_error (error, GSIGNOND_ERROR,
+                     GSIGNOND_ERROR_INTERNAL_COMMUNICATION,
+                     "Frame of %u bytes exceeds the limit", header->length);
+        return FALSE;
+    }
+    if (available < sizeof (_FrameHeader) + header->length)
+        return FALSE;
+
+    priv->in_start += sizeof (_FrameHeader);
+    if (header->length > 0) {
+        GBytes *bytes = g_bytes_new (priv->in_buf + priv->in_start,
+                                     header->length);
+        priv->in_start += header->length;
+        *payload = _decode_payload (bytes, error);
+        g_bytes_unref (bytes);
+        return *payload != NULL;
+    }
+    return TRUE;
+}
+
+/* reads what is available on the socket, with the descriptors passed
+ * along. Returns the number of bytes read, 0 once the peer closed the
+ * socket, or -1 with errno set, EMSGSIZE if descriptors were lost. */
+static gssize
+_receive (GSignondFrameChannel *self)
+{
+    GSignondFrameChannelPrivate *priv = self->priv;
+    struct msghdr msg;
+    struct iovec iov;
+    struct cmsghdr *cmsg;
+    union {
+        struct cmsghdr align;
+        gchar buf[CMSG_SPACE (16 * sizeof (gint))];
+    } control;
+    gssize n;
+
+    /* make room at the end of the buffer */
+    if (priv->in_start > 0) {
+        priv->in_len -= priv->in_start;
+        memmove (priv->in_buf, priv->in_buf + priv->in_start, priv->in_len);
+        priv->in_start = 0;
+    }
+    if (priv->in_size < priv->in_len + GSIGNOND_FRAME_READ_SIZE) {
+        priv->in_size = MAX (priv->in_len + GSIGNOND_FRAME_READ_SIZE,
+                             priv->in_size * 2);
+        priv->in_buf = g_realloc (priv->in_buf, priv->in_size);
+    }
+
+    memset (&msg, 0, sizeof (msg));
+    iov.iov_base = priv->in_buf + priv->in_len;
+    iov.iov_len = priv->in_size - priv->in_len;
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.buf;
+    msg.msg_controllen = sizeof (control.buf);
+
+    do {
+        n = recvmsg (priv->fd, &msg, MSG_CMSG_CLOEXEC | MSG_DONTWAIT);
+    } while (n < 0 && errno == EINTR);
+    if (n < 0)
+        return -1;
+
+    for (cmsg = CMSG_FIRSTHDR (&msg); cmsg; cmsg = CMSG_NXTHDR (&msg, cmsg)) {
+        if (cmsg->cmsg_level == SOL_SOCKET &&
+            cmsg->cmsg_type == SCM_RIGHTS) {
+            gsize n_fds = (cmsg->cmsg_len - CMSG_LEN (0)) / sizeof (gint);
+            gsize i;
+            for (i = 0; i < n_fds; i++) {
+                gint fd;
+                memcpy (&fd, CMSG_DATA (cmsg) + i * sizeof (gint),
+                        sizeof (gint));
+                if (msg.msg_flags & MSG_CTRUNC)
+                    close (fd);
+                else
+                    /* stored off by one, 0 is a valid descriptor */
+                    g_queue_push_tail (priv->in_fds, GINT_TO_POINTER (fd + 1));
+            }
+        }
+    }
+    /* descriptors were dropped, the rest no longer match their frames */
+    if (msg.msg_flags & MSG_CTRUNC) {
+        errno = EMSGSIZE;
+        return -1;
+    }
+    priv->in_len += n;
+
+    return n;
+}
+
+/* emits the complete frames in the input buffer */
+static void
+_dispatch_frames (GSignondFrameChannel *self)
+{
+    _FrameHeader header;
+    GVariant *payload = NULL;
+    GError *error = NULL;
+
+    while (!self->priv->closed &&
+           _take_frame (self, &header, &payload, &error)) {
+        g_signal_emit (self, signals[SIG_FRAME], 0, header.id, header.opcode,
+                       payload);
+        if (payload)
+            g_variant_unref (payload);
+    }
+    if (error) {
+        _fail (self, error);
+        g_error_free (error);
+    }
+}
+
+static gboolean
+_on_readable (gint fd, GIOCondition condition, gpointer user_data)
+{
+    GSignondFrameChannel *self = GSIGNOND_FRAME_CHANNEL (user_data);
+    gboolean keep;
+    gssize n;
+
+    g_object_ref (self);
+    n = _receive (self);
+    if (n == 0) {
+        _fail (self, NULL);
+    } else if (n < 0) {
+        if (errno != EAGAIN && errno != EWOULDBLOCK) {
+            GError *error = NULL;
+            _set_errno_error (&error, "Failed to read frames");
+            _fail (self, error);
+            g_error_free (error);
+        }
+    } else {
+        _dispatch_frames (self);
+    }
+    keep = !self->priv->closed;
+    g_object_unref (self);
+
+    return keep;
+}
+
+static gboolean _on_writable (gint fd, GIOCondition condition,
+                              gpointer user_data);
+
+/* writes the queued frames until the socket would block, each passed
+ * descriptor with the bytes it belongs to */
+static void
+_write_queue (GSignondFrameChannel *self)
+{
+    GSignondFrameChannelPrivate *priv = self->priv;
+    GByteArray *queue = priv->out_queue;
+
+    while (priv->out_written < queue->len) {
+        _OutFd *next = g_queue_peek_head (priv->out_fds);
+        _OutFd *after = g_queue_peek_nth (priv->out_fds, 1);
+        gsize end = queue->len;
+        gboolean with_fd = next && next->offset == priv->out_written;
+        struct msghdr msg;
+        struct iovec iov;
+        union {
+            struct cmsghdr align;
+            gchar buf[CMSG_SPACE (sizeof (gint))];
+        } control;
+        gssize n;
+
+        if (with_fd && after)
+            end = after->offset;
+        else if (!with_fd && next)
+            end = next->offset;
+
+        memset (&msg, 0, sizeof (msg));
+        iov.iov_base = queue->data + priv->out_written;
+        iov.iov_len = end - priv->out_written;
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        if (with_fd) {
+            struct cmsghdr *cmsg;
+            memset (&control, 0, sizeof (control));
+            msg.msg_control = control.buf;
+            msg.msg_controllen = sizeof (control.buf);
+            cmsg = CMSG_FIRSTHDR (&msg);
+            cmsg->cmsg_level = SOL_SOCKET;
+            cmsg->cmsg_type = SCM_RIGHTS;
+            cmsg->cmsg_len = CMSG_LEN (sizeof (gint));
+            memcpy (CMSG_DATA (cmsg), &next->fd, sizeof (gint));
+        }
+
+        do {
+            n = sendmsg (priv->fd, &msg, MSG_NOSIGNAL | MSG_DONTWAIT);
+        } while (n < 0 && errno == EINTR);
+        if (n < 0) {
+            GError *error = NULL;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                if (!priv->out_id)
+                    priv->out_id = g_unix_fd_add (priv->fd, G_IO_OUT,
+                                                  _on_writable, self);
+                return;
+            }
+            _set_errno_error (&error, "Failed to write frames");
+            _fail (self, error);
+            g_error_free (error);
+            return;
+        }
+
+        /* the descriptor went with the first byte */
+        if (with_fd) {
+            g_queue_pop_head (priv->out_fds);
+            close (next->fd);
+            g_slice_free (_OutFd, next);
+        }
+        priv->out_written += n;
+    }
+
+    g_byte_array_set_size (queue, 0);
+    priv->out_written = 0;
+}
+
+static gboolean
+_on_writable (gint fd, GIOCondition condition, gpointer user_data)
+{
+    GSignondFrameChannel *self = GSIGNOND_FRAME_CHANNEL (user_data);
+
+    self->priv->out_id = 0;
+    _write_queue (self);
+
+    return FALSE;
+}
+
+static gboolean
+_flush (gpointer user_data)
+{
+    GSignondFrameChannel *self = GSIGNOND_FRAME_CHANNEL (user_data);
+
+    self->priv->flush_id = 0;
+    if (!self->priv->out_id)
+        _write_queue (self);
+
+    return FALSE;
+}
+
+/**
+ * gsignond_frame_channel_new:
+ * @fd: a connected unix stream socket, which the channel takes over
+ * @error: return location for error
+ *
+ * Returns: (transfer full): a new #GSignondFrameChannel, or NULL if @fd is
+ * not a unix stream socket. @fd is closed in that case too.
+ */
+GSignondFrameChannel *
+gsignond_frame_channel_new (
+        gint fd,
+        GError **error)
+{
+    g_return_val_if_fail (fd >= 0, NULL);
+
+    GSignondFrameChannel *self = NULL;
+    struct sockaddr_storage addr;
+    socklen_t addr_len = sizeof (addr);
+    gint type = 0;
+    socklen_t type_len = sizeof (type);
+
+    if (getsockname (fd, (struct sockaddr *) &addr, &addr_len) != 0 ||
+        addr.ss_family != AF_UNIX ||
+        getsockopt (fd, SOL_SOCKET, SO_TYPE, &type, &type_len) != 0 ||
+        type != SOCK_STREAM) {
+        g_set_error (error, GSIGNOND_ERROR,
+                     GSIGNOND_ERROR_INTERNAL_COMMUNICATION,
+                     "Frame channel needs a unix stream socket");
+        close (fd);
+        return NULL;
+    }
+    fcntl (fd, F_SETFD, FD_CLOEXEC);
+
+    self = GSIGNOND_FRAME_CHANNEL (g_object_new (
+            GSIGNOND_TYPE_FRAME_CHANNEL, NULL));
+    self->priv->fd = fd;
+
+    return self;
+}
+
+/**
+ * gsignond_frame_channel_set_fd_threshold:
+ * @self: a #GSignondFrameChannel
+ * @threshold: size in bytes from which payloads are passed in a memfd,
+ * G_MAXSIZE to always send them inline
+ *
+ * Payloads are passed in a memfd from 64 KiB on by default.
+ */
+void
+gsignond_frame_channel_set_fd_threshold (
+        GSignondFrameChannel *self,
+        gsize threshold)
+{
+    g_return_if_fail (self && GSIGNOND_IS_FRAME_CHANNEL (self));
+
+    self->priv->fd_threshold = threshold;
+}
+
+/**
+ * gsignond_frame_channel_start:
+ * @self: a #GSignondFrameChannel
+ *
+ * Starts reading frames in the main loop, and emitting them with the
+ * #GSignondFrameChannel::frame signal.
+ */
+void
+gsignond_frame_channel_start (
+        GSignondFrameChannel *self)
+{
+    g_return_if_fail (self && GSIGNOND_IS_FRAME_CHANNEL (self));
+
+    if (self->priv->started || self->priv->closed)
+        return;
+
+    self->priv->started = TRUE;
+    self->priv->in_id = g_unix_fd_add (self->priv->fd, G_IO_IN, _on_readable,
+                                       self);
+    /* frames received with a synchronous one are pending already */
+    if (self->priv->in_len > self->priv->in_start)
+        _dispatch_frames (self);
+}
+
+/**
+ * gsignond_frame_channel_receive_sync:
+ * @self: a #GSignondFrameChannel
+ * @id: (out): request id of the frame
+ * @opcode: (out): opcode of the frame
+ * @payload: (out) (transfer full): payload of the frame, or NULL
+ * @cancellable: (allow-none): a #GCancellable
+ * @error: return location for error
+ *
+ * Blocks until a frame is received. Can only be used before
+ * gsignond_frame_channel_start().
+ *
+ * Returns: TRUE if a frame was received.
+ */
+gboolean
+gsignond_frame_channel_receive_sync (
+        GSignondFrameChannel *self,
+        guint32 *id,
+        guint32 *opcode,
+        GVariant **payload,
+        GCancellable *cancellable,
+        GError **error)
+{
+    g_return_val_if_fail (self && GSIGNOND_IS_FRAME_CHANNEL (self), FALSE);
+    g_return_val_if_fail (!self->priv->started && !self->priv->closed,
+                          FALSE);
+
+    GError *local_error = NULL;
+    _FrameHeader header;
+    GPollFD fds[2];
+    gint n_fds = 1;
+    gssize n;
+
+    fds[0].fd = self->priv->fd;
+    fds[0].events = G_IO_IN;
+    if (g_cancellable_make_pollfd (cancellable, &fds[1]))
+        n_fds++;
+
+    while (!_take_frame (self, &header, payload, &local_error) &&
+           !local_error) {
+        if (g_cancellable_set_error_if_cancelled (cancellable, &local_error))
+            break;
+        if (g_poll (fds, n_fds, -1) < 0 && errno != EINTR) {
+            _set_errno_error (&local_error, "Failed to wait for frames");
+            break;
+        }
+        n = _receive (self);
+        if (n == 0) {
+            g_set_error (&local_error, GSIGNOND_ERROR,
+                         GSIGNOND_ERROR_INTERNAL_COMMUNICATION,
+                         "Channel closed by peer");
+            break;
+        }
+        if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+            _set_errno_error (&local_error, "Failed to read frames");
+            break;
+        }
+    }
+    if (n_fds > 1)
+        g_cancellable_release_fd (cancellable);
+
+    if (local_error) {
+        g_propagate_error (error, local_error);
+        return FALSE;
+    }
+    *id = header.id;
+    *opcode = header.opcode;
+    return TRUE;
+}
+
+/**
+ * gsignond_frame_channel_send:
+ * @self: a #GSignondFrameChannel
+ * @id: request id of the frame
+ * @opcode: a #GSignondFrameOpcode
+ * @payload: (allow-none): the payload, consumed if floating
+ *
+ * Queues a frame. Frames queued until the main loop runs again are written
+ * in one batch.
+ */
+void
+gsignond_frame_channel_send (
+        GSignondFrameChannel *self,
+        guint32 id,
+        guint32 opcode,
+        GVariant *payload)
+{
+    g_return_if_fail (self && GSIGNOND_IS_FRAME_CHANNEL (self));
+
+    GSignondFrameChannelPrivate *priv = self->priv;
+    GVariant *boxed = NULL;
+    _FrameHeader header;
+    guint offset;
+    gint fd = -1;
+
+    if (payload)
+        boxed = g_variant_ref_sink (g_variant_new_variant (payload));
+    if (priv->closed) {
+        if (boxed)
+            g_variant_unref (boxed);
+        return;
+    }
+
+    header.length = boxed ? g_variant_get_size (boxed) : 0;
+    header.id = id;
+    header.opcode = opcode;
+    if (boxed && header.length >= priv->fd_threshold)
+        fd = _store_payload (boxed, header.length);
+
+    offset = priv->out_queue->len;
+    if (fd >= 0) {
+        _OutFd *out_fd = g_slice_new (_OutFd);
+        out_fd->offset = offset;
+        out_fd->fd = fd;
+        g_queue_push_tail (priv->out_fds, out_fd);
+        header.opcode |= GSIGNOND_FRAME_FLAG_FD;
+        g_byte_array_append (priv->out_queue, (const guint8 *) &header,
+                             sizeof (header));
+    } else {
+        g_byte_array_set_size (priv->out_queue,
+                               offset + sizeof (header) + header.length);
+        memcpy (priv->out_queue->data + offset, &header, sizeof (header));
+        if (boxed)
+            g_variant_store (boxed, priv->out_queue->data + offset +
+                             sizeof (header));
+    }
+    if (boxed)
+        g_variant_unref (boxed);
+
+    if (!priv->flush_id && !priv->out_id)
+        priv->flush_id = g_idle_add_full (G_PRIORITY_DEFAULT, _flush,
+                                          self, NULL);
+}
+
+/**
+ * gsignond_frame_channel_close:
+ * @self: a #GSignondFrameChannel
+ *
+ * Stops reading and writing frames. Frames that were not written yet are
+ * dropped.
+ */
+void
+gsignond_frame_channel_close (
+        GSignondFrameChannel *self)
+{
+    g_return_if_fail (self && GSIGNOND_IS_FRAME_CHANNEL (self));
+
+    GSignondFrameChannelPrivate *priv = self->priv;
+    _OutFd *out_fd;
+
+    if (priv->closed)
+        return;
+
+    priv->closed = TRUE;
+    if (priv->in_id) {
+        g_source_remove (priv->in_id);
+        priv->in_id = 0;
+    }
+    if (priv->out_id) {
+        g_source_remove (priv->out_id);
+        priv->out_id = 0;
+    }
+    if (priv->flush_id) {
+        g_source_remove (priv->flush_id);
+        priv->flush_id = 0;
+    }
+
+    _close_fds (priv->in_fds);
+    while ((out_fd = g_queue_pop_head (priv->out_fds)) != NULL) {
+        close (out_fd->fd);
+        g_slice_free (_OutFd, out_fd);
+    }
+    g_byte_array_set_size (priv->out_queue, 0);
+    priv->out_written = 0;
+}
@@ -0,0 +1,132 @@
+/* vi: set et sw=4 ts=4 cino=t0,(0: */
+/* -*- Mode: C; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This file is part of gsignond
+ *
+ * Copyright (C) 2014 Intel Corporation.
+ *
+ * Contact: Imran Zaman <imran.zaman@intel.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ */
+
+
+#ifndef __GSIGNOND_FRAME_CHANNEL_H__
+#define __GSIGNOND_FRAME_CHANNEL_H__
+
+#include <glib.h>
+#include <glib-object.h>
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+/*
+ * Type macros.
+ */
+#define GSIGNOND_TYPE_FRAME_CHANNEL   (gsignond_frame_channel_get_type ())
+#define GSIGNOND_FRAME_CHANNEL(obj)   (G_TYPE_CHECK_INSTANCE_CAST ((obj), \
+                                           GSIGNOND_TYPE_FRAME_CHANNEL, \
+                                           GSignondFrameChannel))
+#define GSIGNOND_IS_FRAME_CHANNEL(obj) (G_TYPE_CHECK_INSTANCE_TYPE ((obj), \
+                                           GSIGNOND_TYPE_FRAME_CHANNEL))
+#define GSIGNOND_FRAME_CHANNEL_CLASS(klass) (G_TYPE_CHECK_CLASS_CAST ((klass), \
+                                             GSIGNOND_TYPE_FRAME_CHANNEL, \
+                                             GSignondFrameChannelClass))
+#define GSIGNOND_IS_FRAME_CHANNEL_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE ((klass),\
+                                             GSIGNOND_TYPE_FRAME_CHANNEL))
+#define GSIGNOND_FRAME_CHANNEL_GET_CLASS(obj) (G_TYPE_INSTANCE_GET_CLASS ((obj), \
+                                             GSIGNOND_TYPE_FRAME_CHANNEL, \
+                                             GSignondFrameChannelClass))
+
+/* Messages of the framed plugin loader protocol. Requests go from gsignond
+ * to the loader and carry a new id each, events go from the loader to
+ * gsignond and carry the id of the request the loader was serving. */
+typedef enum {
+    /* loader is ready: (sas) plugin type, mechanisms */
+    GSIGNOND_FRAME_OP_READY = 1,
+
+    /* requests */
+    GSIGNOND_FRAME_OP_CANCEL = 16,              /* no payload */
+    GSIGNOND_FRAME_OP_REQUEST_INITIAL,          /* (a{sv}a{sv}s) */
+    GSIGNOND_FRAME_OP_REQUEST,                  /* a{sv} */
+    GSIGNOND_FRAME_OP_USER_ACTION_FINISHED,     /* a{sv} */
+    GSIGNOND_FRAME_OP_REFRESH,                  /* a{sv} */
+
+    /* events */
+    GSIGNOND_FRAME_OP_RESPONSE = 32,            /* a{sv} */
+    GSIGNOND_FRAME_OP_RESPONSE_FINAL,           /* a{sv} */
+    GSIGNOND_FRAME_OP_STORE,                    /* a{sv} */
+    GSIGNOND_FRAME_OP_ERROR,                    /* gsignond_error_to_variant() */
+    GSIGNOND_FRAME_OP_USER_ACTION_REQUIRED,     /* a{sv} */
+    GSIGNOND_FRAME_OP_REFRESHED,                /* a{sv} */
+    GSIGNOND_FRAME_OP_STATUS_CHANGED            /* (is) */
+} GSignondFrameOpcode;
+
+typedef struct _GSignondFrameChannelPrivate GSignondFrameChannelPrivate;
+
+typedef struct {
+    GObject parent_instance;
+
+    /*< private >*/
+    GSignondFrameChannelPrivate *priv;
+} GSignondFrameChannel;
+
+typedef struct {
+    GObjectClass parent_class;
+
+} GSignondFrameChannelClass;
+
+/* used by GSIGNOND_TYPE_FRAME_CHANNEL */
+GType
+gsignond_frame_channel_get_type (void);
+
+GSignondFrameChannel *
+gsignond_frame_channel_new (
+        gint fd,
+        GError **error);
+
+void
+gsignond_frame_channel_set_fd_threshold (
+        GSignondFrameChannel *self,
+        gsize threshold);
+
+void
+gsignond_frame_channel_start (
+        GSignondFrameChannel *self);
+
+gboolean
+gsignond_frame_channel_receive_sync (
+        GSignondFrameChannel *self,
+        guint32 *id,
+        guint32 *opcode,
+        GVariant **payload,
+        GCancellable *cancellable,
+        GError **error);
+
+void
+gsignond_frame_channel_send (
+        GSignondFrameChannel *self,
+        guint32 id,
+        guint32 opcode,
+        GVariant *payload);
+
+void
+gsignond_frame_channel_close (
+        GSignondFrameChannel *self);
+
+G_END_DECLS
+
+#endif /* __GSIGNOND_FRAME_CHANNEL_H__ */
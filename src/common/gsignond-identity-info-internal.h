@@ -99,6 +99,12 @@ gsignond_identity_info_selective_copy (GSignondIdentityInfo *dest,
 void
 gsignond_identity_info_remove_owner (GSignondIdentityInfo *info);
 
+guint
+gsignond_identity_info_get_acl_generation (GSignondIdentityInfo *info);
+
+guint
+gsignond_identity_info_get_methods_generation (GSignondIdentityInfo *info);
+
 G_END_DECLS
 
 #endif /* __GSIGNOND_IDENTITY_INFO_INTERNAL_H__ */
@@ -35,85 +35,172 @@ G_DEFINE_BOXED_TYPE(GSignondIdentityInfo,
 struct _GSignondIdentityInfo
 {
     volatile gint ref_count;
+    GSignondIdentityInfoPropFlags edit_flags;
+    /* properties that carry a value, set or not by the client */
+    GSignondIdentityInfoPropFlags props;
+    guint32 id;
+    guint32 type;
     gchar *username;
     gchar *secret;
-    GSignondIdentityInfoPropFlags edit_flags;
-    GSignondDictionary *map;
+    gchar *caption;
+    gboolean store_secret;
+    gboolean username_is_secret;
+    gboolean validated;
+    GVariant *refcount;
+    GSequence *realms;                  /* sorted gchar* */
+    GHashTable *methods;                /* gchar* -> sorted GSequence of gchar* */
+    GSignondSecurityContext *owner;
+    GSignondSecurityContextList *acl;
+    guint acl_generation;
+    guint methods_generation;
+    /* entries of unknown keys, passed back to clients as they came */
+    GSignondDictionary *extra;
 };
 
+/* daemon-wide, so that a generation is never reused by another info */
+static volatile gint _generation_counter = 0;
+
+static guint
+_next_generation (void)
+{
+    guint generation;
+
+    do {
+        generation = (guint) g_atomic_int_add (&_generation_counter, 1) + 1;
+    } while (generation == 0);
+
+    return generation;
+}
+
+static void
+_bump_acl_generation (GSignondIdentityInfo *info)
+{
+    info->acl_generation = _next_generation ();
+}
+
+static void
+_bump_methods_generation (GSignondIdentityInfo *info)
+{
+    info->methods_generation = _next_generation ();
+}
+
+/* realms, methods and mechanisms are interned: they repeat across
+ * identities far more often than they differ */
+static GSequence *
+_gsignond_identity_info_seq_copy (GSequence *seq)
+{
+    GSequence *copy = gsignond_interned_sequence_new ();
+    GSequenceIter *iter = NULL;
+
+    if (!seq) return copy;
+
+    iter = g_sequence_get_begin_iter (seq);
+    while (!g_sequence_iter_is_end (iter)) {
+        gsignond_interned_sequence_insert (copy, g_sequence_get (iter));
+        iter = g_sequence_iter_next (iter);
+    }
+
+    return copy;
+}
+
+static GSequence *
+_gsignond_identity_info_seq_from_array (const gchar **items)
+{
+    GSequence *seq = gsignond_interned_sequence_new ();
+
+    for ( ; items && *items; items++)
+        gsignond_interned_sequence_insert (seq, *items);
+
+    return seq;
+}
+
+static GHashTable *
+_gsignond_identity_info_methods_copy (GHashTable *methods)
+{
+    GHashTable *copy = NULL;
+    GHashTableIter iter;
+    const gchar *method = NULL;
+    GSequence *mechanisms = NULL;
+
+    copy = g_hash_table_new_full ((GHashFunc)g_str_hash,
+                                  (GEqualFunc)g_str_equal,
+                                  (GDestroyNotify)gsignond_str_unintern,
+                                  (GDestroyNotify)g_sequence_free);
+    if (!methods) return copy;
+
+    g_hash_table_iter_init (&iter, methods);
+    while (g_hash_table_iter_next (&iter, (gpointer *)&method,
+                                   (gpointer *)&mechanisms)) {
+        g_hash_table_insert (copy, (gpointer) gsignond_str_intern (method),
+                             _gsignond_identity_info_seq_copy (mechanisms));
+    }
+
+    return copy;
+}
+
+/* both sequences are kept sorted, so a single parallel walk is enough */
 static gboolean
 _gsignond_identity_info_seq_cmp (
         GSequence *one,
         GSequence *two)
 {
     GSequenceIter *iter1 = NULL, *iter2 = NULL;
-    gboolean equal = TRUE;
 
-   if (one == two)
+    if (one == two)
         return TRUE;
 
-   if (one == NULL) {
-	if (g_sequence_get_length (two) == 0)
-	    return TRUE;
-        else
-	    return FALSE;
-   }
-
-   if (two == NULL) {
-	if (g_sequence_get_length (one) == 0)
-	    return TRUE;
-	else
-	    return FALSE;
-    }
+    if (one == NULL)
+        return g_sequence_get_length (two) == 0;
+
+    if (two == NULL)
+        return g_sequence_get_length (one) == 0;
 
     if (g_sequence_get_length (one) != g_sequence_get_length (two))
         return FALSE;
 
     iter1 = g_sequence_get_begin_iter (one);
+    iter2 = g_sequence_get_begin_iter (two);
     while (!g_sequence_iter_is_end (iter1)) {
-        iter2 = g_sequence_get_iter_at_pos (two,
-                    g_sequence_iter_get_position (iter1));
-        if (g_strcmp0 (g_sequence_get (iter1), g_sequence_get (iter2)) != 0) {
-            equal = FALSE;
-            break;
-        }
+        if (g_strcmp0 (g_sequence_get (iter1), g_sequence_get (iter2)) != 0)
+            return FALSE;
         iter1 = g_sequence_iter_next (iter1);
+        iter2 = g_sequence_iter_next (iter2);
     }
 
-    return equal;
+    return TRUE;
 }
 
 static gboolean
-_gsignond_identity_info_sec_context_list_cmp (
+_gsignond_identity_info_sec_context_list_equal (
         GSignondSecurityContextList *one,
         GSignondSecurityContextList *two)
 {
-    GSignondSecurityContextList *list_elem1 = NULL, *list_elem2 = NULL;
-    gboolean equal = TRUE;
-
-    if (one == NULL && two == NULL)
-        return TRUE;
-
-    if ((one != NULL && two == NULL) ||
-        (one == NULL && two != NULL) ||
-        (g_list_length (one) != g_list_length (two)))
-        return FALSE;
+    for ( ; one != NULL && two != NULL;
+          one = g_list_next (one), two = g_list_next (two)) {
+        if (gsignond_security_context_compare (
+                (GSignondSecurityContext *)one->data,
+                (GSignondSecurityContext *)two->data) != 0)
+            return FALSE;
+    }
 
-    if (one == two)
-        return TRUE;
+    return one == NULL && two == NULL;
+}
 
-    list_elem1 = one;
-    for ( ; list_elem1 != NULL; list_elem1 = g_list_next (list_elem1)) {
-        list_elem2 = g_list_nth (two, g_list_position (one, list_elem1));
+/* wildcards in either list match, as for access checks */
+static gboolean
+_gsignond_identity_info_sec_context_list_cmp (
+        GSignondSecurityContextList *one,
+        GSignondSecurityContextList *two)
+{
+    for ( ; one != NULL && two != NULL;
+          one = g_list_next (one), two = g_list_next (two)) {
         if (!gsignond_security_context_match (
-                (GSignondSecurityContext *)list_elem1->data,
-                (GSignondSecurityContext *)list_elem2->data)) {
-            equal = FALSE;
-            break;
-        }
+                (GSignondSecurityContext *)one->data,
+                (GSignondSecurityContext *)two->data))
+            return FALSE;
     }
 
-    return equal;
+    return one == NULL && two == NULL;
 }
 
 static gboolean
@@ -124,30 +211,108 @@ _gsignond_identity_info_methods_cmp (
     GHashTableIter iter1;
     GSequence *mechs1 = NULL, *mechs2 = NULL;
     gchar *key = NULL;
-    gboolean equal = TRUE;
 
-    if (one == NULL && two == NULL)
+    if (one == two)
         return TRUE;
 
-    if ((one != NULL && two == NULL) ||
-        (one == NULL && two != NULL) ||
-        (g_hash_table_size (one) != g_hash_table_size (two)))
+    if (one == NULL || two == NULL ||
+        g_hash_table_size (one) != g_hash_table_size (two))
         return FALSE;
 
-    if (one == two)
-        return TRUE;
-
     g_hash_table_iter_init(&iter1, one);
     while (g_hash_table_iter_next (&iter1, (gpointer *)&key,
             (gpointer *)&mechs1)) {
-        mechs2 = (GSequence *)g_hash_table_lookup (two, key);
-        equal = _gsignond_identity_info_seq_cmp (mechs1, mechs2);
-        if (!equal) {
+        if (!g_hash_table_lookup_extended (two, key, NULL,
+                                           (gpointer *)&mechs2) ||
+            !_gsignond_identity_info_seq_cmp (mechs1, mechs2))
+            return FALSE;
+    }
+
+    return TRUE;
+}
+
+static void
+_gsignond_identity_info_clear_prop (
+        GSignondIdentityInfo *info,
+        GSignondIdentityInfoPropFlags prop)
+{
+    switch (prop) {
+        case IDENTITY_INFO_PROP_CAPTION:
+            g_free (info->caption);
+            info->caption = NULL;
+            break;
+        case IDENTITY_INFO_PROP_OWNER:
+            gsignond_security_context_free (info->owner);
+            info->owner = NULL;
+            break;
+        case IDENTITY_INFO_PROP_ACL:
+            gsignond_security_context_list_free (info->acl);
+            info->acl = NULL;
+            break;
+        case IDENTITY_INFO_PROP_METHODS:
+            if (info->methods) g_hash_table_unref (info->methods);
+            info->methods = NULL;
+            break;
+        case IDENTITY_INFO_PROP_REALMS:
+            if (info->realms) g_sequence_free (info->realms);
+            info->realms = NULL;
+            break;
+        case IDENTITY_INFO_PROP_REF_COUNT:
+            if (info->refcount) g_variant_unref (info->refcount);
+            info->refcount = NULL;
+            break;
+        default:
             break;
-        }
     }
+    info->props &= ~prop;
+}
 
-    return equal;
+static void
+_gsignond_identity_info_copy_prop (
+        GSignondIdentityInfo *dest,
+        const GSignondIdentityInfo *src,
+        GSignondIdentityInfoPropFlags prop)
+{
+    _gsignond_identity_info_clear_prop (dest, prop);
+
+    switch (prop) {
+        case IDENTITY_INFO_PROP_ID:
+            dest->id = src->id;
+            break;
+        case IDENTITY_INFO_PROP_TYPE:
+            dest->type = src->type;
+            break;
+        case IDENTITY_INFO_PROP_CAPTION:
+            dest->caption = g_strdup (src->caption);
+            break;
+        case IDENTITY_INFO_PROP_STORE_SECRET:
+            dest->store_secret = src->store_secret;
+            break;
+        case IDENTITY_INFO_PROP_USERNAME_IS_SECRET:
+            dest->username_is_secret = src->username_is_secret;
+            break;
+        case IDENTITY_INFO_PROP_OWNER:
+            dest->owner = gsignond_security_context_copy (src->owner);
+            break;
+        case IDENTITY_INFO_PROP_ACL:
+            dest->acl = gsignond_security_context_list_copy (src->acl);
+            break;
+        case IDENTITY_INFO_PROP_METHODS:
+            dest->methods = _gsignond_identity_info_methods_copy (src->methods);
+            break;
+        case IDENTITY_INFO_PROP_REALMS:
+            dest->realms = _gsignond_identity_info_seq_copy (src->realms);
+            break;
+        case IDENTITY_INFO_PROP_REF_COUNT:
+            dest->refcount = g_variant_ref (src->refcount);
+            break;
+        case IDENTITY_INFO_PROP_VALIDATED:
+            dest->validated = src->validated;
+            break;
+        default:
+            return;
+    }
+    dest->props |= prop;
 }
 
 GSignondIdentityInfoPropFlags
@@ -202,33 +367,15 @@ gsignond_identity_info_selective_copy (GSignondIdentityInfo *dest,
                                        GSignondIdentityInfoPropFlags flags)
 {
     GSignondIdentityInfoPropFlags tmp_flag;
-    guint i;
     g_return_val_if_fail (src, IDENTITY_INFO_PROP_NONE);
     g_return_val_if_fail (dest, IDENTITY_INFO_PROP_NONE);
     g_return_val_if_fail (flags != IDENTITY_INFO_PROP_NONE, flags);
 
-    /* This table should match to GSignondIdentityInfoPropFlags order */
-    const gchar *keys[] = {
-        GSIGNOND_IDENTITY_INFO_ID,
-        GSIGNOND_IDENTITY_INFO_TYPE,
-        GSIGNOND_IDENTITY_INFO_CAPTION,
-        GSIGNOND_IDENTITY_INFO_STORESECRET,
-        GSIGNOND_IDENTITY_INFO_USERNAME_IS_SECRET,
-        GSIGNOND_IDENTITY_INFO_OWNER,
-        GSIGNOND_IDENTITY_INFO_ACL,
-        GSIGNOND_IDENTITY_INFO_AUTHMETHODS,
-        GSIGNOND_IDENTITY_INFO_REALMS,
-        GSIGNOND_IDENTITY_INFO_REFCOUNT,
-        GSIGNOND_IDENTITY_INFO_VALIDATED
-    };
-
-    for (i= 0, tmp_flag = IDENTITY_INFO_PROP_ID; 
+    for (tmp_flag = IDENTITY_INFO_PROP_ID;
          tmp_flag < IDENTITY_INFO_PROP_MAX;
-         tmp_flag <<= 1, i++) {
-        if ((flags & tmp_flag) && 
-            gsignond_dictionary_contains (src->map, keys[i])) {
-            gsignond_dictionary_set (dest->map, keys[i],
-               g_variant_ref (gsignond_dictionary_get (src->map, keys[i])));
+         tmp_flag <<= 1) {
+        if ((flags & tmp_flag) && (src->props & tmp_flag)) {
+            _gsignond_identity_info_copy_prop (dest, src, tmp_flag);
         }
         else {
             flags &= ~tmp_flag;
@@ -245,6 +392,11 @@ gsignond_identity_info_selective_copy (GSignondIdentityInfo *dest,
         dest->secret = g_strdup (src->secret);
     }
 
+    if (flags & (IDENTITY_INFO_PROP_OWNER | IDENTITY_INFO_PROP_ACL))
+        _bump_acl_generation (dest);
+    if (flags & IDENTITY_INFO_PROP_METHODS)
+        _bump_methods_generation (dest);
+
     dest->edit_flags |= flags;
 
     return flags;
@@ -255,7 +407,26 @@ gsignond_identity_info_remove_owner (GSignondIdentityInfo *info)
 {
     g_return_if_fail (info && GSIGNOND_IS_IDENTITY_INFO(info));
 
-    gsignond_dictionary_remove (info->map, GSIGNOND_IDENTITY_INFO_OWNER);
+    if (info->props & IDENTITY_INFO_PROP_OWNER) {
+        _gsignond_identity_info_clear_prop (info, IDENTITY_INFO_PROP_OWNER);
+        _bump_acl_generation (info);
+    }
+}
+
+guint
+gsignond_identity_info_get_acl_generation (GSignondIdentityInfo *info)
+{
+    g_return_val_if_fail (info && GSIGNOND_IS_IDENTITY_INFO(info), 0);
+
+    return info->acl_generation;
+}
+
+guint
+gsignond_identity_info_get_methods_generation (GSignondIdentityInfo *info)
+{
+    g_return_val_if_fail (info && GSIGNOND_IS_IDENTITY_INFO(info), 0);
+
+    return info->methods_generation;
 }
 
 /**
@@ -272,10 +443,79 @@ gsignond_identity_info_new (void)
     return gsignond_identity_info_new_from_variant (NULL);
 }
 
+static GVariant *
+_gsignond_identity_info_lookup (
+        GVariant *variant_map,
+        const gchar *key,
+        const GVariantType *type,
+        GSignondIdentityInfo *info,
+        GSignondIdentityInfoPropFlags prop)
+{
+    GVariant *value = g_variant_lookup_value (variant_map, key, type);
+
+    if (value) {
+        info->props |= prop;
+        info->edit_flags |= prop;
+    }
+
+    return value;
+}
+
+static gboolean
+_gsignond_identity_info_is_known_key (const gchar *key)
+{
+    static const gchar *known_keys[] = {
+        GSIGNOND_IDENTITY_INFO_ID,
+        GSIGNOND_IDENTITY_INFO_USERNAME,
+        GSIGNOND_IDENTITY_INFO_SECRET,
+        GSIGNOND_IDENTITY_INFO_STORESECRET,
+        GSIGNOND_IDENTITY_INFO_CAPTION,
+        GSIGNOND_IDENTITY_INFO_REALMS,
+        GSIGNOND_IDENTITY_INFO_AUTHMETHODS,
+        GSIGNOND_IDENTITY_INFO_OWNER,
+        GSIGNOND_IDENTITY_INFO_ACL,
+        GSIGNOND_IDENTITY_INFO_TYPE,
+        GSIGNOND_IDENTITY_INFO_REFCOUNT,
+        GSIGNOND_IDENTITY_INFO_VALIDATED,
+        GSIGNOND_IDENTITY_INFO_USERNAME_IS_SECRET,
+        NULL
+    };
+    gint i;
+
+    for (i = 0; known_keys[i]; i++)
+        if (g_strcmp0 (key, known_keys[i]) == 0)
+            return TRUE;
+
+    return FALSE;
+}
+
+static void
+_gsignond_identity_info_keep_extra (
+        GSignondIdentityInfo *info,
+        GVariant *variant_map)
+{
+    GVariantIter iter;
+    const gchar *key = NULL;
+    GVariant *value = NULL;
+
+    g_variant_iter_init (&iter, variant_map);
+    while (g_variant_iter_next (&iter, "{&sv}", &key, &value)) {
+        if (!_gsignond_identity_info_is_known_key (key)) {
+            if (!info->extra)
+                info->extra = gsignond_dictionary_new ();
+            gsignond_dictionary_set (info->extra, key, value);
+        }
+        g_variant_unref (value);
+    }
+}
+
 /**
  * gsignond_identity_info_new_from_variant:
  *
- * Creates new instance of GSignondIdentityInfo.
+ * Creates new instance of GSignondIdentityInfo. The variant is parsed once
+ * into typed fields; values of unexpected type are ignored. Entries of keys
+ * that are not identity properties are kept, and returned by
+ * gsignond_identity_info_to_variant() unchanged.
  *
  * Returns: (transfer full) #GSignondIdentityInfo object if successful,
  * NULL otherwise.
@@ -283,72 +523,128 @@ gsignond_identity_info_new (void)
 GSignondIdentityInfo *
 gsignond_identity_info_new_from_variant (GVariant *variant_map)
 {
-    gboolean uname_is_secret = FALSE;
+    GVariant *value = NULL;
     GSignondIdentityInfo *info = g_slice_new0 (GSignondIdentityInfo);
     if (!info) return NULL;
 
     info->ref_count = 1;
     info->edit_flags = IDENTITY_INFO_PROP_NONE;
-    info->username = info->secret = NULL;
+    info->props = IDENTITY_INFO_PROP_NONE;
+    _bump_acl_generation (info);
+    _bump_methods_generation (info);
 
     if (!variant_map) {
-        info->map = gsignond_dictionary_new ();
-
-        gsignond_dictionary_set (info->map, GSIGNOND_IDENTITY_INFO_ID,
-            g_variant_new_uint32 (GSIGNOND_IDENTITY_INFO_NEW_IDENTITY));
+        info->id = GSIGNOND_IDENTITY_INFO_NEW_IDENTITY;
+        info->props |= IDENTITY_INFO_PROP_ID;
 
         return info;
     }
 
-    info->map = gsignond_dictionary_new_from_variant (variant_map);
-    if (!info->map) return info;
-
-    /* update edit flags */
-    if (gsignond_dictionary_contains (info->map, GSIGNOND_IDENTITY_INFO_ID))
-        info->edit_flags |= IDENTITY_INFO_PROP_ID;
-    if (gsignond_dictionary_contains (info->map, GSIGNOND_IDENTITY_INFO_TYPE))
-        info->edit_flags |= IDENTITY_INFO_PROP_TYPE;
-    if (gsignond_dictionary_contains (info->map, 
-                GSIGNOND_IDENTITY_INFO_USERNAME_IS_SECRET)) {
-        info->edit_flags |= IDENTITY_INFO_PROP_USERNAME_IS_SECRET;
-        gsignond_dictionary_get_boolean (info->map,
-                GSIGNOND_IDENTITY_INFO_USERNAME_IS_SECRET, &uname_is_secret);
+    g_return_val_if_fail (
+            g_variant_is_of_type (variant_map, G_VARIANT_TYPE_VARDICT), info);
+
+    if ((value = _gsignond_identity_info_lookup (variant_map,
+                    GSIGNOND_IDENTITY_INFO_ID,
+                    G_VARIANT_TYPE_UINT32, info, IDENTITY_INFO_PROP_ID))) {
+        info->id = g_variant_get_uint32 (value);
+        g_variant_unref (value);
     }
-    if (gsignond_dictionary_contains (info->map,
-                GSIGNOND_IDENTITY_INFO_USERNAME)) {
-        info->edit_flags |= IDENTITY_INFO_PROP_USERNAME;
-        info->username = g_strdup (gsignond_dictionary_get_string (info->map,
-                                            GSIGNOND_IDENTITY_INFO_USERNAME));
-        gsignond_dictionary_remove (info->map, GSIGNOND_IDENTITY_INFO_USERNAME);
+    if ((value = _gsignond_identity_info_lookup (variant_map,
+                    GSIGNOND_IDENTITY_INFO_TYPE,
+                    G_VARIANT_TYPE_INT32, info, IDENTITY_INFO_PROP_TYPE))) {
+        info->type = (guint32) g_variant_get_int32 (value);
+        g_variant_unref (value);
     }
-    if (gsignond_dictionary_contains (info->map, 
-                GSIGNOND_IDENTITY_INFO_SECRET)) {
-        info->edit_flags |= IDENTITY_INFO_PROP_SECRET;
-        info->secret = g_strdup (gsignond_dictionary_get_string (info->map,
-                                    GSIGNOND_IDENTITY_INFO_SECRET));
-        gsignond_dictionary_remove (info->map, GSIGNOND_IDENTITY_INFO_SECRET);
+    if ((value = _gsignond_identity_info_lookup (variant_map,
+                    GSIGNOND_IDENTITY_INFO_USERNAME_IS_SECRET,
+                    G_VARIANT_TYPE_BOOLEAN, info,
+                    IDENTITY_INFO_PROP_USERNAME_IS_SECRET))) {
+        info->username_is_secret = g_variant_get_boolean (value);
+        g_variant_unref (value);
+    }
+    if ((value = _gsignond_identity_info_lookup (variant_map,
+                    GSIGNOND_IDENTITY_INFO_USERNAME,
+                    G_VARIANT_TYPE_STRING, info,
+                    IDENTITY_INFO_PROP_USERNAME))) {
+        info->username = g_variant_dup_string (value, NULL);
+        g_variant_unref (value);
+    }
+    if ((value = _gsignond_identity_info_lookup (variant_map,
+                    GSIGNOND_IDENTITY_INFO_SECRET,
+                    G_VARIANT_TYPE_STRING, info, IDENTITY_INFO_PROP_SECRET))) {
+        info->secret = g_variant_dup_string (value, NULL);
+        g_variant_unref (value);
+    }
+    /* username and secret are not kept as properties */
+    info->props &= ~(IDENTITY_INFO_PROP_USERNAME | IDENTITY_INFO_PROP_SECRET);
+
+    if ((value = _gsignond_identity_info_lookup (variant_map,
+                    GSIGNOND_IDENTITY_INFO_STORESECRET,
+                    G_VARIANT_TYPE_BOOLEAN, info,
+                    IDENTITY_INFO_PROP_STORE_SECRET))) {
+        info->store_secret = g_variant_get_boolean (value);
+        g_variant_unref (value);
+    }
+    if ((value = _gsignond_identity_info_lookup (variant_map,
+                    GSIGNOND_IDENTITY_INFO_CAPTION,
+                    G_VARIANT_TYPE_STRING, info, IDENTITY_INFO_PROP_CAPTION))) {
+        info->caption = g_variant_dup_string (value, NULL);
+        g_variant_unref (value);
+    }
+    if ((value = _gsignond_identity_info_lookup (variant_map,
+                    GSIGNOND_IDENTITY_INFO_AUTHMETHODS,
+                    G_VARIANT_TYPE ("a{sas}"), info,
+                    IDENTITY_INFO_PROP_METHODS))) {
+        GVariantIter iter;
+        const gchar *vmethod = NULL;
+        const gchar **vmechanisms = NULL;
+
+        info->methods = _gsignond_identity_info_methods_copy (NULL);
+        g_variant_iter_init (&iter, value);
+        while (g_variant_iter_next (&iter, "{&s^a&s}", &vmethod, &vmechanisms)) {
+            g_hash_table_replace (info->methods,
+                    (gpointer) gsignond_str_intern (vmethod),
+                    _gsignond_identity_info_seq_from_array (vmechanisms));
+            g_free (vmechanisms);
+        }
+        g_variant_unref (value);
     }
-    if (gsignond_dictionary_contains (info->map,
-                GSIGNOND_IDENTITY_INFO_STORESECRET))
-        info->edit_flags |= IDENTITY_INFO_PROP_STORE_SECRET;
-    if (gsignond_dictionary_contains (info->map,
-                GSIGNOND_IDENTITY_INFO_CAPTION))
-        info->edit_flags |= IDENTITY_INFO_PROP_CAPTION;
-    if (gsignond_dictionary_contains (info->map,
-                GSIGNOND_IDENTITY_INFO_AUTHMETHODS))
-        info->edit_flags |= IDENTITY_INFO_PROP_METHODS;
-    if (gsignond_dictionary_contains (info->map, GSIGNOND_IDENTITY_INFO_REALMS))
-        info->edit_flags |= IDENTITY_INFO_PROP_REALMS;
-    if (gsignond_dictionary_contains (info->map, GSIGNOND_IDENTITY_INFO_ACL))
-        info->edit_flags |= IDENTITY_INFO_PROP_ACL;
-    if (gsignond_dictionary_contains (info->map, GSIGNOND_IDENTITY_INFO_OWNER))
-        info->edit_flags |= IDENTITY_INFO_PROP_OWNER;
-    if (gsignond_dictionary_contains (info->map,
-                GSIGNOND_IDENTITY_INFO_REFCOUNT))
-        info->edit_flags |= IDENTITY_INFO_PROP_REF_COUNT;
-    if (gsignond_dictionary_contains (info->map,
-                GSIGNOND_IDENTITY_INFO_VALIDATED))
-        info->edit_flags |= IDENTITY_INFO_PROP_VALIDATED;
+    if ((value = _gsignond_identity_info_lookup (variant_map,
+                    GSIGNOND_IDENTITY_INFO_REALMS,
+                    G_VARIANT_TYPE_STRING_ARRAY, info,
+                    IDENTITY_INFO_PROP_REALMS))) {
+        const gchar **vrealms = g_variant_get_strv (value, NULL);
+
+        info->realms = _gsignond_identity_info_seq_from_array (vrealms);
+        g_free (vrealms);
+        g_variant_unref (value);
+    }
+    if ((value = _gsignond_identity_info_lookup (variant_map,
+                    GSIGNOND_IDENTITY_INFO_ACL,
+                    G_VARIANT_TYPE ("a(ss)"), info, IDENTITY_INFO_PROP_ACL))) {
+        info->acl = gsignond_security_context_list_from_variant (value);
+        g_variant_unref (value);
+    }
+    if ((value = _gsignond_identity_info_lookup (variant_map,
+                    GSIGNOND_IDENTITY_INFO_OWNER,
+                    G_VARIANT_TYPE ("(ss)"), info, IDENTITY_INFO_PROP_OWNER))) {
+        info->owner = gsignond_security_context_from_variant (value);
+        g_variant_unref (value);
+    }
+    if ((value = _gsignond_identity_info_lookup (variant_map,
+                    GSIGNOND_IDENTITY_INFO_REFCOUNT,
+                    NULL, info, IDENTITY_INFO_PROP_REF_COUNT))) {
+        info->refcount = value;
+    }
+    if ((value = _gsignond_identity_info_lookup (variant_map,
+                    GSIGNOND_IDENTITY_INFO_VALIDATED,
+                    G_VARIANT_TYPE_BOOLEAN, info,
+                    IDENTITY_INFO_PROP_VALIDATED))) {
+        info->validated = g_variant_get_boolean (value);
+        g_variant_unref (value);
+    }
+
+    _gsignond_identity_info_keep_extra (info, variant_map);
 
     return info;
 }
@@ -365,6 +661,7 @@ GSignondIdentityInfo *
 gsignond_identity_info_copy (GSignondIdentityInfo *info)
 {
     GSignondIdentityInfo *new_info = NULL;
+    GSignondIdentityInfoPropFlags prop;
     g_return_val_if_fail (info && GSIGNOND_IS_IDENTITY_INFO (info), NULL);
 
     new_info = g_slice_new0 (GSignondIdentityInfo);
@@ -374,7 +671,13 @@ gsignond_identity_info_copy (GSignondIdentityInfo *info)
     new_info->edit_flags = info->edit_flags;
     new_info->username = g_strdup (info->username);
     new_info->secret = g_strdup (info->secret);
-    new_info->map = gsignond_dictionary_copy (info->map);
+    for (prop = IDENTITY_INFO_PROP_ID; prop < IDENTITY_INFO_PROP_MAX; prop <<= 1)
+        if (info->props & prop)
+            _gsignond_identity_info_copy_prop (new_info, info, prop);
+    _bump_acl_generation (new_info);
+    _bump_methods_generation (new_info);
+    if (info->extra)
+        new_info->extra = gsignond_dictionary_copy (info->extra);
 
     return new_info;
 }
@@ -406,12 +709,18 @@ gsignond_identity_info_ref (GSignondIdentityInfo *info)
 void
 gsignond_identity_info_unref (GSignondIdentityInfo *info)
 {
+    GSignondIdentityInfoPropFlags prop;
+
     g_return_if_fail (info != NULL);
 
     if (g_atomic_int_dec_and_test (&info->ref_count)) {
-        gsignond_dictionary_unref (info->map);
+        for (prop = IDENTITY_INFO_PROP_ID; prop < IDENTITY_INFO_PROP_MAX;
+             prop <<= 1)
+            _gsignond_identity_info_clear_prop (info, prop);
         g_free(info->username);
         g_free(info->secret);
+        if (info->extra)
+            gsignond_dictionary_unref (info->extra);
         g_slice_free (GSignondIdentityInfo, info);
     }
 }
@@ -430,10 +739,7 @@ gsignond_identity_info_get_id (GSignondIdentityInfo *info)
     g_return_val_if_fail (info && GSIGNOND_IS_IDENTITY_INFO (info),
             GSIGNOND_IDENTITY_INFO_NEW_IDENTITY);
 
-    GVariant *var = gsignond_dictionary_get (info->map,
-                        GSIGNOND_IDENTITY_INFO_ID);
-
-    return var ? g_variant_get_uint32 (var)
+    return (info->props & IDENTITY_INFO_PROP_ID) ? info->id
                : GSIGNOND_IDENTITY_INFO_NEW_IDENTITY;
 }
 
@@ -457,12 +763,10 @@ gsignond_identity_info_set_id (
     if (gsignond_identity_info_get_id (info) == id)
         return TRUE;
 
-    return gsignond_dictionary_set (
-            info->map,
-            GSIGNOND_IDENTITY_INFO_ID,
-            g_variant_new_uint32 (id)) &&
-           gsignond_identity_info_set_edit_flags (info,
-            IDENTITY_INFO_PROP_ID);
+    info->id = id;
+    info->props |= IDENTITY_INFO_PROP_ID;
+
+    return gsignond_identity_info_set_edit_flags (info, IDENTITY_INFO_PROP_ID);
 }
 
 /**
@@ -557,9 +861,7 @@ gsignond_identity_info_get_is_username_secret (GSignondIdentityInfo *info)
 {
     g_return_val_if_fail (info && GSIGNOND_IS_IDENTITY_INFO (info), FALSE);
 
-    GVariant *var = gsignond_dictionary_get (info->map,
-            GSIGNOND_IDENTITY_INFO_USERNAME_IS_SECRET);
-    return var ? g_variant_get_boolean (var) : FALSE;
+    return info->username_is_secret;
 }
 
 /**
@@ -577,19 +879,17 @@ gsignond_identity_info_set_username_secret (
         GSignondIdentityInfo *info,
         gboolean username_secret)
 {
-    gboolean res = FALSE;
     g_return_val_if_fail (info && GSIGNOND_IS_IDENTITY_INFO (info), FALSE);
 
-    if (gsignond_identity_info_get_is_username_secret(info) == username_secret)
+    username_secret = !!username_secret;
+    if (info->username_is_secret == username_secret)
         return TRUE;
 
-    res = gsignond_dictionary_set (info->map,
-            GSIGNOND_IDENTITY_INFO_USERNAME_IS_SECRET,
-            g_variant_new_boolean(username_secret)) &&
-           gsignond_identity_info_set_edit_flags (info, 
-            IDENTITY_INFO_PROP_USERNAME_IS_SECRET);
+    info->username_is_secret = username_secret;
+    info->props |= IDENTITY_INFO_PROP_USERNAME_IS_SECRET;
 
-    return res;
+    return gsignond_identity_info_set_edit_flags (info,
+                IDENTITY_INFO_PROP_USERNAME_IS_SECRET);
 }
 
 /**
@@ -651,9 +951,7 @@ gsignond_identity_info_get_store_secret (GSignondIdentityInfo *info)
 {
     g_return_val_if_fail (info && GSIGNOND_IS_IDENTITY_INFO (info), FALSE);
 
-    GVariant *var = gsignond_dictionary_get (info->map,
-            GSIGNOND_IDENTITY_INFO_STORESECRET);
-    return var ? g_variant_get_boolean (var) : FALSE;
+    return info->store_secret;
 }
 
 /**
@@ -673,13 +971,14 @@ gsignond_identity_info_set_store_secret (
 {
     g_return_val_if_fail (info && GSIGNOND_IS_IDENTITY_INFO (info), FALSE);
 
-    if (gsignond_identity_info_get_store_secret (info) == store_secret)
+    store_secret = !!store_secret;
+    if (info->store_secret == store_secret)
         return TRUE;
 
-    return gsignond_dictionary_set (info->map,
-                GSIGNOND_IDENTITY_INFO_STORESECRET,
-                g_variant_new_boolean(store_secret)) &&
-           gsignond_identity_info_set_edit_flags (info,
+    info->store_secret = store_secret;
+    info->props |= IDENTITY_INFO_PROP_STORE_SECRET;
+
+    return gsignond_identity_info_set_edit_flags (info,
                 IDENTITY_INFO_PROP_STORE_SECRET);
 }
 
@@ -696,9 +995,7 @@ gsignond_identity_info_get_caption (GSignondIdentityInfo *info)
 {
     g_return_val_if_fail (info && GSIGNOND_IS_IDENTITY_INFO (info), NULL);
 
-    GVariant *var = gsignond_dictionary_get (info->map,
-                        GSIGNOND_IDENTITY_INFO_CAPTION);
-    return var ? g_variant_get_string (var, NULL) : NULL;
+    return info->caption;
 }
 
 /**
@@ -717,22 +1014,17 @@ gsignond_identity_info_set_caption (
         const gchar *caption)
 {
     g_return_val_if_fail (info && GSIGNOND_IS_IDENTITY_INFO (info), FALSE);
-    const gchar *current_caption = 
-        gsignond_identity_info_get_caption (info);
 
-    if (g_strcmp0 (current_caption, caption) == 0)
+    if (g_strcmp0 (info->caption, caption) == 0)
         return TRUE;
 
-    if (!caption) {
-        return gsignond_dictionary_remove (info->map,
-                GSIGNOND_IDENTITY_INFO_CAPTION) &&
-               gsignond_identity_info_set_edit_flags (info,
-                IDENTITY_INFO_PROP_CAPTION);
+    _gsignond_identity_info_clear_prop (info, IDENTITY_INFO_PROP_CAPTION);
+    if (caption) {
+        info->caption = g_strdup (caption);
+        info->props |= IDENTITY_INFO_PROP_CAPTION;
     }
-    return gsignond_dictionary_set (info->map,
-                GSIGNOND_IDENTITY_INFO_CAPTION,
-                g_variant_new_string (caption)) &&
-           gsignond_identity_info_set_edit_flags (info,
+
+    return gsignond_identity_info_set_edit_flags (info,
                 IDENTITY_INFO_PROP_CAPTION);
 }
 
@@ -740,19 +1032,17 @@ gsignond_identity_info_set_caption (
  * gsignond_identity_info_get_realms:
  * @info: instance of #GSignondIdentityInfo
  *
- * Retrieves the realms from the info.
+ * Retrieves the realms from the info, sorted in ascending order.
  *
- * Returns: (transfer full): the realms if successful, NULL Otherwise.
- * when done realms should be freed using g_sequence_free.
+ * Returns: (transfer none): the realms if successful, NULL Otherwise.
+ * The sequence is owned by @info and is valid until the realms are changed.
  */
 GSequence *
 gsignond_identity_info_get_realms (GSignondIdentityInfo *info)
 {
     g_return_val_if_fail (info && GSIGNOND_IS_IDENTITY_INFO (info), NULL);
 
-    GVariant *var = gsignond_dictionary_get (info->map,
-                        GSIGNOND_IDENTITY_INFO_REALMS);
-    return var ? gsignond_variant_to_sequence (var) : NULL;
+    return info->realms;
 }
 
 /**
@@ -770,23 +1060,26 @@ gsignond_identity_info_set_realms (
         GSignondIdentityInfo *info,
         GSequence *realms)
 {
-    g_return_val_if_fail (info && GSIGNOND_IS_IDENTITY_INFO (info), FALSE);
+    GSequence *new_realms = NULL;
 
+    g_return_val_if_fail (info && GSIGNOND_IS_IDENTITY_INFO (info), FALSE);
     g_return_val_if_fail (realms != NULL, FALSE);
-    GVariant *current_realms = gsignond_dictionary_get (info->map,
-                        GSIGNOND_IDENTITY_INFO_REALMS);
-    GVariant *var_realms = gsignond_sequence_to_variant (realms);
 
-    if (current_realms != NULL &&
-        g_variant_equal (current_realms, var_realms) == TRUE) {
-        g_variant_unref (var_realms);
+    if (realms == info->realms)
+        return TRUE;
+
+    new_realms = _gsignond_identity_info_seq_copy (realms);
+    if (info->realms &&
+        _gsignond_identity_info_seq_cmp (info->realms, new_realms)) {
+        g_sequence_free (new_realms);
         return TRUE;
     }
 
-    return gsignond_dictionary_set (info->map,
-                GSIGNOND_IDENTITY_INFO_REALMS,
-                var_realms) &&
-           gsignond_identity_info_set_edit_flags (info,
+    _gsignond_identity_info_clear_prop (info, IDENTITY_INFO_PROP_REALMS);
+    info->realms = new_realms;
+    info->props |= IDENTITY_INFO_PROP_REALMS;
+
+    return gsignond_identity_info_set_edit_flags (info,
                 IDENTITY_INFO_PROP_REALMS);
 }
 
@@ -795,39 +1088,17 @@ gsignond_identity_info_set_realms (
  * @info: instance of #GSignondIdentityInfo
  *
  * Retrieves the methods from the info whereas #GHashTable consists of
- * (gchar*,GSequence*) and #GSequence is a sequence of gchar *.
+ * (gchar*,GSequence*) and #GSequence is a sorted sequence of gchar *.
  *
- * Returns: (transfer full): the methods if successful, NULL otherwise.
- * when done, methods should be freed using g_hash_table_unref.
+ * Returns: (transfer none): the methods if successful, NULL otherwise.
+ * The table is owned by @info; use g_hash_table_ref to keep it around.
  */
 GHashTable *
 gsignond_identity_info_get_methods (GSignondIdentityInfo *info)
 {
     g_return_val_if_fail (info && GSIGNOND_IS_IDENTITY_INFO (info), NULL);
 
-    GHashTable *methods = NULL;
-    GVariant *var = gsignond_dictionary_get (info->map,
-                        GSIGNOND_IDENTITY_INFO_AUTHMETHODS);
-    if (var != NULL) {
-        GVariantIter iter;
-        gchar *vmethod;
-        gchar **vmechanisms = NULL;
-        GSequence *seq = NULL;
-
-        methods = g_hash_table_new_full ((GHashFunc) g_str_hash,
-                                         (GEqualFunc) g_str_equal,
-                                         (GDestroyNotify) g_free,
-                                         (GDestroyNotify) g_sequence_free);
-
-        g_variant_iter_init (&iter, var);
-        while (g_variant_iter_next (&iter, "{s^as}", &vmethod, &vmechanisms))
-        {
-            /* ownership is transferred */
-            seq = gsignond_array_to_sequence (vmechanisms);
-            g_hash_table_insert (methods, vmethod, seq);
-        }
-    }
-    return methods;
+    return info->methods;
 }
 
 /**
@@ -846,44 +1117,27 @@ gsignond_identity_info_set_methods (
         GSignondIdentityInfo *info,
         GHashTable *methods)
 {
-    g_return_val_if_fail (info && GSIGNOND_IS_IDENTITY_INFO (info), FALSE);
-
-    gchar **items = NULL;
-    GVariantBuilder builder;
-    GVariant *current_mehtods, *var_methods;
-
-    GHashTableIter iter;
-    const gchar *method;
-    GSequence *mechanisms = NULL;
+    GHashTable *new_methods = NULL;
 
-    g_return_val_if_fail (info != NULL, FALSE);
+    g_return_val_if_fail (info && GSIGNOND_IS_IDENTITY_INFO (info), FALSE);
     g_return_val_if_fail (methods != NULL, FALSE);
 
-    g_variant_builder_init (&builder, (const GVariantType *)"a{sas}");
-    g_hash_table_iter_init (&iter, methods);
-    while (g_hash_table_iter_next (&iter,
-                                   (gpointer)&method,
-                                   (gpointer)&mechanisms))
-    {
-        items = gsignond_sequence_to_array (mechanisms);
-        g_variant_builder_add (&builder, "{s^as}", method, items);
-        g_free (items);
-    }
-
-    var_methods = g_variant_builder_end (&builder);
-    current_mehtods = gsignond_dictionary_get (info->map,
-                        GSIGNOND_IDENTITY_INFO_AUTHMETHODS);
+    if (methods == info->methods)
+        return TRUE;
 
-    if (current_mehtods != NULL &&
-        g_variant_equal (current_mehtods, var_methods) == TRUE) {
-        g_variant_unref (var_methods);
+    new_methods = _gsignond_identity_info_methods_copy (methods);
+    if (info->methods &&
+        _gsignond_identity_info_methods_cmp (info->methods, new_methods)) {
+        g_hash_table_unref (new_methods);
         return TRUE;
     }
 
-    return gsignond_dictionary_set (info->map,
-                GSIGNOND_IDENTITY_INFO_AUTHMETHODS,
-                var_methods) &&
-           gsignond_identity_info_set_edit_flags (info,
+    _gsignond_identity_info_clear_prop (info, IDENTITY_INFO_PROP_METHODS);
+    info->methods = new_methods;
+    info->props |= IDENTITY_INFO_PROP_METHODS;
+    _bump_methods_generation (info);
+
+    return gsignond_identity_info_set_edit_flags (info,
                 IDENTITY_INFO_PROP_METHODS);
 }
 
@@ -895,9 +1149,8 @@ gsignond_identity_info_set_methods (
  *
  * Retrieves the mechanisms from the info.
  *
- * Returns: (transfer full): the mechanisms if successful, NULL otherwise.
- * when done, mechanisms should be freed using g_sequence_free; #GSequence is a
- * sequence of gchar *.
+ * Returns: (transfer none): the mechanisms if successful, NULL otherwise;
+ * #GSequence is a sorted sequence of gchar * owned by @info.
  */
 GSequence *
 gsignond_identity_info_get_mechanisms (
@@ -905,33 +1158,9 @@ gsignond_identity_info_get_mechanisms (
         const gchar *method)
 {
     g_return_val_if_fail (info && GSIGNOND_IS_IDENTITY_INFO (info), NULL);
-
-    GVariant *var = NULL;
-    GSequence *mechanisms = NULL;
-
     g_return_val_if_fail (method != NULL, NULL);
 
-    var = gsignond_dictionary_get (info->map,
-                GSIGNOND_IDENTITY_INFO_AUTHMETHODS);
-    if (var != NULL) {
-        GVariantIter iter;
-        gchar *vmethod;
-        gchar **vmechanisms;
-
-        g_variant_iter_init (&iter, var);
-        while (g_variant_iter_next (&iter, "{s^as}", &vmethod, &vmechanisms))
-        {
-            /* ownership is transferred */
-            if (vmethod != NULL && g_strcmp0 (vmethod, method) == 0) {
-                mechanisms = gsignond_array_to_sequence (vmechanisms);
-                g_free (vmethod);
-                break;
-            }
-            g_free (vmethod); vmethod = NULL;
-            g_strfreev (vmechanisms); vmechanisms = NULL;
-        }
-    }
-    return mechanisms;
+    return info->methods ? g_hash_table_lookup (info->methods, method) : NULL;
 }
 
 /**
@@ -948,19 +1177,14 @@ gsignond_identity_info_remove_method (
         const gchar *method)
 {
     g_return_val_if_fail (info && GSIGNOND_IS_IDENTITY_INFO (info), FALSE);
-
-    GHashTable *methods = NULL;
-    gboolean ret = FALSE;
-
     g_return_val_if_fail (method != NULL, FALSE);
 
-    methods = gsignond_identity_info_get_methods (info);
-    if (methods && g_hash_table_remove (methods, method)) {
-        ret = gsignond_identity_info_set_methods (info, methods);
-    }
-    if (methods)
-        g_hash_table_unref (methods);
-    return ret;
+    if (!info->methods || !g_hash_table_remove (info->methods, method))
+        return FALSE;
+    _bump_methods_generation (info);
+
+    return gsignond_identity_info_set_edit_flags (info,
+                IDENTITY_INFO_PROP_METHODS);
 }
 
 /**
@@ -969,17 +1193,15 @@ gsignond_identity_info_remove_method (
  *
  * Retrieves the access control list from the info.
  *
- * Returns: (transfer full): the list if successful, NULL otherwise.
- * when done, list should be freed using gsignond_security_context_list_free.
+ * Returns: (transfer none): the list if successful, NULL otherwise.
+ * The list is owned by @info and is valid until the list is changed.
  */
 GSignondSecurityContextList *
 gsignond_identity_info_get_access_control_list (GSignondIdentityInfo *info)
 {
     g_return_val_if_fail (info && GSIGNOND_IS_IDENTITY_INFO (info), NULL);
 
-    GVariant *var = gsignond_dictionary_get (info->map,
-                        GSIGNOND_IDENTITY_INFO_ACL);
-    return var ? gsignond_security_context_list_from_variant (var) : NULL;
+    return info->acl;
 }
 
 /**
@@ -999,23 +1221,21 @@ gsignond_identity_info_set_access_control_list (
 {
     g_return_val_if_fail (info && GSIGNOND_IS_IDENTITY_INFO (info), FALSE);
 
-    GVariant *current_acl = gsignond_dictionary_get (info->map,
-                              GSIGNOND_IDENTITY_INFO_ACL);
-    GVariant *var_acl = NULL;
+    if (!(info->props & IDENTITY_INFO_PROP_ACL) && !acl) return TRUE;
 
-    if (!current_acl && !acl) return TRUE;
-
-    var_acl = gsignond_security_context_list_to_variant (acl);
-    if (current_acl != NULL &&
-        g_variant_equal (current_acl, var_acl) == TRUE) {
-        g_variant_unref (var_acl);
+    if ((info->props & IDENTITY_INFO_PROP_ACL) &&
+        _gsignond_identity_info_sec_context_list_equal (info->acl,
+                (GSignondSecurityContextList *)acl))
         return TRUE;
-    }
 
     g_return_val_if_fail (acl != NULL, FALSE);
-    return gsignond_dictionary_set (info->map,
-                GSIGNOND_IDENTITY_INFO_ACL, var_acl) &&
-           gsignond_identity_info_set_edit_flags (info,
+
+    _gsignond_identity_info_clear_prop (info, IDENTITY_INFO_PROP_ACL);
+    info->acl = gsignond_security_context_list_copy (acl);
+    info->props |= IDENTITY_INFO_PROP_ACL;
+    _bump_acl_generation (info);
+
+    return gsignond_identity_info_set_edit_flags (info,
                 IDENTITY_INFO_PROP_ACL);
 }
 
@@ -1025,18 +1245,15 @@ gsignond_identity_info_set_access_control_list (
  *
  * Retrieves the id from the info.
  *
- * Returns: (transfer full): the owner if successful, NULL otherwise.
- * when done, owner list should be freed using
- * gsignond_security_context_free.
+ * Returns: (transfer none): the owner if successful, NULL otherwise.
+ * The owner is owned by @info and is valid until the owner is changed.
  */
 GSignondSecurityContext *
 gsignond_identity_info_get_owner (GSignondIdentityInfo *info)
 {
     g_return_val_if_fail (info && GSIGNOND_IS_IDENTITY_INFO (info), NULL);
 
-    GVariant *var = gsignond_dictionary_get (info->map,
-                                             GSIGNOND_IDENTITY_INFO_OWNER);
-    return var ? gsignond_security_context_from_variant (var) : NULL;
+    return info->owner;
 }
 
 /**
@@ -1055,20 +1272,19 @@ gsignond_identity_info_set_owner (
         const GSignondSecurityContext *owner)
 {
     g_return_val_if_fail (info && GSIGNOND_IS_IDENTITY_INFO (info), FALSE);
-
     g_return_val_if_fail (owner != NULL, FALSE);
-    GSignondSecurityContext *current_owner = 
-        gsignond_identity_info_get_owner (info);
 
-    if (current_owner != NULL &&
-        gsignond_security_context_compare (current_owner, owner) == 0)
+    if (info->owner != NULL &&
+        gsignond_security_context_compare (info->owner, owner) == 0)
         return TRUE;
 
-    return (gsignond_dictionary_set (info->map,
-                                     GSIGNOND_IDENTITY_INFO_OWNER,
-                                     gsignond_security_context_to_variant (owner)) &&
-            gsignond_identity_info_set_edit_flags (info,
-                                                   IDENTITY_INFO_PROP_OWNER));
+    _gsignond_identity_info_clear_prop (info, IDENTITY_INFO_PROP_OWNER);
+    info->owner = gsignond_security_context_copy (owner);
+    info->props |= IDENTITY_INFO_PROP_OWNER;
+    _bump_acl_generation (info);
+
+    return gsignond_identity_info_set_edit_flags (info,
+                IDENTITY_INFO_PROP_OWNER);
 }
 
 /**
@@ -1084,9 +1300,7 @@ gsignond_identity_info_get_validated (GSignondIdentityInfo *info)
 {
     g_return_val_if_fail (info && GSIGNOND_IS_IDENTITY_INFO (info), FALSE);
 
-    GVariant *var = gsignond_dictionary_get (info->map,
-                        GSIGNOND_IDENTITY_INFO_VALIDATED);
-    return var ? g_variant_get_boolean (var) : FALSE;
+    return info->validated;
 }
 
 /**
@@ -1106,13 +1320,14 @@ gsignond_identity_info_set_validated (
 {
     g_return_val_if_fail (info && GSIGNOND_IS_IDENTITY_INFO (info), FALSE);
 
-    if (gsignond_identity_info_get_validated (info) == validated)
+    validated = !!validated;
+    if (info->validated == validated)
         return TRUE;
 
-    return gsignond_dictionary_set (info->map,
-                GSIGNOND_IDENTITY_INFO_VALIDATED,
-                g_variant_new_boolean (validated)) &&
-           gsignond_identity_info_set_edit_flags (info,
+    info->validated = validated;
+    info->props |= IDENTITY_INFO_PROP_VALIDATED;
+
+    return gsignond_identity_info_set_edit_flags (info,
                 IDENTITY_INFO_PROP_VALIDATED);
 }
 
@@ -1129,9 +1344,7 @@ gsignond_identity_info_get_identity_type (GSignondIdentityInfo *info)
 {
     g_return_val_if_fail (info && GSIGNOND_IS_IDENTITY_INFO (info), 0);
 
-    GVariant *var = gsignond_dictionary_get (info->map,
-                        GSIGNOND_IDENTITY_INFO_TYPE);
-    return var ? g_variant_get_int32 (var) : 0;
+    return info->type;
 }
 
 /**
@@ -1151,13 +1364,13 @@ gsignond_identity_info_set_identity_type (
 {
     g_return_val_if_fail (info && GSIGNOND_IS_IDENTITY_INFO (info), FALSE);
 
-    if (gsignond_identity_info_get_identity_type (info) == type)
+    if (info->type == type)
         return TRUE;
 
-    return gsignond_dictionary_set (info->map,
-                GSIGNOND_IDENTITY_INFO_TYPE,
-                g_variant_new_int32 (type)) &&
-           gsignond_identity_info_set_edit_flags (info,
+    info->type = type;
+    info->props |= IDENTITY_INFO_PROP_TYPE;
+
+    return gsignond_identity_info_set_edit_flags (info,
                 IDENTITY_INFO_PROP_TYPE);
 }
 
@@ -1176,13 +1389,7 @@ gsignond_identity_info_compare (
         GSignondIdentityInfo *info,
         GSignondIdentityInfo *other)
 {
-    g_return_val_if_fail (info && GSIGNOND_IS_IDENTITY_INFO (info), FALSE);
-    g_return_val_if_fail (other && GSIGNOND_IS_IDENTITY_INFO (other), FALSE);
-
-    GSequence *info_realms = NULL, *other_realms = NULL;
-    GHashTable *info_methods = NULL, *other_methods = NULL;
-    GSignondSecurityContextList *info_acl = NULL, *other_acl = NULL;
-    GSignondSecurityContext *info_owner = NULL, *other_owner = NULL;
+    GList *info_acl = NULL, *other_acl = NULL;
     gboolean equal = FALSE;
 
     if (info == other)
@@ -1196,77 +1403,39 @@ gsignond_identity_info_compare (
         return FALSE;
     }
 
-    if (g_strcmp0 (gsignond_identity_info_get_username (info),
-        gsignond_identity_info_get_username (other)) != 0) {
-        return FALSE;
-    }
-
-    if (g_strcmp0 (gsignond_identity_info_get_secret (info),
-        gsignond_identity_info_get_secret (other)) != 0) {
-        return FALSE;
-    }
-
-    if (gsignond_identity_info_get_store_secret (info) !=
-        gsignond_identity_info_get_store_secret (other)) {
-        return FALSE;
-    }
-
-    if (g_strcmp0 (gsignond_identity_info_get_caption (info),
-        gsignond_identity_info_get_caption (other)) != 0) {
+    if (g_strcmp0 (info->username, other->username) != 0 ||
+        g_strcmp0 (info->secret, other->secret) != 0 ||
+        info->store_secret != other->store_secret ||
+        g_strcmp0 (info->caption, other->caption) != 0) {
         return FALSE;
     }
 
-    info_realms = gsignond_identity_info_get_realms (info);
-    other_realms = gsignond_identity_info_get_realms (other);
-    equal = _gsignond_identity_info_seq_cmp (info_realms, other_realms);
-    if (info_realms) g_sequence_free (info_realms);
-    if (other_realms) g_sequence_free (other_realms);
-    if (!equal) {
+    if (!_gsignond_identity_info_seq_cmp (info->realms, other->realms)) {
         return FALSE;
     }
 
-    info_methods = gsignond_identity_info_get_methods (info);
-    other_methods = gsignond_identity_info_get_methods (other);
-    equal = _gsignond_identity_info_methods_cmp (info_methods, other_methods);
-    if (info_methods) g_hash_table_unref (info_methods);
-    if (other_methods) g_hash_table_unref (other_methods);
-    if (!equal) {
+    if (!_gsignond_identity_info_methods_cmp (info->methods, other->methods)) {
         return FALSE;
     }
 
-    info_acl = gsignond_identity_info_get_access_control_list (info);
-    if (info_acl)
-        info_acl = g_list_sort (
-                        info_acl,
-                        (GCompareFunc)gsignond_security_context_compare);
-    other_acl = gsignond_identity_info_get_access_control_list (other);
-    if (other_acl)
-        other_acl = g_list_sort (
-                        other_acl,
-                        (GCompareFunc)gsignond_security_context_compare);
+    /* ACL order is not significant; sort shallow copies */
+    info_acl = g_list_sort (g_list_copy (info->acl),
+                            (GCompareFunc)gsignond_security_context_compare);
+    other_acl = g_list_sort (g_list_copy (other->acl),
+                             (GCompareFunc)gsignond_security_context_compare);
     equal = _gsignond_identity_info_sec_context_list_cmp (info_acl, other_acl);
-    if (info_acl) gsignond_security_context_list_free (info_acl);
-    if (other_acl) gsignond_security_context_list_free (other_acl);
-    if (!equal) {
-        return FALSE;
-    }
-
-    info_owner = gsignond_identity_info_get_owner (info);
-    other_owner = gsignond_identity_info_get_owner (other);
-    equal = gsignond_security_context_match (info_owner, other_owner);
-    if (info_owner) gsignond_security_context_free (info_owner);
-    if (other_owner) gsignond_security_context_free (other_owner);
+    g_list_free (info_acl);
+    g_list_free (other_acl);
     if (!equal) {
         return FALSE;
     }
 
-    if (gsignond_identity_info_get_validated (info) !=
-        gsignond_identity_info_get_validated (other)) {
+    if (!gsignond_security_context_match (info->owner, other->owner)) {
         return FALSE;
     }
 
-    if (gsignond_identity_info_get_identity_type (info) !=
-        gsignond_identity_info_get_identity_type (other)) {
+    if (info->validated != other->validated ||
+        info->type != other->type) {
         return FALSE;
     }
 
@@ -1277,36 +1446,91 @@ gsignond_identity_info_compare (
  * gsignond_identity_info_to_variant:
  * @info: instance of #GSignondIdentityInfo
  *
- * Converts the #GSignondIndentityInfo to a #GVariant.
+ * Converts the #GSignondIndentityInfo to a #GVariant. The secret is never
+ * included; the username is included only if it is not marked secret.
  *
  * Returns: (transfer full): #GVariant object if successful, NULL otherwise.
  */
 GVariant *
 gsignond_identity_info_to_variant (GSignondIdentityInfo *info)
 {
-    gboolean username_is_secret ;
+    GVariantBuilder builder;
+    GSignondIdentityInfoPropFlags props;
 
     g_return_val_if_fail (info && GSIGNOND_IS_IDENTITY_INFO (info), NULL);
 
-    username_is_secret = gsignond_identity_info_get_is_username_secret (info);
-
-    if (username_is_secret)
-        return gsignond_dictionary_to_variant (info->map);
-    else {
-        GVariant *vdict = NULL;
-        GVariantBuilder *builder = 
-                gsignond_dictionary_to_variant_builder (info->map);
-        if (!builder) return NULL;
+    props = info->props;
+    g_variant_builder_init (&builder, G_VARIANT_TYPE_VARDICT);
+
+    if (props & IDENTITY_INFO_PROP_ID)
+        g_variant_builder_add (&builder, "{sv}", GSIGNOND_IDENTITY_INFO_ID,
+                g_variant_new_uint32 (info->id));
+    if (props & IDENTITY_INFO_PROP_TYPE)
+        g_variant_builder_add (&builder, "{sv}", GSIGNOND_IDENTITY_INFO_TYPE,
+                g_variant_new_int32 ((gint32) info->type));
+    if (props & IDENTITY_INFO_PROP_CAPTION)
+        g_variant_builder_add (&builder, "{sv}", GSIGNOND_IDENTITY_INFO_CAPTION,
+                g_variant_new_string (info->caption));
+    if (props & IDENTITY_INFO_PROP_STORE_SECRET)
+        g_variant_builder_add (&builder, "{sv}",
+                GSIGNOND_IDENTITY_INFO_STORESECRET,
+                g_variant_new_boolean (info->store_secret));
+    if (props & IDENTITY_INFO_PROP_USERNAME_IS_SECRET)
+        g_variant_builder_add (&builder, "{sv}",
+                GSIGNOND_IDENTITY_INFO_USERNAME_IS_SECRET,
+                g_variant_new_boolean (info->username_is_secret));
+    if (props & IDENTITY_INFO_PROP_OWNER)
+        g_variant_builder_add (&builder, "{sv}", GSIGNOND_IDENTITY_INFO_OWNER,
+                gsignond_security_context_to_variant (info->owner));
+    if (props & IDENTITY_INFO_PROP_ACL)
+        g_variant_builder_add (&builder, "{sv}", GSIGNOND_IDENTITY_INFO_ACL,
+                info->acl ? gsignond_security_context_list_to_variant (info->acl)
+                          : g_variant_new_array (G_VARIANT_TYPE ("(ss)"),
+                                                 NULL, 0));
+    if (props & IDENTITY_INFO_PROP_METHODS) {
+        GVariantBuilder methods;
+        GHashTableIter iter;
+        const gchar *method = NULL;
+        GSequence *mechanisms = NULL;
+
+        g_variant_builder_init (&methods, (const GVariantType *)"a{sas}");
+        g_hash_table_iter_init (&iter, info->methods);
+        while (g_hash_table_iter_next (&iter, (gpointer *)&method,
+                                       (gpointer *)&mechanisms)) {
+            g_variant_builder_add (&methods, "{s@as}", method,
+                    gsignond_sequence_to_variant (mechanisms));
+        }
+        g_variant_builder_add (&builder, "{sv}",
+                GSIGNOND_IDENTITY_INFO_AUTHMETHODS,
+                g_variant_builder_end (&methods));
+    }
+    if (props & IDENTITY_INFO_PROP_REALMS)
+        g_variant_builder_add (&builder, "{sv}", GSIGNOND_IDENTITY_INFO_REALMS,
+                gsignond_sequence_to_variant (info->realms));
+    if (props & IDENTITY_INFO_PROP_REF_COUNT)
+        g_variant_builder_add (&builder, "{sv}", GSIGNOND_IDENTITY_INFO_REFCOUNT,
+                info->refcount);
+    if (props & IDENTITY_INFO_PROP_VALIDATED)
+        g_variant_builder_add (&builder, "{sv}",
+                GSIGNOND_IDENTITY_INFO_VALIDATED,
+                g_variant_new_boolean (info->validated));
 
-        g_variant_builder_add (builder, "{sv}", GSIGNOND_IDENTITY_INFO_USERNAME,
+    if (!info->username_is_secret)
+        g_variant_builder_add (&builder, "{sv}", GSIGNOND_IDENTITY_INFO_USERNAME,
                 g_variant_new_string (info->username ? info->username : ""));
 
-        vdict = g_variant_builder_end (builder);
-
-        g_variant_builder_unref (builder);
+    if (info->extra) {
+        GHashTableIter iter;
+        const gchar *key = NULL;
+        GVariant *value = NULL;
 
-        return vdict;
+        g_hash_table_iter_init (&iter, info->extra);
+        while (g_hash_table_iter_next (&iter, (gpointer *)&key,
+                                       (gpointer *)&value))
+            g_variant_builder_add (&builder, "{sv}", key, value);
     }
+
+    return g_variant_builder_end (&builder);
 }
 
 void
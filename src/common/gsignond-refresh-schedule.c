@@ -0,0 +1,247 @@
+/* vi: set et sw=4 ts=4 cino=t0,(0: */
+/* -*- Mode: C; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This file is part of gsignond
+ *
+ * Copyright (C) 2014 Intel Corporation.
+ *
+ * Contact: Imran Zaman <imran.zaman@intel.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ */
+
+#include "gsignond/gsignond-log.h"
+#include "gsignond-refresh-schedule.h"
+#include "gsignond-timer-wheel.h"
+
+/**
+ * SECTION:gsignond-refresh-schedule
+ * @short_description: pending refreshes of tokens, one per key
+ *
+ * #GSignondRefreshSchedule keeps at most one pending refresh per key, such
+ * as an auth session, on a #GSignondTimerWheel. Refreshes are grouped by
+ * an owner, such as the identity of the session, so that all refreshes of
+ * an owner can be cancelled at once. A key keeps its entry after its
+ * refresh fired, until it is scheduled again or removed, so that a token
+ * that keeps coming back short-lived is refreshed only a limited number of
+ * times in a row.
+ */
+
+typedef struct {
+    GSignondRefreshSchedule *schedule;
+    gpointer key;
+    gpointer owner;
+    guint timer_id; /* 0 once fired */
+    guint n_short; /* refreshes in a row at the minimum delay */
+} GSignondRefreshEntry;
+
+struct _GSignondRefreshSchedule
+{
+    GSignondTimerWheel *wheel;
+    GHashTable *entries; /* key -> GSignondRefreshEntry */
+    guint min_delay_ms;
+    guint max_short;
+    GSignondRefreshFunc func;
+    gpointer user_data;
+};
+
+static void
+_entry_free (GSignondRefreshEntry *entry)
+{
+    if (entry->timer_id)
+        gsignond_timer_wheel_remove (entry->schedule->wheel, entry->timer_id);
+    g_slice_free (GSignondRefreshEntry, entry);
+}
+
+static void
+_on_timer (gpointer user_data)
+{
+    GSignondRefreshEntry *entry = (GSignondRefreshEntry *) user_data;
+    GSignondRefreshSchedule *schedule = entry->schedule;
+
+    entry->timer_id = 0;
+    schedule->func (entry->key, entry->owner, schedule->user_data);
+}
+
+/**
+ * gsignond_refresh_schedule_new:
+ * @tick_ms: resolution of the refresh times in milliseconds
+ * @min_delay_ms: refreshes are never sooner than this
+ * @max_short: number of refreshes in a row at @min_delay_ms after which
+ * a key is no longer refreshed
+ * @func: called with the key and owner of each refresh that is due
+ * @user_data: data for @func
+ *
+ * Returns: (transfer full): a new #GSignondRefreshSchedule.
+ */
+GSignondRefreshSchedule *
+gsignond_refresh_schedule_new (
+        guint tick_ms,
+        guint min_delay_ms,
+        guint max_short,
+        GSignondRefreshFunc func,
+        gpointer user_data)
+{
+    GSignondRefreshSchedule *schedule;
+
+    g_return_val_if_fail (tick_ms > 0 && func, NULL);
+
+    schedule = g_slice_new0 (GSignondRefreshSchedule);
+    schedule->wheel = gsignond_timer_wheel_new (tick_ms, 64);
+    schedule->entries = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+            NULL, (GDestroyNotify) _entry_free);
+    schedule->min_delay_ms = min_delay_ms;
+    schedule->max_short = max_short;
+    schedule->func = func;
+    schedule->user_data = user_data;
+
+    return schedule;
+}
+
+/**
+ * gsignond_refresh_schedule_free:
+ * @schedule: a #GSignondRefreshSchedule
+ *
+ * Drops the pending refreshes without running them, and frees @schedule.
+ */
+void
+gsignond_refresh_schedule_free (GSignondRefreshSchedule *schedule)
+{
+    if (!schedule)
+        return;
+
+    g_hash_table_unref (schedule->entries);
+    gsignond_timer_wheel_free (schedule->wheel);
+    g_slice_free (GSignondRefreshSchedule, schedule);
+}
+
+/**
+ * gsignond_refresh_schedule_add:
+ * @schedule: a #GSignondRefreshSchedule
+ * @key: what to refresh
+ * @owner: what @key belongs to
+ * @delay_ms: time until the refresh, raised to the minimum delay
+ *
+ * Schedules a refresh of @key, replacing the one pending for it.
+ *
+ * Returns: TRUE if the refresh was scheduled, FALSE if @key was refreshed
+ * at the minimum delay too many times in a row; its entry is then dropped.
+ */
+gboolean
+gsignond_refresh_schedule_add (
+        GSignondRefreshSchedule *schedule,
+        gpointer key,
+        gpointer owner,
+        gint64 delay_ms)
+{
+    GSignondRefreshEntry *entry;
+    gboolean is_short;
+
+    g_return_val_if_fail (schedule && key, FALSE);
+
+    entry = g_hash_table_lookup (schedule->entries, key);
+    if (entry && entry->timer_id) {
+        gsignond_timer_wheel_remove (schedule->wheel, entry->timer_id);
+        entry->timer_id = 0;
+    }
+
+    is_short = delay_ms <= schedule->min_delay_ms;
+    if (is_short && entry && entry->n_short >= schedule->max_short) {
+        DBG ("not refreshing %p again, it was refreshed %u times in a row",
+             key, entry->n_short);
+        g_hash_table_remove (schedule->entries, key);
+        return FALSE;
+    }
+
+    if (!entry) {
+        entry = g_slice_new0 (GSignondRefreshEntry);
+        entry->schedule = schedule;
+        entry->key = key;
+        g_hash_table_insert (schedule->entries, key, entry);
+    }
+    entry->owner = owner;
+    entry->n_short = is_short ? entry->n_short + 1 : 0;
+    entry->timer_id = gsignond_timer_wheel_add (schedule->wheel,
+            (guint) CLAMP (delay_ms, schedule->min_delay_ms, G_MAXUINT),
+            _on_timer, entry, NULL);
+
+    return TRUE;
+}
+
+/**
+ * gsignond_refresh_schedule_remove:
+ * @schedule: a #GSignondRefreshSchedule
+ * @key: what not to refresh
+ *
+ * Cancels the refresh of @key and forgets about it.
+ *
+ * Returns: TRUE if @key had an entry.
+ */
+gboolean
+gsignond_refresh_schedule_remove (
+        GSignondRefreshSchedule *schedule,
+        gpointer key)
+{
+    g_return_val_if_fail (schedule, FALSE);
+
+    return g_hash_table_remove (schedule->entries, key);
+}
+
+static gboolean
+_entry_has_owner (gpointer key, gpointer value, gpointer user_data)
+{
+    return ((GSignondRefreshEntry *) value)->owner == user_data;
+}
+
+/**
+ * gsignond_refresh_schedule_remove_owner:
+ * @schedule: a #GSignondRefreshSchedule
+ * @owner: owner of the keys not to refresh
+ *
+ * Cancels the refreshes of every key of @owner.
+ *
+ * Returns: the number of entries removed.
+ */
+guint
+gsignond_refresh_schedule_remove_owner (
+        GSignondRefreshSchedule *schedule,
+        gpointer owner)
+{
+    g_return_val_if_fail (schedule, 0);
+
+    return g_hash_table_foreach_remove (schedule->entries, _entry_has_owner,
+                                        owner);
+}
+
+/**
+ * gsignond_refresh_schedule_is_pending:
+ * @schedule: a #GSignondRefreshSchedule
+ * @key: what may be refreshed
+ *
+ * Returns: TRUE if a refresh of @key is waiting to fire.
+ */
+gboolean
+gsignond_refresh_schedule_is_pending (
+        GSignondRefreshSchedule *schedule,
+        gpointer key)
+{
+    GSignondRefreshEntry *entry;
+
+    g_return_val_if_fail (schedule, FALSE);
+
+    entry = g_hash_table_lookup (schedule->entries, key);
+    return entry && entry->timer_id != 0;
+}
@@ -0,0 +1,75 @@
+/* vi: set et sw=4 ts=4 cino=t0,(0: */
+/* -*- Mode: C; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This file is part of gsignond
+ *
+ * Copyright (C) 2014 Intel Corporation.
+ *
+ * Contact: Imran Zaman <imran.zaman@intel.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ */
+
+#ifndef __GSIGNOND_REFRESH_SCHEDULE_H__
+#define __GSIGNOND_REFRESH_SCHEDULE_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef struct _GSignondRefreshSchedule GSignondRefreshSchedule;
+
+typedef void (*GSignondRefreshFunc) (
+        gpointer key,
+        gpointer owner,
+        gpointer user_data);
+
+GSignondRefreshSchedule *
+gsignond_refresh_schedule_new (
+        guint tick_ms,
+        guint min_delay_ms,
+        guint max_short,
+        GSignondRefreshFunc func,
+        gpointer user_data);
+
+void
+gsignond_refresh_schedule_free (GSignondRefreshSchedule *schedule);
+
+gboolean
+gsignond_refresh_schedule_add (
+        GSignondRefreshSchedule *schedule,
+        gpointer key,
+        gpointer owner,
+        gint64 delay_ms);
+
+gboolean
+gsignond_refresh_schedule_remove (
+        GSignondRefreshSchedule *schedule,
+        gpointer key);
+
+guint
+gsignond_refresh_schedule_remove_owner (
+        GSignondRefreshSchedule *schedule,
+        gpointer owner);
+
+gboolean
+gsignond_refresh_schedule_is_pending (
+        GSignondRefreshSchedule *schedule,
+        gpointer key);
+
+G_END_DECLS
+
+#endif /* __GSIGNOND_REFRESH_SCHEDULE_H__ */
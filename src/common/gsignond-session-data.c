@@ -62,6 +62,18 @@
  * Policy setting to define how plugins should handle interaction with the user.
  */
 
+/**
+ * GSignondProcessPriority:
+ * @GSIGNOND_PROCESS_PRIORITY_BACKGROUND: the request is made by a background
+ * job, such as a token refresh or a synchronization
+ * @GSIGNOND_PROCESS_PRIORITY_NORMAL: the default priority
+ * @GSIGNOND_PROCESS_PRIORITY_INTERACTIVE: the request is made for a user
+ * waiting on it, such as a login in the foreground
+ * 
+ * Priority of a process request over the other requests waiting for a plugin
+ * of the same type.
+ */
+
 /**
  * gsignond_session_data_get_username:
  * @data: a #GSignondDictionary structure
@@ -372,3 +384,148 @@ gsignond_session_data_set_window_id (GSignondSessionData *data,
     gsignond_dictionary_set_uint32 (data, "WindowId", window_id);
 }
 
+
+/**
+ * gsignond_session_data_get_process_timeout:
+ * @data: a #GSignondDictionary structure
+ * @process_timeout: the value for the parameter is written here
+ * 
+ * A getter for the time in milliseconds that the daemon is allowed to spend
+ * on a process request, including the time the request is queued.
+ * 
+ * Returns: whether the key-value pair exists in the @data dictionary or not.
+ */
+gboolean
+gsignond_session_data_get_process_timeout (GSignondSessionData *data,
+                                           guint32 *process_timeout)
+{
+    return gsignond_dictionary_get_uint32 (data, "ProcessTimeout",
+                                           process_timeout);
+}
+
+/**
+ * gsignond_session_data_set_process_timeout:
+ * @data: a #GSignondDictionary structure
+ * @process_timeout: process timeout to use, in milliseconds
+ * 
+ * A setter for the time in milliseconds that the daemon is allowed to spend
+ * on a process request. Once it passes, the request fails with
+ * #GSIGNOND_ERROR_TIMED_OUT, and a plugin still working on it is cancelled,
+ * or stopped if it does not react. A timeout of 0 means no limit.
+ */
+void
+gsignond_session_data_set_process_timeout (GSignondSessionData *data,
+                                           guint32 process_timeout)
+{
+    gsignond_dictionary_set_uint32 (data, "ProcessTimeout",
+                                    process_timeout);
+}
+
+/**
+ * gsignond_session_data_get_process_priority:
+ * @data: a #GSignondDictionary structure
+ * @priority: the value for the parameter is written here
+ * 
+ * A getter for the priority of the process request over the other requests
+ * waiting for a plugin of the same type.
+ * 
+ * Returns: whether the key-value pair exists in the @data dictionary or not.
+ */
+gboolean
+gsignond_session_data_get_process_priority (GSignondSessionData *data,
+                                            GSignondProcessPriority *priority)
+{
+    return gsignond_dictionary_get_uint32 (data, "ProcessPriority", priority);
+}
+
+/**
+ * gsignond_session_data_set_process_priority:
+ * @data: a #GSignondDictionary structure
+ * @priority: priority to use
+ * 
+ * A setter for the priority of the process request. Requests waiting for a
+ * plugin are served by priority, and gain priority the longer they wait. If
+ * this property is not set, requests with #GSIGNOND_UI_POLICY_NO_USER_INTERACTION
+ * have #GSIGNOND_PROCESS_PRIORITY_BACKGROUND, and the others
+ * #GSIGNOND_PROCESS_PRIORITY_NORMAL. Priorities above
+ * #GSIGNOND_PROCESS_PRIORITY_NORMAL are kept for requests the daemon makes
+ * itself, those of client requests are lowered to it.
+ */
+void
+gsignond_session_data_set_process_priority (GSignondSessionData *data,
+                                            GSignondProcessPriority priority)
+{
+    gsignond_dictionary_set_uint32 (data, "ProcessPriority", priority);
+}
+
+/**
+ * gsignond_session_data_get_cache_ttl:
+ * @data: a #GSignondDictionary structure
+ * @cache_ttl: the value for the parameter is written here
+ * 
+ * A getter for the time in seconds a final response of a plugin may be
+ * reused for.
+ * 
+ * Returns: whether the key-value pair exists in the @data dictionary or not.
+ */
+gboolean
+gsignond_session_data_get_cache_ttl (GSignondSessionData *data,
+                                     guint32 *cache_ttl)
+{
+    return gsignond_dictionary_get_uint32 (data, "CacheTtl", cache_ttl);
+}
+
+/**
+ * gsignond_session_data_set_cache_ttl:
+ * @data: a #GSignondDictionary structure
+ * @cache_ttl: time in seconds to cache the response for
+ * 
+ * A setter for the time in seconds a response may be reused for. Plugins
+ * set it on the data passed to gsignond_plugin_response_final(), when the
+ * response, such as a still valid access token, can answer identical
+ * requests for a while. The daemon then answers these requests itself,
+ * until the time passes or the identity or its tokens are changed. The key
+ * is removed from the response before it reaches the client, and from
+ * client requests before they reach the plugin.
+ */
+void
+gsignond_session_data_set_cache_ttl (GSignondSessionData *data,
+                                     guint32 cache_ttl)
+{
+    gsignond_dictionary_set_uint32 (data, "CacheTtl", cache_ttl);
+}
+
+/**
+ * gsignond_session_data_get_token_expiry:
+ * @data: a #GSignondDictionary structure
+ * @expiry: the value for the parameter is written here
+ * 
+ * A getter for the time the token stored by a plugin expires, in seconds
+ * since the Epoch.
+ * 
+ * Returns: whether the key-value pair exists in the @data dictionary or not.
+ */
+gboolean
+gsignond_session_data_get_token_expiry (GSignondSessionData *data,
+                                        gint64 *expiry)
+{
+    return gsignond_dictionary_get_int64 (data, "TokenExpiry", expiry);
+}
+
+/**
+ * gsignond_session_data_set_token_expiry:
+ * @data: a #GSignondDictionary structure
+ * @expiry: expiry time in seconds since the Epoch
+ * 
+ * A setter for the time the token stored by a plugin expires. Plugins set
+ * it on the data passed to gsignond_plugin_store(). Shortly before that
+ * time, the daemon repeats the request that stored the token in the
+ * background, without user interaction, so that the plugin can refresh
+ * the token before applications need it.
+ */
+void
+gsignond_session_data_set_token_expiry (GSignondSessionData *data,
+                                        gint64 expiry)
+{
+    gsignond_dictionary_set_int64 (data, "TokenExpiry", expiry);
+}
@@ -0,0 +1,284 @@
+/* vi: set et sw=4 ts=4 cino=t0,(0: */
+/* -*- Mode: C; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This file is part of gsignond
+ *
+ * Copyright (C) 2014 Intel Corporation.
+ *
+ * Contact: Imran Zaman <imran.zaman@intel.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ */
+
+
+#include "gsignond/gsignond-log.h"
+#include "gsignond-timer-wheel.h"
+
+/**
+ * SECTION:gsignond-timer-wheel
+ * @short_description: coarse timers for many long running timeouts
+ *
+ * #GSignondTimerWheel keeps timers in a ring of slots, one slot per tick.
+ * A single main loop source advances the ring while there are timers, so
+ * the cost of a timer does not depend on how many others are pending.
+ * Timers fire on a tick boundary, up to one tick late, which suits
+ * timeouts of minutes or hours, such as token refreshes.
+ */
+
+typedef struct {
+    guint id;
+    guint slot;
+    guint rounds; /* revolutions of the ring left before firing */
+    gboolean firing;
+    gboolean removed;
+    GSignondTimerWheelFunc func;
+    gpointer user_data;
+    GDestroyNotify notify;
+} GSignondTimerWheelEntry;
+
+struct _GSignondTimerWheel
+{
+    guint tick_ms;
+    guint n_slots;
+    GList **slots;
+    guint cursor;
+    gint64 last_tick; /* monotonic time the cursor was last advanced */
+    GHashTable *entries; /* id -> GSignondTimerWheelEntry */
+    guint last_id;
+    guint source_id;
+};
+
+static void
+_entry_free (GSignondTimerWheelEntry *entry)
+{
+    if (entry->notify)
+        entry->notify (entry->user_data);
+    g_slice_free (GSignondTimerWheelEntry, entry);
+}
+
+static void
+_advance (GSignondTimerWheel *wheel, GQueue *due)
+{
+    GList *slot, *link;
+
+    wheel->cursor = (wheel->cursor + 1) % wheel->n_slots;
+    slot = wheel->slots[wheel->cursor];
+    wheel->slots[wheel->cursor] = NULL;
+
+    for (link = slot; link; link = link->next) {
+        GSignondTimerWheelEntry *entry = link->data;
+        if (entry->rounds > 0) {
+            entry->rounds--;
+            wheel->slots[wheel->cursor] =
+                g_list_prepend (wheel->slots[wheel->cursor], entry);
+        } else {
+            entry->firing = TRUE;
+            g_queue_push_tail (due, entry);
+        }
+    }
+    g_list_free (slot);
+}
+
+static gboolean
+_on_tick (gpointer user_data)
+{
+    GSignondTimerWheel *wheel = (GSignondTimerWheel *) user_data;
+    gint64 now = g_get_monotonic_time ();
+    gint64 tick_us = (gint64) wheel->tick_ms * G_TIME_SPAN_MILLISECOND;
+    GSignondTimerWheelEntry *entry;
+    GQueue due = G_QUEUE_INIT;
+
+    /* catch up with the ticks missed while the main loop was busy or the
+     * system was suspended */
+    do {
+        _advance (wheel, &due);
+        wheel->last_tick += tick_us;
+    } while (now - wheel->last_tick >= tick_us);
+
+    while ((entry = g_queue_pop_head (&due)) != NULL) {
+        if (!entry->removed) {
+            g_hash_table_remove (wheel->entries, GUINT_TO_POINTER (entry->id));
+            entry->func (entry->user_data);
+        }
+        _entry_free (entry);
+    }
+
+    if (g_hash_table_size (wheel->entries) == 0) {
+        wheel->source_id = 0;
+        return FALSE;
+    }
+    return TRUE;
+}
+
+/**
+ * gsignond_timer_wheel_new:
+ * @tick_ms: resolution of the timers in milliseconds
+ * @n_slots: number of slots in the ring
+ *
+ * Timers up to @tick_ms * @n_slots milliseconds away are placed directly in
+ * their slot, further ones wait for the ring to come round.
+ *
+ * Returns: (transfer full): a new #GSignondTimerWheel.
+ */
+GSignondTimerWheel *
+gsignond_timer_wheel_new (
+        guint tick_ms,
+        guint n_slots)
+{
+    GSignondTimerWheel *wheel;
+
+    g_return_val_if_fail (tick_ms > 0 && n_slots > 0, NULL);
+
+    wheel = g_slice_new0 (GSignondTimerWheel);
+    wheel->tick_ms = tick_ms;
+    wheel->n_slots = n_slots;
+    wheel->slots = g_new0 (GList *, n_slots);
+    wheel->entries = g_hash_table_new (g_direct_hash, g_direct_equal);
+
+    return wheel;
+}
+
+/**
+ * gsignond_timer_wheel_free:
+ * @wheel: a #GSignondTimerWheel
+ *
+ * Drops the pending timers without firing them, and frees @wheel. Must not
+ * be called from a timer callback.
+ */
+void
+gsignond_timer_wheel_free (GSignondTimerWheel *wheel)
+{
+    guint i;
+
+    if (!wheel)
+        return;
+
+    if (wheel->source_id)
+        g_source_remove (wheel->source_id);
+    for (i = 0; i < wheel->n_slots; i++)
+        g_list_free_full (wheel->slots[i], (GDestroyNotify) _entry_free);
+    g_free (wheel->slots);
+    g_hash_table_unref (wheel->entries);
+    g_slice_free (GSignondTimerWheel, wheel);
+}
+
+/**
+ * gsignond_timer_wheel_add:
+ * @wheel: a #GSignondTimerWheel
+ * @delay_ms: time in milliseconds until @func is called
+ * @func: function to call
+ * @user_data: data for @func
+ * @notify: (allow-none): called with @user_data once the timer has fired or
+ * has been removed
+ *
+ * Returns: id of the timer, for gsignond_timer_wheel_remove().
+ */
+guint
+gsignond_timer_wheel_add (
+        GSignondTimerWheel *wheel,
+        guint delay_ms,
+        GSignondTimerWheelFunc func,
+        gpointer user_data,
+        GDestroyNotify notify)
+{
+    GSignondTimerWheelEntry *entry;
+    gint64 now = g_get_monotonic_time ();
+    gint64 tick_us = (gint64) wheel->tick_ms * G_TIME_SPAN_MILLISECOND;
+    guint ticks;
+
+    g_return_val_if_fail (wheel && func, 0);
+
+    if (wheel->source_id == 0) {
+        wheel->last_tick = now;
+        /* ticks of whole seconds wake up together with other timers */
+        if (wheel->tick_ms % 1000 == 0)
+            wheel->source_id = g_timeout_add_seconds (wheel->tick_ms / 1000,
+                                                      _on_tick, wheel);
+        else
+            wheel->source_id = g_timeout_add (wheel->tick_ms, _on_tick,
+                                              wheel);
+    }
+
+    /* counted from the last tick and rounded up, so that timers never fire
+     * early */
+    ticks = (guint) MAX (1, ((gint64) delay_ms * G_TIME_SPAN_MILLISECOND +
+                             now - wheel->last_tick + tick_us - 1) / tick_us);
+
+    entry = g_slice_new0 (GSignondTimerWheelEntry);
+    entry->id = ++wheel->last_id;
+    if (entry->id == 0)
+        entry->id = ++wheel->last_id;
+    entry->slot = (wheel->cursor + ticks) % wheel->n_slots;
+    entry->rounds = (ticks - 1) / wheel->n_slots;
+    entry->func = func;
+    entry->user_data = user_data;
+    entry->notify = notify;
+
+    wheel->slots[entry->slot] = g_list_prepend (wheel->slots[entry->slot],
+                                                entry);
+    g_hash_table_insert (wheel->entries, GUINT_TO_POINTER (entry->id), entry);
+
+    return entry->id;
+}
+
+/**
+ * gsignond_timer_wheel_remove:
+ * @wheel: a #GSignondTimerWheel
+ * @id: id of a timer
+ *
+ * Removes a timer before it fires.
+ *
+ * Returns: TRUE if the timer was pending.
+ */
+gboolean
+gsignond_timer_wheel_remove (
+        GSignondTimerWheel *wheel,
+        guint id)
+{
+    GSignondTimerWheelEntry *entry;
+
+    g_return_val_if_fail (wheel, FALSE);
+
+    entry = g_hash_table_lookup (wheel->entries, GUINT_TO_POINTER (id));
+    if (!entry)
+        return FALSE;
+    g_hash_table_remove (wheel->entries, GUINT_TO_POINTER (id));
+
+    /* due in the tick being run, freed once the tick is done */
+    if (entry->firing) {
+        entry->removed = TRUE;
+        return TRUE;
+    }
+
+    wheel->slots[entry->slot] = g_list_remove (wheel->slots[entry->slot],
+                                               entry);
+    _entry_free (entry);
+    return TRUE;
+}
+
+/**
+ * gsignond_timer_wheel_get_size:
+ * @wheel: a #GSignondTimerWheel
+ *
+ * Returns: the number of pending timers.
+ */
+guint
+gsignond_timer_wheel_get_size (GSignondTimerWheel *wheel)
+{
+    g_return_val_if_fail (wheel, 0);
+
+    return g_hash_table_size (wheel->entries);
+}
@@ -0,0 +1,64 @@
+/* vi: set et sw=4 ts=4 cino=t0,(0: */
+/* -*- Mode: C; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This file is part of gsignond
+ *
+ * Copyright (C) 2014 Intel Corporation.
+ *
+ * Contact: Imran Zaman <imran.zaman@intel.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ */
+
+
+#ifndef __GSIGNOND_TIMER_WHEEL_H__
+#define __GSIGNOND_TIMER_WHEEL_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef struct _GSignondTimerWheel GSignondTimerWheel;
+
+typedef void (*GSignondTimerWheelFunc) (gpointer user_data);
+
+GSignondTimerWheel *
+gsignond_timer_wheel_new (
+        guint tick_ms,
+        guint n_slots);
+
+void
+gsignond_timer_wheel_free (GSignondTimerWheel *wheel);
+
+guint
+gsignond_timer_wheel_add (
+        GSignondTimerWheel *wheel,
+        guint delay_ms,
+        GSignondTimerWheelFunc func,
+        gpointer user_data,
+        GDestroyNotify notify);
+
+gboolean
+gsignond_timer_wheel_remove (
+        GSignondTimerWheel *wheel,
+        guint id);
+
+guint
+gsignond_timer_wheel_get_size (GSignondTimerWheel *wheel);
+
+G_END_DECLS
+
+#endif /* __GSIGNOND_TIMER_WHEEL_H__ */
@@ -28,6 +28,7 @@
 #include <time.h>
 #include <fcntl.h>
 #include <unistd.h>
+#include <pthread.h>
 #include <sys/stat.h>
 
 #include "gsignond/gsignond-utils.h"
@@ -42,17 +43,41 @@
  * Miscellaneous utility functions are described below.
  */
 
+/* nonces generated at a time by a thread */
+#define GSIGNOND_NONCE_BATCH 16
+
 typedef struct __nonce_ctx_t
 {
     gboolean initialized;
-    guint32 serial;
     guchar key[32];
     guchar entropy[16];
 } _nonce_ctx_t;
 
+/* nonce generator of a thread, so that threads do not contend for a lock */
+typedef struct __nonce_thread_ctx_t
+{
+    GHmac *hmac; /* keyed with the key and the thread's entropy */
+    GChecksum *checksum; /* reset for each nonce of a batch */
+    guint generation;
+    guint64 serial;
+    guint next;
+    gchar nonces[GSIGNOND_NONCE_BATCH][GSIGNOND_NONCE_LENGTH + 1];
+} _nonce_thread_ctx_t;
+
+typedef struct __intern_entry_t
+{
+    guint ref_count;
+    gchar str[1];
+} _intern_entry_t;
+
 static size_t pagesize = 0;
 static _nonce_ctx_t _nonce_ctx = { 0, };
-G_LOCK_DEFINE_STATIC (_nonce_lock);
+static volatile gint _nonce_generation = 0;
+static volatile gint _nonce_threads = 0;
+static void _nonce_thread_ctx_free (gpointer data);
+static GPrivate _nonce_thread_ctx = G_PRIVATE_INIT (_nonce_thread_ctx_free);
+static GHashTable *_intern_table = NULL;
+G_LOCK_DEFINE_STATIC (_intern_lock);
 
 /**
  * gsignond_wipe_file:
@@ -197,33 +222,143 @@ _dir_exit:
     return retval;
 }
 
+/* a forked process must not hand out the nonces of its parent */
+static void
+_on_nonce_fork_child (void)
+{
+    g_atomic_int_inc (&_nonce_generation);
+}
+
 static gboolean
 _init_nonce_gen ()
 {
-    if (G_LIKELY(_nonce_ctx.initialized))
-        return TRUE;
+    static gsize init = 0;
+
+    if (g_once_init_enter (&init)) {
+        int fd = open ("/dev/urandom", O_RDONLY);
+        if (fd >= 0) {
+            if (read (fd, _nonce_ctx.key, sizeof (_nonce_ctx.key)) ==
+                sizeof (_nonce_ctx.key) &&
+                read (fd, _nonce_ctx.entropy, sizeof(_nonce_ctx.entropy)) ==
+                sizeof (_nonce_ctx.entropy))
+                _nonce_ctx.initialized = TRUE;
+            close (fd);
+        }
+        pthread_atfork (NULL, NULL, _on_nonce_fork_child);
+        g_once_init_leave (&init, 1);
+    }
+
+    return _nonce_ctx.initialized;
+}
+
+static void
+_nonce_thread_ctx_free (gpointer data)
+{
+    _nonce_thread_ctx_t *ctx = (_nonce_thread_ctx_t *) data;
+
+    if (ctx->hmac)
+        g_hmac_unref (ctx->hmac);
+    if (ctx->checksum)
+        g_checksum_free (ctx->checksum);
+    memset (ctx->nonces, 0x00, sizeof (ctx->nonces));
+    g_slice_free (_nonce_thread_ctx_t, ctx);
+}
+
+/* keys the HMAC of the thread, which is only copied for each batch */
+static void
+_reset_nonce_thread_ctx (_nonce_thread_ctx_t *ctx)
+{
+    gint thread_serial = g_atomic_int_add (&_nonce_threads, 1);
+    pid_t pid = getpid ();
+
+    if (ctx->hmac)
+        g_hmac_unref (ctx->hmac);
+    ctx->hmac = g_hmac_new (G_CHECKSUM_SHA1,
+                            _nonce_ctx.key, sizeof (_nonce_ctx.key));
+    g_hmac_update (ctx->hmac, _nonce_ctx.entropy, sizeof (_nonce_ctx.entropy));
+    g_hmac_update (ctx->hmac, (const guchar *) &pid, sizeof (pid));
+    g_hmac_update (ctx->hmac,
+                   (const guchar *) &thread_serial, sizeof (thread_serial));
+    if (!ctx->checksum)
+        ctx->checksum = g_checksum_new (G_CHECKSUM_SHA1);
+    ctx->generation = g_atomic_int_get (&_nonce_generation);
+    ctx->next = GSIGNOND_NONCE_BATCH;
+}
+
+/* one HMAC of the batch serial and time gives a secret batch key, each
+ * nonce is the SHA1 of that key and its index in the batch, so that only
+ * one HMAC state is allocated per batch */
+static void
+_refill_nonces (_nonce_thread_ctx_t *ctx)
+{
+    struct timespec ts;
+    guint8 batch_key[20];
+    gsize key_len = sizeof (batch_key);
+    GHmac *hmac;
+    guint i;
+
+    memset (&ts, 0x00, sizeof (ts));
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    hmac = g_hmac_copy (ctx->hmac);
+    ctx->serial++;
+    g_hmac_update (hmac, (const guchar *) &ctx->serial, sizeof (ctx->serial));
+    g_hmac_update (hmac, (const guchar *) &ts, sizeof (ts));
+    g_hmac_get_digest (hmac, batch_key, &key_len);
+    g_hmac_unref (hmac);
+
+    for (i = 0; i < GSIGNOND_NONCE_BATCH; i++) {
+        g_checksum_update (ctx->checksum, batch_key, key_len);
+        g_checksum_update (ctx->checksum, (const guchar *) &i, sizeof (i));
+        g_strlcpy (ctx->nonces[i], g_checksum_get_string (ctx->checksum),
+                   GSIGNOND_NONCE_LENGTH + 1);
+        g_checksum_reset (ctx->checksum);
+    }
+    memset (batch_key, 0x00, sizeof (batch_key));
+    memset (&ts, 0x00, sizeof(ts));
+    ctx->next = 0;
+}
+
+/**
+ * gsignond_generate_nonce_into:
+ * @nonce: buffer of #GSIGNOND_NONCE_LENGTH + 1 bytes for the nonce
+ *
+ * This function generates a random secure nonce using SHA1 HMAC, like
+ * gsignond_generate_nonce(), without allocating the result. Each thread
+ * generates nonces in batches with a key state of its own, so concurrent
+ * callers do not wait for each other.
+ *
+ * Returns: TRUE if @nonce was filled with the nonce in lowercase hexadecimal
+ * format, FALSE if no randomness was available.
+ */
+gboolean
+gsignond_generate_nonce_into (gchar *nonce)
+{
+    _nonce_thread_ctx_t *ctx;
 
-    int fd;
+    g_return_val_if_fail (nonce != NULL, FALSE);
 
-    fd = open ("/dev/urandom", O_RDONLY);
-    if (fd < 0)
-        goto init_exit;
-    if (read (fd, _nonce_ctx.key, sizeof (_nonce_ctx.key)) !=
-        sizeof (_nonce_ctx.key))
-        goto init_close;
-    if (read (fd, _nonce_ctx.entropy, sizeof(_nonce_ctx.entropy)) !=
-        sizeof (_nonce_ctx.entropy))
-        goto init_close;
+    if (G_UNLIKELY (!_init_nonce_gen()))
+        return FALSE;
 
-    _nonce_ctx.serial = 0;
+    ctx = g_private_get (&_nonce_thread_ctx);
+    if (G_UNLIKELY (!ctx)) {
+        ctx = g_slice_new0 (_nonce_thread_ctx_t);
+        _reset_nonce_thread_ctx (ctx);
+        g_private_set (&_nonce_thread_ctx, ctx);
+    } else if (G_UNLIKELY (ctx->generation !=
+                           (guint) g_atomic_int_get (&_nonce_generation))) {
+        _reset_nonce_thread_ctx (ctx);
+    }
 
-    _nonce_ctx.initialized = TRUE;
+    if (ctx->next == GSIGNOND_NONCE_BATCH)
+        _refill_nonces (ctx);
 
-init_close:
-    close (fd);
+    memcpy (nonce, ctx->nonces[ctx->next], GSIGNOND_NONCE_LENGTH + 1);
+    /* a nonce is handed out once */
+    memset (ctx->nonces[ctx->next], 0x00, GSIGNOND_NONCE_LENGTH + 1);
+    ctx->next++;
 
-init_exit:
-    return _nonce_ctx.initialized;
+    return TRUE;
 }
 
 /**
@@ -236,32 +371,12 @@ init_exit:
 gchar *
 gsignond_generate_nonce ()
 {
-    GHmac *hmac;
-    gchar *nonce = NULL;
-    struct timespec ts;
-
-    G_LOCK (_nonce_lock);
-
-    if (G_UNLIKELY (!_init_nonce_gen()))
-        goto nonce_exit;
-
-    hmac = g_hmac_new (G_CHECKSUM_SHA1,
-                       _nonce_ctx.key, sizeof (_nonce_ctx.key));
-    g_hmac_update (hmac, _nonce_ctx.entropy, sizeof (_nonce_ctx.entropy));
-    _nonce_ctx.serial++;
-    g_hmac_update (hmac,
-                   (const guchar *) &_nonce_ctx.serial,
-                   sizeof (_nonce_ctx.serial));
-    if (clock_gettime (CLOCK_MONOTONIC, &ts) == 0)
-        g_hmac_update (hmac, (const guchar *) &ts, sizeof (ts));
-    memset (&ts, 0x00, sizeof(ts));
-    nonce = g_strdup (g_hmac_get_string (hmac));
-    g_hmac_unref (hmac);
+    gchar nonce[GSIGNOND_NONCE_LENGTH + 1];
 
-nonce_exit:
-    G_UNLOCK (_nonce_lock);
+    if (!gsignond_generate_nonce_into (nonce))
+        return NULL;
 
-    return nonce;
+    return g_strdup (nonce);
 }
 
 static gint
@@ -444,4 +559,104 @@ gsignond_is_host_in_domain(const gchar *host, const gchar *domain)
     g_strfreev(domain_parts);
     
     return result == 0 ? TRUE : FALSE;
-}
\ No newline at end of file
+}
+
+/**
+ * gsignond_str_intern:
+ * @str: (allow-none): a string
+ *
+ * Returns the canonical copy of @str, creating it if needed. Equal strings
+ * interned this way share the same pointer, so they can be compared with
+ * pointer equality. Each call takes a reference, which must be dropped with
+ * gsignond_str_unintern(); the returned string must never be freed or
+ * modified.
+ *
+ * Returns: (transfer none): canonical string, or NULL if @str is NULL.
+ */
+const gchar *
+gsignond_str_intern (const gchar *str)
+{
+    _intern_entry_t *entry = NULL;
+
+    if (!str) return NULL;
+
+    G_LOCK (_intern_lock);
+    if (G_UNLIKELY (!_intern_table))
+        _intern_table = g_hash_table_new (g_str_hash, g_str_equal);
+
+    entry = g_hash_table_lookup (_intern_table, str);
+    if (!entry) {
+        gsize len = strlen (str);
+
+        entry = g_malloc (G_STRUCT_OFFSET (_intern_entry_t, str) + len + 1);
+        entry->ref_count = 0;
+        memcpy (entry->str, str, len + 1);
+        g_hash_table_insert (_intern_table, entry->str, entry);
+    }
+    entry->ref_count++;
+    G_UNLOCK (_intern_lock);
+
+    return entry->str;
+}
+
+/**
+ * gsignond_str_unintern:
+ * @str: (allow-none): a string returned by gsignond_str_intern()
+ *
+ * Drops a reference taken by gsignond_str_intern(). The canonical copy is
+ * released when the last reference is gone.
+ */
+void
+gsignond_str_unintern (const gchar *str)
+{
+    _intern_entry_t *entry = NULL;
+
+    if (!str) return;
+
+    G_LOCK (_intern_lock);
+    if (_intern_table)
+        entry = g_hash_table_lookup (_intern_table, str);
+    if (G_UNLIKELY (!entry || entry->str != str)) {
+        G_UNLOCK (_intern_lock);
+        WARN ("'%s' is not an interned string", str);
+        return;
+    }
+    if (--entry->ref_count == 0) {
+        g_hash_table_remove (_intern_table, entry->str);
+        g_free (entry);
+    }
+    G_UNLOCK (_intern_lock);
+}
+
+/**
+ * gsignond_interned_sequence_new:
+ *
+ * Creates an empty sequence for strings returned by gsignond_str_intern().
+ * Items are released with gsignond_str_unintern() when removed.
+ *
+ * Returns: (transfer full): #GSequence of interned strings
+ */
+GSequence *
+gsignond_interned_sequence_new (void)
+{
+    return g_sequence_new ((GDestroyNotify) gsignond_str_unintern);
+}
+
+/**
+ * gsignond_interned_sequence_insert:
+ * @seq: a sequence created by gsignond_interned_sequence_new()
+ * @str: string to intern and insert
+ *
+ * Interns @str and inserts it into @seq keeping the sequence sorted.
+ */
+void
+gsignond_interned_sequence_insert (GSequence *seq, const gchar *str)
+{
+    g_return_if_fail (seq != NULL);
+    g_return_if_fail (str != NULL);
+
+    g_sequence_insert_sorted (seq,
+                              (gpointer) gsignond_str_intern (str),
+                              (GCompareDataFunc) _compare_strings,
+                              NULL);
+}
@@ -333,6 +333,7 @@ gsignond_db_credentials_database_load_identity (
  *   ("Owner":GSignondSecurtityContext *context) - Identities matched with this 'context'
  *   ("Type":guint32 type) - Identities matched with 'type'
  *   ("Caption":gchar *caption) - Identties matched/start with 'caption'
+ *   ("Ids":au ids) - Identities with one of the 'ids'
  *
  * Fetches the list of the identities.
  *
@@ -30,6 +30,7 @@
 
 #include "gsignond/gsignond-log.h"
 #include "gsignond/gsignond-config.h"
+#include "gsignond/gsignond-utils.h"
 #include "common/db/gsignond-db-error.h"
 #include "common/gsignond-identity-info-internal.h"
 #include "gsignond-db-metadata-database.h"
@@ -122,25 +123,16 @@ enum GSignondIdentityFlags {
     GSignondIdentityFlag_UserNameIsSecret = 0x0004,
 };
 
-static gint
-_compare_strings (
-		const gchar* a,
-		const gchar* b,
-		gpointer data)
-{
-	(void)data;
-	return g_strcmp0 (a,b);
-}
-
+/* realms and mechanisms are interned, the list strings are released */
 static GSequence *
 _gsignond_db_metadata_database_list_to_sequence (GList *list)
 {
     GSequence *seq = NULL;
-    seq = g_sequence_new ((GDestroyNotify)g_free);
+    seq = gsignond_interned_sequence_new ();
     list = g_list_first (list);
     for ( ; list != NULL; list = g_list_next (list)) {
-        g_sequence_insert_sorted (seq, (gchar *) list->data,
-        		(GCompareDataFunc)_compare_strings, NULL);
+        gsignond_interned_sequence_insert (seq, (const gchar *) list->data);
+        g_free (list->data);
     }
     return seq;
 }
@@ -226,7 +218,7 @@ _gsignond_db_metadata_database_get_sequence (
                     query);
     sqlite3_free (query);
     seq = _gsignond_db_metadata_database_list_to_sequence (list);
-    g_list_free (list); /*list elements are owned by sequence*/
+    g_list_free (list);
 
     return seq;
 }
@@ -1246,11 +1238,6 @@ gsignond_db_metadata_database_update_identity (
     }
 
 finished:
-    if (methods) g_hash_table_unref (methods);
-    if (realms) g_sequence_free (realms);
-    if (acl) gsignond_security_context_list_free (acl);
-    if (owner) gsignond_security_context_free (owner);
-
     return ret;
 }
 
@@ -1339,7 +1326,7 @@ gsignond_db_metadata_database_get_identity (
     if (tuples) {
         methods = g_hash_table_new_full ((GHashFunc)g_str_hash,
                 (GEqualFunc)g_str_equal,
-                (GDestroyNotify)g_free,
+                (GDestroyNotify)gsignond_str_unintern,
                 (GDestroyNotify)g_sequence_free);
         g_hash_table_iter_init(&iter, tuples);
         while (g_hash_table_iter_next (&iter, (gpointer *)&method_id,
@@ -1350,7 +1337,8 @@ gsignond_db_metadata_database_get_identity (
                     "( MECHANISMS JOIN ACL ON ACL.mechanism_id = MECHANISMS.id ) "
                     "WHERE ACL.method_id = %u AND ACL.identity_id = %u;",
                     method_id, identity_id);
-            g_hash_table_insert(methods, g_strdup(method), mechanisms);
+            g_hash_table_insert(methods,
+                    (gpointer) gsignond_str_intern (method), mechanisms);
         }
         g_hash_table_destroy (tuples);
         gsignond_identity_info_set_methods (identity, methods);
@@ -1364,7 +1352,8 @@ gsignond_db_metadata_database_get_identity (
  * gsignond_db_metadata_database_get_identities:
  *
  * @self: instance of #GSignondDbMetadataDatabase
- * @filter: (transfer none) filter to apply (supported filters: Owner, Type & Caption)
+ * @filter: (transfer none) filter to apply (supported filters: Owner, Type,
+ * Caption & Ids)
  *
  * Reads all the identities that are matched by applying @filter,
  * from the database into a list.
@@ -1382,6 +1371,7 @@ gsignond_db_metadata_database_get_identities (
     gchar *owner_query = NULL;
     gchar *caption_query = NULL;
     gchar *type_query = NULL;
+    gchar *ids_query = NULL;
     gchar *query = NULL;
     GArray *ids = NULL;
     gint i;
@@ -1391,6 +1381,7 @@ gsignond_db_metadata_database_get_identities (
 
     if (filter) {
         GVariant *owner_var = NULL;
+        GVariant *ids_var = NULL;
         const gchar *caption = NULL;
         gint type = 0;
         gboolean append_where = TRUE;
@@ -1418,15 +1409,33 @@ gsignond_db_metadata_database_get_identities (
     				append_where ? "WHERE" : "AND", type);
     		append_where = FALSE;
     	}
+
+    	/* identities listed by id, all selected by the id query */
+    	ids_var = gsignond_dictionary_get (filter, "Ids");
+    	if (ids_var && g_variant_is_of_type (ids_var, G_VARIANT_TYPE ("au"))) {
+    		GString *list = g_string_new (NULL);
+    		GVariantIter iter;
+    		guint32 id;
+
+    		g_variant_iter_init (&iter, ids_var);
+    		while (g_variant_iter_next (&iter, "u", &id))
+    			g_string_append_printf (list, "%s%u", list->len ? "," : "", id);
+    		ids_query = sqlite3_mprintf (" %s id IN (%s)",
+    				append_where ? "WHERE" : "AND", list->str);
+    		g_string_free (list, TRUE);
+    		append_where = FALSE;
+    	}
     }
 
-    query = sqlite3_mprintf ("SELECT id FROM IDENTITY %s%s%s ORDER BY id",
+    query = sqlite3_mprintf ("SELECT id FROM IDENTITY %s%s%s%s ORDER BY id",
     		owner_query ? owner_query : "",
     		caption_query ? caption_query : "",
-    		type_query ? type_query : "");
+    		type_query ? type_query : "",
+    		ids_query ? ids_query : "");
     sqlite3_free(owner_query);
     sqlite3_free(caption_query);
     sqlite3_free(type_query);
+    sqlite3_free(ids_query);
 
     ids = gsignond_db_sql_database_query_exec_int_array (
                 GSIGNOND_DB_SQL_DATABASE (self),
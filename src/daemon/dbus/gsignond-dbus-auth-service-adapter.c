@@ -27,6 +27,7 @@
 #include "gsignond/gsignond-log.h"
 #include "gsignond-dbus-auth-service-adapter.h"
 #include "gsignond-dbus-identity-adapter.h"
+#include "gsignond-dbus-auth-session-adapter.h"
 #include "gsignond-dbus.h"
 
 enum
@@ -71,6 +72,19 @@ static gboolean _handle_query_identities (GSignondDbusAuthServiceAdapter *,
                                       GVariant*, 
                                       const gchar *,
                                       gpointer);
+static gboolean _handle_get_identities_info (GSignondDbusAuthServiceAdapter *,
+                                         GDBusMethodInvocation *,
+                                         GVariant *,
+                                         const gchar *,
+                                         gpointer);
+static gboolean _handle_authenticate (GSignondDbusAuthServiceAdapter *,
+                                  GDBusMethodInvocation *,
+                                  guint32,
+                                  const gchar *,
+                                  const gchar *,
+                                  GVariant *,
+                                  const gchar *,
+                                  gpointer);
 static gboolean _handle_clear (GSignondDbusAuthServiceAdapter *, GDBusMethodInvocation *, gpointer);
 static void _on_identity_disposed (gpointer data, GObject *object);
 
@@ -225,6 +239,10 @@ gsignond_dbus_auth_service_adapter_init (GSignondDbusAuthServiceAdapter *self)
         "handle-query-mechanisms", G_CALLBACK(_handle_query_mechanisms), self);
     g_signal_connect_swapped (self->priv->dbus_auth_service,
         "handle-query-identities", G_CALLBACK(_handle_query_identities), self);
+    g_signal_connect_swapped (self->priv->dbus_auth_service,
+        "handle-get-identities-info", G_CALLBACK(_handle_get_identities_info), self);
+    g_signal_connect_swapped (self->priv->dbus_auth_service,
+        "handle-authenticate", G_CALLBACK(_handle_authenticate), self);
     g_signal_connect_swapped (self->priv->dbus_auth_service,
         "handle-clear", G_CALLBACK(_handle_clear), self);
 }
@@ -416,7 +434,7 @@ _handle_query_methods (GSignondDbusAuthServiceAdapter   *self,
                        GDBusMethodInvocation *invocation,
                        gpointer               user_data)
 {
-    const gchar **methods = NULL;
+    GVariant *methods = NULL;
     GError *error = NULL;
  
     gsignond_disposable_set_auto_dispose (GSIGNOND_DISPOSABLE (self), FALSE);
@@ -427,10 +445,9 @@ _handle_query_methods (GSignondDbusAuthServiceAdapter   *self,
         g_dbus_method_invocation_return_gerror (invocation, error);
         g_error_free (error);
     } else {
-        const gchar *const empty_methods[] = { NULL };
-        gsignond_dbus_auth_service_complete_query_methods (
-              self->priv->dbus_auth_service, invocation,
-              methods ? (const gchar * const*)methods : empty_methods);
+        /* reply with the daemon's prebuilt variant, no strv conversion */
+        g_dbus_method_invocation_return_value (invocation,
+              g_variant_new ("(@as)", methods));
     }
 
     gsignond_disposable_set_auto_dispose (GSIGNOND_DISPOSABLE (self), TRUE);
@@ -444,7 +461,7 @@ _handle_query_mechanisms (GSignondDbusAuthServiceAdapter *self,
                           const gchar *method,
                           gpointer user_data)
 {
-    const gchar **mechanisms = 0;
+    GVariant *mechanisms = NULL;
     GError *error = NULL;
 
     gsignond_disposable_set_auto_dispose (GSIGNOND_DISPOSABLE (self), FALSE);
@@ -452,8 +469,8 @@ _handle_query_mechanisms (GSignondDbusAuthServiceAdapter *self,
     mechanisms = gsignond_daemon_query_mechanisms (self->priv->auth_service, method, &error);
 
     if (mechanisms)
-        gsignond_dbus_auth_service_complete_query_mechanisms (
-            self->priv->dbus_auth_service, invocation, (const gchar* const*)mechanisms);
+        g_dbus_method_invocation_return_value (invocation,
+            g_variant_new ("(@as)", mechanisms));
     else {
         g_dbus_method_invocation_return_gerror (invocation, error);
         g_error_free (error);
@@ -533,6 +550,210 @@ _handle_query_identities (GSignondDbusAuthServiceAdapter *self,
     return TRUE;
 }
 
+static gboolean
+_handle_get_identities_info (GSignondDbusAuthServiceAdapter *self,
+                             GDBusMethodInvocation *invocation,
+                             GVariant *ids,
+                             const gchar *app_context,
+                             gpointer user_data)
+{
+    GVariant *infos = NULL;
+    GVariant *errors = NULL;
+    GSignondSecurityContext *sec_context;
+    const gchar *sender =  NULL;
+    int fd = -1;
+
+    gsignond_disposable_set_auto_dispose (GSIGNOND_DISPOSABLE (self), FALSE);
+
+#ifdef USE_P2P
+    GDBusConnection *connection = NULL;
+    connection = g_dbus_method_invocation_get_connection (invocation);
+    fd = g_socket_get_fd (g_socket_connection_get_socket (G_SOCKET_CONNECTION (g_dbus_connection_get_stream(connection))));
+#else
+    sender = g_dbus_method_invocation_get_sender (invocation);
+#endif
+    sec_context = gsignond_security_context_new ();
+    gsignond_access_control_manager_security_context_of_peer(
+            gsignond_daemon_get_access_control_manager (self->priv->auth_service),
+            sec_context,
+            fd,
+            sender, app_context);
+
+    infos = gsignond_daemon_get_identities_info (self->priv->auth_service,
+                                                 ids,
+                                                 sec_context,
+                                                 &errors);
+
+    gsignond_security_context_free (sec_context);
+
+    gsignond_dbus_auth_service_complete_get_identities_info (
+        self->priv->dbus_auth_service, invocation, infos, errors);
+
+    gsignond_disposable_set_auto_dispose (GSIGNOND_DISPOSABLE (self), TRUE);
+
+    return TRUE;
+}
+
+typedef struct {
+    GSignondDbusAuthServiceAdapter *adapter;
+    GDBusMethodInvocation *invocation;
+    GSignondAuthSession *session;
+    guint32 id;
+    gchar *method;
+    gchar *app_context;
+    gulong user_action_handler_id;
+    gchar *session_path;
+} _AuthenticateInfo;
+
+/* the daemon shows the dialogs; the caller gets the session as if it had
+ * asked for it with getAuthSession, so that it can follow or cancel the
+ * request while the user interacts */
+static void
+_on_authenticate_user_action (GSignondAuthSession *session,
+                              GSignondSignonuiData *ui_data,
+                              gpointer user_data)
+{
+    _AuthenticateInfo *info = (_AuthenticateInfo *) user_data;
+    GSignondDbusAuthServiceAdapter *self = info->adapter;
+    GSignondDbusAuthSessionAdapter *dbus_session = NULL;
+    GDBusConnection *connection = NULL;
+    GError *error = NULL;
+
+    if (info->session_path)
+        return;
+
+    connection = g_dbus_method_invocation_get_connection (info->invocation);
+    dbus_session = gsignond_dbus_auth_session_adapter_new_with_connection (
+            g_object_ref (connection), g_object_ref (session),
+            info->app_context,
+            gsignond_daemon_get_auth_session_timeout (
+                self->priv->auth_service));
+    if (!dbus_session)
+        return;
+    info->session_path = g_strdup (
+            gsignond_dbus_auth_session_adapter_get_object_path (dbus_session));
+
+    /* only the caller learns about its session */
+    if (!g_dbus_connection_emit_signal (connection,
+            g_dbus_method_invocation_get_sender (info->invocation),
+            g_dbus_method_invocation_get_object_path (info->invocation),
+            g_dbus_method_invocation_get_interface_name (info->invocation),
+            "authenticateUserActionRequired",
+            g_variant_new ("(uso)", info->id, info->method,
+                           info->session_path),
+            &error)) {
+        WARN ("failed to emit authenticateUserActionRequired : %s",
+              error->message);
+        g_error_free (error);
+    }
+}
+
+static void
+_on_authenticated (GSignondSessionData *reply,
+                   const GError *error,
+                   gpointer user_data)
+{
+    _AuthenticateInfo *info = (_AuthenticateInfo *) user_data;
+    GSignondDbusAuthServiceAdapter *self = info->adapter;
+
+    if (info->session) {
+        g_signal_handler_disconnect (info->session,
+                                     info->user_action_handler_id);
+    }
+
+    if (error) {
+        DBG ("ERROR : %s(%d)", error->message, error->code);
+        g_dbus_method_invocation_return_gerror (info->invocation, error);
+    }
+    else {
+        gsignond_dbus_auth_service_complete_authenticate (
+            self->priv->dbus_auth_service, info->invocation,
+            gsignond_dictionary_to_variant ((GSignondDictionary *) reply),
+            info->session_path ? info->session_path : "/");
+    }
+
+    gsignond_disposable_set_auto_dispose (GSIGNOND_DISPOSABLE (self), TRUE);
+
+    if (info->session)
+        g_object_unref (info->session);
+    g_free (info->method);
+    g_free (info->app_context);
+    g_free (info->session_path);
+    g_object_unref (self);
+    g_slice_free (_AuthenticateInfo, info);
+}
+
+static gboolean
+_handle_authenticate (GSignondDbusAuthServiceAdapter *self,
+                      GDBusMethodInvocation *invocation,
+                      guint32 id,
+                      const gchar *method,
+                      const gchar *mechanism,
+                      GVariant *session_data,
+                      const gchar *app_context,
+                      gpointer user_data)
+{
+    _AuthenticateInfo *info = NULL;
+    GSignondSessionData *data = NULL;
+    GSignondSecurityContext *sec_context;
+    GError *error = NULL;
+    const gchar *sender =  NULL;
+    int fd = -1;
+
+    gsignond_disposable_set_auto_dispose (GSIGNOND_DISPOSABLE (self), FALSE);
+
+#ifdef USE_P2P
+    GDBusConnection *connection = NULL;
+    connection = g_dbus_method_invocation_get_connection (invocation);
+    fd = g_socket_get_fd (g_socket_connection_get_socket (G_SOCKET_CONNECTION (g_dbus_connection_get_stream(connection))));
+#else
+    sender = g_dbus_method_invocation_get_sender (invocation);
+#endif
+    sec_context = gsignond_security_context_new ();
+    gsignond_access_control_manager_security_context_of_peer(
+            gsignond_daemon_get_access_control_manager (self->priv->auth_service),
+            sec_context,
+            fd,
+            sender, app_context);
+
+    info = g_slice_new0 (_AuthenticateInfo);
+    info->adapter = g_object_ref (self);
+    info->invocation = invocation;
+    info->id = id;
+    info->method = g_strdup (method);
+    info->app_context = g_strdup (app_context);
+
+    data = (GSignondSessionData *) gsignond_dictionary_new_from_variant (
+            session_data);
+    info->session = gsignond_daemon_authenticate (self->priv->auth_service,
+                                                  id, method, mechanism, data,
+                                                  sec_context,
+                                                  _on_authenticated, info,
+                                                  &error);
+    gsignond_dictionary_unref (data);
+    gsignond_security_context_free (sec_context);
+
+    if (info->session) {
+        /* the response comes from the main loop, after this returns */
+        info->user_action_handler_id = g_signal_connect (info->session,
+                "process-user-action-required",
+                G_CALLBACK (_on_authenticate_user_action), info);
+    }
+    else {
+        g_dbus_method_invocation_return_gerror (invocation, error);
+        g_error_free (error);
+
+        g_free (info->method);
+        g_free (info->app_context);
+        g_object_unref (info->adapter);
+        g_slice_free (_AuthenticateInfo, info);
+
+        gsignond_disposable_set_auto_dispose (GSIGNOND_DISPOSABLE (self), TRUE);
+    }
+
+    return TRUE;
+}
+
 static gboolean
 _handle_clear (GSignondDbusAuthServiceAdapter *self,
                GDBusMethodInvocation *invocation,
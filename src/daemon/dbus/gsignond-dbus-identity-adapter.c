@@ -429,6 +429,7 @@ _handle_get_info (GSignondDbusIdentityAdapter *self,
     if (identity_data) {
         gsignond_dbus_identity_complete_get_info (
             self->priv->dbus_identity, invocation, identity_data);
+        g_variant_unref (identity_data);
     }
     else {
         g_dbus_method_invocation_return_gerror (invocation, error);
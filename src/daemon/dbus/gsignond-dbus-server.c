@@ -288,6 +288,24 @@ gsignond_dbus_server_start_auth_service (GSignondDbusServer *server, GDBusConnec
     g_object_weak_ref (G_OBJECT (auth_service), _on_auth_service_dispose, server);
 }
 
+/* the server may be replaced while the plugins are enumerated */
+static GWeakRef *
+_new_weak_ref (GSignondDbusServer *server)
+{
+    GWeakRef *ref = g_slice_new (GWeakRef);
+    g_weak_ref_init (ref, server);
+    return ref;
+}
+
+static GSignondDbusServer *
+_steal_weak_ref (GWeakRef *ref)
+{
+    GSignondDbusServer *server = g_weak_ref_get (ref);
+    g_weak_ref_clear (ref);
+    g_slice_free (GWeakRef, ref);
+    return server;
+}
+
 #ifdef USE_P2P
 static gboolean
 _on_client_request (GDBusServer *dbus_server, GDBusConnection *connection, gpointer userdata)
@@ -304,6 +322,19 @@ _on_client_request (GDBusServer *dbus_server, GDBusConnection *connection, gpoin
     return TRUE;
 }
 
+static void
+_on_plugins_enumerated (GObject *factory, GAsyncResult *result, gpointer user_data)
+{
+    GSignondDbusServer *server = _steal_weak_ref (user_data);
+
+    gsignond_plugin_proxy_factory_enumerate_finish (
+        GSIGNOND_PLUGIN_PROXY_FACTORY (factory), result, NULL);
+    if (!server) return;
+
+    g_dbus_server_start (server->priv->bus_server);
+    g_object_unref (server);
+}
+
 GSignondDbusServer * gsignond_dbus_server_new_with_address (const gchar *address)
 {
     GError *err = NULL;
@@ -348,7 +379,11 @@ GSignondDbusServer * gsignond_dbus_server_new_with_address (const gchar *address
 
     g_signal_connect (server->priv->bus_server, "new-connection", G_CALLBACK(_on_client_request), server);
 
-    g_dbus_server_start (server->priv->bus_server);
+    /* accept clients once the plugins are known, so that no request waits
+     * in the main loop for the plugin loaders */
+    gsignond_plugin_proxy_factory_enumerate (
+        gsignond_daemon_get_plugin_proxy_factory (server->priv->daemon),
+        _on_plugins_enumerated, _new_weak_ref (server));
 
     if (file_path)
         g_chmod (file_path, S_IRUSR | S_IWUSR);
@@ -395,9 +430,14 @@ _on_name_acquired (GDBusConnection *connection,
     gsignond_dbus_server_start_auth_service (server, connection);
 }
 
-GSignondDbusServer * gsignond_dbus_server_new () {
-    GSignondDbusServer *server = GSIGNOND_DBUS_SERVER (
-            g_object_new (GSIGNOND_TYPE_DBUS_SERVER, NULL));
+static void
+_on_plugins_enumerated (GObject *factory, GAsyncResult *result, gpointer user_data)
+{
+    GSignondDbusServer *server = _steal_weak_ref (user_data);
+
+    gsignond_plugin_proxy_factory_enumerate_finish (
+        GSIGNOND_PLUGIN_PROXY_FACTORY (factory), result, NULL);
+    if (!server) return;
 
     server->priv->name_owner_id = g_bus_own_name (GSIGNOND_BUS_TYPE,
             GSIGNOND_SERVICE, 
@@ -406,6 +446,18 @@ GSignondDbusServer * gsignond_dbus_server_new () {
             _on_name_acquired,
             _on_name_lost,
             server, NULL);
+    g_object_unref (server);
+}
+
+GSignondDbusServer * gsignond_dbus_server_new () {
+    GSignondDbusServer *server = GSIGNOND_DBUS_SERVER (
+            g_object_new (GSIGNOND_TYPE_DBUS_SERVER, NULL));
+
+    /* take the name once the plugins are known, so that no request waits
+     * in the main loop for the plugin loaders */
+    gsignond_plugin_proxy_factory_enumerate (
+        gsignond_daemon_get_plugin_proxy_factory (server->priv->daemon),
+        _on_plugins_enumerated, _new_weak_ref (server));
 
     return server;
 }
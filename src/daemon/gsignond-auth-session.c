@@ -51,19 +51,41 @@ enum {
 static guint signals[SIG_MAX] = { 0 };
 
 typedef struct {
-    GSignondAuthSession *self;
     ProcessReadyCb ready_cb;
     StateChangeCb state_change_cb;
     gpointer userdata;
+} _ProcessWaiter;
+
+/* a request passed to the plugin proxy, answering all the callers that made
+ * the same request while it was in flight */
+typedef struct {
+    GSignondAuthSession *self;
+    GBytes *key;
+    GQueue waiters;
 } _ProcessData;
 
+/* a final response a plugin allowed to be reused */
+typedef struct {
+    GSignondSessionData *response;
+    gint64 expires_at;
+} _CachedResponse;
+
+typedef struct {
+    GSignondAuthSession *self;
+    GSignondSessionData *response;
+    ProcessReadyCb ready_cb;
+    gpointer userdata;
+} _CachedReply;
+
 struct _GSignondAuthSessionPrivate
 {
     gchar *method;
     GSignondPluginProxy *proxy;
-    GSequence *available_mechanisms;
     GSignondIdentityInfo *identity_info;
     GSignondDictionary *token_data;
+    GHashTable *in_flight; /* (key, _ProcessData) */
+    GHashTable *response_cache; /* (key, _CachedResponse) */
+    GBytes *store_request; /* request that stored the token data */
 };
 
 G_DEFINE_TYPE (GSignondAuthSession, gsignond_auth_session, G_TYPE_OBJECT)
@@ -74,12 +96,7 @@ G_DEFINE_TYPE (GSignondAuthSession, gsignond_auth_session, G_TYPE_OBJECT)
 
 #define VALIDATE_X_ACCESS(info, ctx, ret) \
 { \
-    GSignondAccessControlManager *acm = gsignond_get_access_control_manager(); \
-    GSignondSecurityContextList *acl = gsignond_identity_info_get_access_control_list (info); \
-    GSignondSecurityContext *owner = gsignond_identity_info_get_owner (info); \
-    gboolean valid = gsignond_access_control_manager_peer_is_allowed_to_use_identity (acm, ctx, owner, acl); \
-    gsignond_security_context_free (owner); \
-    gsignond_security_context_list_free (acl); \
+    gboolean valid = gsignond_peer_is_allowed_to_use_identity (ctx, info); \
     if (!valid) { \
         WARN ("security check failed"); \
         if (error) { \
@@ -89,74 +106,23 @@ G_DEFINE_TYPE (GSignondAuthSession, gsignond_auth_session, G_TYPE_OBJECT)
     } \
 }
 
-static gint
-_sort_cmp (gconstpointer str1, gconstpointer str2, gpointer user_data)
+static gboolean
+_mechanism_is_allowed (GSignondAuthSession *self, const gchar *mechanism)
 {
-    (void) user_data;
-
-    return g_strcmp0 ((const gchar *) str1, (const gchar *) str2);
-}
+    gint id;
 
-static void
-_create_mechanism_cache (GSignondAuthSession *self)
-{
-    GSignondAuthSessionPrivate *priv = self->priv;
-
-    if (priv->available_mechanisms)
-        return;
+    if (!mechanism)
+        return FALSE;
 
-    gchar **mechanisms, **iter;
-    GSequence *allowed_mechanisms = NULL;
-    GSequenceIter *wcard = NULL;
-
-    self->priv->available_mechanisms = g_sequence_new (g_free);
-    if (!gsignond_identity_info_get_is_identity_new (priv->identity_info)) {
-        allowed_mechanisms = gsignond_identity_info_get_mechanisms (
-                                                           priv->identity_info,
-                                                           priv->method);
-        if (!allowed_mechanisms)
-            return;
-        wcard = g_sequence_lookup (allowed_mechanisms,
-                                   (gpointer) "*",
-                                   _sort_cmp, NULL);
-    }
+    id = gsignond_plugin_proxy_factory_get_mechanism_id (
+                gsignond_get_plugin_proxy_factory (), self->priv->method,
+                mechanism);
+    if (id < 0)
+        return FALSE;
 
-    g_object_get (self->priv->proxy, 
-                  "mechanisms", &mechanisms,
-                  NULL);
-    if (!mechanisms) {
-        if (allowed_mechanisms)
-            g_sequence_free (allowed_mechanisms);
-        return;
-    }
-    if (wcard || !allowed_mechanisms) {
-        DBG ("add all mechanisms to allowed");
-        for (iter = mechanisms; *iter != NULL; iter++) {
-            g_sequence_insert_sorted (priv->available_mechanisms,
-                                      (gpointer) *iter,
-                                      _sort_cmp,
-                                      NULL);
-            DBG ("  allow '%s'", *iter);
-        }
-    } else {
-        DBG ("allow intersection of plugin and ACL mechanisms");
-        for (iter = mechanisms; *iter != NULL; iter++) {
-            GSequenceIter *pos = g_sequence_lookup (allowed_mechanisms,
-                                                    (gpointer) *iter,
-                                                    _sort_cmp,
-                                                    NULL);
-            if (pos) {
-                DBG ("  allow: '%s'", *iter); 
-                g_sequence_insert_sorted (priv->available_mechanisms,
-                                          (gpointer) *iter,
-                                          _sort_cmp,
-                                          NULL);
-	    }
-        }
-    }
-    if (allowed_mechanisms)
-        g_sequence_free (allowed_mechanisms);
-    g_free (mechanisms);
+    return (gsignond_get_allowed_mechanisms (self->priv->identity_info,
+                                             self->priv->method) &
+            (G_GUINT64_CONSTANT(1) << id)) != 0;
 }
 
 gchar **
@@ -173,22 +139,24 @@ gsignond_auth_session_query_available_mechanisms (GSignondAuthSession *self,
 
     VALIDATE_X_ACCESS (self->priv->identity_info, ctx, NULL);
 
+    GSignondPluginProxyFactory *factory = gsignond_get_plugin_proxy_factory ();
+    const gchar **plugin_mechanisms = NULL;
+    GSignondMechanismSet allowed;
     gchar **mechanisms, **iter;
     const gchar **src_iter;
 
-    _create_mechanism_cache (self);
-    mechanisms = (gchar **)
-        g_malloc0 ((g_sequence_get_length (self->priv->available_mechanisms) +
-                   1) * sizeof(gchar *));
+    plugin_mechanisms = gsignond_plugin_proxy_factory_get_plugin_mechanisms (
+                                                factory, self->priv->method);
+    allowed = gsignond_get_allowed_mechanisms (self->priv->identity_info,
+                                               self->priv->method);
+    mechanisms = g_new0 (gchar *,
+                         g_strv_length ((gchar **) wanted_mechanisms) + 1);
     iter = mechanisms;
     for (src_iter = wanted_mechanisms; *src_iter != NULL; src_iter++) {
-        GSequenceIter *pos = g_sequence_lookup (
-                                              self->priv->available_mechanisms,
-                                              (gpointer) *src_iter,
-                                              _sort_cmp,
-                                              NULL);
-        if (pos) {
-            *iter = g_sequence_get (pos);
+        gint id = gsignond_plugin_proxy_factory_get_mechanism_id (factory,
+                                            self->priv->method, *src_iter);
+        if (id >= 0 && (allowed & (G_GUINT64_CONSTANT(1) << id))) {
+            *iter = (gchar *) plugin_mechanisms[id];
             iter++;
         }
     }
@@ -197,6 +165,199 @@ gsignond_auth_session_query_available_mechanisms (GSignondAuthSession *self,
     return mechanisms;
 }
 
+static gint
+_compare_keys (gconstpointer a, gconstpointer b)
+{
+    return g_strcmp0 (*(const gchar **) a, *(const gchar **) b);
+}
+
+/* serialized mechanism and session data, with the keys in sorted order so
+ * that equal requests have equal keys */
+static GBytes *
+_make_request_key (const gchar *mechanism,
+                   GSignondSessionData *session_data)
+{
+    GVariantBuilder builder;
+    GPtrArray *keys = g_ptr_array_new ();
+    GHashTableIter iter;
+    gpointer key;
+    GVariant *request;
+    GBytes *bytes;
+    guint i;
+
+    if (session_data) {
+        g_hash_table_iter_init (&iter, session_data);
+        while (g_hash_table_iter_next (&iter, &key, NULL))
+            g_ptr_array_add (keys, key);
+        g_ptr_array_sort (keys, _compare_keys);
+    }
+
+    g_variant_builder_init (&builder, G_VARIANT_TYPE_VARDICT);
+    for (i = 0; i < keys->len; i++) {
+        const gchar *name = g_ptr_array_index (keys, i);
+        g_variant_builder_add (&builder, "{sv}", name,
+                               gsignond_dictionary_get (session_data, name));
+    }
+    g_ptr_array_free (keys, TRUE);
+
+    request = g_variant_ref_sink (g_variant_new ("(sa{sv})",
+                                                 mechanism ? mechanism : "",
+                                                 &builder));
+    bytes = g_variant_get_data_as_bytes (request);
+    g_variant_unref (request);
+
+    return bytes;
+}
+
+static void
+_process_waiter_free (gpointer data)
+{
+    g_slice_free (_ProcessWaiter, data);
+}
+
+static void
+_process_data_add_waiter (_ProcessData *data,
+                          ProcessReadyCb ready_cb,
+                          StateChangeCb state_change_cb,
+                          gpointer userdata)
+{
+    _ProcessWaiter *waiter = g_slice_new0 (_ProcessWaiter);
+    waiter->ready_cb = ready_cb;
+    waiter->state_change_cb = state_change_cb;
+    waiter->userdata = userdata;
+    g_queue_push_tail (&data->waiters, waiter);
+}
+
+static void
+_cached_response_free (gpointer data)
+{
+    _CachedResponse *cached = (_CachedResponse *) data;
+
+    gsignond_dictionary_unref (cached->response);
+    g_slice_free (_CachedResponse, cached);
+}
+
+static gboolean
+_cached_response_is_expired (gpointer key,
+                             gpointer value,
+                             gpointer user_data)
+{
+    return ((_CachedResponse *) value)->expires_at <= *(gint64 *) user_data;
+}
+
+/* returns the response to pass to the client, with the cache hint of the
+ * plugin removed */
+static GSignondSessionData *
+_cache_response (GSignondAuthSession *self,
+                 GBytes *key,
+                 GSignondSessionData *result)
+{
+    _CachedResponse *cached;
+    guint32 ttl = 0;
+    gint64 now;
+
+    if (!result || !gsignond_session_data_get_cache_ttl (result, &ttl))
+        return gsignond_dictionary_ref (result);
+
+    result = gsignond_dictionary_copy (result);
+    gsignond_dictionary_remove (result, "CacheTtl");
+    if (ttl == 0 || !key || !self->priv->response_cache)
+        return result;
+
+    now = g_get_monotonic_time ();
+    g_hash_table_foreach_remove (self->priv->response_cache,
+                                 _cached_response_is_expired, &now);
+
+    cached = g_slice_new0 (_CachedResponse);
+    cached->response = gsignond_dictionary_ref (result);
+    cached->expires_at = now + (gint64) ttl * G_TIME_SPAN_SECOND;
+    g_hash_table_replace (self->priv->response_cache, g_bytes_ref (key),
+                          cached);
+    DBG ("caching response for %u s", ttl);
+
+    return result;
+}
+
+static gboolean
+_reply_from_cache (gpointer user_data)
+{
+    _CachedReply *reply = (_CachedReply *) user_data;
+
+    if (reply->ready_cb)
+        reply->ready_cb (reply->response, NULL, reply->userdata);
+
+    gsignond_dictionary_unref (reply->response);
+    g_object_unref (reply->self);
+    g_slice_free (_CachedReply, reply);
+
+    return FALSE;
+}
+
+/**
+ * gsignond_auth_session_clear_response_cache:
+ * @self: instance of #GSignondAuthSession
+ *
+ * Drops the plugin responses cached by @self, for instance when the identity
+ * it belongs to changes.
+ */
+void
+gsignond_auth_session_clear_response_cache (GSignondAuthSession *self)
+{
+    g_return_if_fail (self && GSIGNOND_IS_AUTH_SESSION (self));
+
+    if (self->priv->response_cache)
+        g_hash_table_remove_all (self->priv->response_cache);
+}
+
+/* answers every caller waiting on the request, and frees it */
+static void
+_process_data_complete (_ProcessData *data,
+                        GSignondSessionData *result,
+                        const GError *error)
+{
+    GSignondAuthSession *self = data->self;
+    _ProcessWaiter *waiter;
+
+    /* requests made from the callbacks start a new flight */
+    if (data->key && self->priv->in_flight &&
+        g_hash_table_lookup (self->priv->in_flight, data->key) == data)
+        g_hash_table_remove (self->priv->in_flight, data->key);
+
+    if (result)
+        result = _cache_response (self, data->key, result);
+
+    if (data->waiters.length > 1)
+        DBG ("answering %u coalesced requests", data->waiters.length);
+    while ((waiter = g_queue_pop_head (&data->waiters)) != NULL) {
+        if (waiter->ready_cb)
+            waiter->ready_cb (result, error, waiter->userdata);
+        _process_waiter_free (waiter);
+    }
+
+    if (result)
+        gsignond_dictionary_unref (result);
+    if (data->key)
+        g_bytes_unref (data->key);
+    g_slice_free (_ProcessData, data);
+}
+
+/* a cancelled request may be dropped without an answer, so new requests
+ * must not wait on it */
+static void
+_forget_in_flight (GSignondAuthSession *self)
+{
+    if (self->priv->in_flight)
+        g_hash_table_remove_all (self->priv->in_flight);
+}
+
+static void
+_process_request (GSignondAuthSession *self,
+                  GSignondSessionData *session_data,
+                  const gchar *mechanism,
+                  ProcessReadyCb ready_cb,
+                  StateChangeCb state_change_cb,
+                  gpointer userdata);
+
 gboolean
 gsignond_auth_session_process (GSignondAuthSession *self,
                                GSignondSessionData *session_data,
@@ -215,15 +376,24 @@ gsignond_auth_session_process (GSignondAuthSession *self,
 
     VALIDATE_X_ACCESS (self->priv->identity_info, ctx, FALSE);
 
-    _create_mechanism_cache (self);
-    if (!g_sequence_lookup (self->priv->available_mechanisms,
-                            (gpointer) mechanism,
-                            _sort_cmp,
-                            NULL)) {
+    if (!_mechanism_is_allowed (self, mechanism)) {
         if (error) *error = gsignond_get_gerror_for_id (GSIGNOND_ERROR_MECHANISM_NOT_AVAILABLE, "Mechanism is not available");
         return FALSE;
     }
 
+    /* only the plugin decides whether its response may be reused */
+    if (session_data)
+        gsignond_dictionary_remove (session_data, "CacheTtl");
+
+    /* clients may lower the priority of their requests but not raise it
+     * above the default, interactive requests are made by the daemon */
+    GSignondProcessPriority priority;
+    if (session_data &&
+        gsignond_session_data_get_process_priority (session_data, &priority) &&
+        priority > GSIGNOND_PROCESS_PRIORITY_NORMAL)
+        gsignond_session_data_set_process_priority (session_data,
+                GSIGNOND_PROCESS_PRIORITY_NORMAL);
+
     if (session_data && 
         self->priv->identity_info) {
         if (!gsignond_session_data_get_username (session_data)) {
@@ -245,14 +415,125 @@ gsignond_auth_session_process (GSignondAuthSession *self,
                                                       realms);
     }
 
-    _ProcessData * data = g_slice_new0 (_ProcessData);
+    _process_request (self, session_data, mechanism, ready_cb,
+                      state_change_cb, userdata);
+
+    return TRUE;
+}
+
+static void
+_process_request (GSignondAuthSession *self,
+                  GSignondSessionData *session_data,
+                  const gchar *mechanism,
+                  ProcessReadyCb ready_cb,
+                  StateChangeCb state_change_cb,
+                  gpointer userdata)
+{
+    guint32 timeout = 0;
+    gint64 deadline = 0;
+    GBytes *key = NULL;
+    _ProcessData *data = NULL;
+    _CachedResponse *cached = NULL;
+
+    /* the deadline covers the time the request waits for a plugin */
+    if (session_data &&
+        gsignond_session_data_get_process_timeout (session_data, &timeout) &&
+        timeout > 0)
+        deadline = g_get_monotonic_time () +
+                   (gint64) timeout * G_TIME_SPAN_MILLISECOND;
+
+    /* a request equal to one that is in flight, such as several
+     * applications refreshing the token of a shared identity at once, gets
+     * the answer to that one */
+    key = _make_request_key (mechanism, session_data);
+
+    /* the plugin allowed its answer to an equal request to be reused */
+    cached = g_hash_table_lookup (self->priv->response_cache, key);
+    if (cached && cached->expires_at > g_get_monotonic_time ()) {
+        _CachedReply *reply = g_slice_new0 (_CachedReply);
+        DBG ("answering request for mechanism '%s' from cache", mechanism);
+        reply->self = g_object_ref (self);
+        reply->response = gsignond_dictionary_ref (cached->response);
+        reply->ready_cb = ready_cb;
+        reply->userdata = userdata;
+        g_idle_add (_reply_from_cache, reply);
+        g_bytes_unref (key);
+        return;
+    }
+    if (cached)
+        g_hash_table_remove (self->priv->response_cache, key);
+
+    data = g_hash_table_lookup (self->priv->in_flight, key);
+    if (data) {
+        DBG ("coalescing request for mechanism '%s'", mechanism);
+        g_bytes_unref (key);
+        _process_data_add_waiter (data, ready_cb, state_change_cb, userdata);
+        return;
+    }
+
+    data = g_slice_new0 (_ProcessData);
     data->self = self;
-    data->ready_cb = ready_cb;
-    data->state_change_cb = state_change_cb;
-    data->userdata = userdata;
+    data->key = key;
+    g_queue_init (&data->waiters);
+    _process_data_add_waiter (data, ready_cb, state_change_cb, userdata);
+    g_hash_table_insert (self->priv->in_flight, g_bytes_ref (key), data);
+
     gsignond_plugin_proxy_process(self->priv->proxy, self, session_data,
                                   self->priv->token_data,
-                                  mechanism, data);
+                                  mechanism, deadline, data);
+}
+
+/**
+ * gsignond_auth_session_process_in_background:
+ * @self: instance of #GSignondAuthSession
+ * @ready_cb: (allow-none): called once the request is done
+ * @userdata: data for @ready_cb
+ *
+ * Repeats the request that made the plugin store the current token data,
+ * at background priority and without user interaction, so that the plugin
+ * refreshes the token before clients need it. No client sees the response,
+ * the plugin only stores the new token data.
+ *
+ * Returns: TRUE if a request was started, FALSE if no token was stored
+ * through @self.
+ */
+gboolean
+gsignond_auth_session_process_in_background (GSignondAuthSession *self,
+                                             ProcessReadyCb ready_cb,
+                                             gpointer userdata)
+{
+    GVariant *request, *data_variant = NULL;
+    const gchar *mechanism = NULL;
+    GSignondSessionData *session_data;
+
+    g_return_val_if_fail (self && GSIGNOND_IS_AUTH_SESSION (self), FALSE);
+
+    if (!self->priv->store_request)
+        return FALSE;
+
+    request = g_variant_ref_sink (g_variant_new_from_bytes (
+            G_VARIANT_TYPE ("(sa{sv})"), self->priv->store_request, TRUE));
+    g_variant_get (request, "(&s@a{sv})", &mechanism, &data_variant);
+    if (!_mechanism_is_allowed (self, mechanism)) {
+        DBG ("mechanism '%s' is no longer allowed", mechanism);
+        g_variant_unref (data_variant);
+        g_variant_unref (request);
+        return FALSE;
+    }
+
+    session_data = gsignond_dictionary_new_from_variant (data_variant);
+    gsignond_session_data_set_ui_policy (session_data,
+            GSIGNOND_UI_POLICY_NO_USER_INTERACTION);
+    gsignond_session_data_set_process_priority (session_data,
+            GSIGNOND_PROCESS_PRIORITY_BACKGROUND);
+
+    DBG ("refreshing token with mechanism '%s'", mechanism);
+    _process_request (self, session_data, mechanism, ready_cb, NULL,
+                      userdata);
+
+    gsignond_dictionary_unref (session_data);
+    g_variant_unref (data_variant);
+    g_variant_unref (request);
 
     return TRUE;
 }
@@ -269,6 +550,7 @@ gsignond_auth_session_cancel (GSignondAuthSession *self,
     }
     VALIDATE_X_ACCESS (self->priv->identity_info, ctx, FALSE);
 
+    _forget_in_flight (self);
     gsignond_plugin_proxy_cancel(self->priv->proxy, self);
     g_signal_emit (self, signals[SIG_PROCESS_CANCELED], 0, NULL);
 
@@ -280,6 +562,7 @@ gsignond_auth_session_abort_process (GSignondAuthSession *self)
 {
     g_return_if_fail (self && GSIGNOND_IS_AUTH_SESSION (self));
 
+    _forget_in_flight (self);
     gsignond_plugin_proxy_cancel (self->priv->proxy, self);
     g_signal_emit (self, signals[SIG_PROCESS_CANCELED], 0, NULL);
 }
@@ -288,14 +571,15 @@ void
 gsignond_auth_session_user_action_finished (GSignondAuthSession *self,
                                             GSignondSignonuiData *ui_data)
 {
-    gsignond_plugin_proxy_user_action_finished(self->priv->proxy, ui_data);
+    gsignond_plugin_proxy_user_action_finished(self->priv->proxy, self,
+                                               ui_data);
 }
 
 void
 gsignond_auth_session_refresh (GSignondAuthSession *self, 
                                GSignondSignonuiData *ui_data)
 {
-    gsignond_plugin_proxy_refresh(self->priv->proxy, ui_data);
+    gsignond_plugin_proxy_refresh(self->priv->proxy, self, ui_data);
 }
 
 GSignondAccessControlManager *
@@ -356,6 +640,21 @@ _dispose (GObject *object)
         self->priv->token_data = NULL;
     }
 
+    if (self->priv->in_flight) {
+        g_hash_table_unref (self->priv->in_flight);
+        self->priv->in_flight = NULL;
+    }
+
+    if (self->priv->response_cache) {
+        g_hash_table_unref (self->priv->response_cache);
+        self->priv->response_cache = NULL;
+    }
+
+    if (self->priv->store_request) {
+        g_bytes_unref (self->priv->store_request);
+        self->priv->store_request = NULL;
+    }
+
     G_OBJECT_CLASS (gsignond_auth_session_parent_class)->dispose (object);
 }
 
@@ -369,11 +668,6 @@ _finalize (GObject *object)
         self->priv->method = NULL;
     }
 
-    if (self->priv->available_mechanisms) {
-        g_sequence_free (self->priv->available_mechanisms);
-        self->priv->available_mechanisms = NULL;
-    }
-
     G_OBJECT_CLASS (gsignond_auth_session_parent_class)->finalize (object);
 }
 
@@ -386,7 +680,15 @@ gsignond_auth_session_init (GSignondAuthSession *self)
     self->priv->proxy = NULL;
     self->priv->identity_info = NULL;
     self->priv->token_data = NULL;
-    self->priv->available_mechanisms = NULL;
+    /* the requests are owned by the plugin proxy until they complete */
+    self->priv->in_flight = g_hash_table_new_full (g_bytes_hash,
+                                                   g_bytes_equal,
+                                                   (GDestroyNotify) g_bytes_unref,
+                                                   NULL);
+    self->priv->response_cache = g_hash_table_new_full (g_bytes_hash,
+            g_bytes_equal, (GDestroyNotify) g_bytes_unref,
+            _cached_response_free);
+    self->priv->store_request = NULL;
 }
 
 static void
@@ -490,11 +792,7 @@ gsignond_auth_session_notify_process_result (GSignondAuthSession *iface,
         WARN("assert (userdata)");
         return ;
     }
-    _ProcessData *data = (_ProcessData *)userdata;
-
-    if (data->ready_cb) data->ready_cb (result, NULL, data->userdata);
-
-    g_slice_free (_ProcessData, data);
+    _process_data_complete ((_ProcessData *)userdata, result, NULL);
 }
 
 void
@@ -506,11 +804,7 @@ gsignond_auth_session_notify_process_error (GSignondAuthSession *iface,
         WARN("assert (userdata)");
         return ;
     }
-    _ProcessData *data = (_ProcessData *)userdata;
-
-    if (data->ready_cb) data->ready_cb (NULL, error, data->userdata);
-
-    g_slice_free (_ProcessData, data);
+    _process_data_complete ((_ProcessData *)userdata, NULL, error);
 }
 
 void 
@@ -524,17 +818,35 @@ gsignond_auth_session_notify_state_changed (GSignondAuthSession *self,
         return ;
     }
     _ProcessData *data = (_ProcessData *)userdata;
+    GList *link;
 
-    if (data->state_change_cb) data->state_change_cb (state, message, data->userdata);
+    for (link = data->waiters.head; link; link = link->next) {
+        _ProcessWaiter *waiter = (_ProcessWaiter *) link->data;
+        if (waiter->state_change_cb)
+            waiter->state_change_cb (state, message, waiter->userdata);
+    }
 }
 
 void 
 gsignond_auth_session_notify_store (GSignondAuthSession *self, 
-                                    GSignondDictionary *token_data)
+                                    GSignondDictionary *token_data,
+                                    gpointer userdata)
 {
+    _ProcessData *data = (_ProcessData *) userdata;
+
     g_return_if_fail (self && GSIGNOND_IS_AUTH_SESSION (self));
     g_return_if_fail (token_data);
 
+    /* remembered to refresh the token the same way */
+    if (data && data->key) {
+        if (self->priv->store_request)
+            g_bytes_unref (self->priv->store_request);
+        self->priv->store_request = g_bytes_ref (data->key);
+    }
+
+    /* responses may depend on the tokens being replaced */
+    gsignond_auth_session_clear_response_cache (self);
+
     /* cache token data */
     if (self->priv->token_data)
         gsignond_dictionary_unref (self->priv->token_data);
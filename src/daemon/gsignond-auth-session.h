@@ -95,6 +95,14 @@ gsignond_auth_session_cancel (GSignondAuthSession *self,
 void
 gsignond_auth_session_abort_process (GSignondAuthSession *self);
 
+void
+gsignond_auth_session_clear_response_cache (GSignondAuthSession *self);
+
+gboolean
+gsignond_auth_session_process_in_background (GSignondAuthSession *self,
+                                             ProcessReadyCb ready_cb,
+                                             gpointer userdata);
+
 void 
 gsignond_auth_session_user_action_finished (GSignondAuthSession *self,
                                             GSignondSignonuiData *ui_data);
@@ -132,7 +140,8 @@ gsignond_auth_session_notify_state_changed (GSignondAuthSession *self,
 
 void 
 gsignond_auth_session_notify_store (GSignondAuthSession *self, 
-                                    GSignondDictionary *token_data);
+                                    GSignondDictionary *token_data,
+                                    gpointer userdata);
 
 void 
 gsignond_auth_session_notify_user_action_required (GSignondAuthSession *self, 
@@ -35,7 +35,10 @@
 #include "gsignond/gsignond-extension-interface.h"
 #include "gsignond/gsignond-utils.h"
 #include "daemon/gsignond-identity.h"
+#include "daemon/gsignond-auth-session.h"
 #include "daemon/db/gsignond-db-credentials-database.h"
+#include "common/gsignond-identity-info-internal.h"
+#include "common/gsignond-refresh-schedule.h"
 
 struct _GSignondDaemonPrivate
 {
@@ -49,8 +52,38 @@ struct _GSignondDaemonPrivate
     GSignondAccessControlManager *acm;
     GSignondPluginProxyFactory *plugin_proxy_factory;
     GSignondSignonuiProxy *ui;
+    GHashTable          *mechanism_sets; /* set of _MechanismSetEntry */
+    /* prebuilt query replies, valid for one plugin registry generation */
+    guint                replies_generation;
+    GVariant            *methods_reply;
+    GHashTable          *mechanisms_replies; /* method -> GVariant */
+    GSignondRefreshSchedule *token_refreshes; /* session, by identity */
 };
 
+#define GSIGNOND_MECHANISM_SET_CACHE_SIZE 512
+
+/* allowed mechanisms of a method for one generation of identity methods */
+typedef struct {
+    guint methods_generation;
+    gchar *method;
+    GSignondMechanismSet mechanisms;
+} _MechanismSetEntry;
+
+/* refresh times are rounded up to this, in seconds, so that the daemon
+ * wakes up rarely while it waits for tokens to expire */
+#define GSIGNOND_DAEMON_TOKEN_REFRESH_TICK 60
+/* tokens are refreshed this long before they expire, a minute more than
+ * the rounding may take */
+#define GSIGNOND_DAEMON_TOKEN_REFRESH_LEAD 120
+/* and not sooner than this after they are stored, in seconds */
+#define GSIGNOND_DAEMON_TOKEN_REFRESH_MIN_DELAY 30
+/* a token that keeps coming back with less time than that to live is
+ * given up on after this many refreshes in a row */
+#define GSIGNOND_DAEMON_TOKEN_REFRESH_MAX_SHORT 3
+
+static void _on_token_refresh (gpointer session, gpointer identity,
+                               gpointer userdata);
+
 G_DEFINE_TYPE (GSignondDaemon, gsignond_daemon, G_TYPE_OBJECT)
 
 
@@ -88,11 +121,58 @@ _free_identity (gpointer data, gpointer user_data)
     g_object_unref (identity);
 }
 
+static guint
+_mechanism_set_entry_hash (gconstpointer key)
+{
+    const _MechanismSetEntry *entry = (const _MechanismSetEntry *) key;
+
+    return g_str_hash (entry->method) ^ entry->methods_generation;
+}
+
+static gboolean
+_mechanism_set_entry_equal (gconstpointer a, gconstpointer b)
+{
+    const _MechanismSetEntry *entry1 = (const _MechanismSetEntry *) a;
+    const _MechanismSetEntry *entry2 = (const _MechanismSetEntry *) b;
+
+    return entry1->methods_generation == entry2->methods_generation &&
+           g_strcmp0 (entry1->method, entry2->method) == 0;
+}
+
+static void
+_mechanism_set_entry_free (gpointer data)
+{
+    _MechanismSetEntry *entry = (_MechanismSetEntry *) data;
+
+    gsignond_str_unintern (entry->method);
+    g_slice_free (_MechanismSetEntry, entry);
+}
+
 static void
 _dispose (GObject *object)
 {
     GSignondDaemon *self = GSIGNOND_DAEMON(object);
 
+    if (self->priv->token_refreshes) {
+        gsignond_refresh_schedule_free (self->priv->token_refreshes);
+        self->priv->token_refreshes = NULL;
+    }
+
+    if (self->priv->mechanism_sets) {
+        g_hash_table_unref (self->priv->mechanism_sets);
+        self->priv->mechanism_sets = NULL;
+    }
+
+    if (self->priv->methods_reply) {
+        g_variant_unref (self->priv->methods_reply);
+        self->priv->methods_reply = NULL;
+    }
+
+    if (self->priv->mechanisms_replies) {
+        g_hash_table_unref (self->priv->mechanisms_replies);
+        self->priv->mechanisms_replies = NULL;
+    }
+
     if (self->priv->ui) {
         g_object_unref (self->priv->ui);
         self->priv->ui = NULL;
@@ -317,6 +397,16 @@ gsignond_daemon_init (GSignondDaemon *self)
     self->priv->config = gsignond_config_new ();
     self->priv->identities = g_hash_table_new_full (
             g_direct_hash, g_direct_equal, NULL, NULL);
+    self->priv->mechanism_sets = g_hash_table_new_full (
+            _mechanism_set_entry_hash, _mechanism_set_entry_equal,
+            _mechanism_set_entry_free, NULL);
+    self->priv->mechanisms_replies = g_hash_table_new_full (
+            g_str_hash, g_str_equal, g_free, (GDestroyNotify)g_variant_unref);
+    self->priv->token_refreshes = gsignond_refresh_schedule_new (
+            GSIGNOND_DAEMON_TOKEN_REFRESH_TICK * 1000,
+            GSIGNOND_DAEMON_TOKEN_REFRESH_MIN_DELAY * 1000,
+            GSIGNOND_DAEMON_TOKEN_REFRESH_MAX_SHORT,
+            _on_token_refresh, self);
     self->priv->plugin_proxy_factory = gsignond_plugin_proxy_factory_new(
         self->priv->config);
     
@@ -493,12 +583,7 @@ gsignond_daemon_get_identity (GSignondDaemon *daemon,
 
 #define VALIDATE_IDENTITY_X_ACCESS(info, ctx, ret) \
 { \
-    GSignondAccessControlManager *acm = daemon->priv->acm; \
-    GSignondSecurityContextList *acl = gsignond_identity_info_get_access_control_list (info); \
-    GSignondSecurityContext *owner = gsignond_identity_info_get_owner (info); \
-    gboolean valid = gsignond_access_control_manager_peer_is_allowed_to_use_identity (acm, ctx, owner, acl); \
-    gsignond_security_context_free (owner); \
-    gsignond_security_context_list_free (acl); \
+    gboolean valid = gsignond_daemon_peer_is_allowed_to_use_identity (daemon, ctx, info); \
     if (!valid) { \
         WARN ("identity access check failed"); \
         gsignond_identity_info_unref (info); \
@@ -551,7 +636,388 @@ gsignond_daemon_get_identity (GSignondDaemon *daemon,
 #undef VALIDATE_IDENTITY_READ_ACCESS
 }
 
-const gchar ** 
+typedef struct {
+    GSignondIdentity *identity;
+    ProcessReadyCb ready_cb;
+    gpointer userdata;
+    GSignondSessionData *results;
+    GError *error;
+} _Authentication;
+
+static gboolean
+_complete_authentication (gpointer user_data)
+{
+    _Authentication *auth = (_Authentication *) user_data;
+
+    if (auth->ready_cb)
+        auth->ready_cb (auth->results, auth->error, auth->userdata);
+
+    if (auth->results)
+        gsignond_dictionary_unref (auth->results);
+    if (auth->error)
+        g_error_free (auth->error);
+    g_object_unref (auth->identity);
+    g_slice_free (_Authentication, auth);
+
+    return FALSE;
+}
+
+static void
+_on_authenticated (GSignondSessionData *results,
+                   const GError *error,
+                   gpointer user_data)
+{
+    _Authentication *auth = (_Authentication *) user_data;
+
+    /* a plugin that failed to load answers from within
+     * gsignond_auth_session_process(), before the caller got the session */
+    if (results)
+        auth->results = gsignond_dictionary_ref (results);
+    if (error)
+        auth->error = g_error_copy (error);
+    g_idle_add (_complete_authentication, auth);
+}
+
+/**
+ * gsignond_daemon_authenticate:
+ * @daemon: instance of #GSignondDaemon
+ * @id: id of the identity to authenticate with
+ * @method: authentication method
+ * @mechanism: authentication mechanism
+ * @session_data: data for the authentication request
+ * @ctx: security context of the peer
+ * @ready_cb: called with the final response of the request
+ * @userdata: data for @ready_cb
+ * @error: (out): return location for the error
+ *
+ * Runs an authentication request as the sequence of
+ * gsignond_daemon_get_identity(), gsignond_identity_get_auth_session() and
+ * gsignond_auth_session_process() would, with the same access checks, but
+ * without a client holding the identity and the session in between. The
+ * identity is kept alive until the request is done, so that the dialogs
+ * and the token data of the request are handled as usual.
+ *
+ * @ready_cb is always called from the main loop, never before this
+ * function returns.
+ *
+ * Returns: (transfer full): the session the request runs on, or NULL if the
+ * request could not be started, in which case @ready_cb is not called.
+ */
+GSignondAuthSession *
+gsignond_daemon_authenticate (GSignondDaemon *daemon,
+                              guint32 id,
+                              const gchar *method,
+                              const gchar *mechanism,
+                              GSignondSessionData *session_data,
+                              const GSignondSecurityContext *ctx,
+                              ProcessReadyCb ready_cb,
+                              gpointer userdata,
+                              GError **error)
+{
+    GSignondIdentity *identity = NULL;
+    GSignondAuthSession *session = NULL;
+    _Authentication *auth = NULL;
+
+    identity = gsignond_daemon_get_identity (daemon, id, ctx, error);
+    if (!identity)
+        return NULL;
+
+    session = gsignond_identity_get_auth_session (identity, method, ctx,
+                                                  error);
+    if (!session) {
+        g_object_unref (identity);
+        return NULL;
+    }
+
+    auth = g_slice_new0 (_Authentication);
+    auth->identity = identity;
+    auth->ready_cb = ready_cb;
+    auth->userdata = userdata;
+    if (!gsignond_auth_session_process (session, session_data, mechanism,
+                                        ctx, _on_authenticated, NULL, auth,
+                                        error)) {
+        g_slice_free (_Authentication, auth);
+        g_object_unref (session);
+        g_object_unref (identity);
+        return NULL;
+    }
+
+    DBG ("authenticating with identity %u, method '%s'", id, method);
+
+    return session;
+}
+
+static void
+_add_identity_error (GVariantBuilder *errors,
+                     guint32 id,
+                     GSignondError code,
+                     const gchar *message)
+{
+    GError *error = gsignond_get_gerror_for_id (code, "%s", message);
+    gchar *name = g_dbus_error_encode_gerror (error);
+
+    g_variant_builder_add (errors, "{us}", id, name);
+    g_free (name);
+    g_error_free (error);
+}
+
+/**
+ * gsignond_daemon_get_identities_info:
+ * @daemon: instance of #GSignondDaemon
+ * @ids: identity ids, of type "au"
+ * @ctx: security context of the peer
+ * @errors: (out) (transfer full): the D-Bus error name for each id whose
+ * info is not returned, of type "a{us}"
+ *
+ * Reads the info of several identities at once, as
+ * gsignond_daemon_get_identity() and gsignond_identity_get_info() would for
+ * each id, with the same access checks. Identities in use are taken from
+ * the cache, the others are selected from the database with one id query
+ * and then read one by one, without creating identity objects for them.
+ * Each id is answered once, however often it is listed.
+ *
+ * Returns: (transfer full): the info of the identities the peer may use, of
+ * type "aa{sv}", in the order of @ids.
+ */
+GVariant *
+gsignond_daemon_get_identities_info (GSignondDaemon *daemon,
+                                     GVariant *ids,
+                                     const GSignondSecurityContext *ctx,
+                                     GVariant **errors)
+{
+    GHashTable *infos = NULL; /* id -> GSignondIdentityInfo */
+    GHashTable *seen = NULL;
+    GArray *unique_ids = NULL;
+    GVariantBuilder missing, builder, error_builder;
+    GVariantIter iter;
+    guint32 id;
+    guint i;
+    gboolean load = FALSE;
+
+    g_return_val_if_fail (daemon && GSIGNOND_IS_DAEMON (daemon), NULL);
+    g_return_val_if_fail (ids && ctx && errors, NULL);
+
+    /* each id is answered once, in the order it is first listed */
+    seen = g_hash_table_new (g_direct_hash, g_direct_equal);
+    unique_ids = g_array_new (FALSE, FALSE, sizeof (guint32));
+    g_variant_iter_init (&iter, ids);
+    while (g_variant_iter_next (&iter, "u", &id)) {
+        if (g_hash_table_contains (seen, GUINT_TO_POINTER (id)))
+            continue;
+        g_hash_table_add (seen, GUINT_TO_POINTER (id));
+        g_array_append_val (unique_ids, id);
+    }
+    g_hash_table_unref (seen);
+
+    infos = g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL,
+                                   (GDestroyNotify) gsignond_identity_info_unref);
+
+    /* identities in use have the current info */
+    g_variant_builder_init (&missing, G_VARIANT_TYPE ("au"));
+    for (i = 0; i < unique_ids->len; i++) {
+        GSignondIdentity *identity;
+
+        id = g_array_index (unique_ids, guint32, i);
+        if (id == 0)
+            continue;
+        identity = g_hash_table_lookup (daemon->priv->identities,
+                                        GUINT_TO_POINTER (id));
+        if (identity) {
+            g_hash_table_insert (infos, GUINT_TO_POINTER (id),
+                    gsignond_identity_info_ref (
+                        gsignond_identity_get_identity_info (identity)));
+        } else {
+            g_variant_builder_add (&missing, "u", id);
+            load = TRUE;
+        }
+    }
+
+    if (load) {
+        GSignondDictionary *filter = gsignond_dictionary_new ();
+        GSignondIdentityInfoList *list, *item;
+
+        gsignond_dictionary_set (filter, "Ids",
+                                 g_variant_builder_end (&missing));
+        list = gsignond_db_credentials_database_load_identities (
+                daemon->priv->db, filter);
+        gsignond_dictionary_unref (filter);
+        for (item = list; item; item = g_list_next (item)) {
+            GSignondIdentityInfo *info = (GSignondIdentityInfo *) item->data;
+            g_hash_table_insert (infos,
+                    GUINT_TO_POINTER (gsignond_identity_info_get_id (info)),
+                    gsignond_identity_info_ref (info));
+        }
+        gsignond_identity_info_list_free (list);
+    } else {
+        g_variant_builder_clear (&missing);
+    }
+
+    DBG ("%u of %u identities found", g_hash_table_size (infos),
+         unique_ids->len);
+
+    g_variant_builder_init (&builder, G_VARIANT_TYPE ("aa{sv}"));
+    g_variant_builder_init (&error_builder, G_VARIANT_TYPE ("a{us}"));
+    for (i = 0; i < unique_ids->len; i++) {
+        GSignondIdentityInfo *info;
+
+        id = g_array_index (unique_ids, guint32, i);
+        if (id == 0) {
+            _add_identity_error (&error_builder, id,
+                    GSIGNOND_ERROR_IDENTITY_ERR, "Invalid identity id");
+            continue;
+        }
+        info = g_hash_table_lookup (infos, GUINT_TO_POINTER (id));
+        if (!info) {
+            _add_identity_error (&error_builder, id,
+                    GSIGNOND_ERROR_IDENTITY_NOT_FOUND, "Identity not found");
+            continue;
+        }
+
+        /* the checks of getIdentity and of getInfo */
+        if (gsignond_daemon_peer_is_allowed_to_use_identity (daemon, ctx,
+                                                             info) &&
+            gsignond_access_control_manager_peer_is_owner_of_identity (
+                    daemon->priv->acm, ctx,
+                    gsignond_identity_info_get_owner (info)))
+            g_variant_builder_add_value (&builder,
+                    gsignond_identity_info_to_variant (info));
+        else
+            _add_identity_error (&error_builder, id,
+                    GSIGNOND_ERROR_PERMISSION_DENIED, "Can not read identity");
+    }
+    g_hash_table_unref (infos);
+    g_array_unref (unique_ids);
+
+    *errors = g_variant_builder_end (&error_builder);
+    return g_variant_builder_end (&builder);
+}
+
+/**
+ * gsignond_daemon_peer_is_allowed_to_use_identity:
+ * @daemon: instance of #GSignondDaemon
+ * @ctx: security context of the peer
+ * @info: identity info to check the access against
+ *
+ * Checks if the peer is allowed to use the identity. Decisions are remembered
+ * by the access control manager per identity ACL generation, so that the
+ * access control list is evaluated only once per peer until it changes.
+ *
+ * Returns: TRUE if access is allowed, FALSE otherwise
+ */
+gboolean
+gsignond_daemon_peer_is_allowed_to_use_identity (GSignondDaemon *daemon,
+                                                 const GSignondSecurityContext *ctx,
+                                                 GSignondIdentityInfo *info)
+{
+    g_return_val_if_fail (daemon && GSIGNOND_IS_DAEMON (daemon), FALSE);
+    g_return_val_if_fail (ctx && info, FALSE);
+
+    GSignondAccessControlManager *acm = daemon->priv->acm;
+    GSignondSecurityContextList *acl = NULL;
+    GSignondSecurityContext *owner = NULL;
+    guint32 id = gsignond_identity_info_get_id (info);
+    guint generation = gsignond_identity_info_get_acl_generation (info);
+    gboolean allowed = FALSE;
+
+    if (gsignond_access_control_manager_lookup_identity_decision (
+                                        acm, ctx, id, generation, &allowed))
+        return allowed;
+
+    acl = gsignond_identity_info_get_access_control_list (info);
+    owner = gsignond_identity_info_get_owner (info);
+    allowed = gsignond_access_control_manager_peer_is_allowed_to_use_identity (
+                                                        acm, ctx, owner, acl);
+
+    gsignond_access_control_manager_cache_identity_decision (
+                                        acm, ctx, id, generation, allowed);
+
+    return allowed;
+}
+
+/**
+ * gsignond_daemon_get_allowed_mechanisms:
+ * @daemon: instance of #GSignondDaemon
+ * @info: identity info
+ * @method: authentication method
+ *
+ * Intersects the mechanisms of the @method plugin with the mechanisms the
+ * identity allows for @method. The result is shared by all auth sessions of
+ * the identity and recomputed only when the identity methods change.
+ *
+ * Returns: set of mechanism ids assigned by #GSignondPluginProxyFactory
+ */
+GSignondMechanismSet
+gsignond_daemon_get_allowed_mechanisms (GSignondDaemon *daemon,
+                                        GSignondIdentityInfo *info,
+                                        const gchar *method)
+{
+    GSignondPluginProxyFactory *factory = NULL;
+    GSequence *allowed = NULL;
+    _MechanismSetEntry key, *entry = NULL;
+
+    g_return_val_if_fail (daemon && GSIGNOND_IS_DAEMON (daemon), 0);
+    g_return_val_if_fail (info && method, 0);
+
+    factory = daemon->priv->plugin_proxy_factory;
+    if (gsignond_identity_info_get_is_identity_new (info))
+        return gsignond_plugin_proxy_factory_get_mechanism_set (factory,
+                                                                method, NULL);
+
+    key.methods_generation =
+        gsignond_identity_info_get_methods_generation (info);
+    key.method = (gchar *) method;
+    entry = g_hash_table_lookup (daemon->priv->mechanism_sets, &key);
+    if (entry)
+        return entry->mechanisms;
+
+    if (g_hash_table_size (daemon->priv->mechanism_sets) >=
+            GSIGNOND_MECHANISM_SET_CACHE_SIZE) {
+        DBG ("mechanism set cache full, flushing");
+        g_hash_table_remove_all (daemon->priv->mechanism_sets);
+    }
+
+    entry = g_slice_new0 (_MechanismSetEntry);
+    entry->methods_generation = key.methods_generation;
+    entry->method = (gchar *) gsignond_str_intern (method);
+    allowed = gsignond_identity_info_get_mechanisms (info, method);
+    if (allowed)
+        entry->mechanisms = gsignond_plugin_proxy_factory_get_mechanism_set (
+                                                    factory, method, allowed);
+    g_hash_table_add (daemon->priv->mechanism_sets, entry);
+
+    return entry->mechanisms;
+}
+
+/* drops the prebuilt replies once the plugin registry has changed */
+static void
+_sync_query_replies (GSignondDaemon *daemon)
+{
+    guint generation = gsignond_plugin_proxy_factory_get_generation (
+            daemon->priv->plugin_proxy_factory);
+
+    if (daemon->priv->replies_generation == generation)
+        return;
+
+    if (daemon->priv->methods_reply) {
+        g_variant_unref (daemon->priv->methods_reply);
+        daemon->priv->methods_reply = NULL;
+    }
+    g_hash_table_remove_all (daemon->priv->mechanisms_replies);
+    daemon->priv->replies_generation = generation;
+}
+
+/**
+ * gsignond_daemon_query_methods:
+ * @daemon: instance of #GSignondDaemon
+ * @error: return location for error
+ *
+ * Returns the names of available authentication methods as an "as" variant.
+ * The variant is built once per plugin registry generation and shared
+ * between callers.
+ *
+ * Returns: (transfer none): the methods, or NULL on error.
+ */
+GVariant *
 gsignond_daemon_query_methods (GSignondDaemon *daemon, GError **error)
 {
     if (!daemon || !GSIGNOND_IS_DAEMON (daemon)) {
@@ -560,11 +1026,32 @@ gsignond_daemon_query_methods (GSignondDaemon *daemon, GError **error)
         return NULL;
     }
 
-    return gsignond_plugin_proxy_factory_get_plugin_types (
+    const gchar **methods = gsignond_plugin_proxy_factory_get_plugin_types (
             daemon->priv->plugin_proxy_factory);
+
+    _sync_query_replies (daemon);
+
+    if (!daemon->priv->methods_reply) {
+        daemon->priv->methods_reply = g_variant_ref_sink (
+                g_variant_new_strv (methods, methods ? -1 : 0));
+    }
+
+    return daemon->priv->methods_reply;
 }
 
-const gchar ** 
+/**
+ * gsignond_daemon_query_mechanisms:
+ * @daemon: instance of #GSignondDaemon
+ * @method: the method
+ * @error: return location for error
+ *
+ * Returns the mechanisms supported by @method as an "as" variant. The
+ * variant is built once per plugin registry generation and shared between
+ * callers.
+ *
+ * Returns: (transfer none): the mechanisms, or NULL if @method is unknown.
+ */
+GVariant *
 gsignond_daemon_query_mechanisms (GSignondDaemon *daemon, const gchar *method, GError **error) 
 {
     if (!daemon || !GSIGNOND_IS_DAEMON (daemon)) {
@@ -579,9 +1066,20 @@ gsignond_daemon_query_mechanisms (GSignondDaemon *daemon, const gchar *method, G
     if (!mechanisms || mechanisms[0] == NULL) {
         DBG("no mechanisms found for method '%s'", method);
         if (error) *error = gsignond_get_gerror_for_id (GSIGNOND_ERROR_METHOD_NOT_KNOWN, "method '%s' not found", method);
+        return NULL;
     }
 
-    return mechanisms;
+    _sync_query_replies (daemon);
+
+    GVariant *reply = g_hash_table_lookup (daemon->priv->mechanisms_replies,
+                                           method);
+    if (!reply) {
+        reply = g_variant_ref_sink (g_variant_new_strv (mechanisms, -1));
+        g_hash_table_insert (daemon->priv->mechanisms_replies,
+                             g_strdup (method), reply);
+    }
+
+    return reply;
 }
 
 static gboolean
@@ -800,12 +1298,121 @@ gsignond_daemon_cancel_dialog (GSignondDaemon *self,
     return gsignond_signonui_proxy_cancel_request (self->priv->ui, caller, handler, userdata);
 }
 
+static void
+_on_token_refreshed (GSignondSessionData *results,
+                     const GError *error,
+                     gpointer userdata)
+{
+    if (error)
+        DBG ("token refresh failed: %s", error->message);
+
+    /* the identity stores the new token until here */
+    g_object_unref (userdata);
+}
+
+static void
+_on_token_refresh (gpointer session, gpointer identity, gpointer userdata)
+{
+    GSignondDaemon *self = GSIGNOND_DAEMON (userdata);
+
+    if (!gsignond_auth_session_process_in_background (session,
+                _on_token_refreshed, g_object_ref (identity))) {
+        DBG ("no request to refresh the token of session %p", session);
+        g_object_unref (identity);
+        gsignond_refresh_schedule_remove (self->priv->token_refreshes,
+                                          session);
+    }
+}
+
+/**
+ * gsignond_daemon_schedule_token_refresh:
+ * @self: instance of #GSignondDaemon
+ * @identity: identity @session belongs to
+ * @session: auth session that stored a token
+ * @expiry: time the token expires, in seconds since the epoch
+ *
+ * Repeats the request that stored the token of @session in the background
+ * shortly before @expiry, so that the plugin refreshes the token before a
+ * client finds it expired. A refresh already scheduled for @session is
+ * replaced. Neither @identity nor @session is kept alive for the refresh;
+ * the identity cancels it with gsignond_daemon_cancel_token_refreshes()
+ * when either goes away or the identity is signed out or removed.
+ */
+void
+gsignond_daemon_schedule_token_refresh (GSignondDaemon *self,
+                                        GSignondIdentity *identity,
+                                        GSignondAuthSession *session,
+                                        gint64 expiry)
+{
+    gint64 delay;
+
+    g_return_if_fail (self && GSIGNOND_IS_DAEMON (self));
+    g_return_if_fail (identity && GSIGNOND_IS_IDENTITY (identity));
+    g_return_if_fail (session && GSIGNOND_IS_AUTH_SESSION (session));
+
+    if (!self->priv->token_refreshes)
+        return;
+
+    delay = expiry - GSIGNOND_DAEMON_TOKEN_REFRESH_LEAD -
+            g_get_real_time () / G_USEC_PER_SEC;
+    delay = CLAMP (delay, 0, G_MAXUINT / 1000);
+    if (gsignond_refresh_schedule_add (self->priv->token_refreshes, session,
+                                       identity, delay * 1000))
+        DBG ("token of session %p refreshed in %" G_GINT64_FORMAT " s",
+             session, MAX (delay, GSIGNOND_DAEMON_TOKEN_REFRESH_MIN_DELAY));
+}
+
+/**
+ * gsignond_daemon_cancel_token_refreshes:
+ * @self: instance of #GSignondDaemon
+ * @identity: identity the refreshes belong to
+ * @session: (allow-none): auth session whose refresh to cancel, or NULL
+ * for the refreshes of every session of @identity
+ *
+ * Cancels token refreshes scheduled with
+ * gsignond_daemon_schedule_token_refresh(), so that a stale request does
+ * not store a token again after a sign out.
+ */
+void
+gsignond_daemon_cancel_token_refreshes (GSignondDaemon *self,
+                                        GSignondIdentity *identity,
+                                        GSignondAuthSession *session)
+{
+    g_return_if_fail (self && GSIGNOND_IS_DAEMON (self));
+
+    if (!self->priv->token_refreshes)
+        return;
+
+    if (session)
+        gsignond_refresh_schedule_remove (self->priv->token_refreshes,
+                                          session);
+    else
+        gsignond_refresh_schedule_remove_owner (self->priv->token_refreshes,
+                                                identity);
+}
+
 GSignondAccessControlManager *
 gsignond_get_access_control_manager ()
 {
     return gsignond_daemon_get_access_control_manager(GSIGNOND_DAEMON(self));
 }
 
+gboolean
+gsignond_peer_is_allowed_to_use_identity (const GSignondSecurityContext *ctx,
+                                          GSignondIdentityInfo *info)
+{
+    return gsignond_daemon_peer_is_allowed_to_use_identity (
+                                            GSIGNOND_DAEMON(self), ctx, info);
+}
+
+GSignondMechanismSet
+gsignond_get_allowed_mechanisms (GSignondIdentityInfo *info,
+                                 const gchar *method)
+{
+    return gsignond_daemon_get_allowed_mechanisms (GSIGNOND_DAEMON(self),
+                                                   info, method);
+}
+
 GSignondPluginProxyFactory *
 gsignond_get_plugin_proxy_factory ()
 {
@@ -32,6 +32,7 @@
 #include <gsignond/gsignond-access-control-manager.h>
 #include "common/gsignond-identity-info.h"
 #include "gsignond-signonui-proxy.h"
+#include "gsignond-auth-session.h"
 #include "plugins/gsignond-plugin-proxy-factory.h"
 
 G_BEGIN_DECLS
@@ -73,10 +74,37 @@ gsignond_daemon_get_identity (GSignondDaemon *daemon,
                               const GSignondSecurityContext *ctx,
                               GError **error);
 
-const gchar ** 
+GSignondAuthSession *
+gsignond_daemon_authenticate (GSignondDaemon *daemon,
+                              guint32 id,
+                              const gchar *method,
+                              const gchar *mechanism,
+                              GSignondSessionData *session_data,
+                              const GSignondSecurityContext *ctx,
+                              ProcessReadyCb ready_cb,
+                              gpointer userdata,
+                              GError **error);
+
+GVariant *
+gsignond_daemon_get_identities_info (GSignondDaemon *daemon,
+                                     GVariant *ids,
+                                     const GSignondSecurityContext *ctx,
+                                     GVariant **errors);
+
+gboolean
+gsignond_daemon_peer_is_allowed_to_use_identity (GSignondDaemon *daemon,
+                                                 const GSignondSecurityContext *ctx,
+                                                 GSignondIdentityInfo *info);
+
+GSignondMechanismSet
+gsignond_daemon_get_allowed_mechanisms (GSignondDaemon *daemon,
+                                        GSignondIdentityInfo *info,
+                                        const gchar *method);
+
+GVariant *
 gsignond_daemon_query_methods (GSignondDaemon *daemon, GError **error);
 
-const gchar ** 
+GVariant *
 gsignond_daemon_query_mechanisms (GSignondDaemon *daemon,
                                   const gchar *method,
                                   GError **error);
@@ -152,9 +180,28 @@ gsignond_daemon_cancel_dialog (GSignondDaemon *self,
                                GSignondSignonuiProxyCancelRequestCb handler,
                                gpointer userdata);
 
+void
+gsignond_daemon_schedule_token_refresh (GSignondDaemon *daemon,
+                                        GSignondIdentity *identity,
+                                        GSignondAuthSession *session,
+                                        gint64 expiry);
+
+void
+gsignond_daemon_cancel_token_refreshes (GSignondDaemon *daemon,
+                                        GSignondIdentity *identity,
+                                        GSignondAuthSession *session);
+
 GSignondAccessControlManager *
 gsignond_get_access_control_manager ();
 
+gboolean
+gsignond_peer_is_allowed_to_use_identity (const GSignondSecurityContext *ctx,
+                                          GSignondIdentityInfo *info);
+
+GSignondMechanismSet
+gsignond_get_allowed_mechanisms (GSignondIdentityInfo *info,
+                                 const gchar *method);
+
 GSignondPluginProxyFactory *
 gsignond_get_plugin_proxy_factory ();
 
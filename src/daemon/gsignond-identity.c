@@ -61,6 +61,7 @@ struct _GSignondIdentityPrivate
     GSignondIdentityInfo *info;
     GSignondDaemon *owner;
     GHashTable *auth_sessions; // (auth_method,auth_session) table
+    GVariant *info_reply; // cached getInfo() reply, dropped on info changes
 };
 
 typedef struct _GSignondIdentityCbData
@@ -82,12 +83,7 @@ static void _on_store_token (GSignondAuthSession *session, GSignondDictionary *t
 
 #define VALIDATE_IDENTITY_X_ACCESS(identity, ctx, ret) \
 { \
-    GSignondAccessControlManager *acm = gsignond_daemon_get_access_control_manager (identity->priv->owner); \
-    GSignondSecurityContextList *acl = gsignond_identity_info_get_access_control_list (identity->priv->info); \
-    GSignondSecurityContext *owner = gsignond_identity_info_get_owner (identity->priv->info); \
-    gboolean valid = gsignond_access_control_manager_peer_is_allowed_to_use_identity (acm, ctx, owner, acl); \
-    gsignond_security_context_free (owner); \
-    gsignond_security_context_list_free (acl); \
+    gboolean valid = gsignond_daemon_peer_is_allowed_to_use_identity (identity->priv->owner, ctx, identity->priv->info); \
     if (!valid) { \
         WARN ("cannot access identity."); \
         if (error) *error = gsignond_get_gerror_for_id (GSIGNOND_ERROR_PERMISSION_DENIED, "identity can not be accessed"); \
@@ -100,7 +96,6 @@ static void _on_store_token (GSignondAuthSession *session, GSignondDictionary *t
     GSignondAccessControlManager *acm = gsignond_daemon_get_access_control_manager (identity->priv->owner); \
     GSignondSecurityContext *owner = gsignond_identity_info_get_owner (identity->priv->info); \
     gboolean valid = gsignond_access_control_manager_peer_is_owner_of_identity (acm, ctx, owner); \
-    gsignond_security_context_free (owner); \
     if (!valid) { \
         WARN ("is_owner_of_identity check failed."); \
         if (error) *error = gsignond_get_gerror_for_id (GSIGNOND_ERROR_PERMISSION_DENIED, "identity can not be accessed"); \
@@ -113,7 +108,6 @@ static void _on_store_token (GSignondAuthSession *session, GSignondDictionary *t
     GSignondAccessControlManager *acm = gsignond_daemon_get_access_control_manager (identity->priv->owner); \
     GSignondSecurityContextList *acl = gsignond_identity_info_get_access_control_list (identity->priv->info); \
     gboolean valid = gsignond_access_control_manager_acl_is_valid (acm, ctx, acl); \
-    gsignond_security_context_list_free (acl); \
     if (!valid) { \
         WARN ("acl validity check failed."); \
         if (error) *error = gsignond_get_gerror_for_id (GSIGNOND_ERROR_PERMISSION_DENIED, "invalid access control list"); \
@@ -121,10 +115,44 @@ static void _on_store_token (GSignondAuthSession *session, GSignondDictionary *t
     } \
 }
 
+static void
+_invalidate_info_reply (GSignondIdentity *identity)
+{
+    if (identity->priv->info_reply) {
+        g_variant_unref (identity->priv->info_reply);
+        identity->priv->info_reply = NULL;
+    }
+}
+
+static void
+_clear_session_cache (gpointer key, gpointer value, gpointer user_data)
+{
+    gsignond_auth_session_clear_response_cache (GSIGNOND_AUTH_SESSION (value));
+}
+
+static void
+_on_info_updated (GSignondIdentity *identity,
+                  GSignondIdentityChangeType change,
+                  gpointer user_data)
+{
+    _invalidate_info_reply (identity);
+    /* responses cached for the sessions are stale after a store or a sign
+     * out */
+    if (identity->priv->auth_sessions)
+        g_hash_table_foreach (identity->priv->auth_sessions,
+                              _clear_session_cache, NULL);
+    /* and a refresh would store the token again */
+    if ((change == GSIGNOND_IDENTITY_SIGNED_OUT ||
+         change == GSIGNOND_IDENTITY_REMOVED) && identity->priv->owner)
+        gsignond_daemon_cancel_token_refreshes (identity->priv->owner,
+                                                identity, NULL);
+}
+
 static gboolean 
 _set_id (GSignondIdentity *identity, guint32 id)
 {
     gsignond_identity_info_set_id (identity->priv->info, id);
+    _invalidate_info_reply (identity);
     g_object_notify_by_pspec (G_OBJECT(identity), properties[PROP_INFO]);
 
     return TRUE;
@@ -157,6 +185,7 @@ _set_property (GObject *object, guint property_id, const GValue *value,
         case PROP_INFO:
             self->priv->info =
                (GSignondIdentityInfo *)g_value_get_boxed (value);
+            _invalidate_info_reply (self);
             break;
         default:
             G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
@@ -184,11 +213,14 @@ _dispose (GObject *object)
     }
 
     if (self->priv->owner) {
+        gsignond_daemon_cancel_token_refreshes (self->priv->owner, self, NULL);
         DBG("unref owner %p", self->priv->owner);
         g_object_unref (self->priv->owner);
         self->priv->owner = NULL;
     }
 
+    _invalidate_info_reply (self);
+
     if (self->priv->info) {
         gsignond_identity_info_unref (self->priv->info);
         self->priv->info = NULL;
@@ -209,6 +241,9 @@ gsignond_identity_init (GSignondIdentity *self)
     self->priv = GSIGNOND_IDENTITY_PRIV(self);
 
     self->priv->auth_sessions = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+    self->priv->info_reply = NULL;
+
+    g_signal_connect (self, "info-updated", G_CALLBACK (_on_info_updated), NULL);
 }
 
 static void
@@ -301,15 +336,19 @@ gsignond_identity_get_info (GSignondIdentity *identity, const GSignondSecurityCo
 
     VALIDATE_IDENTITY_RW_ACCESS (identity, ctx, NULL);
 
-    /* prepare identity info, excluding password and username if secret */
-    vinfo = gsignond_identity_info_to_variant (identity->priv->info);
-    if (!vinfo) {
-        WARN ("identity info to variant convertion failed.");
-        if (error) *error = gsignond_get_gerror_for_id (GSIGNOND_ERROR_IDENTITY_ERR, "Identity internal eror.");
-        return NULL;
+    /* prepare identity info, excluding password and username if secret;
+     * the result is kept until the identity info changes */
+    if (!identity->priv->info_reply) {
+        vinfo = gsignond_identity_info_to_variant (identity->priv->info);
+        if (!vinfo) {
+            WARN ("identity info to variant convertion failed.");
+            if (error) *error = gsignond_get_gerror_for_id (GSIGNOND_ERROR_IDENTITY_ERR, "Identity internal eror.");
+            return NULL;
+        }
+        identity->priv->info_reply = g_variant_ref_sink (vinfo);
     }
 
-    return vinfo;
+    return g_variant_ref (identity->priv->info_reply);
 }
 
 static void
@@ -382,6 +421,7 @@ _on_user_action_completed (GSignondSignonuiData *reply, GError *error, gpointer
         ui_error == SIGNONUI_ERROR_NONE) {
         gsignond_identity_info_set_username (priv->info,
                                              gsignond_signonui_data_get_username (reply));
+        _invalidate_info_reply (cb_data->identity);
     }
 
     /* storing secret allowed? */
@@ -454,6 +494,7 @@ _on_store_token (GSignondAuthSession *session, GSignondDictionary *token_data, g
 {
     GSignondIdentity *identity = GSIGNOND_IDENTITY (userdata);
     guint32 identity_id = GSIGNOND_IDENTITY_INFO_NEW_IDENTITY;
+    gint64 expiry = 0;
 
     g_return_if_fail (identity && session && GSIGNOND_IS_AUTH_SESSION (session));
 
@@ -462,6 +503,11 @@ _on_store_token (GSignondAuthSession *session, GSignondDictionary *token_data, g
     if (identity_id != GSIGNOND_IDENTITY_INFO_NEW_IDENTITY) {
         gsignond_daemon_store_identity_data (identity->priv->owner, identity_id, 
             gsignond_auth_session_get_method (session), token_data);
+
+        /* refresh the token before clients find it expired */
+        if (gsignond_session_data_get_token_expiry (token_data, &expiry))
+            gsignond_daemon_schedule_token_refresh (identity->priv->owner,
+                    identity, session, expiry);
     }
 }
 
@@ -478,6 +524,9 @@ _on_session_dead (gpointer data, GObject *session)
 
     DBG ("identity %p session %p disposed", identity, session);
     
+    if (identity->priv->owner)
+        gsignond_daemon_cancel_token_refreshes (identity->priv->owner,
+                identity, GSIGNOND_AUTH_SESSION (session));
     g_hash_table_foreach_remove (identity->priv->auth_sessions,
             _compare_session_by_pointer, session);   
 }
@@ -527,10 +576,9 @@ gsignond_identity_get_auth_session (GSignondIdentity *identity,
 
     supported_methods = gsignond_identity_info_get_methods (identity->priv->info);
 
-    if (supported_methods) {
+    if (supported_methods)
         method_available = g_hash_table_contains (supported_methods, method);
-        g_hash_table_unref (supported_methods);
-    } else if (gsignond_identity_info_get_is_identity_new (
+    else if (gsignond_identity_info_get_is_identity_new (
                                                          identity->priv->info))
         method_available = TRUE;
     else
@@ -885,14 +933,12 @@ gsignond_identity_store (GSignondIdentity *identity,
         if (_check_string (sys_ctx) <= 0) {
             gsignond_identity_info_remove_owner (identity_info);
         }
-        gsignond_security_context_free (owner_ctx);
         owner_ctx = NULL;
     }
 
     contexts = gsignond_identity_info_get_access_control_list (identity_info);
     if (contexts) {
         VALIDATE_IDENTITY_WRITE_ACL (identity, ctx, 0);
-        gsignond_security_context_list_free (contexts);
     }
    
     flags = gsignond_identity_info_get_edit_flags (identity_info);
@@ -911,6 +957,7 @@ gsignond_identity_store (GSignondIdentity *identity,
         flag_mask |= IDENTITY_INFO_PROP_OWNER;
     flags &= flag_mask;
     gsignond_identity_info_selective_copy (priv->info, identity_info, flags);
+    _invalidate_info_reply (identity);
 
     /* FIXME : either username/secret changed reset the identity
      * valdated state to FALSE ???
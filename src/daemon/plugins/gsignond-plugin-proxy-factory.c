@@ -25,10 +25,12 @@
 
 #include <string.h>
 #include <stdio.h>
+#include <glib/gstdio.h>
 
 #include "config.h"
 
 #include "gsignond/gsignond-log.h"
+#include "gsignond/gsignond-utils.h"
 #include "gsignond-plugin-proxy-factory.h"
 #include "gsignond-plugin-remote.h"
 
@@ -72,46 +74,222 @@ static gchar** _get_plugin_names_from_loader(const gchar* loader_path)
     }
 }
 
-static void _add_plugins(GSignondPluginProxyFactory* self, const gchar* loader_path, gchar** plugins)
+/* method, mechanism and loader names are interned, they are shared with
+ * the identities and auth sessions that refer to them */
+static gchar** _intern_strv(gchar** strv)
 {
-    DBG ("Checking mechanisms of plugins provided by %s", loader_path);
-    gchar **plugin_iter = plugins;
-    while (*plugin_iter) {
-        GSignondPlugin* plugin = GSIGNOND_PLUGIN (
-                gsignond_plugin_remote_new (loader_path, *plugin_iter));
-        if (plugin != NULL) {
-            gchar* plugin_type;
-            gchar** mechanisms;
-            g_object_get(plugin,
-                        "type", &plugin_type,
-                        "mechanisms", &mechanisms,
-                         NULL);
-            if (g_strcmp0 (plugin_type, *plugin_iter) == 0) {
-                const gchar* loader = g_hash_table_lookup(self->methods_to_loader_paths,
-                                                          plugin_type);
-                // Do not replace plugins provided by gsignond-plugind with
-                // 3rd party plugins
-                if (loader && g_str_has_suffix(loader, "/gsignond-plugind")) {
-                    DBG("Do not replace plugin %s with plugin provided by loader %s",
-                        plugin_type, loader_path);
-                    g_strfreev(mechanisms);
-                } else {
-                    DBG("Adding plugin %s to plugin enumeration", plugin_type);
-                    g_hash_table_insert(self->methods_to_mechanisms,
-                        g_strdup(plugin_type), mechanisms);
-                    g_hash_table_insert(self->methods_to_loader_paths,
-                        g_strdup(plugin_type), g_strdup(loader_path));
-                }
-            } else {
-                DBG("Plugin returned type property %s, which does not match requested type %s",
-                    plugin_type, *plugin_iter);
-                g_strfreev(mechanisms);
-            }
-            g_free(plugin_type);
-            g_object_unref(plugin);
+    guint i, n = strv ? g_strv_length(strv) : 0;
+    gchar** interned = g_new0(gchar*, n + 1);
+
+    for (i = 0; i < n; i++)
+        interned[i] = (gchar*)gsignond_str_intern(strv[i]);
+    g_strfreev(strv);
+
+    return interned;
+}
+
+static void _unintern_strv(gchar** strv)
+{
+    gchar** iter;
+
+    for (iter = strv; iter && *iter; iter++)
+        gsignond_str_unintern(*iter);
+    g_free(strv);
+}
+
+static GHashTable* _index_mechanisms(const gchar* plugin_type, gchar** mechanisms)
+{
+    GHashTable* ids = g_hash_table_new(g_str_hash, g_str_equal);
+    gint id;
+
+    for (id = 0; mechanisms[id] != NULL; id++) {
+        if (id >= GSIGNOND_MECHANISM_SET_MAX_SIZE) {
+            WARN("Plugin %s lists more than %d mechanisms, ignoring the rest",
+                 plugin_type, GSIGNOND_MECHANISM_SET_MAX_SIZE);
+            break;
         }
-        plugin_iter++;
+        if (!g_hash_table_contains(ids, mechanisms[id]))
+            g_hash_table_insert(ids, mechanisms[id], GINT_TO_POINTER(id + 1));
+    }
+
+    return ids;
+}
+
+/* takes ownership of mechanisms */
+static void _register_plugin(GSignondPluginProxyFactory* self,
+    const gchar* loader_path, const gchar* plugin_type, gchar** mechanisms)
+{
+    const gchar* loader = g_hash_table_lookup(self->methods_to_loader_paths,
+                                              plugin_type);
+    // Do not replace plugins provided by gsignond-plugind with
+    // 3rd party plugins
+    if (loader && g_str_has_suffix(loader, "/gsignond-plugind")) {
+        DBG("Do not replace plugin %s with plugin provided by loader %s",
+            plugin_type, loader_path);
+        g_strfreev(mechanisms);
+        return;
+    }
+
+    DBG("Adding plugin %s to plugin enumeration", plugin_type);
+    mechanisms = _intern_strv(mechanisms);
+    g_hash_table_insert(self->mechanism_ids,
+        (gpointer)gsignond_str_intern(plugin_type),
+        _index_mechanisms(plugin_type, mechanisms));
+    g_hash_table_insert(self->methods_to_mechanisms,
+        (gpointer)gsignond_str_intern(plugin_type),
+        mechanisms);
+    g_hash_table_insert(self->methods_to_loader_paths,
+        (gpointer)gsignond_str_intern(plugin_type),
+        (gpointer)gsignond_str_intern(loader_path));
+}
+
+/* Plugin manifests
+ *
+ * A loader run with --describe prints a manifest of type
+ * GSIGNOND_PLUGIN_MANIFEST_TYPE: the files the manifest was derived from
+ * (plugin directory and plugin modules), and the type and mechanisms of each
+ * plugin it provides.
+ *
+ * Manifests are stored in the cache file stamped with the size and
+ * modification time of the loader and of the files they depend on, and are
+ * reused until any of those change. */
+#define GSIGNOND_PLUGIN_MANIFEST_TYPE "(asa(sas))"
+#define GSIGNOND_PLUGIN_CACHE_VERSION 1
+/* loader size, loader mtime, [(file, size, mtime)], [(type, mechanisms)] */
+#define GSIGNOND_PLUGIN_CACHE_ENTRY_TYPE "(xxa(sxx)a(sas))"
+#define GSIGNOND_PLUGIN_CACHE_TYPE "(ua{s" GSIGNOND_PLUGIN_CACHE_ENTRY_TYPE "})"
+
+/* A probe is shared by the factory, the thread describing the loader and
+ * the plugins started for a loader that can't describe itself; the factory
+ * clears the factory pointer when it no longer waits for the probe. */
+typedef struct {
+    volatile gint ref_count;
+    GSignondPluginProxyFactory* factory; /* main loop only */
+    gchar* loader_path;
+    gboolean running;   /* the loader is being described */
+    GVariant* entry;    /* cache entry, NULL if the loader can't describe */
+    gboolean from_cache;
+    gchar** plugin_names; /* listed by a loader that can't describe */
+    GVariantBuilder* plugins; /* "a(sas)" of the plugins started so far */
+    guint n_starting;   /* plugins being started to read their properties */
+} _LoaderProbe;
+
+static _LoaderProbe* _loader_probe_ref(_LoaderProbe* probe)
+{
+    g_atomic_int_inc(&probe->ref_count);
+    return probe;
+}
+
+static void _loader_probe_unref(_LoaderProbe* probe)
+{
+    if (!g_atomic_int_dec_and_test(&probe->ref_count))
+        return;
+    if (probe->entry)
+        g_variant_unref(probe->entry);
+    g_strfreev(probe->plugin_names);
+    if (probe->plugins)
+        g_variant_builder_unref(probe->plugins);
+    g_free(probe->loader_path);
+    g_slice_free(_LoaderProbe, probe);
+}
+
+static void _loader_probe_release(_LoaderProbe* probe)
+{
+    probe->factory = NULL;
+    _loader_probe_unref(probe);
+}
+
+static gboolean _get_file_stamp(const gchar* path, gint64* size, gint64* mtime)
+{
+    GStatBuf st;
+
+    if (g_stat(path, &st) != 0)
+        return FALSE;
+    *size = st.st_size;
+    *mtime = st.st_mtime;
+    return TRUE;
+}
+
+static gboolean _cache_entry_is_valid(const gchar* loader_path, GVariant* entry)
+{
+    gint64 size, mtime, cached_size, cached_mtime;
+    GVariantIter* files;
+    const gchar* file;
+    gboolean valid;
+
+    g_variant_get(entry, "(xxa(sxx)@a(sas))", &cached_size, &cached_mtime,
+                  &files, NULL);
+    valid = _get_file_stamp(loader_path, &size, &mtime) &&
+            size == cached_size && mtime == cached_mtime;
+    while (valid &&
+           g_variant_iter_next(files, "(&sxx)", &file, &cached_size,
+                               &cached_mtime)) {
+        valid = _get_file_stamp(file, &size, &mtime) &&
+                size == cached_size && mtime == cached_mtime;
     }
+    g_variant_iter_free(files);
+
+    return valid;
+}
+
+/* runs in a worker thread, returns a new cache entry or NULL */
+static gpointer _describe_loader(gpointer data)
+{
+    const gchar* loader_path = data;
+    gchar* argv[] = { (gchar*)loader_path, (gchar*)"--describe", NULL };
+    gchar* standard_output = NULL;
+    gint exit_status = -1;
+    GError* error = NULL;
+    GVariant *manifest, *deps, *plugins, *entry;
+    GVariantBuilder files;
+    GVariantIter iter;
+    const gchar* file;
+    gint64 loader_size, loader_mtime, size, mtime;
+
+    if (!_get_file_stamp(loader_path, &loader_size, &loader_mtime))
+        return NULL;
+
+    if (!g_spawn_sync(NULL, argv, NULL, G_SPAWN_STDERR_TO_DEV_NULL, NULL, NULL,
+                      &standard_output, NULL, &exit_status, &error)) {
+        DBG("Loader %s could not be described: %s", loader_path,
+            error->message);
+        g_error_free(error);
+        return NULL;
+    }
+    if (exit_status != 0) {
+        DBG("Loader %s does not support --describe", loader_path);
+        g_free(standard_output);
+        return NULL;
+    }
+
+    manifest = g_variant_parse(G_VARIANT_TYPE(GSIGNOND_PLUGIN_MANIFEST_TYPE),
+                               standard_output, NULL, NULL, &error);
+    g_free(standard_output);
+    if (!manifest) {
+        DBG("Loader %s returned invalid manifest: %s", loader_path,
+            error->message);
+        g_error_free(error);
+        return NULL;
+    }
+
+    deps = g_variant_get_child_value(manifest, 0);
+    plugins = g_variant_get_child_value(manifest, 1);
+    g_variant_unref(manifest);
+
+    g_variant_builder_init(&files, G_VARIANT_TYPE("a(sxx)"));
+    g_variant_iter_init(&iter, deps);
+    while (g_variant_iter_next(&iter, "&s", &file)) {
+        if (!_get_file_stamp(file, &size, &mtime))
+            size = mtime = -1;
+        g_variant_builder_add(&files, "(sxx)", file, size, mtime);
+    }
+    g_variant_unref(deps);
+
+    entry = g_variant_new("(xxa(sxx)@a(sas))", loader_size, loader_mtime,
+                          &files, plugins);
+    g_variant_unref(plugins);
+
+    return g_variant_ref_sink(entry);
 }
 
 static void _insert_method(gchar* method, gchar*** method_iter_p)
@@ -121,7 +299,101 @@ static void _insert_method(gchar* method, gchar*** method_iter_p)
 }
 
 
-static void _enumerate_plugins(GSignondPluginProxyFactory* self)
+/* the caches are kept next to the per-user storage directories of the
+ * storage manager, never in the home directory of the daemon's user */
+static gchar* _get_storage_cache_path(GSignondPluginProxyFactory* self,
+                                      const gchar* file_name)
+{
+    const gchar* storage_path = NULL;
+
+    if (self->config)
+        storage_path = gsignond_config_get_string(self->config,
+                                        GSIGNOND_CONFIG_GENERAL_STORAGE_PATH);
+    if (!storage_path)
+        storage_path = BASE_STORAGE_DIR;
+#   ifdef ENABLE_DEBUG
+    const gchar* env_val = g_getenv("SSO_STORAGE_PATH");
+    if (env_val)
+        storage_path = env_val;
+#   endif
+    return g_build_filename(storage_path, "gsignond-cache", file_name, NULL);
+}
+
+static gchar* _get_manifest_cache_path(GSignondPluginProxyFactory* self)
+{
+    const gchar* path = NULL;
+
+    if (self->config)
+        path = gsignond_config_get_string(self->config,
+                                          GSIGNOND_CONFIG_GENERAL_PLUGIN_CACHE);
+    if (path)
+        return path[0] ? g_strdup(path) : NULL;
+
+    return _get_storage_cache_path(self, "plugins.cache");
+}
+
+static GVariant* _load_manifest_cache(const gchar* cache_path)
+{
+    gchar* contents = NULL;
+    gsize length = 0;
+    GVariant* cache;
+    GVariant* entries = NULL;
+
+    if (!cache_path || !g_file_get_contents(cache_path, &contents, &length, NULL))
+        return NULL;
+
+    cache = g_variant_new_from_data(G_VARIANT_TYPE(GSIGNOND_PLUGIN_CACHE_TYPE),
+                                    contents, length, FALSE, g_free, contents);
+    g_variant_ref_sink(cache);
+    if (!g_variant_is_normal_form(cache)) {
+        DBG("Ignoring malformed plugin cache %s", cache_path);
+    } else {
+        guint32 version;
+        g_variant_get(cache, "(u@a{s" GSIGNOND_PLUGIN_CACHE_ENTRY_TYPE "})",
+                      &version, &entries);
+        if (version != GSIGNOND_PLUGIN_CACHE_VERSION) {
+            DBG("Ignoring plugin cache %s of version %u", cache_path, version);
+            g_variant_unref(entries);
+            entries = NULL;
+        }
+    }
+    g_variant_unref(cache);
+
+    return entries;
+}
+
+static void _save_manifest_cache(const gchar* cache_path, GPtrArray* probes)
+{
+    GVariantBuilder entries;
+    GVariant* cache;
+    GError* error = NULL;
+    gchar* cache_dir;
+    guint i;
+
+    g_variant_builder_init(&entries, G_VARIANT_TYPE(
+        "a{s" GSIGNOND_PLUGIN_CACHE_ENTRY_TYPE "}"));
+    for (i = 0; i < probes->len; i++) {
+        _LoaderProbe* probe = g_ptr_array_index(probes, i);
+        if (probe->entry)
+            g_variant_builder_add(&entries, "{s@" GSIGNOND_PLUGIN_CACHE_ENTRY_TYPE "}",
+                                  probe->loader_path, probe->entry);
+    }
+    cache = g_variant_ref_sink(g_variant_new("(ua{s" GSIGNOND_PLUGIN_CACHE_ENTRY_TYPE "})",
+        GSIGNOND_PLUGIN_CACHE_VERSION, &entries));
+
+    cache_dir = g_path_get_dirname(cache_path);
+    if (g_mkdir_with_parents(cache_dir, 0700) != 0 ||
+        !g_file_set_contents(cache_path, g_variant_get_data(cache),
+                             g_variant_get_size(cache), &error)) {
+        DBG("Failed to write plugin cache %s: %s", cache_path,
+            error ? error->message : "could not create directory");
+        g_clear_error(&error);
+    }
+    g_free(cache_dir);
+    g_variant_unref(cache);
+}
+
+static const gchar* _get_loaders_path()
 {
     const gchar *loaders_path = GSIGNOND_PLUGINLOADERS_DIR;
 #   ifdef ENABLE_DEBUG
@@ -129,6 +401,141 @@ static void _enumerate_plugins(GSignondPluginProxyFactory* self)
     if (env_val)
         loaders_path = env_val;
 #   endif
+    return loaders_path;
+}
+
+static void _finish_enumeration(GSignondPluginProxyFactory* self);
+
+/* completes the enumeration once no loader is being described */
+static void _check_enumeration(GSignondPluginProxyFactory* self)
+{
+    guint i;
+
+    for (i = 0; i < self->loader_probes->len; i++) {
+        _LoaderProbe* probe = g_ptr_array_index(self->loader_probes, i);
+        if (probe->running)
+            return;
+    }
+    _finish_enumeration(self);
+}
+
+typedef struct {
+    _LoaderProbe* probe;
+    gchar* plugin_type; /* as listed by the loader */
+} _PluginStart;
+
+static void _on_plugin_started(GObject* source, GAsyncResult* res,
+                               gpointer data)
+{
+    _PluginStart* start = data;
+    _LoaderProbe* probe = start->probe;
+    GSignondPluginRemote* plugin;
+    GError* error = NULL;
+
+    plugin = gsignond_plugin_remote_new_finish(res, &error);
+    if (plugin) {
+        gchar* plugin_type = NULL;
+        gchar** mechanisms = NULL;
+
+        g_object_get(plugin, "type", &plugin_type,
+                     "mechanisms", &mechanisms, NULL);
+        if (mechanisms && g_strcmp0(plugin_type, start->plugin_type) == 0) {
+            g_variant_builder_add(probe->plugins, "(s^as)", plugin_type,
+                                  mechanisms);
+        } else {
+            DBG("Plugin returned type property %s, which does not match "
+                "requested type %s", plugin_type, start->plugin_type);
+        }
+        g_free(plugin_type);
+        g_strfreev(mechanisms);
+        g_object_unref(plugin);
+    } else {
+        DBG("Plugin %s of loader %s could not be started: %s",
+            start->plugin_type, probe->loader_path, error->message);
+        g_error_free(error);
+    }
+
+    if (--probe->n_starting == 0) {
+        probe->running = FALSE;
+        if (probe->factory)
+            _check_enumeration(probe->factory);
+    }
+    _loader_probe_unref(probe);
+    g_free(start->plugin_type);
+    g_slice_free(_PluginStart, start);
+}
+
+/* Loaders that do not support --describe only list their plugins, each
+ * plugin is started to read its properties. All of them are started at
+ * once and their properties are collected as they come in. */
+static void _start_plugins(_LoaderProbe* probe)
+{
+    gchar** name;
+
+    DBG("Checking mechanisms of plugins provided by %s", probe->loader_path);
+    probe->plugins = g_variant_builder_new(G_VARIANT_TYPE("a(sas)"));
+    for (name = probe->plugin_names; *name; name++) {
+        _PluginStart* start;
+
+        if (!**name)
+            continue;
+        start = g_slice_new0(_PluginStart);
+        start->probe = _loader_probe_ref(probe);
+        start->plugin_type = g_strdup(*name);
+        probe->n_starting++;
+        gsignond_plugin_remote_new_async(probe->loader_path, *name, NULL,
+                                         _on_plugin_started, start);
+    }
+    if (probe->n_starting == 0)
+        probe->running = FALSE;
+}
+
+static gboolean _on_loader_described(gpointer data)
+{
+    _LoaderProbe* probe = data;
+
+    if (!probe->factory)
+        return G_SOURCE_REMOVE;
+
+    if (!probe->entry && probe->plugin_names)
+        _start_plugins(probe);
+    else
+        probe->running = FALSE;
+    if (!probe->running)
+        _check_enumeration(probe->factory);
+
+    return G_SOURCE_REMOVE;
+}
+
+/* runs in a worker thread: describes the loader, or has it list its plugins
+ * if it can't, and hands the probe back to the main loop */
+static gpointer _describe_loader_in_thread(gpointer data)
+{
+    _LoaderProbe* probe = data;
+
+    probe->entry = _describe_loader(probe->loader_path);
+    if (!probe->entry)
+        probe->plugin_names = _get_plugin_names_from_loader(
+                probe->loader_path);
+
+    g_idle_add_full(G_PRIORITY_DEFAULT_IDLE, _on_loader_described, probe,
+                    (GDestroyNotify)_loader_probe_unref);
+
+    return NULL;
+}
+
+/* Starts describing the loaders that are not in the manifest cache, one
+ * worker thread each, so that the loaders run in parallel and in the
+ * background of daemon start-up. The threads are not joined: each hands
+ * its result to the main loop, which completes the enumeration when the
+ * last loader is done. */
+static void _start_enumeration(GSignondPluginProxyFactory* self)
+{
+    const gchar *loaders_path = _get_loaders_path();
+    gboolean running = FALSE;
+
+    if (self->loader_probes)
+        return;
 
     GDir* loaders_dir = g_dir_open(loaders_path, 0, NULL);
     if (loaders_dir == NULL) {
@@ -136,21 +543,100 @@ static void _enumerate_plugins(GSignondPluginProxyFactory* self)
         return;
     }
 
+    gchar* cache_path = _get_manifest_cache_path(self);
+    GVariant* cache = _load_manifest_cache(cache_path);
+    g_free(cache_path);
+
     DBG ("Getting lists of plugins from loaders in %s (factory=%p)", loaders_path, self);
+    self->loader_probes = g_ptr_array_new_with_free_func(
+        (GDestroyNotify)_loader_probe_release);
     while (1) {
         const gchar* loader_name = g_dir_read_name(loaders_dir);
         if (loader_name == NULL)
             break;
-        gchar* loader_path = g_build_filename(loaders_path, loader_name, NULL);
-        gchar** plugins = _get_plugin_names_from_loader(loader_path);
-        if (plugins != NULL) {
-            _add_plugins(self, loader_path, plugins);
-            g_strfreev(plugins);
+        _LoaderProbe* probe = g_slice_new0(_LoaderProbe);
+        probe->ref_count = 1;
+        probe->factory = self;
+        probe->loader_path = g_build_filename(loaders_path, loader_name, NULL);
+        g_ptr_array_add(self->loader_probes, probe);
+
+        if (cache) {
+            probe->entry = g_variant_lookup_value(cache, probe->loader_path,
+                G_VARIANT_TYPE(GSIGNOND_PLUGIN_CACHE_ENTRY_TYPE));
+            if (probe->entry &&
+                !_cache_entry_is_valid(probe->loader_path, probe->entry)) {
+                g_variant_unref(probe->entry);
+                probe->entry = NULL;
+            }
+            probe->from_cache = (probe->entry != NULL);
+        }
+        if (!probe->from_cache) {
+            GThread* thread = g_thread_try_new("gsignond-plugin-describe",
+                _describe_loader_in_thread, _loader_probe_ref(probe), NULL);
+            if (thread) {
+                g_thread_unref(thread);
+            } else {
+                /* no thread could be started, the main loop is still
+                 * handed the result */
+                _describe_loader_in_thread(probe);
+            }
+            probe->running = TRUE;
+            running = TRUE;
         }
-        g_free(loader_path);
     }
     g_dir_close(loaders_dir);
 
+    if (cache)
+        g_variant_unref(cache);
+
+    /* everything came from the cache, nothing to wait for */
+    if (!running)
+        _finish_enumeration(self);
+}
+
+static void _finish_enumeration(GSignondPluginProxyFactory* self)
+{
+    gboolean cache_dirty = FALSE;
+    GSList* tasks;
+    guint i;
+
+    for (i = 0; i < self->loader_probes->len; i++) {
+        _LoaderProbe* probe = g_ptr_array_index(self->loader_probes, i);
+
+        GVariant* plugins = NULL;
+
+        if (probe->entry && !probe->from_cache)
+            cache_dirty = TRUE;
+
+        if (probe->entry)
+            plugins = g_variant_get_child_value(probe->entry, 3);
+        else if (probe->plugins)
+            plugins = g_variant_ref_sink(g_variant_builder_end(probe->plugins));
+
+        if (plugins) {
+            GVariantIter iter;
+            const gchar* plugin_type;
+            gchar** mechanisms;
+
+            g_variant_iter_init(&iter, plugins);
+            while (g_variant_iter_next(&iter, "(&s^as)", &plugin_type,
+                                       &mechanisms))
+                _register_plugin(self, probe->loader_path, plugin_type,
+                                 mechanisms);
+            g_variant_unref(plugins);
+        }
+    }
+
+    if (cache_dirty) {
+        gchar* cache_path = _get_manifest_cache_path(self);
+        if (cache_path)
+            _save_manifest_cache(cache_path, self->loader_probes);
+        g_free(cache_path);
+    }
+
+    g_ptr_array_unref(self->loader_probes);
+    self->loader_probes = NULL;
+
     // make a flat list of available plugin types
     int n_plugins = g_hash_table_size(self->methods_to_mechanisms);
     self->methods = g_new0(gchar*, n_plugins + 1);
@@ -160,6 +646,388 @@ static void _enumerate_plugins(GSignondPluginProxyFactory* self)
     g_list_foreach(keys, (GFunc)_insert_method, &method_iter);
 
     g_list_free(keys);
+
+    self->generation++;
+
+    tasks = self->enumerate_tasks;
+    self->enumerate_tasks = NULL;
+    while (tasks) {
+        g_task_return_boolean(tasks->data, TRUE);
+        g_object_unref(tasks->data);
+        tasks = g_slist_delete_link(tasks, tasks);
+    }
+}
+
+/* A query that comes before the enumeration is complete runs the main
+ * loop until the callbacks have completed it. The daemon waits with
+ * gsignond_plugin_proxy_factory_enumerate() before it takes requests. */
+static void _enumerate_plugins(GSignondPluginProxyFactory* self)
+{
+    _start_enumeration(self);
+    while (self->loader_probes)
+        g_main_context_iteration(NULL, TRUE);
+}
+
+#define GSIGNOND_PLUGIN_STANDBY_DEFAULT 1
+#define GSIGNOND_PLUGIN_ZYGOTE_DEFAULT 0
+
+/* Keeps gsignond-plugind processes running that load a plugin on demand,
+ * so that starting a plugin does not have to wait for a new process, and
+ * optionally a zygote they are forked from. */
+static void _start_standby(GSignondPluginProxyFactory* self)
+{
+    gint size = GSIGNOND_PLUGIN_STANDBY_DEFAULT;
+    gint zygote = GSIGNOND_PLUGIN_ZYGOTE_DEFAULT;
+    gchar* loader_path;
+
+    if (self->config &&
+        gsignond_config_get_string(self->config,
+                                   GSIGNOND_CONFIG_GENERAL_PLUGIN_STANDBY))
+        size = gsignond_config_get_integer(self->config,
+                                   GSIGNOND_CONFIG_GENERAL_PLUGIN_STANDBY);
+    if (self->config &&
+        gsignond_config_get_string(self->config,
+                                   GSIGNOND_CONFIG_GENERAL_PLUGIN_ZYGOTE))
+        zygote = gsignond_config_get_integer(self->config,
+                                   GSIGNOND_CONFIG_GENERAL_PLUGIN_ZYGOTE);
+    if (size <= 0 && zygote <= 0)
+        return;
+
+    loader_path = g_build_filename(_get_loaders_path(), "gsignond-plugind",
+                                   NULL);
+    if (g_file_test(loader_path, G_FILE_TEST_IS_EXECUTABLE)) {
+        GSignondPluginZygote* plugin_zygote = NULL;
+
+        if (zygote > 0)
+            plugin_zygote = gsignond_plugin_zygote_new(loader_path);
+        self->standby = GSIGNOND_PLUGIN_STANDBY(g_object_new(
+                GSIGNOND_TYPE_PLUGIN_STANDBY,
+                "loaderpath", loader_path,
+                "size", (guint) MAX(size, 0),
+                "zygote", plugin_zygote,
+                NULL));
+        if (plugin_zygote)
+            g_object_unref(plugin_zygote);
+    }
+    g_free(loader_path);
+}
+
+/* Runs the GLib plugins listed in the configuration in one shared
+ * gsignond-plugind process. */
+static void _start_shared_loader(GSignondPluginProxyFactory* self)
+{
+    const gchar* shared = NULL;
+    gchar* loader_path;
+
+    if (self->config)
+        shared = gsignond_config_get_string(self->config,
+                                   GSIGNOND_CONFIG_GENERAL_SHARED_PLUGINS);
+    if (!shared || !*shared)
+        return;
+
+    loader_path = g_build_filename(_get_loaders_path(), "gsignond-plugind",
+                                   NULL);
+    if (g_file_test(loader_path, G_FILE_TEST_IS_EXECUTABLE))
+        self->shared_loader = gsignond_plugin_shared_loader_new(loader_path,
+                                                                self->standby);
+    g_free(loader_path);
+}
+
+/* Plugin usage
+ *
+ * The factory keeps the history of each plugin type: the average idle time
+ * between the last user of the plugin going away and the next request for
+ * it, and the mean deviation of that time, estimated as in TCP's
+ * retransmission timer (RFC 6298).
+ *
+ * When PluginTimeoutMax is above PluginTimeout, an idle plugin is kept for
+ * the average idle time plus four deviations, as long as that stays within
+ * the bound. Plugin types that are requested at regular intervals longer
+ * than the bound are started again shortly before the next request is due,
+ * both after their idle timeout and after daemon start-up, for which the
+ * history is stored in the usage cache file. */
+#define GSIGNOND_PLUGIN_USAGE_VERSION 1
+/* idle since (real time, 0 if in use), mean gap, gap deviation, gaps */
+#define GSIGNOND_PLUGIN_USAGE_ENTRY_TYPE "(xddu)"
+#define GSIGNOND_PLUGIN_USAGE_TYPE "(ua{s" GSIGNOND_PLUGIN_USAGE_ENTRY_TYPE "})"
+#define GSIGNOND_PLUGIN_PRESPAWN_LEAD 2 /* seconds */
+#define GSIGNOND_PLUGIN_PRESPAWN_MIN_GAPS 3
+
+typedef struct {
+    GSignondPluginProxyFactory* factory;
+    const gchar* plugin_type;   /* interned, owned by the usage table */
+    gint64 idle_since;
+    gdouble mean_gap;           /* seconds */
+    gdouble gap_dev;            /* seconds */
+    guint n_gaps;
+    gboolean prespawned;        /* started ahead of a request */
+    guint prespawn_id;
+} _PluginUsage;
+
+static GSignondPluginProxy* _get_proxy(GSignondPluginProxyFactory* factory,
+                                       const gchar* plugin_type);
+
+static void _plugin_usage_free(_PluginUsage* usage)
+{
+    if (usage->prespawn_id)
+        g_source_remove(usage->prespawn_id);
+    g_slice_free(_PluginUsage, usage);
+}
+
+static _PluginUsage* _get_usage(GSignondPluginProxyFactory* self,
+                                const gchar* plugin_type)
+{
+    _PluginUsage* usage = g_hash_table_lookup(self->usage, plugin_type);
+
+    if (!usage) {
+        usage = g_slice_new0(_PluginUsage);
+        usage->factory = self;
+        usage->plugin_type = gsignond_str_intern(plugin_type);
+        g_hash_table_insert(self->usage, (gpointer)usage->plugin_type, usage);
+    }
+    return usage;
+}
+
+/* returns FALSE if plugin timeouts are not adapted */
+static gboolean _get_timeout_bounds(GSignondPluginProxyFactory* self,
+                                    guint* min_timeout, guint* max_timeout)
+{
+    gint base, max;
+
+    if (!self->config || !self->usage)
+        return FALSE;
+    base = gsignond_config_get_integer(self->config,
+                                       GSIGNOND_CONFIG_PLUGIN_TIMEOUT);
+    max = gsignond_config_get_integer(self->config,
+                                      GSIGNOND_CONFIG_PLUGIN_TIMEOUT_MAX);
+    if (base <= 0 || max <= base)
+        return FALSE;
+
+    *min_timeout = base;
+    *max_timeout = max;
+    return TRUE;
+}
+
+static guint _get_idle_timeout(GSignondPluginProxyFactory* self,
+                               _PluginUsage* usage)
+{
+    guint min_timeout, max_timeout;
+    gdouble timeout;
+
+    if (!_get_timeout_bounds(self, &min_timeout, &max_timeout))
+        return gsignond_config_get_integer(self->config,
+                                           GSIGNOND_CONFIG_PLUGIN_TIMEOUT);
+    if (!usage || usage->n_gaps == 0)
+        return min_timeout;
+
+    if (usage->prespawned) {
+        /* wait until the request is as late as it usually gets */
+        timeout = MIN(GSIGNOND_PLUGIN_PRESPAWN_LEAD + 2 * usage->gap_dev,
+                      max_timeout);
+    } else {
+        timeout = usage->mean_gap + 4 * usage->gap_dev;
+        /* not worth keeping the plugin around for */
+        if (timeout > max_timeout)
+            return min_timeout;
+    }
+
+    return MAX(min_timeout, (guint)timeout + 1);
+}
+
+static void _record_request(GSignondPluginProxyFactory* self,
+                            const gchar* plugin_type)
+{
+    guint min_timeout, max_timeout;
+    _PluginUsage* usage;
+    gdouble gap, err;
+
+    if (!_get_timeout_bounds(self, &min_timeout, &max_timeout))
+        return;
+
+    usage = _get_usage(self, plugin_type);
+    if (usage->prespawn_id) {
+        g_source_remove(usage->prespawn_id);
+        usage->prespawn_id = 0;
+    }
+    usage->prespawned = FALSE;
+    if (usage->idle_since == 0)
+        return;
+
+    gap = (g_get_real_time() - usage->idle_since) / (gdouble)G_USEC_PER_SEC;
+    if (gap < 0)
+        gap = 0;
+    if (usage->n_gaps == 0) {
+        usage->mean_gap = gap;
+        usage->gap_dev = gap / 2;
+    } else {
+        err = gap > usage->mean_gap ? gap - usage->mean_gap
+                                    : usage->mean_gap - gap;
+        usage->gap_dev += (err - usage->gap_dev) / 4;
+        usage->mean_gap += (gap - usage->mean_gap) / 8;
+    }
+    if (usage->n_gaps < G_MAXUINT)
+        usage->n_gaps++;
+    usage->idle_since = 0;
+    DBG("Plugin %s idle gap %.1fs, mean %.1fs, deviation %.1fs",
+        plugin_type, gap, usage->mean_gap, usage->gap_dev);
+}
+
+static gboolean _prespawn_plugin(gpointer data)
+{
+    _PluginUsage* usage = data;
+    GSignondPluginProxyFactory* self = usage->factory;
+    GSignondPluginProxy* proxy;
+
+    usage->prespawn_id = 0;
+    if (g_hash_table_lookup(self->plugins, usage->plugin_type))
+        return FALSE;
+
+    DBG("Starting plugin %s ahead of its expected use", usage->plugin_type);
+    usage->prespawned = TRUE;
+    proxy = _get_proxy(self, usage->plugin_type);
+    if (proxy)
+        g_object_unref(proxy);
+    else
+        usage->prespawned = FALSE;
+
+    return FALSE;
+}
+
+/* starts the plugin again before the next request, if the plugin is
+ * requested at regular intervals */
+static void _schedule_prespawn(GSignondPluginProxyFactory* self,
+                               _PluginUsage* usage)
+{
+    gint64 now, due;
+
+    if (usage->prespawn_id || usage->idle_since == 0 ||
+        usage->n_gaps < GSIGNOND_PLUGIN_PRESPAWN_MIN_GAPS ||
+        usage->gap_dev * 4 > usage->mean_gap)
+        return;
+
+    now = g_get_real_time();
+    due = usage->idle_since + (gint64)((usage->mean_gap - usage->gap_dev -
+            GSIGNOND_PLUGIN_PRESPAWN_LEAD) * G_USEC_PER_SEC);
+    if (due < now)
+        return;
+
+    DBG("Plugin %s is expected to be used in %.1fs", usage->plugin_type,
+        (due - now) / (gdouble)G_USEC_PER_SEC + GSIGNOND_PLUGIN_PRESPAWN_LEAD);
+    usage->prespawn_id = g_timeout_add_seconds((due - now) / G_USEC_PER_SEC,
+                                               _prespawn_plugin, usage);
+}
+
+static gchar* _get_usage_cache_path(GSignondPluginProxyFactory* self)
+{
+    const gchar* path = gsignond_config_get_string(self->config,
+                                   GSIGNOND_CONFIG_GENERAL_PLUGIN_USAGE_CACHE);
+
+    if (path)
+        return path[0] ? g_strdup(path) : NULL;
+
+    return _get_storage_cache_path(self, "plugin-usage.cache");
+}
+
+static void _load_usage(GSignondPluginProxyFactory* self)
+{
+    guint min_timeout, max_timeout;
+    gchar* cache_path;
+    gchar* contents = NULL;
+    gsize length = 0;
+    GVariant* cache;
+    GVariantIter* entries;
+    const gchar* plugin_type;
+    guint32 version;
+    gint64 idle_since;
+    gdouble mean_gap, gap_dev;
+    guint n_gaps;
+
+    if (!_get_timeout_bounds(self, &min_timeout, &max_timeout))
+        return;
+
+    cache_path = _get_usage_cache_path(self);
+    if (!cache_path ||
+        !g_file_get_contents(cache_path, &contents, &length, NULL)) {
+        g_free(cache_path);
+        return;
+    }
+
+    cache = g_variant_new_from_data(G_VARIANT_TYPE(GSIGNOND_PLUGIN_USAGE_TYPE),
+                                    contents, length, FALSE, g_free, contents);
+    g_variant_ref_sink(cache);
+    if (!g_variant_is_normal_form(cache)) {
+        DBG("Ignoring malformed plugin usage cache %s", cache_path);
+        goto out;
+    }
+    g_variant_get(cache, "(ua{s" GSIGNOND_PLUGIN_USAGE_ENTRY_TYPE "})",
+                  &version, &entries);
+    if (version != GSIGNOND_PLUGIN_USAGE_VERSION) {
+        DBG("Ignoring plugin usage cache %s of version %u", cache_path,
+            version);
+        g_variant_iter_free(entries);
+        goto out;
+    }
+    while (g_variant_iter_next(entries, "{&s" GSIGNOND_PLUGIN_USAGE_ENTRY_TYPE "}",
+                               &plugin_type, &idle_since, &mean_gap, &gap_dev,
+                               &n_gaps)) {
+        _PluginUsage* usage = _get_usage(self, plugin_type);
+        usage->idle_since = idle_since;
+        usage->mean_gap = mean_gap;
+        usage->gap_dev = gap_dev;
+        usage->n_gaps = n_gaps;
+        _schedule_prespawn(self, usage);
+    }
+    g_variant_iter_free(entries);
+
+out:
+    g_variant_unref(cache);
+    g_free(cache_path);
+}
+
+static void _save_usage(GSignondPluginProxyFactory* self)
+{
+    guint min_timeout, max_timeout;
+    GVariantBuilder entries;
+    GHashTableIter iter;
+    _PluginUsage* usage;
+    GVariant* cache;
+    GError* error = NULL;
+    gchar* cache_path;
+    gchar* cache_dir;
+    gint64 now = g_get_real_time();
+
+    if (!_get_timeout_bounds(self, &min_timeout, &max_timeout) ||
+        g_hash_table_size(self->usage) == 0)
+        return;
+    cache_path = _get_usage_cache_path(self);
+    if (!cache_path)
+        return;
+
+    g_variant_builder_init(&entries, G_VARIANT_TYPE(
+        "a{s" GSIGNOND_PLUGIN_USAGE_ENTRY_TYPE "}"));
+    g_hash_table_iter_init(&iter, self->usage);
+    while (g_hash_table_iter_next(&iter, NULL, (gpointer *)&usage)) {
+        /* plugins still in use are idle from now on */
+        g_variant_builder_add(&entries, "{s" GSIGNOND_PLUGIN_USAGE_ENTRY_TYPE "}",
+                              usage->plugin_type,
+                              usage->idle_since ? usage->idle_since : now,
+                              usage->mean_gap, usage->gap_dev, usage->n_gaps);
+    }
+    cache = g_variant_ref_sink(g_variant_new(
+        "(ua{s" GSIGNOND_PLUGIN_USAGE_ENTRY_TYPE "})",
+        GSIGNOND_PLUGIN_USAGE_VERSION, &entries));
+
+    cache_dir = g_path_get_dirname(cache_path);
+    if (g_mkdir_with_parents(cache_dir, 0700) != 0 ||
+        !g_file_set_contents(cache_path, g_variant_get_data(cache),
+                             g_variant_get_size(cache), &error)) {
+        DBG("Failed to write plugin usage cache %s: %s", cache_path,
+            error ? error->message : "could not create directory");
+        g_clear_error(&error);
+    }
+    g_free(cache_dir);
+    g_free(cache_path);
+    g_variant_unref(cache);
 }
 
 static GObject *
@@ -174,7 +1042,12 @@ gsignond_plugin_proxy_factory_constructor (GType                  gtype,
     obj = G_OBJECT_CLASS (gsignond_plugin_proxy_factory_parent_class)->constructor (
         gtype, n_properties, properties);
   }
-  
+
+  _start_enumeration (GSIGNOND_PLUGIN_PROXY_FACTORY (obj));
+  _start_standby (GSIGNOND_PLUGIN_PROXY_FACTORY (obj));
+  _start_shared_loader (GSIGNOND_PLUGIN_PROXY_FACTORY (obj));
+  _load_usage (GSIGNOND_PLUGIN_PROXY_FACTORY (obj));
+
   return obj;
 }
 
@@ -221,6 +1094,28 @@ gsignond_plugin_proxy_factory_dispose (GObject *gobject)
 {
     GSignondPluginProxyFactory *self = GSIGNOND_PLUGIN_PROXY_FACTORY (gobject);
 
+    if (self->loader_probes) {
+        g_ptr_array_unref (self->loader_probes);
+        self->loader_probes = NULL;
+    }
+    g_slist_free_full (self->enumerate_tasks, g_object_unref);
+    self->enumerate_tasks = NULL;
+
+    if (self->usage) {
+        _save_usage (self);
+        g_hash_table_destroy (self->usage);
+        self->usage = NULL;
+    }
+
+    if (self->shared_loader) {
+        g_object_unref (self->shared_loader);
+        self->shared_loader = NULL;
+    }
+    if (self->standby) {
+        g_object_unref (self->standby);
+        self->standby = NULL;
+    }
+
     if (self->config) {
         g_object_unref (self->config);
         self->config = NULL;
@@ -247,6 +1142,10 @@ gsignond_plugin_proxy_factory_finalize (GObject *gobject)
         g_hash_table_destroy (self->methods_to_loader_paths);
         self->methods_to_loader_paths = NULL;
     }
+    if (self->mechanism_ids) {
+        g_hash_table_destroy (self->mechanism_ids);
+        self->mechanism_ids = NULL;
+    }
     if (self->methods) {
         g_free (self->methods);
         self->methods = NULL;
@@ -287,20 +1186,35 @@ gsignond_plugin_proxy_factory_init (GSignondPluginProxyFactory *self)
 {
     self->methods_to_mechanisms = g_hash_table_new_full((GHashFunc)g_str_hash,
                                              (GEqualFunc)g_str_equal,
-                                             (GDestroyNotify)g_free,
-                                             (GDestroyNotify)g_strfreev);
+                                             (GDestroyNotify)gsignond_str_unintern,
+                                             (GDestroyNotify)_unintern_strv);
 
     self->methods_to_loader_paths = g_hash_table_new_full((GHashFunc)g_str_hash,
                                              (GEqualFunc)g_str_equal,
-                                             (GDestroyNotify)g_free,
-                                             (GDestroyNotify)g_free);
+                                             (GDestroyNotify)gsignond_str_unintern,
+                                             (GDestroyNotify)gsignond_str_unintern);
+
+    self->mechanism_ids = g_hash_table_new_full((GHashFunc)g_str_hash,
+                                             (GEqualFunc)g_str_equal,
+                                             (GDestroyNotify)gsignond_str_unintern,
+                                             (GDestroyNotify)g_hash_table_unref);
 
     self->plugins = g_hash_table_new_full ((GHashFunc)g_str_hash,
                                            (GEqualFunc)g_str_equal,
-                                           (GDestroyNotify)g_free,
+                                           (GDestroyNotify)gsignond_str_unintern,
                                            (GDestroyNotify)g_object_unref);
 
+    self->usage = g_hash_table_new_full ((GHashFunc)g_str_hash,
+                                         (GEqualFunc)g_str_equal,
+                                         (GDestroyNotify)gsignond_str_unintern,
+                                         (GDestroyNotify)_plugin_usage_free);
+
     self->methods = NULL;
+    self->generation = 0;
+    self->loader_probes = NULL;
+    self->enumerate_tasks = NULL;
+    self->standby = NULL;
+    self->shared_loader = NULL;
 }
 
 GSignondPluginProxyFactory* 
@@ -317,25 +1231,62 @@ static gboolean
 _find_proxy_by_pointer (gpointer key, gpointer value, gpointer userdata)
 {
     if (userdata == value) {
-        g_free (key);
+        gsignond_str_unintern (key);
         return TRUE;
     }
     return FALSE;
 }
 
+static _PluginUsage *
+_find_usage_by_proxy (GSignondPluginProxyFactory *factory, GObject *proxy)
+{
+    GHashTableIter iter;
+    gpointer key, value;
+
+    if (!factory->usage)
+        return NULL;
+
+    g_hash_table_iter_init (&iter, factory->plugins);
+    while (g_hash_table_iter_next (&iter, &key, &value)) {
+        if (value == proxy)
+            return g_hash_table_lookup (factory->usage, key);
+    }
+    return NULL;
+}
+
 static void
 _remove_dead_proxy (gpointer data, GObject *dead_proxy)
 {
     GSignondPluginProxyFactory *factory = GSIGNOND_PLUGIN_PROXY_FACTORY(data);
     if (factory) {
+        _PluginUsage *usage = _find_usage_by_proxy (factory, dead_proxy);
+
         g_hash_table_foreach_steal (factory->plugins, 
                 _find_proxy_by_pointer, dead_proxy);
+        if (usage) {
+            if (!usage->prespawned)
+                _schedule_prespawn (factory, usage);
+            usage->prespawned = FALSE;
+        }
     }
 }
 
 static void
 _proxy_toggle_ref_cb (gpointer userdata, GObject *proxy, gboolean is_last_ref)
 {
+    GSignondPluginProxyFactory *factory = GSIGNOND_PLUGIN_PROXY_FACTORY(userdata);
+    guint min_timeout, max_timeout;
+
+    if (is_last_ref &&
+        _get_timeout_bounds (factory, &min_timeout, &max_timeout)) {
+        _PluginUsage *usage = _find_usage_by_proxy (factory, proxy);
+
+        if (usage && !usage->prespawned)
+            usage->idle_since = g_get_real_time ();
+        gsignond_disposable_set_timeout (GSIGNOND_DISPOSABLE (proxy),
+                                         _get_idle_timeout (factory, usage));
+    }
+
     /* start/stop timeout timer */
     gsignond_disposable_set_auto_dispose (GSIGNOND_DISPOSABLE (proxy), is_last_ref);
 
@@ -343,14 +1294,104 @@ _proxy_toggle_ref_cb (gpointer userdata, GObject *proxy, gboolean is_last_ref)
     else g_object_weak_unref (proxy, _remove_dead_proxy, userdata);
 }
 
-GSignondPluginProxy*
-gsignond_plugin_proxy_factory_get_plugin(GSignondPluginProxyFactory* factory,
-                                         const gchar* plugin_type)
+static void
+_on_proxy_started (GObject *source, GAsyncResult *res, gpointer userdata)
 {
-    g_return_val_if_fail (factory && GSIGNOND_IS_PLUGIN_PROXY_FACTORY(factory), NULL);
-    g_return_val_if_fail (plugin_type, NULL);
+    GSignondPluginProxyFactory *factory = GSIGNOND_PLUGIN_PROXY_FACTORY(userdata);
+    GError *error = NULL;
+
+    if (!g_async_initable_init_finish (G_ASYNC_INITABLE(source), res, &error)) {
+        DBG("plugin proxy %p failed to start: %s", source, error->message);
+        g_error_free (error);
+        /* forget the proxy, the next request starts a new one */
+        if (g_hash_table_foreach_steal (factory->plugins,
+                    _find_proxy_by_pointer, source))
+            g_object_remove_toggle_ref (source, _proxy_toggle_ref_cb, factory);
+    }
+    g_object_unref (factory);
+}
+
+#define GSIGNOND_PLUGIN_WORKERS_DEFAULT 4
+
+static guint _get_max_workers(GSignondPluginProxyFactory* self)
+{
+    gint max_workers = GSIGNOND_PLUGIN_WORKERS_DEFAULT;
+
+    if (self->config &&
+        gsignond_config_get_string(self->config,
+                                   GSIGNOND_CONFIG_GENERAL_PLUGIN_WORKERS))
+        max_workers = gsignond_config_get_integer(self->config,
+                                   GSIGNOND_CONFIG_GENERAL_PLUGIN_WORKERS);
+
+    return max_workers > 0 ? (guint) max_workers : 1;
+}
+
+#define GSIGNOND_IN_PROCESS_PLUGINS_DEFAULT "password;digest"
+
+/* Checks a semicolon-separated list of trusted plugins from the
+ * configuration. Only plugins of the GLib plugin loader can be trusted. */
+static gboolean _is_listed(GSignondPluginProxyFactory* self,
+                           const gchar* key,
+                           const gchar* default_value,
+                           const gchar* plugin_type,
+                           const gchar* loader_path)
+{
+    const gchar* allowed = default_value;
+    gboolean found = FALSE;
+    gchar** names;
+    gchar** name_iter;
+
+    if (!loader_path || !g_str_has_suffix(loader_path, "/gsignond-plugind"))
+        return FALSE;
+
+    if (self->config) {
+        const gchar* value = gsignond_config_get_string(self->config, key);
+        if (value)
+            allowed = value;
+    }
+
+    names = g_strsplit(allowed, ";", -1);
+    for (name_iter = names; *name_iter && !found; name_iter++)
+        found = (g_strcmp0(g_strstrip(*name_iter), plugin_type) == 0);
+    g_strfreev(names);
+
+    return found;
+}
+
+static gboolean _is_framed_loader(GSignondPluginProxyFactory* self,
+                                  const gchar* loader_path)
+{
+    const gchar* framed = NULL;
+    gboolean found = FALSE;
+    gchar* loader_name;
+    gchar** names;
+    gchar** name_iter;
 
+    if (self->config)
+        framed = gsignond_config_get_string(self->config,
+                                   GSIGNOND_CONFIG_GENERAL_FRAMED_LOADERS);
+    if (!framed || !*framed || !loader_path)
+        return FALSE;
+
+    loader_name = g_path_get_basename(loader_path);
+    names = g_strsplit(framed, ";", -1);
+    for (name_iter = names; *name_iter && !found; name_iter++)
+        found = (g_strcmp0(g_strstrip(*name_iter), loader_name) == 0);
+    g_strfreev(names);
+    g_free(loader_name);
+
+    return found;
+}
+
+static GSignondPluginProxy*
+_get_proxy(GSignondPluginProxyFactory* factory, const gchar* plugin_type)
+{
     GSignondPluginProxy* proxy = NULL;
+    GSignondPluginStandby* standby = NULL;
+    GSignondPluginSharedLoader* shared_loader = NULL;
+    const gchar* loader_path;
+    gboolean in_process;
+    gboolean framed;
 
     if (factory->methods == NULL) {
         _enumerate_plugins (factory);
@@ -368,14 +1409,58 @@ gsignond_plugin_proxy_factory_get_plugin(GSignondPluginProxyFactory* factory,
         return proxy;
     }
 
-    proxy = gsignond_plugin_proxy_new(g_hash_table_lookup(factory->methods_to_loader_paths, plugin_type), plugin_type,
-                                      gsignond_config_get_integer (factory->config, GSIGNOND_CONFIG_PLUGIN_TIMEOUT));
-    if (proxy == NULL) {
-        return NULL;
-    }
-    g_hash_table_insert(factory->plugins, g_strdup (plugin_type), proxy);
+    /* the plugin is started in the background, requests are queued by the
+     * proxy until it is up */
+    loader_path = g_hash_table_lookup(factory->methods_to_loader_paths,
+                                      plugin_type);
+    in_process = _is_listed(factory,
+                            GSIGNOND_CONFIG_GENERAL_IN_PROCESS_PLUGINS,
+                            GSIGNOND_IN_PROCESS_PLUGINS_DEFAULT,
+                            plugin_type, loader_path);
+    if (!in_process && factory->standby &&
+        g_strcmp0(loader_path, gsignond_plugin_standby_get_loader_path(
+                factory->standby)) == 0)
+        standby = factory->standby;
+    framed = !in_process && _is_framed_loader(factory, loader_path);
+    if (!in_process && !framed && factory->shared_loader &&
+        _is_listed(factory, GSIGNOND_CONFIG_GENERAL_SHARED_PLUGINS, "",
+                   plugin_type, loader_path) &&
+        g_strcmp0(loader_path, gsignond_plugin_shared_loader_get_loader_path(
+                factory->shared_loader)) == 0)
+        shared_loader = factory->shared_loader;
+    proxy = g_object_new(GSIGNOND_TYPE_PLUGIN_PROXY,
+                         "loaderpath", loader_path,
+                         "in-process", in_process,
+                         "standby", standby,
+                         "shared-loader", shared_loader,
+                         "framed", framed,
+                         "type", plugin_type,
+                         "auto-dispose", FALSE,
+                         "timeout", gsignond_config_get_integer (factory->config, GSIGNOND_CONFIG_PLUGIN_TIMEOUT),
+                         "max-workers", _get_max_workers(factory),
+                         NULL);
+    g_hash_table_insert(factory->plugins,
+                        (gpointer) gsignond_str_intern (plugin_type), proxy);
     DBG("get new plugin %s -> %p", plugin_type, proxy);
     g_object_add_toggle_ref(G_OBJECT(proxy), _proxy_toggle_ref_cb, factory);
+    g_async_initable_init_async(G_ASYNC_INITABLE(proxy), G_PRIORITY_DEFAULT,
+                                NULL, _on_proxy_started, g_object_ref(factory));
+
+    return proxy;
+}
+
+GSignondPluginProxy*
+gsignond_plugin_proxy_factory_get_plugin(GSignondPluginProxyFactory* factory,
+                                         const gchar* plugin_type)
+{
+    GSignondPluginProxy* proxy;
+
+    g_return_val_if_fail (factory && GSIGNOND_IS_PLUGIN_PROXY_FACTORY(factory), NULL);
+    g_return_val_if_fail (plugin_type, NULL);
+
+    proxy = _get_proxy (factory, plugin_type);
+    if (proxy)
+        _record_request (factory, plugin_type);
 
     return proxy;
 }
@@ -402,3 +1487,160 @@ gsignond_plugin_proxy_factory_get_plugin_mechanisms(
 
     return g_hash_table_lookup(factory->methods_to_mechanisms, plugin_type);
 }
+
+/**
+ * gsignond_plugin_proxy_factory_get_generation:
+ * @factory: instance of #GSignondPluginProxyFactory
+ *
+ * Returns the generation of the plugin registry. It changes whenever the
+ * available plugin types or their mechanisms change, so data derived from
+ * them can be cached against it.
+ *
+ * Returns: the registry generation, 0 if plugins were not enumerated yet.
+ */
+guint
+gsignond_plugin_proxy_factory_get_generation(
+   GSignondPluginProxyFactory* factory)
+{
+    g_return_val_if_fail(factory, 0);
+
+    return factory->generation;
+}
+
+/**
+ * gsignond_plugin_proxy_factory_enumerate:
+ * @factory: instance of #GSignondPluginProxyFactory
+ * @callback: called once the plugins are enumerated
+ * @user_data: user data for @callback
+ *
+ * Waits, without blocking, for the enumeration started when @factory was
+ * created. Plugin queries made after @callback has been called do not
+ * need to wait for the loaders.
+ */
+void
+gsignond_plugin_proxy_factory_enumerate(
+   GSignondPluginProxyFactory* factory, GAsyncReadyCallback callback,
+   gpointer user_data)
+{
+    GTask* task;
+
+    g_return_if_fail(factory && GSIGNOND_IS_PLUGIN_PROXY_FACTORY(factory));
+
+    task = g_task_new(factory, NULL, callback, user_data);
+    if (factory->loader_probes)
+        factory->enumerate_tasks = g_slist_prepend(factory->enumerate_tasks,
+                                                   task);
+    else {
+        g_task_return_boolean(task, TRUE);
+        g_object_unref(task);
+    }
+}
+
+/**
+ * gsignond_plugin_proxy_factory_enumerate_finish:
+ * @factory: instance of #GSignondPluginProxyFactory
+ * @result: the #GAsyncResult passed to the callback
+ * @error: return location for error
+ *
+ * Finishes gsignond_plugin_proxy_factory_enumerate().
+ *
+ * Returns: TRUE once the plugins are enumerated.
+ */
+gboolean
+gsignond_plugin_proxy_factory_enumerate_finish(
+   GSignondPluginProxyFactory* factory, GAsyncResult* result, GError** error)
+{
+    g_return_val_if_fail(g_task_is_valid(result, factory), FALSE);
+
+    return g_task_propagate_boolean(G_TASK(result), error);
+}
+
+/**
+ * gsignond_plugin_proxy_factory_get_mechanism_id:
+ * @factory: instance of #GSignondPluginProxyFactory
+ * @plugin_type: the method
+ * @mechanism: name of the mechanism
+ *
+ * Returns the id assigned to @mechanism of @plugin_type at enumeration. Ids
+ * are bit positions in a #GSignondMechanismSet.
+ *
+ * Returns: the id, or -1 if the plugin does not support @mechanism.
+ */
+gint
+gsignond_plugin_proxy_factory_get_mechanism_id(
+   GSignondPluginProxyFactory* factory, const gchar* plugin_type,
+   const gchar* mechanism)
+{
+    GHashTable* ids;
+
+    g_return_val_if_fail(factory->mechanism_ids, -1);
+    g_return_val_if_fail(plugin_type && mechanism, -1);
+
+    if (factory->methods == NULL) {
+        _enumerate_plugins (factory);
+    }
+
+    ids = g_hash_table_lookup(factory->mechanism_ids, plugin_type);
+    if (!ids)
+        return -1;
+
+    return GPOINTER_TO_INT(g_hash_table_lookup(ids, mechanism)) - 1;
+}
+
+/**
+ * gsignond_plugin_proxy_factory_get_mechanism_set:
+ * @factory: instance of #GSignondPluginProxyFactory
+ * @plugin_type: the method
+ * @mechanisms: (allow-none): sequence of mechanism names
+ *
+ * Maps @mechanisms to the set of matching mechanisms of @plugin_type.
+ * A NULL sequence, or one containing the "*" wildcard, maps to all
+ * mechanisms of the plugin; names the plugin does not know are ignored.
+ *
+ * Returns: the mechanism set.
+ */
+GSignondMechanismSet
+gsignond_plugin_proxy_factory_get_mechanism_set(
+   GSignondPluginProxyFactory* factory, const gchar* plugin_type,
+   GSequence* mechanisms)
+{
+    GSignondMechanismSet set = 0;
+    GSequenceIter* iter;
+    GHashTable* ids;
+    GHashTableIter ids_iter;
+    gpointer value;
+
+    g_return_val_if_fail(factory->mechanism_ids, 0);
+    g_return_val_if_fail(plugin_type, 0);
+
+    if (factory->methods == NULL) {
+        _enumerate_plugins (factory);
+    }
+
+    ids = g_hash_table_lookup(factory->mechanism_ids, plugin_type);
+    if (!ids)
+        return 0;
+
+    if (!mechanisms)
+        goto all;
+
+    for (iter = g_sequence_get_begin_iter(mechanisms);
+         !g_sequence_iter_is_end(iter);
+         iter = g_sequence_iter_next(iter)) {
+        const gchar* mechanism = g_sequence_get(iter);
+        gint id;
+
+        if (g_strcmp0(mechanism, "*") == 0)
+            goto all;
+        id = GPOINTER_TO_INT(g_hash_table_lookup(ids, mechanism)) - 1;
+        if (id >= 0)
+            set |= G_GUINT64_CONSTANT(1) << id;
+    }
+    return set;
+
+all:
+    g_hash_table_iter_init(&ids_iter, ids);
+    while (g_hash_table_iter_next(&ids_iter, NULL, &value))
+        set |= G_GUINT64_CONSTANT(1) << (GPOINTER_TO_INT(value) - 1);
+    return set;
+}
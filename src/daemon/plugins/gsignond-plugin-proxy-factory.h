@@ -28,6 +28,8 @@
 
 #include <glib-object.h>
 #include "gsignond-plugin-proxy.h"
+#include "gsignond-plugin-standby.h"
+#include "gsignond-plugin-shared-loader.h"
 #include <gsignond/gsignond-config.h>
 
 #define GSIGNOND_TYPE_PLUGIN_PROXY_FACTORY             (gsignond_plugin_proxy_factory_get_type ())
@@ -38,6 +40,11 @@
 #define GSIGNOND_PLUGIN_PROXY_FACTORY_GET_CLASS(obj)   (G_TYPE_INSTANCE_GET_CLASS ((obj), GSIGNOND_TYPE_PLUGIN_PROXY_FACTORY, GSignondPluginProxyFactoryClass))
 
 
+/* Mechanisms of a plugin are numbered in the order the plugin lists them at
+ * enumeration, so that a set of them fits in a bitmask. */
+typedef guint64 GSignondMechanismSet;
+#define GSIGNOND_MECHANISM_SET_MAX_SIZE 64
+
 typedef struct _GSignondPluginProxyFactory        GSignondPluginProxyFactory;
 typedef struct _GSignondPluginProxyFactoryClass   GSignondPluginProxyFactoryClass;
 
@@ -52,6 +59,13 @@ struct _GSignondPluginProxyFactory
     gchar** methods;
     GHashTable* methods_to_mechanisms;
     GHashTable* methods_to_loader_paths;
+    GHashTable* mechanism_ids; /* method -> (mechanism -> id + 1) */
+    guint generation; /* bumped whenever the plugin registry is rebuilt */
+    GPtrArray* loader_probes; /* pending enumeration */
+    GSList* enumerate_tasks; /* waiting for the enumeration */
+    GSignondPluginStandby* standby; /* gsignond-plugind processes */
+    GSignondPluginSharedLoader* shared_loader;
+    GHashTable* usage; /* method -> request history */
 };
 
 struct _GSignondPluginProxyFactoryClass
@@ -75,6 +89,29 @@ gsignond_plugin_proxy_factory_get_plugin_types(
 const gchar**
 gsignond_plugin_proxy_factory_get_plugin_mechanisms(
    GSignondPluginProxyFactory* factory, const gchar* plugin_type);
+
+guint
+gsignond_plugin_proxy_factory_get_generation(
+   GSignondPluginProxyFactory* factory);
+
+void
+gsignond_plugin_proxy_factory_enumerate(
+   GSignondPluginProxyFactory* factory, GAsyncReadyCallback callback,
+   gpointer user_data);
+
+gboolean
+gsignond_plugin_proxy_factory_enumerate_finish(
+   GSignondPluginProxyFactory* factory, GAsyncResult* result, GError** error);
+
+gint
+gsignond_plugin_proxy_factory_get_mechanism_id(
+   GSignondPluginProxyFactory* factory, const gchar* plugin_type,
+   const gchar* mechanism);
+
+GSignondMechanismSet
+gsignond_plugin_proxy_factory_get_mechanism_set(
+   GSignondPluginProxyFactory* factory, const gchar* plugin_type,
+   GSequence* mechanisms);
    
 
 #endif /* __GSIGNOND_PLUGIN_PROXY_FACTORY_H__ */
@@ -23,12 +23,15 @@
  * 02110-1301 USA
  */
 
+#include <string.h>
+
 #include "gsignond/gsignond-error.h"
 #include "gsignond/gsignond-log.h"
 #include "gsignond/gsignond-config.h"
 #include "daemon/gsignond-auth-session.h"
 #include "gsignond-plugin-proxy.h"
 #include "gsignond-plugin-remote.h"
+#include "gplugind/gsignond-plugin-loader.h"
 
 #define GSIGNOND_PLUGIN_PROXY_PRIV(obj) \
     G_TYPE_INSTANCE_GET_PRIVATE ((obj), \
@@ -42,47 +45,129 @@ enum
     PROP_TYPE,
     PROP_MECHANISMS,
     PROP_LOADERPATH,
+    PROP_MAX_WORKERS,
+    PROP_IN_PROCESS,
+    PROP_STANDBY,
+    PROP_SHARED_LOADER,
+    PROP_FRAMED,
     
     N_PROPERTIES
 };
 
+#define N_PRIORITIES (GSIGNOND_PROCESS_PRIORITY_INTERACTIVE + 1)
+
+typedef struct {
+    guint n_dispatched;
+    gint64 total_wait;
+    gint64 max_wait;
+} GSignondPluginProxyWaitStats;
+
 struct _GSignondPluginProxyPrivate
 {
     gchar* loader_path;
     gchar* plugin_type;
-    GSignondPlugin* plugin;
+    GPtrArray* workers; /* running GSignondPluginWorkers */
+    guint max_workers;
+    guint starting_workers; /* extra workers being spawned */
+    gboolean initializing;
+    gboolean initialized;
+    GError* init_error;
+    GList* init_tasks; /* waiting for the first worker to start */
     GQueue* session_queue;
+    gboolean in_process;
+    GSignondPluginStandby* standby;
+    GSignondPluginSharedLoader* shared_loader;
+    gboolean framed;
+    GQueue* deferred_queue; /* requests to in-process plugins */
+    guint deferred_id;
+    GSignondPluginProxyWaitStats wait_stats[N_PRIORITIES];
+};
+
+/* time in microseconds a queued request waits to gain one priority class */
+#define GSIGNOND_PLUGIN_PROXY_AGING_INTERVAL (2 * G_TIME_SPAN_SECOND)
+
+/* time in milliseconds a plugin has to react to the cancellation of a
+ * request that ran past its deadline, before it is stopped */
+#define GSIGNOND_PLUGIN_PROXY_CANCEL_GRACE 1000
+
+/* A plugin instance serving one session at a time */
+typedef struct {
+    GSignondPluginProxy* proxy; /* not owned */
+    GSignondPlugin* plugin;
     GSignondAuthSession* active_session;
     gpointer active_process_userdata;
     gboolean expecting_request;
-};
+    guint n_processed;
+    guint watchdog_id;
+    gboolean overrun; /* the session was failed, waiting for the plugin */
+} GSignondPluginWorker;
 
 typedef struct {
+    GSignondPluginProxy* proxy; /* not owned */
     GSignondAuthSession* auth_session;
     GSignondSessionData* session_data;
     GSignondDictionary* identity_method_cache;
     gchar* mechanism;
+    gint64 deadline; /* monotonic time, 0 if none */
+    guint expire_id;
+    GSignondProcessPriority priority;
+    gint64 queued_at;
     gpointer userdata;
 } GSignondProcessData;
 
 static GParamSpec *obj_properties[N_PROPERTIES] = { NULL, };
 
-G_DEFINE_TYPE (GSignondPluginProxy, gsignond_plugin_proxy, GSIGNOND_TYPE_DISPOSABLE);
+static void
+gsignond_plugin_proxy_initable_iface_init (GInitableIface *iface);
+static void
+gsignond_plugin_proxy_async_initable_iface_init (GAsyncInitableIface *iface);
+
+G_DEFINE_TYPE_WITH_CODE (GSignondPluginProxy, gsignond_plugin_proxy,
+        GSIGNOND_TYPE_DISPOSABLE,
+        G_IMPLEMENT_INTERFACE (G_TYPE_INITABLE,
+                gsignond_plugin_proxy_initable_iface_init)
+        G_IMPLEMENT_INTERFACE (G_TYPE_ASYNC_INITABLE,
+                gsignond_plugin_proxy_async_initable_iface_init));
+
+static GSignondProcessPriority
+_get_priority (GSignondSessionData *session_data)
+{
+    GSignondProcessPriority priority = GSIGNOND_PROCESS_PRIORITY_NORMAL;
+    GSignondUiPolicy ui_policy = GSIGNOND_UI_POLICY_DEFAULT;
+
+    if (!session_data)
+        return priority;
+    /* gsignond_auth_session_process() has lowered client priorities to
+     * the default, higher ones come from the daemon */
+    if (gsignond_session_data_get_process_priority (session_data, &priority))
+        return MIN (priority, GSIGNOND_PROCESS_PRIORITY_INTERACTIVE);
+    /* nobody waits on requests that may not interact with the user */
+    if (gsignond_session_data_get_ui_policy (session_data, &ui_policy) &&
+        ui_policy == GSIGNOND_UI_POLICY_NO_USER_INTERACTION)
+        return GSIGNOND_PROCESS_PRIORITY_BACKGROUND;
+    return GSIGNOND_PROCESS_PRIORITY_NORMAL;
+}
 
 static GSignondProcessData*
 gsignond_process_data_new (
+        GSignondPluginProxy* proxy,
         GSignondAuthSession* auth_session,
         GSignondSessionData *session_data,
         GSignondDictionary *identity_method_cache,
         const gchar* mechanism,
+        gint64 deadline,
         gpointer userdata)
 {
     GSignondProcessData* data = g_slice_new0 (GSignondProcessData);
+    data->proxy = proxy;
     data->auth_session = g_object_ref (auth_session);
     data->session_data = gsignond_dictionary_copy (session_data);
     if (identity_method_cache)
         data->identity_method_cache = gsignond_dictionary_copy (identity_method_cache);
     data->mechanism = g_strdup (mechanism);
+    data->deadline = deadline;
+    data->priority = _get_priority (session_data);
+    data->queued_at = g_get_monotonic_time ();
     data->userdata = userdata;
     return data;
 }
@@ -91,6 +176,8 @@ static void
 gsignond_process_data_free (
         GSignondProcessData* data)
 {
+    if (data->expire_id)
+        g_source_remove (data->expire_id);
     g_object_unref (data->auth_session);
     gsignond_dictionary_unref (data->session_data);
     if (data->identity_method_cache)
@@ -99,24 +186,193 @@ gsignond_process_data_free (
     g_slice_free (GSignondProcessData, data);
 }
 
+/* milliseconds left until @deadline, rounded up */
+static guint
+_msecs_until (gint64 deadline)
+{
+    gint64 now = g_get_monotonic_time ();
+
+    if (deadline <= now)
+        return 0;
+    return (guint) MIN ((deadline - now + G_TIME_SPAN_MILLISECOND - 1) /
+                        G_TIME_SPAN_MILLISECOND, G_MAXUINT);
+}
+
+static gboolean
+_is_expired (GSignondProcessData *data)
+{
+    return data->deadline && g_get_monotonic_time () >= data->deadline;
+}
+
 static void
-gsignond_plugin_proxy_process_queue (
-        GSignondPluginProxy *self)
+_notify_timed_out (
+        GSignondAuthSession *session,
+        gpointer userdata)
 {
-    g_assert (GSIGNOND_IS_PLUGIN_PROXY (self));
+    GError *error = g_error_new (GSIGNOND_ERROR, GSIGNOND_ERROR_TIMED_OUT,
+                                 "The request did not complete in time");
+    gsignond_auth_session_notify_process_error (session, error, userdata);
+    g_error_free (error);
+}
+
+static gboolean
+_on_queued_request_expired (gpointer user_data)
+{
+    GSignondProcessData *data = (GSignondProcessData *) user_data;
+    GSignondPluginProxy *self = data->proxy;
+
+    data->expire_id = 0;
+    DBG ("%s request of session %p expired in the queue",
+         self->priv->plugin_type, data->auth_session);
+    g_queue_remove (self->priv->session_queue, data);
+    _notify_timed_out (data->auth_session, data->userdata);
+    gsignond_process_data_free (data);
+
+    return FALSE;
+}
+
+/* takes ownership of data */
+static void
+_enqueue_request (
+        GSignondPluginProxy *self,
+        GSignondProcessData *data)
+{
+    if (data->deadline)
+        data->expire_id = g_timeout_add (_msecs_until (data->deadline),
+                                         _on_queued_request_expired, data);
+    g_queue_push_tail (self->priv->session_queue, data);
+}
+
+static GSignondPluginWorker*
+_find_worker_by_session (
+        GSignondPluginProxy *self,
+        GSignondAuthSession *session)
+{
+    GPtrArray *workers = self->priv->workers;
+    guint i;
 
+    for (i = 0; workers && i < workers->len; i++) {
+        GSignondPluginWorker *worker = g_ptr_array_index (workers, i);
+        if (worker->active_session == session)
+            return worker;
+    }
+    return NULL;
+}
+
+/* the least loaded idle worker, if any */
+static GSignondPluginWorker*
+_find_idle_worker (GSignondPluginProxy *self)
+{
+    GPtrArray *workers = self->priv->workers;
+    GSignondPluginWorker *idle = NULL;
+    guint i;
+
+    for (i = 0; workers && i < workers->len; i++) {
+        GSignondPluginWorker *worker = g_ptr_array_index (workers, i);
+        if (worker->active_session == NULL &&
+            (!idle || worker->n_processed < idle->n_processed))
+            idle = worker;
+    }
+    return idle;
+}
+
+static gboolean
+_is_first_of_session (GList *link)
+{
+    GSignondAuthSession *session =
+        ((GSignondProcessData *) link->data)->auth_session;
+
+    for (link = link->prev; link; link = link->prev) {
+        if (((GSignondProcessData *) link->data)->auth_session == session)
+            return FALSE;
+    }
+    return TRUE;
+}
+
+/* picks the request with the highest priority, where each aging interval
+ * spent in the queue counts as one priority class, so that background
+ * requests are not starved. Requests of a session that is already being
+ * served or has earlier requests queued wait for those, so that they reach
+ * the plugins in order */
+static GList*
+_find_dispatchable (GSignondPluginProxy *self)
+{
+    gint64 now = g_get_monotonic_time ();
+    gint64 best_score = 0;
+    GList *link, *best = NULL;
+
+    for (link = self->priv->session_queue->head; link; link = link->next) {
+        GSignondProcessData *data = (GSignondProcessData *) link->data;
+        gint64 score;
+
+        if (_find_worker_by_session (self, data->auth_session) ||
+            !_is_first_of_session (link))
+            continue;
+        score = data->priority * GSIGNOND_PLUGIN_PROXY_AGING_INTERVAL +
+                now - data->queued_at;
+        if (!best || score > best_score) {
+            best = link;
+            best_score = score;
+        }
+    }
+    return best;
+}
+
+static void
+_account_wait (
+        GSignondPluginProxy *self,
+        GSignondProcessData *data)
+{
+    GSignondPluginProxyWaitStats *stats =
+        &self->priv->wait_stats[data->priority];
+    gint64 wait = g_get_monotonic_time () - data->queued_at;
+
+    stats->n_dispatched++;
+    stats->total_wait += wait;
+    if (wait > stats->max_wait)
+        stats->max_wait = wait;
+    DBG ("%s request of priority %d dispatched after %" G_GINT64_FORMAT
+         " us", self->priv->plugin_type, data->priority, wait);
+}
+
+static gboolean
+_start_worker_async (GSignondPluginProxy *self);
+static void
+_on_remote_plugin_dead (gpointer data, GObject *dead_obj);
+static void
+_set_watchdog (GSignondPluginWorker *worker, gint64 deadline);
+
+static void
+_dispatch_queue (GSignondPluginProxy *self)
+{
     GSignondPluginProxyPrivate *priv = self->priv;
-    GSignondProcessData* next_data = g_queue_pop_head (priv->session_queue);
-    if (next_data) {
-        priv->expecting_request = FALSE;
-        priv->active_process_userdata = next_data->userdata;
-        priv->active_session = next_data->auth_session;
-        g_object_ref (priv->active_session);
+    GSignondPluginWorker *worker;
+    GList *link;
+
+    while ((worker = _find_idle_worker (self)) != NULL &&
+           (link = _find_dispatchable (self)) != NULL) {
+        GSignondProcessData* next_data = link->data;
+        g_queue_delete_link (priv->session_queue, link);
+
+        if (_is_expired (next_data)) {
+            DBG ("dropping expired %s request of session %p",
+                 priv->plugin_type, next_data->auth_session);
+            _notify_timed_out (next_data->auth_session, next_data->userdata);
+            gsignond_process_data_free (next_data);
+            continue;
+        }
+
+        _account_wait (self, next_data);
+        worker->expecting_request = FALSE;
+        worker->n_processed++;
+        worker->active_process_userdata = next_data->userdata;
+        worker->active_session = g_object_ref (next_data->auth_session);
         gsignond_auth_session_notify_state_changed (
-                priv->active_session, GSIGNOND_PLUGIN_STATE_STARTED,
+                worker->active_session, GSIGNOND_PLUGIN_STATE_STARTED,
                 "The request is being processed.",
-                priv->active_process_userdata);
-        gsignond_plugin_request_initial (priv->plugin,
+                worker->active_process_userdata);
+        _set_watchdog (worker, next_data->deadline);
+        gsignond_plugin_request_initial (worker->plugin,
                                          next_data->session_data,
                                          next_data->identity_method_cache,
                                          next_data->mechanism);
@@ -124,27 +380,196 @@ gsignond_plugin_proxy_process_queue (
     }
 }
 
+static void
+gsignond_plugin_proxy_process_queue (
+        GSignondPluginProxy *self)
+{
+    g_assert (GSIGNOND_IS_PLUGIN_PROXY (self));
+
+    GSignondPluginProxyPrivate *priv = self->priv;
+    GList *link;
+    guint n_waiting = 0;
+
+    /* requests stay queued until the plugin has started */
+    if (!priv->workers || priv->workers->len == 0)
+        return;
+
+    _dispatch_queue (self);
+
+    /* grow the pool with the number of requests that could run now */
+    for (link = priv->session_queue->head; link; link = link->next) {
+        GSignondProcessData *data = (GSignondProcessData *) link->data;
+        if (!_find_worker_by_session (self, data->auth_session))
+            n_waiting++;
+    }
+    while (n_waiting > priv->starting_workers &&
+           priv->workers->len + priv->starting_workers < priv->max_workers) {
+        if (!_start_worker_async (self))
+            break;
+        if (priv->in_process)
+            n_waiting--;
+    }
+
+    /* in-process workers are ready right away */
+    if (priv->in_process)
+        _dispatch_queue (self);
+}
+
+/* detaches the plugin from the worker, returns the worker's reference */
+static GSignondPlugin*
+_worker_steal_plugin (GSignondPluginWorker *worker)
+{
+    GSignondPlugin *plugin = worker->plugin;
+
+    if (plugin) {
+        g_signal_handlers_disconnect_matched (plugin,
+                G_SIGNAL_MATCH_DATA, 0, 0, NULL, NULL, worker);
+        g_object_weak_unref (G_OBJECT (plugin), _on_remote_plugin_dead,
+                             worker);
+        worker->plugin = NULL;
+    }
+    return plugin;
+}
+
+static void
+_worker_free (GSignondPluginWorker *worker)
+{
+    GSignondPlugin *plugin = _worker_steal_plugin (worker);
+
+    if (plugin)
+        g_object_unref (plugin);
+    if (worker->watchdog_id)
+        g_source_remove (worker->watchdog_id);
+    if (worker->active_session)
+        g_object_unref (worker->active_session);
+    g_slice_free (GSignondPluginWorker, worker);
+}
+
+/* keeps a single idle worker around once the queue has drained */
+static void
+_shrink_pool (GSignondPluginProxy *self)
+{
+    GPtrArray *workers = self->priv->workers;
+    gboolean have_idle = FALSE;
+    guint i;
+
+    if (!workers || !g_queue_is_empty (self->priv->session_queue))
+        return;
+
+    for (i = 0; i < workers->len; ) {
+        GSignondPluginWorker *worker = g_ptr_array_index (workers, i);
+        if (worker->active_session == NULL) {
+            if (have_idle) {
+                DBG ("stopping idle %s worker %p", self->priv->plugin_type,
+                     worker->plugin);
+                g_ptr_array_remove_index (workers, i);
+                continue;
+            }
+            have_idle = TRUE;
+        }
+        i++;
+    }
+}
+
+/* stops the plugin of a worker that does not respond, and starts a new one
+ * in its place */
+static void
+_replace_worker (GSignondPluginWorker *worker)
+{
+    GSignondPluginProxy *self = worker->proxy;
+    GSignondPlugin *plugin = _worker_steal_plugin (worker);
+
+    g_object_ref (self);
+    g_ptr_array_remove (self->priv->workers, worker);
+    /* a remote plugin kills its loader process when it goes away, which
+     * runs the main loop until the process is gone */
+    g_object_unref (plugin);
+    if (self->priv->workers) {
+        _start_worker_async (self);
+        gsignond_plugin_proxy_process_queue (self);
+    }
+    g_object_unref (self);
+}
+
+static gboolean
+_on_worker_overrun (gpointer user_data)
+{
+    GSignondPluginWorker *worker = (GSignondPluginWorker *) user_data;
+    GSignondPluginProxy *self = worker->proxy;
+    gpointer userdata;
+
+    worker->watchdog_id = 0;
+    if (worker->overrun) {
+        WARN ("plugin %s did not react to cancellation, stopping it",
+              self->priv->plugin_type);
+        _replace_worker (worker);
+        return FALSE;
+    }
+
+    WARN ("plugin %s ran past the deadline of session %p, cancelling",
+          self->priv->plugin_type, worker->active_session);
+    /* the session is failed right away, the worker is busy until the
+     * plugin has given up on the request */
+    worker->overrun = TRUE;
+    worker->expecting_request = FALSE;
+    userdata = worker->active_process_userdata;
+    worker->active_process_userdata = NULL;
+    _notify_timed_out (worker->active_session, userdata);
+
+    worker->watchdog_id = g_timeout_add (GSIGNOND_PLUGIN_PROXY_CANCEL_GRACE,
+                                         _on_worker_overrun, worker);
+    gsignond_plugin_cancel (worker->plugin);
+
+    return FALSE;
+}
+
+/* a deadline of 0 stops the watchdog */
+static void
+_set_watchdog (
+        GSignondPluginWorker *worker,
+        gint64 deadline)
+{
+    if (worker->watchdog_id) {
+        g_source_remove (worker->watchdog_id);
+        worker->watchdog_id = 0;
+    }
+    if (deadline)
+        worker->watchdog_id = g_timeout_add (_msecs_until (deadline),
+                                             _on_worker_overrun, worker);
+}
+
+static void
+_worker_finished (GSignondPluginWorker *worker)
+{
+    GSignondPluginProxy *self = worker->proxy;
+
+    _set_watchdog (worker, 0);
+    worker->overrun = FALSE;
+    g_object_unref (worker->active_session);
+    worker->active_session = NULL;
+    worker->active_process_userdata = NULL;
+    gsignond_plugin_proxy_process_queue (self);
+    _shrink_pool (self);
+}
+
 static void
 gsignond_plugin_proxy_response_final_callback (
         GSignondPlugin *plugin,
         GSignondSessionData *result,
         gpointer user_data)
 {
-    GSignondPluginProxy *self = GSIGNOND_PLUGIN_PROXY (user_data);
-    GSignondPluginProxyPrivate *priv = self->priv;
+    GSignondPluginWorker *worker = (GSignondPluginWorker *) user_data;
 
     DBG ("");
-    if (priv->active_session == NULL) {
+    if (worker->active_session == NULL) {
         WARN("Error: plugin %s reported 'response_final', but no active session"
-                " in plugin proxy", priv->plugin_type);
+                " in plugin proxy", worker->proxy->priv->plugin_type);
         return;
     }
-    gsignond_auth_session_notify_process_result (priv->active_session, result,
-            priv->active_process_userdata);
-    g_object_unref (priv->active_session);
-    priv->active_session = NULL;
-    priv->active_process_userdata = NULL;
-    gsignond_plugin_proxy_process_queue (self);
+    if (!worker->overrun)
+        gsignond_auth_session_notify_process_result (worker->active_session,
+                result, worker->active_process_userdata);
+    _worker_finished (worker);
 }
 
 static void
@@ -153,17 +578,21 @@ gsignond_plugin_proxy_response_callback(
         GSignondSessionData *result,
         gpointer user_data)
 {
-    GSignondPluginProxy *self = GSIGNOND_PLUGIN_PROXY (user_data);
-    GSignondPluginProxyPrivate *priv = self->priv;
+    GSignondPluginWorker *worker = (GSignondPluginWorker *) user_data;
 
-    if (priv->active_session == NULL) {
+    if (worker->active_session == NULL) {
         WARN("Error: plugin %s reported 'response', but no active session "
-                "in plugin proxy", priv->plugin_type);
+                "in plugin proxy", worker->proxy->priv->plugin_type);
         return;
     }
-    priv->expecting_request = TRUE;
-    gsignond_auth_session_notify_process_result (priv->active_session,
-            result, priv->active_process_userdata);
+    if (worker->overrun)
+        return;
+    /* the client has its answer, the deadline of its next request
+     * applies from here */
+    _set_watchdog (worker, 0);
+    worker->expecting_request = TRUE;
+    gsignond_auth_session_notify_process_result (worker->active_session,
+            result, worker->active_process_userdata);
 }
 
 static void
@@ -172,15 +601,17 @@ gsignond_plugin_proxy_store_callback (
         GSignondSessionData *result,
         gpointer user_data)
 {
-    GSignondPluginProxy *self = GSIGNOND_PLUGIN_PROXY (user_data);
-    GSignondPluginProxyPrivate *priv = self->priv;
+    GSignondPluginWorker *worker = (GSignondPluginWorker *) user_data;
 
-    if (priv->active_session == NULL) {
+    if (worker->active_session == NULL) {
         WARN("Error: plugin %s reported 'store', but no active session "
-                "in plugin proxy", priv->plugin_type);
+                "in plugin proxy", worker->proxy->priv->plugin_type);
         return;
     }
-    gsignond_auth_session_notify_store (priv->active_session, result);
+    if (worker->overrun)
+        return;
+    gsignond_auth_session_notify_store (worker->active_session, result,
+                                        worker->active_process_userdata);
 }
 
 static void
@@ -189,15 +620,16 @@ gsignond_plugin_proxy_refreshed_callback (
         GSignondSignonuiData *ui_result,
         gpointer user_data)
 {
-    GSignondPluginProxy *self = GSIGNOND_PLUGIN_PROXY (user_data);
-    GSignondPluginProxyPrivate *priv = self->priv;
+    GSignondPluginWorker *worker = (GSignondPluginWorker *) user_data;
 
-    if (priv->active_session == NULL) {
+    if (worker->active_session == NULL) {
         WARN("Error: plugin %s reported 'refreshed', but no active session"
-                " in plugin proxy", priv->plugin_type);
+                " in plugin proxy", worker->proxy->priv->plugin_type);
         return;
     }
-    gsignond_auth_session_notify_refreshed (priv->active_session, ui_result);
+    if (worker->overrun)
+        return;
+    gsignond_auth_session_notify_refreshed (worker->active_session, ui_result);
 }
 
 static void
@@ -206,16 +638,17 @@ gsignond_plugin_proxy_user_action_required_callback (
         GSignondSignonuiData *ui_request,
         gpointer user_data)
 {
-    GSignondPluginProxy *self = GSIGNOND_PLUGIN_PROXY (user_data);
-    GSignondPluginProxyPrivate *priv = self->priv;
+    GSignondPluginWorker *worker = (GSignondPluginWorker *) user_data;
 
-    if (priv->active_session == NULL) {
+    if (worker->active_session == NULL) {
         WARN("Error: plugin %s reported 'user_action_required', but no active"
-                " session in plugin proxy", priv->plugin_type);
+                " session in plugin proxy", worker->proxy->priv->plugin_type);
         return;
     }
+    if (worker->overrun)
+        return;
     gsignond_auth_session_notify_user_action_required(
-        priv->active_session, ui_request);
+        worker->active_session, ui_request);
 }
 
 static void
@@ -224,20 +657,18 @@ gsignond_plugin_proxy_error_callback (
         GError* error,
         gpointer user_data)
 {
-    GSignondPluginProxy *self = GSIGNOND_PLUGIN_PROXY (user_data);
-    GSignondPluginProxyPrivate *priv = self->priv;
+    GSignondPluginWorker *worker = (GSignondPluginWorker *) user_data;
 
-    if (priv->active_session == NULL) {
+    if (worker->active_session == NULL) {
         WARN("Error: plugin %s reported error %s, but no active session "
-                "in plugin proxy", priv->plugin_type, error->message);
+                "in plugin proxy", worker->proxy->priv->plugin_type,
+                error->message);
         return;
     }
-    gsignond_auth_session_notify_process_error (priv->active_session, error,
-            priv->active_process_userdata);
-    g_object_unref (priv->active_session);
-    priv->active_session = NULL;
-    priv->active_process_userdata = NULL;
-    gsignond_plugin_proxy_process_queue (self);
+    if (!worker->overrun)
+        gsignond_auth_session_notify_process_error (worker->active_session,
+                error, worker->active_process_userdata);
+    _worker_finished (worker);
 }
 
 static void
@@ -247,83 +678,378 @@ gsignond_plugin_proxy_status_changed_callback (
         const gchar *message,
         gpointer user_data)
 {
-    GSignondPluginProxy *self = GSIGNOND_PLUGIN_PROXY (user_data);
-    GSignondPluginProxyPrivate *priv = self->priv;
+    GSignondPluginWorker *worker = (GSignondPluginWorker *) user_data;
 
-    if (priv->active_session == NULL) {
+    if (worker->active_session == NULL) {
         WARN("Error: plugin %s reported change in state %d with message %s, "
-                "but no active session in plugin proxy", priv->plugin_type,
-                state, message);
+                "but no active session in plugin proxy",
+                worker->proxy->priv->plugin_type, state, message);
         return;
     }
-    gsignond_auth_session_notify_state_changed (priv->active_session,
+    if (worker->overrun)
+        return;
+    gsignond_auth_session_notify_state_changed (worker->active_session,
                                                 (gint) state, message,
-                                                priv->active_process_userdata);
+                                                worker->active_process_userdata);
 }
 
 static void
 _on_remote_plugin_dead (gpointer data, GObject *dead_obj)
 {
 DBG("{");
-    GSignondPluginProxy *proxy = NULL;
-    if (data && (proxy = GSIGNOND_PLUGIN_PROXY(data))) {
-        proxy->priv->plugin = NULL;
-        g_object_unref (G_OBJECT(data));
+    GSignondPluginWorker *worker = (GSignondPluginWorker *) data;
+    GSignondPluginProxy *proxy = worker->proxy;
+
+    worker->plugin = NULL;
+    g_object_ref (proxy);
+    _set_watchdog (worker, 0);
+    /* the request the plugin was serving would otherwise never complete,
+     * and identical requests would keep joining it */
+    if (worker->active_session && !worker->overrun) {
+        GError *error = g_error_new (GSIGNOND_ERROR,
+                                     GSIGNOND_ERROR_INTERNAL_COMMUNICATION,
+                                     "Plugin %s exited during the request",
+                                     proxy->priv->plugin_type);
+        WARN ("%s", error->message);
+        gsignond_auth_session_notify_process_error (worker->active_session,
+                error, worker->active_process_userdata);
+        g_error_free (error);
     }
+
+    if (proxy->priv->workers) {
+        g_ptr_array_remove (proxy->priv->workers, worker);
+        if (!g_queue_is_empty (proxy->priv->session_queue)) {
+            _start_worker_async (proxy);
+            gsignond_plugin_proxy_process_queue (proxy);
+        } else if (proxy->priv->workers->len == 0) {
+            g_object_unref (G_OBJECT(proxy));
+        }
+    }
+    g_object_unref (proxy);
 DBG("}");
 }
 
-static GObject *
-gsignond_plugin_proxy_constructor (
-        GType                  gtype,
-        guint                  n_properties,
-        GObjectConstructParam *properties)
+/* takes ownership of plugin */
+static gboolean
+_add_worker (
+        GSignondPluginProxy *self,
+        GSignondPlugin *plugin,
+        GError **error)
+{
+    GSignondPluginProxyPrivate *priv = self->priv;
+    GSignondPluginWorker *worker;
+    gchar *type = NULL;
+
+    if (priv->workers == NULL) {
+        /* disposed while the plugin was starting */
+        g_set_error (error, GSIGNOND_ERROR, GSIGNOND_ERROR_METHOD_NOT_AVAILABLE,
+                     "Plugin proxy %s is disposed", priv->plugin_type);
+        g_object_unref (plugin);
+        return FALSE;
+    }
+
+    g_object_get (plugin, "type", &type, NULL);
+    if (g_strcmp0 (type, priv->plugin_type) != 0) {
+        g_set_error (error, GSIGNOND_ERROR, GSIGNOND_ERROR_METHOD_NOT_AVAILABLE,
+                     "Plugin %s reports type %s", priv->plugin_type, type);
+        g_free (type);
+        g_object_unref (plugin);
+        return FALSE;
+    }
+    g_free (type);
+
+    worker = g_slice_new0 (GSignondPluginWorker);
+    worker->proxy = self;
+    worker->plugin = plugin;
+
+    g_signal_connect(plugin, "response", G_CALLBACK(
+        gsignond_plugin_proxy_response_callback), worker);
+    g_signal_connect(plugin, "response-final", G_CALLBACK(
+        gsignond_plugin_proxy_response_final_callback), worker);
+    g_signal_connect(plugin, "user-action-required", G_CALLBACK(
+        gsignond_plugin_proxy_user_action_required_callback), worker);
+    g_signal_connect(plugin, "error", G_CALLBACK(
+        gsignond_plugin_proxy_error_callback), worker);
+    g_signal_connect(plugin, "store", G_CALLBACK(
+        gsignond_plugin_proxy_store_callback), worker);
+    g_signal_connect(plugin, "refreshed", G_CALLBACK(
+        gsignond_plugin_proxy_refreshed_callback), worker);
+    g_signal_connect(plugin, "status-changed", G_CALLBACK(
+        gsignond_plugin_proxy_status_changed_callback), worker);
+
+    g_object_weak_ref (G_OBJECT(plugin), _on_remote_plugin_dead, worker);
+
+    g_ptr_array_add (priv->workers, worker);
+    DBG ("%s worker %p added, %u running", priv->plugin_type, plugin,
+         priv->workers->len);
+
+    return TRUE;
+}
+
+/* plugins on the in-process allow-list are loaded into the daemon, further
+ * workers are new instances of the type registered by the loaded module */
+static GSignondPlugin*
+_new_in_process_plugin (GSignondPluginProxy *self)
 {
-    GObject *obj;
+    GPtrArray *workers = self->priv->workers;
+
+    if (workers && workers->len > 0) {
+        GSignondPluginWorker *worker = g_ptr_array_index (workers, 0);
+        return GSIGNOND_PLUGIN (g_object_new (G_OBJECT_TYPE (worker->plugin),
+                                              NULL));
+    }
+    return gsignond_load_plugin (NULL, self->priv->plugin_type);
+}
 
-    /* Always chain up to the parent constructor */
-    obj = G_OBJECT_CLASS (gsignond_plugin_proxy_parent_class)->
-        constructor (gtype, n_properties, properties);
-  
-    /* update the object state depending on constructor properties */
-    GSignondPluginProxy* self = GSIGNOND_PLUGIN_PROXY (obj);
+static gboolean
+gsignond_plugin_proxy_initable_init (
+        GInitable *initable,
+        GCancellable *cancellable,
+        GError **error)
+{
+    GSignondPluginProxy *self = GSIGNOND_PLUGIN_PROXY (initable);
     GSignondPluginProxyPrivate *priv = self->priv;
-    priv->plugin = GSIGNOND_PLUGIN (gsignond_plugin_remote_new (priv->loader_path,
-            priv->plugin_type));
+    GSignondPlugin *plugin = NULL;
 
-    if (priv->plugin == NULL) {
-        g_free (priv->plugin_type);
-        priv->plugin_type = NULL;
+    if (priv->initialized) {
+        if (priv->init_error && error)
+            *error = g_error_copy (priv->init_error);
+        return priv->init_error == NULL;
+    }
+    g_return_val_if_fail (!priv->initializing, FALSE);
 
+    if (priv->in_process)
+        plugin = _new_in_process_plugin (self);
+    else
+        plugin = GSIGNOND_PLUGIN (gsignond_plugin_remote_new (
+                priv->loader_path, priv->plugin_type));
+    if (plugin == NULL) {
+        priv->init_error = g_error_new (GSIGNOND_ERROR,
+                GSIGNOND_ERROR_METHOD_NOT_AVAILABLE,
+                "Plugin %s could not be started", priv->plugin_type);
     } else {
-        gchar *type = NULL;
-
-        g_signal_connect(priv->plugin, "response", G_CALLBACK(
-            gsignond_plugin_proxy_response_callback), self);
-        g_signal_connect(priv->plugin, "response-final", G_CALLBACK(
-            gsignond_plugin_proxy_response_final_callback), self);
-        g_signal_connect(priv->plugin, "user-action-required", G_CALLBACK(
-            gsignond_plugin_proxy_user_action_required_callback), self);
-        g_signal_connect(priv->plugin, "error", G_CALLBACK(
-            gsignond_plugin_proxy_error_callback), self);
-        g_signal_connect(priv->plugin, "store", G_CALLBACK(
-            gsignond_plugin_proxy_store_callback), self);
-        g_signal_connect(priv->plugin, "refreshed", G_CALLBACK(
-            gsignond_plugin_proxy_refreshed_callback), self);
-        g_signal_connect(priv->plugin, "status-changed", G_CALLBACK(
-            gsignond_plugin_proxy_status_changed_callback), self);
-
-        g_object_get (priv->plugin, "type", &type, NULL);
-        if (g_strcmp0 (type, priv->plugin_type) != 0) {
-            g_free (priv->plugin_type);
-            priv->plugin_type = NULL;
+        _add_worker (self, plugin, &priv->init_error);
+    }
+    priv->initialized = TRUE;
+
+    if (priv->init_error && error)
+        *error = g_error_copy (priv->init_error);
+    return priv->init_error == NULL;
+}
+
+static void
+gsignond_plugin_proxy_initable_iface_init (GInitableIface *iface)
+{
+    iface->init = gsignond_plugin_proxy_initable_init;
+}
+
+static void
+_complete_init_task (gpointer data, gpointer user_data)
+{
+    GTask *task = G_TASK (data);
+    GError *error = (GError *) user_data;
+
+    if (error)
+        g_task_return_error (task, g_error_copy (error));
+    else
+        g_task_return_boolean (task, TRUE);
+    g_object_unref (task);
+}
+
+/* takes ownership of plugin */
+static void
+_on_plugin_started (
+        GSignondPluginProxy *self,
+        GSignondPlugin *plugin)
+{
+    GSignondPluginProxyPrivate *priv = self->priv;
+    GList *tasks;
+
+    if (plugin == NULL) {
+        priv->init_error = g_error_new (GSIGNOND_ERROR,
+                GSIGNOND_ERROR_METHOD_NOT_AVAILABLE,
+                "Plugin %s could not be started", priv->plugin_type);
+    } else {
+        _add_worker (self, plugin, &priv->init_error);
+    }
+    priv->initializing = FALSE;
+    priv->initialized = TRUE;
+
+    tasks = priv->init_tasks;
+    priv->init_tasks = NULL;
+    g_list_foreach (tasks, _complete_init_task, priv->init_error);
+    g_list_free (tasks);
+
+    if (priv->init_error) {
+        /* fail the requests that were queued during startup */
+        GSignondProcessData* data;
+        while ((data = g_queue_pop_head (priv->session_queue)) != NULL) {
+            gsignond_auth_session_notify_process_error (data->auth_session,
+                    priv->init_error, data->userdata);
+            gsignond_process_data_free (data);
         }
-        g_free (type);
+    } else {
+        gsignond_plugin_proxy_process_queue (self);
+    }
+}
+
+static void
+_on_remote_plugin_ready (
+        GObject *source,
+        GAsyncResult *res,
+        gpointer user_data)
+{
+    GSignondPluginProxy *self = GSIGNOND_PLUGIN_PROXY (user_data);
+    GSignondPluginRemote *plugin = NULL;
+    GError *error = NULL;
+
+    plugin = gsignond_plugin_remote_new_finish (res, &error);
+    if (plugin == NULL) {
+        DBG ("Plugin %s could not be started: %s", self->priv->plugin_type,
+             error->message);
+        g_error_free (error);
+    }
+    _on_plugin_started (self, plugin ? GSIGNOND_PLUGIN (plugin) : NULL);
+
+    g_object_unref (self);
+}
+
+static void
+_on_worker_ready (
+        GObject *source,
+        GAsyncResult *res,
+        gpointer user_data)
+{
+    GSignondPluginProxy *self = GSIGNOND_PLUGIN_PROXY (user_data);
+    GSignondPluginProxyPrivate *priv = self->priv;
+    GSignondPluginRemote *plugin = NULL;
+    GError *error = NULL;
+
+    priv->starting_workers--;
+    plugin = gsignond_plugin_remote_new_finish (res, &error);
+    if (plugin == NULL) {
+        /* the requests are still served by the running workers */
+        WARN ("Extra worker for plugin %s could not be started: %s",
+              priv->plugin_type, error->message);
+        g_error_free (error);
+    } else if (_add_worker (self, GSIGNOND_PLUGIN (plugin), NULL)) {
+        gsignond_plugin_proxy_process_queue (self);
+        _shrink_pool (self);
+    }
+
+    g_object_unref (self);
+}
+
+/* starts a plugin loader process, takes one that is in standby, or has the
+ * shared one export the plugin */
+static void
+_new_remote_plugin_async (
+        GSignondPluginProxy *self,
+        GAsyncReadyCallback callback)
+{
+    GSignondPluginProxyPrivate *priv = self->priv;
+
+    if (priv->framed)
+        gsignond_plugin_remote_new_framed_async (priv->loader_path,
+                priv->plugin_type, priv->standby, NULL, callback,
+                g_object_ref (self));
+    else if (priv->shared_loader)
+        gsignond_plugin_remote_new_shared_async (priv->shared_loader,
+                priv->plugin_type, NULL, callback, g_object_ref (self));
+    else if (priv->standby)
+        gsignond_plugin_remote_new_from_standby_async (priv->standby,
+                priv->plugin_type, NULL, callback, g_object_ref (self));
+    else
+        gsignond_plugin_remote_new_async (priv->loader_path,
+                priv->plugin_type, NULL, callback, g_object_ref (self));
+}
+
+static gboolean
+_start_worker_async (GSignondPluginProxy *self)
+{
+    GSignondPluginProxyPrivate *priv = self->priv;
+    GSignondPluginRemote *host = NULL;
+
+    if (priv->in_process) {
+        GSignondPlugin *plugin = _new_in_process_plugin (self);
+        return plugin && _add_worker (self, plugin, NULL);
+    }
+
+    if (priv->workers->len > 0)
+        host = GSIGNOND_PLUGIN_REMOTE (((GSignondPluginWorker *)
+                g_ptr_array_index (priv->workers, 0))->plugin);
+
+    priv->starting_workers++;
+    /* a loader multiplexing sessions serves the extra workers from the
+     * process that is running already */
+    if (host && gsignond_plugin_remote_supports_sessions (host))
+        gsignond_plugin_remote_new_session_async (host, NULL,
+                _on_worker_ready, g_object_ref (self));
+    else
+        _new_remote_plugin_async (self, _on_worker_ready);
+    return TRUE;
+}
+
+static void
+_start_plugin_async (GSignondPluginProxy *self)
+{
+    GSignondPluginProxyPrivate *priv = self->priv;
+
+    if (priv->initialized || priv->initializing)
+        return;
+
+    priv->initializing = TRUE;
+    if (priv->in_process) {
+        GSignondPlugin *plugin = _new_in_process_plugin (self);
+        if (plugin == NULL)
+            DBG ("Plugin %s could not be loaded", priv->plugin_type);
+        _on_plugin_started (self, plugin);
+        return;
+    }
+    _new_remote_plugin_async (self, _on_remote_plugin_ready);
+}
+
+static void
+gsignond_plugin_proxy_init_async (
+        GAsyncInitable *initable,
+        int io_priority,
+        GCancellable *cancellable,
+        GAsyncReadyCallback callback,
+        gpointer user_data)
+{
+    GSignondPluginProxy *self = GSIGNOND_PLUGIN_PROXY (initable);
+    GSignondPluginProxyPrivate *priv = self->priv;
+    GTask *task = g_task_new (self, cancellable, callback, user_data);
 
-        g_object_weak_ref (G_OBJECT(priv->plugin), _on_remote_plugin_dead, obj);
+    g_task_set_priority (task, io_priority);
 
+    if (priv->initialized) {
+        _complete_init_task (task, priv->init_error);
+        return;
     }
-    return obj;
+
+    /* the proxy can be used meanwhile, requests are queued until the
+     * plugin is up */
+    priv->init_tasks = g_list_append (priv->init_tasks, task);
+    _start_plugin_async (self);
+}
+
+static gboolean
+gsignond_plugin_proxy_init_finish (
+        GAsyncInitable *initable,
+        GAsyncResult *res,
+        GError **error)
+{
+    g_return_val_if_fail (g_task_is_valid (res, initable), FALSE);
+
+    return g_task_propagate_boolean (G_TASK (res), error);
+}
+
+static void
+gsignond_plugin_proxy_async_initable_iface_init (GAsyncInitableIface *iface)
+{
+    iface->init_async = gsignond_plugin_proxy_init_async;
+    iface->init_finish = gsignond_plugin_proxy_init_finish;
 }
 
 static void
@@ -346,6 +1072,23 @@ gsignond_plugin_proxy_set_property (
             g_assert (self->priv->loader_path == NULL);
             priv->loader_path = g_value_dup_string (value);
             break;
+        case PROP_MAX_WORKERS:
+            priv->max_workers = g_value_get_uint (value);
+            break;
+        case PROP_IN_PROCESS:
+            priv->in_process = g_value_get_boolean (value);
+            break;
+        case PROP_STANDBY:
+            g_assert (priv->standby == NULL);
+            priv->standby = g_value_dup_object (value);
+            break;
+        case PROP_SHARED_LOADER:
+            g_assert (priv->shared_loader == NULL);
+            priv->shared_loader = g_value_dup_object (value);
+            break;
+        case PROP_FRAMED:
+            priv->framed = g_value_get_boolean (value);
+            break;
         default:
             G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
             break;
@@ -368,12 +1111,32 @@ gsignond_plugin_proxy_get_property (
             g_value_set_string (value, priv->plugin_type);
             break;
         case PROP_MECHANISMS:
-            g_object_get_property (G_OBJECT(priv->plugin),
-                                   "mechanisms", value);
+            if (priv->workers && priv->workers->len > 0) {
+                GSignondPluginWorker *worker =
+                    g_ptr_array_index (priv->workers, 0);
+                g_object_get_property (G_OBJECT(worker->plugin),
+                                       "mechanisms", value);
+            } else
+                g_value_set_boxed (value, NULL);
             break;
         case PROP_LOADERPATH:
             g_value_set_string (value, priv->loader_path);
             break;
+        case PROP_MAX_WORKERS:
+            g_value_set_uint (value, priv->max_workers);
+            break;
+        case PROP_IN_PROCESS:
+            g_value_set_boolean (value, priv->in_process);
+            break;
+        case PROP_STANDBY:
+            g_value_set_object (value, priv->standby);
+            break;
+        case PROP_SHARED_LOADER:
+            g_value_set_object (value, priv->shared_loader);
+            break;
+        case PROP_FRAMED:
+            g_value_set_boolean (value, priv->framed);
+            break;
         default:
             G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
             break;
@@ -387,14 +1150,21 @@ gsignond_plugin_proxy_dispose (
     GSignondPluginProxy *self = GSIGNOND_PLUGIN_PROXY (gobject);
     GSignondPluginProxyPrivate *priv = self->priv;
 
-    if (priv->active_session) {
-        g_object_unref (priv->active_session);
-        priv->active_session = NULL;
+    if (priv->deferred_id) {
+        g_source_remove (priv->deferred_id);
+        priv->deferred_id = 0;
+    }
+    if (priv->workers) {
+        g_ptr_array_unref (priv->workers);
+        priv->workers = NULL;
     }
-    if (priv->plugin) {
-        g_object_weak_unref (G_OBJECT(priv->plugin), _on_remote_plugin_dead, self);
-        g_object_unref (priv->plugin);
-        priv->plugin = NULL;
+    if (priv->standby) {
+        g_object_unref (priv->standby);
+        priv->standby = NULL;
+    }
+    if (priv->shared_loader) {
+        g_object_unref (priv->shared_loader);
+        priv->shared_loader = NULL;
     }
 
   /* Chain up to the parent class */
@@ -421,6 +1191,13 @@ gsignond_plugin_proxy_finalize (GObject *gobject)
                            (GDestroyNotify) gsignond_process_data_free);
         priv->session_queue = NULL;
     }
+    if (priv->deferred_queue)
+    {
+        g_queue_free_full (priv->deferred_queue,
+                           (GDestroyNotify) gsignond_process_data_free);
+        priv->deferred_queue = NULL;
+    }
+    g_clear_error (&priv->init_error);
 
     /* Chain up to the parent class */
     G_OBJECT_CLASS (gsignond_plugin_proxy_parent_class)->finalize (gobject);
@@ -436,7 +1213,6 @@ gsignond_plugin_proxy_class_init (
     g_type_class_add_private (gobject_class,
                               sizeof (GSignondPluginProxyPrivate)); 
 
-    gobject_class->constructor = gsignond_plugin_proxy_constructor;
     gobject_class->set_property = gsignond_plugin_proxy_set_property;
     gobject_class->get_property = gsignond_plugin_proxy_get_property;
     gobject_class->dispose = gsignond_plugin_proxy_dispose;
@@ -462,6 +1238,41 @@ gsignond_plugin_proxy_class_init (
                                                    G_PARAM_CONSTRUCT_ONLY | G_PARAM_READWRITE |
                                                    G_PARAM_STATIC_STRINGS);
 
+    obj_properties[PROP_MAX_WORKERS] = g_param_spec_uint ("max-workers",
+                                                   "Maximum workers",
+                                                   "Maximum number of sessions served concurrently",
+                                                   1, G_MAXUINT, 1,
+                                                   G_PARAM_CONSTRUCT_ONLY | G_PARAM_READWRITE |
+                                                   G_PARAM_STATIC_STRINGS);
+
+    obj_properties[PROP_IN_PROCESS] = g_param_spec_boolean ("in-process",
+                                                   "In-process",
+                                                   "Load the plugin into the daemon instead of a plugin loader process",
+                                                   FALSE,
+                                                   G_PARAM_CONSTRUCT_ONLY | G_PARAM_READWRITE |
+                                                   G_PARAM_STATIC_STRINGS);
+
+    obj_properties[PROP_STANDBY] = g_param_spec_object ("standby",
+                                                   "Standby loaders",
+                                                   "Pool of plugin loader processes to take loaders from",
+                                                   GSIGNOND_TYPE_PLUGIN_STANDBY,
+                                                   G_PARAM_CONSTRUCT_ONLY | G_PARAM_READWRITE |
+                                                   G_PARAM_STATIC_STRINGS);
+
+    obj_properties[PROP_SHARED_LOADER] = g_param_spec_object ("shared-loader",
+                                                   "Shared loader",
+                                                   "Plugin loader process shared with other plugin types",
+                                                   GSIGNOND_TYPE_PLUGIN_SHARED_LOADER,
+                                                   G_PARAM_CONSTRUCT_ONLY | G_PARAM_READWRITE |
+                                                   G_PARAM_STATIC_STRINGS);
+
+    obj_properties[PROP_FRAMED] = g_param_spec_boolean ("framed",
+                                                   "Framed transport",
+                                                   "Talk to the plugin loader with binary frames instead of D-Bus",
+                                                   FALSE,
+                                                   G_PARAM_CONSTRUCT_ONLY | G_PARAM_READWRITE |
+                                                   G_PARAM_STATIC_STRINGS);
+
     g_object_class_install_properties (gobject_class,
                                        N_PROPERTIES,
                                        obj_properties);
@@ -477,11 +1288,22 @@ gsignond_plugin_proxy_init (
 
     priv->loader_path = NULL;
     priv->plugin_type = NULL;
-    priv->plugin = NULL;
+    priv->workers = g_ptr_array_new_with_free_func (
+            (GDestroyNotify) _worker_free);
+    priv->max_workers = 1;
+    priv->starting_workers = 0;
+    priv->initializing = FALSE;
+    priv->initialized = FALSE;
+    priv->init_error = NULL;
+    priv->init_tasks = NULL;
     priv->session_queue = g_queue_new ();
-    priv->active_session = NULL;
-    priv->active_process_userdata = NULL;
-    priv->expecting_request = FALSE;
+    priv->in_process = FALSE;
+    priv->standby = NULL;
+    priv->shared_loader = NULL;
+    priv->framed = FALSE;
+    priv->deferred_queue = g_queue_new ();
+    priv->deferred_id = 0;
+    memset (priv->wait_stats, 0, sizeof (priv->wait_stats));
 }
 
 static const gchar *
@@ -501,18 +1323,139 @@ gsignond_plugin_proxy_new (
 {
     g_return_val_if_fail (loader_path && plugin_type, NULL);
 
-    GSignondPluginProxy* proxy = g_object_new (GSIGNOND_TYPE_PLUGIN_PROXY,
-                                               "loaderpath", loader_path,
-                                               "type", plugin_type,
-                                               "auto-dispose", FALSE,
-                                               "timeout", timeout,
-                                               NULL);
-    if (g_strcmp0 (plugin_type,
-                   gsignond_plugin_proxy_get_plugin_type (proxy)) == 0)
-        return proxy;
+    GError *error = NULL;
+    GSignondPluginProxy* proxy = g_initable_new (GSIGNOND_TYPE_PLUGIN_PROXY,
+                                                 NULL, &error,
+                                                 "loaderpath", loader_path,
+                                                 "type", plugin_type,
+                                                 "auto-dispose", FALSE,
+                                                 "timeout", timeout,
+                                                 NULL);
+    if (!proxy) {
+        DBG ("%s", error->message);
+        g_error_free (error);
+    }
+    return proxy;
+}
 
-    g_object_unref (proxy);
-    return NULL;
+/**
+ * gsignond_plugin_proxy_new_async:
+ * @loader_path: path of the plugin loader
+ * @plugin_type: type of the plugin
+ * @timeout: auto-dispose timeout of the proxy
+ * @cancellable: (allow-none): a #GCancellable
+ * @callback: called when the plugin is up
+ * @user_data: user data for @callback
+ *
+ * Creates a proxy and starts its plugin without blocking the main loop. Use
+ * gsignond_plugin_proxy_new_finish() in @callback to get the result.
+ *
+ * A proxy created with g_object_new() and started with
+ * g_async_initable_init_async() can be used before the plugin is up:
+ * requests passed to gsignond_plugin_proxy_process() are queued meanwhile,
+ * and fail with GSIGNOND_ERROR_METHOD_NOT_AVAILABLE if the plugin could not
+ * be started.
+ */
+void
+gsignond_plugin_proxy_new_async (
+        const gchar *loader_path,
+        const gchar *plugin_type,
+        gint timeout,
+        GCancellable *cancellable,
+        GAsyncReadyCallback callback,
+        gpointer user_data)
+{
+    g_return_if_fail (loader_path && plugin_type);
+
+    g_async_initable_new_async (GSIGNOND_TYPE_PLUGIN_PROXY,
+                                G_PRIORITY_DEFAULT, cancellable,
+                                callback, user_data,
+                                "loaderpath", loader_path,
+                                "type", plugin_type,
+                                "auto-dispose", FALSE,
+                                "timeout", timeout,
+                                NULL);
+}
+
+/**
+ * gsignond_plugin_proxy_new_finish:
+ * @result: the #GAsyncResult passed to the callback
+ * @error: return location for error
+ *
+ * Returns: (transfer full): the proxy, or NULL if the plugin could not be
+ * started.
+ */
+GSignondPluginProxy*
+gsignond_plugin_proxy_new_finish (
+        GAsyncResult *result,
+        GError **error)
+{
+    GObject *source = g_async_result_get_source_object (result);
+    GObject *proxy = g_async_initable_new_finish (G_ASYNC_INITABLE (source),
+                                                  result, error);
+    g_object_unref (source);
+
+    return proxy ? GSIGNOND_PLUGIN_PROXY (proxy) : NULL;
+}
+
+static void
+_process (
+        GSignondPluginProxy *self,
+        GSignondAuthSession *session,
+        GSignondSessionData *session_data,
+        GSignondDictionary *identity_method_cache,
+        const gchar *mechanism,
+        gint64 deadline,
+        gpointer userdata)
+{
+    GSignondPluginProxyPrivate *priv = self->priv;
+    GSignondPluginWorker *worker;
+
+    _start_plugin_async (self);
+    if (priv->init_error) {
+        gsignond_auth_session_notify_process_error (session, priv->init_error,
+                                                    userdata);
+        return;
+    }
+
+    worker = _find_worker_by_session (self, session);
+    if (worker && worker->expecting_request == TRUE) {
+        worker->expecting_request = FALSE;
+        _set_watchdog (worker, deadline);
+        // mechanism and identity_method_cache are discarded if this is not an initial request
+        gsignond_plugin_request (worker->plugin, session_data);
+        return;
+    }
+
+    _enqueue_request (self, gsignond_process_data_new (self, session,
+                                                       session_data,
+                                                       identity_method_cache,
+                                                       mechanism, deadline,
+                                                       userdata));
+    gsignond_auth_session_notify_state_changed (
+            session, GSIGNOND_PLUGIN_STATE_PROCESS_PENDING,
+            "The request has been queued.", userdata);
+    gsignond_plugin_proxy_process_queue (self);
+}
+
+static gboolean
+_process_deferred (gpointer user_data)
+{
+    GSignondPluginProxy *self = GSIGNOND_PLUGIN_PROXY (user_data);
+    GSignondPluginProxyPrivate *priv = self->priv;
+    GSignondProcessData *data;
+
+    priv->deferred_id = 0;
+    g_object_ref (self);
+    while ((data = g_queue_pop_head (priv->deferred_queue)) != NULL) {
+        _process (self, data->auth_session, data->session_data,
+                  data->identity_method_cache, data->mechanism,
+                  data->deadline, data->userdata);
+        gsignond_process_data_free (data);
+    }
+    g_object_unref (self);
+
+    return FALSE;
 }
 
 void
@@ -522,6 +1465,7 @@ gsignond_plugin_proxy_process (
         GSignondSessionData *session_data,
         GSignondDictionary *identity_method_cache,
         const gchar *mechanism,
+        gint64 deadline,
         gpointer userdata)
 {
     g_assert (GSIGNOND_IS_PLUGIN_PROXY (self));
@@ -529,24 +1473,56 @@ gsignond_plugin_proxy_process (
 
     GSignondPluginProxyPrivate *priv = self->priv;
 
-    if (session == priv->active_session && priv->expecting_request == TRUE) {
-        priv->expecting_request = FALSE;
-        // mechanism and identity_method_cache are discarded if this is not an initial request
-        gsignond_plugin_request (priv->plugin, session_data);
+    if (!priv->in_process) {
+        _process (self, session, session_data, identity_method_cache,
+                  mechanism, deadline, userdata);
         return;
     }
 
-    g_queue_push_tail (priv->session_queue,
-                       gsignond_process_data_new (session,
-                                                  session_data, 
+    /* in-process plugins reply before returning, so their requests are
+     * passed on from the main loop to keep the replies asynchronous */
+    g_queue_push_tail (priv->deferred_queue,
+                       gsignond_process_data_new (self, session, session_data,
                                                   identity_method_cache,
-                                                  mechanism, userdata));
-    gsignond_auth_session_notify_state_changed (
-            session, GSIGNOND_PLUGIN_STATE_PROCESS_PENDING,
-            "The request has been queued.", userdata);
-    if (priv->active_session == NULL) {
-        gsignond_plugin_proxy_process_queue (self);
-    }
+                                                  mechanism, deadline,
+                                                  userdata));
+    if (priv->deferred_id == 0)
+        priv->deferred_id = g_idle_add (_process_deferred, self);
+}
+
+/**
+ * gsignond_plugin_proxy_get_wait_stats:
+ * @self: a #GSignondPluginProxy
+ * @priority: the priority class
+ * @n_dispatched: (out) (allow-none): number of requests of @priority passed
+ * to the plugin
+ * @total_wait: (out) (allow-none): total time in microseconds these requests
+ * waited in the queue
+ * @max_wait: (out) (allow-none): the longest time in microseconds one of
+ * these requests waited in the queue
+ *
+ * Reports how long the requests of a priority class wait for a plugin, to
+ * help tuning the pool size and priorities.
+ */
+void
+gsignond_plugin_proxy_get_wait_stats (
+        GSignondPluginProxy *self,
+        GSignondProcessPriority priority,
+        guint *n_dispatched,
+        gint64 *total_wait,
+        gint64 *max_wait)
+{
+    g_return_if_fail (GSIGNOND_IS_PLUGIN_PROXY (self));
+    g_return_if_fail (priority <= GSIGNOND_PROCESS_PRIORITY_INTERACTIVE);
+
+    GSignondPluginProxyWaitStats *stats = &self->priv->wait_stats[priority];
+
+    if (n_dispatched)
+        *n_dispatched = stats->n_dispatched;
+    if (total_wait)
+        *total_wait = stats->total_wait;
+    if (max_wait)
+        *max_wait = stats->max_wait;
 }
 
 static gint
@@ -562,17 +1538,13 @@ gsignond_plugin_proxy_compare_process_data (
         return 1;
 }
 
-static GSignondProcessData*
+static GList*
 gsignond_plugin_proxy_find_by_session_iface (
-        GSignondPluginProxy *self,
+        GQueue *queue,
         GSignondAuthSession *session)
 {
-    g_assert (GSIGNOND_IS_PLUGIN_PROXY (self));
-
-    return (GSignondProcessData*) g_queue_find_custom (
-                                    self->priv->session_queue, 
-                                    session,
-                                    gsignond_plugin_proxy_compare_process_data);
+    return g_queue_find_custom (queue, session,
+                                gsignond_plugin_proxy_compare_process_data);
 }
 
 void 
@@ -584,14 +1556,21 @@ gsignond_plugin_proxy_cancel (
     g_assert (GSIGNOND_IS_AUTH_SESSION (session));
 
     GSignondPluginProxyPrivate *priv = self->priv;
+    GSignondPluginWorker *worker = _find_worker_by_session (self, session);
 
     /* cancel active session */
-    if (session == priv->active_session) {
-        gsignond_plugin_cancel (priv->plugin);
+    if (worker) {
+        gsignond_plugin_cancel (worker->plugin);
     } else { /* cancel by de-queue */
-        GSignondProcessData* data =
-            gsignond_plugin_proxy_find_by_session_iface (self, session);
-        if (!data) {
+        GQueue *queue = priv->session_queue;
+        GList *link = gsignond_plugin_proxy_find_by_session_iface (queue,
+                                                                   session);
+        if (!link) {
+            queue = priv->deferred_queue;
+            link = gsignond_plugin_proxy_find_by_session_iface (queue,
+                                                                session);
+        }
+        if (!link) {
             GError* error = g_error_new (GSIGNOND_ERROR, 
                                          GSIGNOND_ERROR_WRONG_STATE,
                                          "Canceling an unknown session");
@@ -599,39 +1578,41 @@ gsignond_plugin_proxy_cancel (
             g_error_free (error);
             return;
         }
-        g_queue_remove (priv->session_queue, data);
-        gsignond_process_data_free (data);
+        gsignond_process_data_free ((GSignondProcessData *) link->data);
+        g_queue_delete_link (queue, link);
     }
 }
 
 void
 gsignond_plugin_proxy_user_action_finished (
         GSignondPluginProxy *self,
+        GSignondAuthSession *session,
         GSignondSignonuiData *ui_data)
 {
     g_assert (GSIGNOND_IS_PLUGIN_PROXY (self));
 
-    if (self->priv->active_session == NULL) {
+    GSignondPluginWorker *worker = _find_worker_by_session (self, session);
+    if (worker == NULL) {
         WARN("Error: 'user_action_finished' requested for plugin %s but no "
                 "active session", self->priv->plugin_type);
         return;
     }
-    gsignond_plugin_user_action_finished (self->priv->plugin, ui_data);
+    gsignond_plugin_user_action_finished (worker->plugin, ui_data);
 }
 
 void
 gsignond_plugin_proxy_refresh (
         GSignondPluginProxy *self,
+        GSignondAuthSession *session,
         GSignondSignonuiData *ui_data)
 {
     g_assert (GSIGNOND_IS_PLUGIN_PROXY (self));
 
-    if (self->priv->active_session == NULL) {
+    GSignondPluginWorker *worker = _find_worker_by_session (self, session);
+    if (worker == NULL) {
         WARN("Error: 'refresh' requested for plugin %s but no active session",
                 self->priv->plugin_type);
         return;
     }
-    gsignond_plugin_refresh (self->priv->plugin, ui_data);
+    gsignond_plugin_refresh (worker->plugin, ui_data);
 }
-
-
@@ -27,6 +27,7 @@
 #define __GSIGNOND_PLUGIN_PROXY_H__
 
 #include <glib-object.h>
+#include <gio/gio.h>
 
 #include "common/gsignond-disposable.h"
 #include "daemon/gsignond-types.h"
@@ -75,6 +76,20 @@ gsignond_plugin_proxy_new(
         const gchar* plugin_type,
         gint timeout);
 
+void
+gsignond_plugin_proxy_new_async (
+        const gchar* loader_path,
+        const gchar* plugin_type,
+        gint timeout,
+        GCancellable *cancellable,
+        GAsyncReadyCallback callback,
+        gpointer user_data);
+
+GSignondPluginProxy*
+gsignond_plugin_proxy_new_finish (
+        GAsyncResult *result,
+        GError **error);
+
 void 
 gsignond_plugin_proxy_cancel (
         GSignondPluginProxy *self,
@@ -86,14 +101,24 @@ gsignond_plugin_proxy_process (
         GSignondSessionData *session_data,
         GSignondDictionary *identity_method_cache,
         const gchar *mechanism,
+        gint64 deadline,
         gpointer userdata);
 void
 gsignond_plugin_proxy_user_action_finished (
         GSignondPluginProxy *self,
+        GSignondAuthSession* session,
         GSignondSignonuiData *ui_data);
 void
+gsignond_plugin_proxy_get_wait_stats (
+        GSignondPluginProxy *self,
+        GSignondProcessPriority priority,
+        guint *n_dispatched,
+        gint64 *total_wait,
+        gint64 *max_wait);
+void
 gsignond_plugin_proxy_refresh (
         GSignondPluginProxy *self,
+        GSignondAuthSession* session,
         GSignondSignonuiData *ui_data);
 
 #endif /* __GSIGNOND_PLUGIN_PROXY_H__ */
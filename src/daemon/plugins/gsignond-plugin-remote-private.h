@@ -29,13 +29,37 @@
 #include <glib.h>
 #include <daemon/dbus/gsignond-dbus-remote-plugin-gen.h>
 #include "daemon/dbus/gsignond-dbus.h"
+#include "common/gsignond-frame-channel.h"
 
 G_BEGIN_DECLS
 
 struct _GSignondPluginRemotePrivate
 {
+    gchar *loader_path;
+    gchar *plugin_type;
     GDBusConnection   *connection;
     GSignondDbusRemotePluginV1 *dbus_plugin_proxy;
+    /* set instead of dbus_plugin_proxy when the loader multiplexes
+     * sessions */
+    GSignondDbusRemotePluginV2 *dbus_plugin_proxy_v2;
+    guint session;
+    /* the remote plugin owning the loader process, for sessions opened on
+     * an already running loader */
+    struct _GSignondPluginRemote *host;
+    /* pre-started loader processes to take the loader from */
+    struct _GSignondPluginStandby *standby;
+    /* loader process shared by plugins of several types */
+    struct _GSignondPluginSharedLoader *shared_loader;
+    /* object of the plugin on the connection, NULL for the default */
+    gchar *object_path;
+    /* framed transport, used instead of the connection */
+    gboolean framed;
+    GSignondFrameChannel *channel;
+    gchar *framed_type;
+    gchar **framed_mechanisms;
+    guint32 last_request;
+    /* async initialization waiting for the loader to be ready */
+    GTask *ready_task;
     GPid cpid;
     guint child_watch_id;
 
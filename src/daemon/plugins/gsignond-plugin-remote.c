@@ -25,6 +25,11 @@
 
 #include "config.h"
 
+#include <errno.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
 #include "gsignond/gsignond-log.h"
 #include "gsignond/gsignond-error.h"
 #include "gsignond/gsignond-plugin-interface.h"
@@ -32,22 +37,39 @@
 #include "daemon/dbus/gsignond-dbus.h"
 #include "gsignond-plugin-remote-private.h"
 #include "gsignond-plugin-remote.h"
+#include "gsignond-plugin-standby.h"
 
 enum
 {
     PROP_0,
     PROP_TYPE,
     PROP_MECHANISMS,
+    PROP_LOADER_PATH,
+    PROP_PLUGIN_TYPE,
+    PROP_HOST,
+    PROP_STANDBY,
+    PROP_SHARED_LOADER,
+    PROP_FRAMED,
     N_PROPERTIES
 };
 
 static void
 gsignond_plugin_remote_interface_init (
         GSignondPluginInterface *iface);
+static void
+gsignond_plugin_remote_initable_iface_init (
+        GInitableIface *iface);
+static void
+gsignond_plugin_remote_async_initable_iface_init (
+        GAsyncInitableIface *iface);
 
 G_DEFINE_TYPE_WITH_CODE (GSignondPluginRemote, gsignond_plugin_remote,
         G_TYPE_OBJECT, G_IMPLEMENT_INTERFACE (GSIGNOND_TYPE_PLUGIN,
-                gsignond_plugin_remote_interface_init));
+                gsignond_plugin_remote_interface_init)
+        G_IMPLEMENT_INTERFACE (G_TYPE_INITABLE,
+                gsignond_plugin_remote_initable_iface_init)
+        G_IMPLEMENT_INTERFACE (G_TYPE_ASYNC_INITABLE,
+                gsignond_plugin_remote_async_initable_iface_init));
 
 #define GSIGNOND_PLUGIN_REMOTE_GET_PRIV(obj) \
         G_TYPE_INSTANCE_GET_PRIVATE ((obj), GSIGNOND_TYPE_PLUGIN_REMOTE, \
@@ -77,7 +99,32 @@ gsignond_plugin_remote_set_property (
         const GValue *value,
         GParamSpec *pspec)
 {
+    GSignondPluginRemote *self = GSIGNOND_PLUGIN_REMOTE (object);
+
     switch (property_id) {
+        case PROP_LOADER_PATH:
+            g_free (self->priv->loader_path);
+            self->priv->loader_path = g_value_dup_string (value);
+            break;
+        case PROP_PLUGIN_TYPE:
+            g_free (self->priv->plugin_type);
+            self->priv->plugin_type = g_value_dup_string (value);
+            break;
+        case PROP_HOST:
+            g_assert (self->priv->host == NULL);
+            self->priv->host = g_value_dup_object (value);
+            break;
+        case PROP_STANDBY:
+            g_assert (self->priv->standby == NULL);
+            self->priv->standby = g_value_dup_object (value);
+            break;
+        case PROP_SHARED_LOADER:
+            g_assert (self->priv->shared_loader == NULL);
+            self->priv->shared_loader = g_value_dup_object (value);
+            break;
+        case PROP_FRAMED:
+            self->priv->framed = g_value_get_boolean (value);
+            break;
         default:
             G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
     }
@@ -94,15 +141,45 @@ gsignond_plugin_remote_get_property (
 
     switch (property_id) {
         case PROP_TYPE: {
-            g_value_set_string (value,
-                                gsignond_dbus_remote_plugin_v1_get_method(self->priv->dbus_plugin_proxy));
+            if (self->priv->framed)
+                g_value_set_string (value, self->priv->framed_type);
+            else if (self->priv->dbus_plugin_proxy_v2)
+                g_value_set_string (value,
+                                    gsignond_dbus_remote_plugin_v2_get_method(self->priv->dbus_plugin_proxy_v2));
+            else
+                g_value_set_string (value,
+                                    gsignond_dbus_remote_plugin_v1_get_method(self->priv->dbus_plugin_proxy));
             break;
         }
         case PROP_MECHANISMS: {
-            g_value_set_boxed (value,
-                               gsignond_dbus_remote_plugin_v1_get_mechanisms(self->priv->dbus_plugin_proxy));
+            if (self->priv->framed)
+                g_value_set_boxed (value, self->priv->framed_mechanisms);
+            else if (self->priv->dbus_plugin_proxy_v2)
+                g_value_set_boxed (value,
+                                   gsignond_dbus_remote_plugin_v2_get_mechanisms(self->priv->dbus_plugin_proxy_v2));
+            else
+                g_value_set_boxed (value,
+                                   gsignond_dbus_remote_plugin_v1_get_mechanisms(self->priv->dbus_plugin_proxy));
             break;
         }
+        case PROP_LOADER_PATH:
+            g_value_set_string (value, self->priv->loader_path);
+            break;
+        case PROP_PLUGIN_TYPE:
+            g_value_set_string (value, self->priv->plugin_type);
+            break;
+        case PROP_HOST:
+            g_value_set_object (value, self->priv->host);
+            break;
+        case PROP_STANDBY:
+            g_value_set_object (value, self->priv->standby);
+            break;
+        case PROP_SHARED_LOADER:
+            g_value_set_object (value, self->priv->shared_loader);
+            break;
+        case PROP_FRAMED:
+            g_value_set_boolean (value, self->priv->framed);
+            break;
         default:
             G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
     }
@@ -123,6 +200,15 @@ gsignond_plugin_remote_dispose (GObject *object)
 {
     GSignondPluginRemote *self = GSIGNOND_PLUGIN_REMOTE (object);
 
+    /* closed first, the loader going down is expected from now on */
+    if (self->priv->channel) {
+        g_signal_handlers_disconnect_matched (self->priv->channel,
+                G_SIGNAL_MATCH_DATA, 0, 0, NULL, NULL, self);
+        gsignond_frame_channel_close (self->priv->channel);
+        g_object_unref (self->priv->channel);
+        self->priv->channel = NULL;
+    }
+
     if (self->priv->cpid > 0 && self->priv->is_plugind_up) {
         DBG ("Send SIGTERM to Plugind");
         kill (self->priv->cpid, SIGTERM);
@@ -163,13 +249,46 @@ gsignond_plugin_remote_dispose (GObject *object)
         self->priv->dbus_plugin_proxy = NULL;
     }
 
+    if (self->priv->dbus_plugin_proxy_v2) {
+        g_signal_handlers_disconnect_matched (self->priv->dbus_plugin_proxy_v2,
+                G_SIGNAL_MATCH_DATA, 0, 0, NULL, NULL, self);
+        /* the host's own session goes away with the loader process */
+        if (self->priv->host && self->priv->session)
+            gsignond_dbus_remote_plugin_v2_call_close_session (
+                    self->priv->dbus_plugin_proxy_v2, self->priv->session,
+                    NULL, NULL, NULL);
+        g_object_unref (self->priv->dbus_plugin_proxy_v2);
+        self->priv->dbus_plugin_proxy_v2 = NULL;
+    }
+
+    if (self->priv->host) {
+        g_object_unref (self->priv->host);
+        self->priv->host = NULL;
+    }
+
+    if (self->priv->standby) {
+        g_object_unref (self->priv->standby);
+        self->priv->standby = NULL;
+    }
+
+    if (self->priv->shared_loader) {
+        g_object_unref (self->priv->shared_loader);
+        self->priv->shared_loader = NULL;
+    }
+
     G_OBJECT_CLASS (gsignond_plugin_remote_parent_class)->dispose (object);
 }
 
 static void
 gsignond_plugin_remote_finalize (GObject *object)
 {
-    //GSignondPluginRemote *self = GSIGNOND_PLUGIN_REMOTE (object);
+    GSignondPluginRemote *self = GSIGNOND_PLUGIN_REMOTE (object);
+
+    g_free (self->priv->loader_path);
+    g_free (self->priv->plugin_type);
+    g_free (self->priv->object_path);
+    g_free (self->priv->framed_type);
+    g_strfreev (self->priv->framed_mechanisms);
 
     G_OBJECT_CLASS (gsignond_plugin_remote_parent_class)->finalize (object);
 }
@@ -191,6 +310,53 @@ gsignond_plugin_remote_class_init (GSignondPluginRemoteClass *klass)
     g_object_class_override_property (object_class, PROP_MECHANISMS,
             "mechanisms");
 
+    g_object_class_install_property (object_class, PROP_LOADER_PATH,
+            g_param_spec_string ("loaderpath",
+                                 "Path to loader",
+                                 "Path to plugin loader for this plugin",
+                                 NULL,
+                                 G_PARAM_CONSTRUCT_ONLY | G_PARAM_READWRITE |
+                                 G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property (object_class, PROP_PLUGIN_TYPE,
+            g_param_spec_string ("plugintype",
+                                 "Plugin type",
+                                 "Type of the plugin to load",
+                                 NULL,
+                                 G_PARAM_CONSTRUCT_ONLY | G_PARAM_READWRITE |
+                                 G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property (object_class, PROP_HOST,
+            g_param_spec_object ("host",
+                                 "Host plugin",
+                                 "Remote plugin whose loader process serves "
+                                 "this session",
+                                 GSIGNOND_TYPE_PLUGIN_REMOTE,
+                                 G_PARAM_CONSTRUCT_ONLY | G_PARAM_READWRITE |
+                                 G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property (object_class, PROP_STANDBY,
+            g_param_spec_object ("standby",
+                                 "Standby loaders",
+                                 "Pool of loader processes to take the "
+                                 "plugin loader from",
+                                 GSIGNOND_TYPE_PLUGIN_STANDBY,
+                                 G_PARAM_CONSTRUCT_ONLY | G_PARAM_READWRITE |
+                                 G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property (object_class, PROP_SHARED_LOADER,
+            g_param_spec_object ("shared-loader",
+                                 "Shared loader",
+                                 "Loader process shared with plugins of "
+                                 "other types",
+                                 GSIGNOND_TYPE_PLUGIN_SHARED_LOADER,
+                                 G_PARAM_CONSTRUCT_ONLY | G_PARAM_READWRITE |
+                                 G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property (object_class, PROP_FRAMED,
+            g_param_spec_boolean ("framed",
+                                  "Framed transport",
+                                  "Whether to talk to the loader with binary "
+                                  "frames instead of D-Bus",
+                                  FALSE,
+                                  G_PARAM_CONSTRUCT_ONLY | G_PARAM_READWRITE |
+                                  G_PARAM_STATIC_STRINGS));
+
 }
 
 static void
@@ -198,8 +364,22 @@ gsignond_plugin_remote_init (GSignondPluginRemote *self)
 {
     self->priv = GSIGNOND_PLUGIN_REMOTE_GET_PRIV(self);
 
+    self->priv->loader_path = NULL;
+    self->priv->plugin_type = NULL;
     self->priv->connection = NULL;
     self->priv->dbus_plugin_proxy = NULL;
+    self->priv->dbus_plugin_proxy_v2 = NULL;
+    self->priv->session = 0;
+    self->priv->host = NULL;
+    self->priv->standby = NULL;
+    self->priv->shared_loader = NULL;
+    self->priv->object_path = NULL;
+    self->priv->framed = FALSE;
+    self->priv->channel = NULL;
+    self->priv->framed_type = NULL;
+    self->priv->framed_mechanisms = NULL;
+    self->priv->last_request = 0;
+    self->priv->ready_task = NULL;
     self->priv->cpid = 0;
 
     self->priv->child_watch_id = 0;
@@ -207,6 +387,36 @@ gsignond_plugin_remote_init (GSignondPluginRemote *self)
     self->priv->is_plugind_up = FALSE;
 }
 
+/* sends a request frame with a new id */
+static void
+_send_request (
+        GSignondPluginRemote *self,
+        GSignondFrameOpcode opcode,
+        GVariant *payload)
+{
+    gsignond_frame_channel_send (self->priv->channel,
+                                 ++self->priv->last_request, opcode, payload);
+}
+
+/* completion of any V2 call */
+static void
+_v2_call_async_cb (
+        GObject *object,
+        GAsyncResult *res,
+        gpointer user_data)
+{
+    GError *error = NULL;
+    GSignondPluginRemote *self = GSIGNOND_PLUGIN_REMOTE (user_data);
+    GVariant *result = g_dbus_proxy_call_finish (G_DBUS_PROXY (object), res,
+                                                 &error);
+    if (result)
+        g_variant_unref (result);
+    if (error) {
+        gsignond_plugin_error (GSIGNOND_PLUGIN(self), error);
+        g_error_free (error);
+    }
+}
+
 static void
 _cancel_async_cb (
         GObject *object,
@@ -231,6 +441,16 @@ gsignond_plugin_remote_cancel (
     g_return_if_fail (plugin && GSIGNOND_IS_PLUGIN_REMOTE (plugin));
     GSignondPluginRemote *self = GSIGNOND_PLUGIN_REMOTE (plugin);
 
+    if (self->priv->channel) {
+        _send_request (self, GSIGNOND_FRAME_OP_CANCEL, NULL);
+        return;
+    }
+    if (self->priv->dbus_plugin_proxy_v2) {
+        gsignond_dbus_remote_plugin_v2_call_cancel (
+                self->priv->dbus_plugin_proxy_v2, self->priv->session, NULL,
+                _v2_call_async_cb, self);
+        return;
+    }
     gsignond_dbus_remote_plugin_v1_call_cancel (
             self->priv->dbus_plugin_proxy, NULL, _cancel_async_cb, self);
 }
@@ -272,6 +492,18 @@ gsignond_plugin_remote_request_initial (
         cache = gsignond_dictionary_to_variant (empty_cache);
         gsignond_dictionary_unref(empty_cache);
     }
+    if (self->priv->channel) {
+        _send_request (self, GSIGNOND_FRAME_OP_REQUEST_INITIAL,
+                       g_variant_new ("(@a{sv}@a{sv}s)", data, cache,
+                                      mechanism));
+        return;
+    }
+    if (self->priv->dbus_plugin_proxy_v2) {
+        gsignond_dbus_remote_plugin_v2_call_request_initial (
+                self->priv->dbus_plugin_proxy_v2, self->priv->session, data,
+                cache, mechanism, NULL, _v2_call_async_cb, self);
+        return;
+    }
     gsignond_dbus_remote_plugin_v1_call_request_initial (
             self->priv->dbus_plugin_proxy, data, cache, mechanism, NULL,
             _request_initial_async_cb, self);
@@ -304,6 +536,16 @@ gsignond_plugin_remote_request (
     GSignondPluginRemote *self = GSIGNOND_PLUGIN_REMOTE (plugin);
 
     GVariant *data = gsignond_dictionary_to_variant (session_data);
+    if (self->priv->channel) {
+        _send_request (self, GSIGNOND_FRAME_OP_REQUEST, data);
+        return;
+    }
+    if (self->priv->dbus_plugin_proxy_v2) {
+        gsignond_dbus_remote_plugin_v2_call_request (
+                self->priv->dbus_plugin_proxy_v2, self->priv->session, data,
+                NULL, _v2_call_async_cb, self);
+        return;
+    }
     gsignond_dbus_remote_plugin_v1_call_request (
             self->priv->dbus_plugin_proxy, data, NULL, _request_async_cb, self);
 }
@@ -336,6 +578,16 @@ gsignond_plugin_remote_user_action_finished (
     GSignondPluginRemote *self = GSIGNOND_PLUGIN_REMOTE (plugin);
 
     GVariant *data = gsignond_dictionary_to_variant (signonui_data);
+    if (self->priv->channel) {
+        _send_request (self, GSIGNOND_FRAME_OP_USER_ACTION_FINISHED, data);
+        return;
+    }
+    if (self->priv->dbus_plugin_proxy_v2) {
+        gsignond_dbus_remote_plugin_v2_call_user_action_finished (
+                self->priv->dbus_plugin_proxy_v2, self->priv->session, data,
+                NULL, _v2_call_async_cb, self);
+        return;
+    }
     gsignond_dbus_remote_plugin_v1_call_user_action_finished (
             self->priv->dbus_plugin_proxy, data, NULL,
             _user_action_finished_async_cb, self);
@@ -368,6 +620,16 @@ gsignond_plugin_remote_refresh (
     GSignondPluginRemote *self = GSIGNOND_PLUGIN_REMOTE (plugin);
 
     GVariant *data = gsignond_dictionary_to_variant (signonui_data);
+    if (self->priv->channel) {
+        _send_request (self, GSIGNOND_FRAME_OP_REFRESH, data);
+        return;
+    }
+    if (self->priv->dbus_plugin_proxy_v2) {
+        gsignond_dbus_remote_plugin_v2_call_refresh (
+                self->priv->dbus_plugin_proxy_v2, self->priv->session, data,
+                NULL, _v2_call_async_cb, self);
+        return;
+    }
     gsignond_dbus_remote_plugin_v1_call_refresh (
             self->priv->dbus_plugin_proxy, data, NULL, _refresh_async_cb, self);
 }
@@ -477,18 +739,261 @@ _status_changed_cb (
             (GSignondPluginState)status, message);
 }
 
-GSignondPluginRemote *
-gsignond_plugin_remote_new (
-        const gchar *loader_path,
-        const gchar *plugin_type)
+/* V2 signals are broadcast to all sessions sharing the loader, each remote
+ * plugin picks its own */
+static void
+_response_v2_cb (
+        GSignondPluginRemote *self,
+        guint session,
+        GVariant *session_data,
+        gpointer user_data)
+{
+    if (session == self->priv->session)
+        _response_cb (self, session_data, user_data);
+}
+
+static void
+_response_final_v2_cb (
+        GSignondPluginRemote *self,
+        guint session,
+        GVariant *session_data,
+        gpointer user_data)
+{
+    if (session == self->priv->session)
+        _response_final_cb (self, session_data, user_data);
+}
+
+static void
+_store_v2_cb (
+        GSignondPluginRemote *self,
+        guint session,
+        GVariant *session_data,
+        gpointer user_data)
+{
+    if (session == self->priv->session)
+        _store_cb (self, session_data, user_data);
+}
+
+static void
+_error_v2_cb (
+        GSignondPluginRemote *self,
+        guint session,
+        GVariant *error,
+        gpointer user_data)
+{
+    if (session == self->priv->session)
+        _error_cb (self, error, user_data);
+}
+
+static void
+_user_action_required_v2_cb (
+        GSignondPluginRemote *self,
+        guint session,
+        GVariant *ui_data,
+        gpointer user_data)
+{
+    if (session == self->priv->session)
+        _user_action_required_cb (self, ui_data, user_data);
+}
+
+static void
+_refreshed_v2_cb (
+        GSignondPluginRemote *self,
+        guint session,
+        GVariant *ui_data,
+        gpointer user_data)
+{
+    if (session == self->priv->session)
+        _refreshed_cb (self, ui_data, user_data);
+}
+
+static void
+_status_changed_v2_cb (
+        GSignondPluginRemote *self,
+        guint session,
+        gint status,
+        gchar *message,
+        gpointer user_data)
+{
+    if (session == self->priv->session)
+        _status_changed_cb (self, status, message, user_data);
+}
+
+static void
+_connect_plugin_proxy_v2 (
+        GSignondPluginRemote *plugin)
+{
+    GSignondDbusRemotePluginV2 *proxy = plugin->priv->dbus_plugin_proxy_v2;
+
+    DBG("session %u opened (%p)", plugin->priv->session, plugin);
+
+    g_signal_connect_swapped (proxy, "response",
+            G_CALLBACK (_response_v2_cb), plugin);
+    g_signal_connect_swapped (proxy, "response-final",
+            G_CALLBACK (_response_final_v2_cb), plugin);
+    g_signal_connect_swapped (proxy, "store",
+            G_CALLBACK (_store_v2_cb), plugin);
+    g_signal_connect_swapped (proxy, "error",
+            G_CALLBACK (_error_v2_cb), plugin);
+    g_signal_connect_swapped (proxy, "user-action-required",
+            G_CALLBACK (_user_action_required_v2_cb), plugin);
+    g_signal_connect_swapped (proxy, "refreshed",
+            G_CALLBACK (_refreshed_v2_cb), plugin);
+    g_signal_connect_swapped (proxy, "status-changed",
+            G_CALLBACK (_status_changed_v2_cb), plugin);
+}
+
+/* takes the plugin type and mechanisms the loader announces when ready */
+static gboolean
+_framed_ready (
+        GSignondPluginRemote *self,
+        guint32 opcode,
+        GVariant *payload,
+        GError **error)
+{
+    if (opcode != GSIGNOND_FRAME_OP_READY || !payload ||
+        !g_variant_is_of_type (payload, G_VARIANT_TYPE ("(sas)"))) {
+        g_set_error (error, GSIGNOND_ERROR,
+                     GSIGNOND_ERROR_INTERNAL_COMMUNICATION,
+                     "Plugin loader did not get ready");
+        return FALSE;
+    }
+    g_variant_get (payload, "(s^as)", &self->priv->framed_type,
+                   &self->priv->framed_mechanisms);
+    DBG ("framed plugin '%s' ready (%p)", self->priv->framed_type, self);
+    return TRUE;
+}
+
+static void
+_complete_ready_task (
+        GSignondPluginRemote *self,
+        GError *error)
+{
+    GTask *task = self->priv->ready_task;
+
+    self->priv->ready_task = NULL;
+    if (error)
+        g_task_return_error (task, error);
+    else
+        g_task_return_boolean (task, TRUE);
+    g_object_unref (task);
+}
+
+static void
+_on_frame (
+        GSignondPluginRemote *self,
+        guint id,
+        guint opcode,
+        GVariant *payload,
+        gpointer user_data)
 {
     GError *error = NULL;
+    gint status = 0;
+    const gchar *message = NULL;
+
+    if (self->priv->ready_task) {
+        _framed_ready (self, opcode, payload, &error);
+        _complete_ready_task (self, error);
+        return;
+    }
+
+    if (opcode == GSIGNOND_FRAME_OP_STATUS_CHANGED) {
+        if (payload && g_variant_is_of_type (payload, G_VARIANT_TYPE ("(is)"))) {
+            g_variant_get (payload, "(i&s)", &status, &message);
+            _status_changed_cb (self, status, (gchar *)message, NULL);
+            return;
+        }
+    } else if (opcode == GSIGNOND_FRAME_OP_ERROR) {
+        if (payload) {
+            _error_cb (self, payload, NULL);
+            return;
+        }
+    } else if (payload &&
+               g_variant_is_of_type (payload, G_VARIANT_TYPE_VARDICT)) {
+        switch (opcode) {
+            case GSIGNOND_FRAME_OP_RESPONSE:
+                _response_cb (self, payload, NULL);
+                return;
+            case GSIGNOND_FRAME_OP_RESPONSE_FINAL:
+                _response_final_cb (self, payload, NULL);
+                return;
+            case GSIGNOND_FRAME_OP_STORE:
+                _store_cb (self, payload, NULL);
+                return;
+            case GSIGNOND_FRAME_OP_USER_ACTION_REQUIRED:
+                _user_action_required_cb (self, payload, NULL);
+                return;
+            case GSIGNOND_FRAME_OP_REFRESHED:
+                _refreshed_cb (self, payload, NULL);
+                return;
+            default:
+                break;
+        }
+    }
+    DBG ("ignoring invalid frame for request %u with opcode %u", id, opcode);
+}
+
+static void
+_on_channel_closed (
+        GSignondPluginRemote *self,
+        gpointer user_data)
+{
+    GError *error = g_error_new (GSIGNOND_ERROR,
+                                 GSIGNOND_ERROR_INTERNAL_COMMUNICATION,
+                                 "Plugin loader closed the channel");
+
+    DBG ("frame channel of %p closed", self);
+    if (self->priv->ready_task) {
+        _complete_ready_task (self, error);
+        return;
+    }
+    gsignond_plugin_error (GSIGNOND_PLUGIN (self), error);
+    g_error_free (error);
+}
+
+static void
+_watch_plugind (
+        GSignondPluginRemote *self,
+        GPid cpid)
+{
+    self->priv->child_watch_id = g_child_watch_add (cpid,
+            (GChildWatchFunc)_on_child_down_cb, self);
+    self->priv->cpid = cpid;
+    self->priv->is_plugind_up = TRUE;
+}
+
+/* connects the framed loader's stdin and stdout to its socket end */
+static void
+_setup_framed_stdio (gpointer user_data)
+{
+    gint fd = GPOINTER_TO_INT (user_data);
+
+    dup2 (fd, 0);
+    dup2 (fd, 1);
+}
+
+/* starts the plugin loader, talked to on two pipes, or on a unix socket
+ * pair when framed. Returns the descriptors of this end; both are the same
+ * socket in the latter case. */
+static gboolean
+_spawn_plugind_fds (
+        GSignondPluginRemote *self,
+        gint *cin_fd,
+        gint *cout_fd,
+        GError **error)
+{
     GPid cpid = 0;
     gchar **argv;
-    gint cin_fd, cout_fd;
-    GSignondPluginRemote *plugin = NULL;
-    GSignondPipeStream *stream = NULL;
+    gint sv[2] = { -1, -1 };
     gboolean ret = FALSE;
+    GSignondPluginZygote *zygote = NULL;
+    gchar *option = NULL;
+
+    if (!self->priv->loader_path || !self->priv->plugin_type) {
+        g_set_error (error, GSIGNOND_ERROR, GSIGNOND_ERROR_INTERNAL_SERVER,
+                     "Plugin loader or type not set");
+        return FALSE;
+    }
 
     /* This guarantees that writes to a pipe will never cause
      * a process terminanation via SIGPIPE, and instead a proper
@@ -496,51 +1001,164 @@ gsignond_plugin_remote_new (
     signal(SIGPIPE, SIG_IGN);
 
     /* Spawn child process */
-    argv = g_new0 (gchar *, 2 + 1);
-    argv[0] = g_strdup(loader_path);
-    argv[1] = g_strdup_printf("--load-plugin=%s",plugin_type);
-    ret = g_spawn_async_with_pipes (NULL, argv, NULL,
-            G_SPAWN_DO_NOT_REAP_CHILD, NULL,
-            NULL, &cpid, &cin_fd, &cout_fd, NULL, &error);
+    argv = g_new0 (gchar *, 3 + 1);
+    argv[0] = g_strdup(self->priv->loader_path);
+    argv[1] = g_strdup_printf("--load-plugin=%s", self->priv->plugin_type);
+    if (self->priv->framed)
+        argv[2] = g_strdup ("--framed");
+    if (self->priv->standby)
+        zygote = gsignond_plugin_standby_get_zygote (self->priv->standby);
+    if (zygote) {
+        option = g_strjoinv (" ", argv + 1);
+        if (self->priv->framed)
+            ret = gsignond_plugin_zygote_fork_socket (zygote, option, &cpid,
+                                                      cin_fd, NULL);
+        else
+            ret = gsignond_plugin_zygote_fork (zygote, option, &cpid, cin_fd,
+                                               cout_fd, NULL);
+        g_free (option);
+        if (ret && self->priv->framed)
+            *cout_fd = *cin_fd;
+        else if (!ret)
+            DBG ("failed to fork plugind from zygote, starting it instead");
+    }
+    if (!ret && self->priv->framed) {
+        /* a socket, as the framed loader passes descriptors */
+        if (socketpair (AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sv) == 0) {
+            ret = g_spawn_async (NULL, argv, NULL,
+                    G_SPAWN_DO_NOT_REAP_CHILD, _setup_framed_stdio,
+                    GINT_TO_POINTER (sv[1]), &cpid, error);
+            close (sv[1]);
+            if (ret)
+                *cin_fd = *cout_fd = sv[0];
+            else
+                close (sv[0]);
+        } else {
+            g_set_error (error, GSIGNOND_ERROR,
+                         GSIGNOND_ERROR_INTERNAL_SERVER,
+                         "Failed to create socket pair: %s",
+                         strerror (errno));
+        }
+    } else if (!ret) {
+        ret = g_spawn_async_with_pipes (NULL, argv, NULL,
+                G_SPAWN_DO_NOT_REAP_CHILD, NULL,
+                NULL, &cpid, cin_fd, cout_fd, NULL, error);
+    }
     g_strfreev (argv);
     if (ret == FALSE || (kill(cpid, 0) != 0)) {
         DBG ("failed to start plugind: error %s(%d)", 
-            error ? error->message : "(null)", ret);
-        if (error) g_error_free (error);
-        return NULL;
+            error && *error ? (*error)->message : "(null)", ret);
+        if (error && !*error)
+            g_set_error (error, GSIGNOND_ERROR, GSIGNOND_ERROR_INTERNAL_SERVER,
+                         "Failed to start plugind");
+        return FALSE;
     }
 
-    /* Create dbus plugin object */
-    plugin = GSIGNOND_PLUGIN_REMOTE (g_object_new (GSIGNOND_TYPE_PLUGIN_REMOTE,
-            NULL));
+    _watch_plugind (self, cpid);
 
-    plugin->priv->child_watch_id = g_child_watch_add (cpid,
-            (GChildWatchFunc)_on_child_down_cb, plugin);
-    plugin->priv->cpid = cpid;
-    plugin->priv->is_plugind_up = TRUE;
+    return TRUE;
+}
 
-    /* Create dbus connection */
-    stream = gsignond_pipe_stream_new (cout_fd, cin_fd, TRUE);
-    plugin->priv->connection = g_dbus_connection_new_sync (G_IO_STREAM (stream),
-            NULL, G_DBUS_CONNECTION_FLAGS_NONE, NULL, NULL, NULL);
-    g_object_unref (stream);
+/* starts the plugin loader and returns the stream to talk to it */
+static GSignondPipeStream *
+_spawn_plugind (
+        GSignondPluginRemote *self,
+        GError **error)
+{
+    gint cin_fd, cout_fd;
 
-    /* Create dbus proxy */
-    plugin->priv->dbus_plugin_proxy =
-            gsignond_dbus_remote_plugin_v1_proxy_new_sync (
-                    plugin->priv->connection,
-                    G_DBUS_PROXY_FLAGS_NONE,
-                    NULL,
-                    GSIGNOND_PLUGIN_OBJECTPATH,
-                    NULL,
-                    &error);
-    if (error) {
-        DBG ("Failed to register object: %s", error->message);
-        g_error_free (error);
-        g_object_unref (plugin);
+    if (!_spawn_plugind_fds (self, &cin_fd, &cout_fd, error))
         return NULL;
-    }
-    DBG("'%s' object exported(%p)", GSIGNOND_PLUGIN_OBJECTPATH, plugin);
+
+    return gsignond_pipe_stream_new (cout_fd, cin_fd, TRUE);
+}
+
+/* starts the framed loader and opens the channel to it */
+static gboolean
+_open_channel (
+        GSignondPluginRemote *self,
+        GError **error)
+{
+    gint cin_fd, cout_fd;
+
+    if (!_spawn_plugind_fds (self, &cin_fd, &cout_fd, error))
+        return FALSE;
+
+    self->priv->channel = gsignond_frame_channel_new (cin_fd, error);
+    if (!self->priv->channel)
+        return FALSE;
+    g_signal_connect_swapped (self->priv->channel, "frame",
+            G_CALLBACK (_on_frame), self);
+    g_signal_connect_swapped (self->priv->channel, "closed",
+            G_CALLBACK (_on_channel_closed), self);
+    return TRUE;
+}
+
+/* adopts a connected loader process from the standby pool, which still
+ * has to be told to load the plugin */
+static gboolean
+_take_standby (
+        GSignondPluginRemote *self,
+        GSignondDbusRemotePluginLoader **loader)
+{
+    GPid cpid = 0;
+
+    /* loaders in standby talk D-Bus */
+    if (self->priv->framed || !self->priv->standby ||
+        !gsignond_plugin_standby_take (self->priv->standby, &cpid,
+                                       &self->priv->connection, loader))
+        return FALSE;
+
+    _watch_plugind (self, cpid);
+    return TRUE;
+}
+
+static const gchar *
+_get_object_path (GSignondPluginRemote *self)
+{
+    return self->priv->object_path ? self->priv->object_path :
+            GSIGNOND_PLUGIN_OBJECTPATH;
+}
+
+/* whether the host serves a plugin of another type, which is then exported
+ * on the host's loader process */
+static gboolean
+_is_hosted_elsewhere (GSignondPluginRemote *self)
+{
+    return self->priv->host && g_strcmp0 (self->priv->host->priv->plugin_type,
+                                          self->priv->plugin_type) != 0;
+}
+
+/* takes the shared loader process as host, if it is running */
+static void
+_find_shared_host (GSignondPluginRemote *self)
+{
+    GSignondPluginRemote *host = NULL;
+
+    if (self->priv->host || !self->priv->shared_loader)
+        return;
+
+    host = gsignond_plugin_shared_loader_get_host (self->priv->shared_loader);
+    if (host)
+        self->priv->host = g_object_ref (host);
+}
+
+/* offers the loader process the plugin started to plugins of other types */
+static void
+_share_loader (GSignondPluginRemote *self)
+{
+    if (self->priv->shared_loader && self->priv->cpid > 0 &&
+        self->priv->dbus_plugin_proxy_v2 &&
+        !gsignond_plugin_shared_loader_get_host (self->priv->shared_loader))
+        gsignond_plugin_shared_loader_set_host (self->priv->shared_loader,
+                                                self);
+}
+
+static void
+_connect_plugin_proxy (
+        GSignondPluginRemote *plugin)
+{
+    DBG("'%s' object exported(%p)", _get_object_path (plugin), plugin);
 
     plugin->priv->signal_response = g_signal_connect_swapped (
             plugin->priv->dbus_plugin_proxy, "response",
@@ -563,7 +1181,765 @@ gsignond_plugin_remote_new (
     plugin->priv->signal_status_changed = g_signal_connect_swapped (
             plugin->priv->dbus_plugin_proxy, "status-changed",
             G_CALLBACK(_status_changed_cb), plugin);
+}
+
+static gboolean
+_open_session_sync (
+        GSignondPluginRemote *self,
+        GCancellable *cancellable,
+        GError **error)
+{
+    if (!gsignond_dbus_remote_plugin_v2_call_open_session_sync (
+                self->priv->dbus_plugin_proxy_v2, &self->priv->session,
+                cancellable, error)) {
+        DBG ("Failed to open session: %s",
+             error && *error ? (*error)->message : "");
+        return FALSE;
+    }
+    _connect_plugin_proxy_v2 (self);
+    return TRUE;
+}
+
+static gboolean
+_export_on_host_sync (
+        GSignondPluginRemote *self,
+        GCancellable *cancellable,
+        GError **error)
+{
+    GSignondDbusRemotePluginLoader *loader = NULL;
+    gboolean exported;
+
+    self->priv->connection = g_object_ref (
+            self->priv->host->priv->connection);
+    loader = gsignond_dbus_remote_plugin_loader_proxy_new_sync (
+            self->priv->connection,
+            G_DBUS_PROXY_FLAGS_DO_NOT_LOAD_PROPERTIES,
+            NULL,
+            GSIGNOND_PLUGIN_OBJECTPATH,
+            cancellable,
+            error);
+    if (!loader)
+        return FALSE;
+
+    exported = gsignond_dbus_remote_plugin_loader_call_export_plugin_sync (
+            loader, self->priv->plugin_type, &self->priv->object_path,
+            cancellable, error);
+    g_object_unref (loader);
+    if (!exported) {
+        DBG ("Shared loader failed to export plugin %s",
+             self->priv->plugin_type);
+        return FALSE;
+    }
+
+    self->priv->dbus_plugin_proxy_v2 =
+            gsignond_dbus_remote_plugin_v2_proxy_new_sync (
+                    self->priv->connection,
+                    G_DBUS_PROXY_FLAGS_NONE,
+                    NULL,
+                    _get_object_path (self),
+                    cancellable,
+                    error);
+    if (!self->priv->dbus_plugin_proxy_v2)
+        return FALSE;
+
+    return _open_session_sync (self, cancellable, error);
+}
+
+static gboolean
+_initable_init_framed (
+        GSignondPluginRemote *self,
+        GCancellable *cancellable,
+        GError **error)
+{
+    GVariant *payload = NULL;
+    guint32 id = 0, opcode = 0;
+    gboolean ready;
+
+    if (!_open_channel (self, error))
+        return FALSE;
+
+    if (!gsignond_frame_channel_receive_sync (self->priv->channel, &id,
+                &opcode, &payload, cancellable, error)) {
+        DBG ("Failed to receive from plugind");
+        return FALSE;
+    }
+    ready = _framed_ready (self, opcode, payload, error);
+    if (payload)
+        g_variant_unref (payload);
+    if (!ready)
+        return FALSE;
+
+    gsignond_frame_channel_start (self->priv->channel);
+    return TRUE;
+}
+
+static gboolean
+_initable_init (
+        GSignondPluginRemote *self,
+        GCancellable *cancellable,
+        GError **error)
+{
+    GSignondDbusRemotePluginLoader *loader = NULL;
+    GSignondPipeStream *stream = NULL;
+
+    if (self->priv->dbus_plugin_proxy || self->priv->session ||
+        self->priv->channel)
+        return TRUE;
+
+    if (self->priv->framed)
+        return _initable_init_framed (self, cancellable, error);
+
+    _find_shared_host (self);
+    if (_is_hosted_elsewhere (self))
+        return _export_on_host_sync (self, cancellable, error);
+
+    if (self->priv->host) {
+        self->priv->connection = g_object_ref (
+                self->priv->host->priv->connection);
+        self->priv->dbus_plugin_proxy_v2 = g_object_ref (
+                self->priv->host->priv->dbus_plugin_proxy_v2);
+        return _open_session_sync (self, cancellable, error);
+    }
+
+    if (_take_standby (self, &loader)) {
+        gboolean loaded = gsignond_dbus_remote_plugin_loader_call_load_plugin_sync (
+                loader, self->priv->plugin_type, cancellable, error);
+        g_object_unref (loader);
+        if (!loaded) {
+            DBG ("Standby loader failed to load plugin %s",
+                 self->priv->plugin_type);
+            return FALSE;
+        }
+    } else {
+        stream = _spawn_plugind (self, error);
+        if (!stream)
+            return FALSE;
+
+        /* Create dbus connection */
+        self->priv->connection = g_dbus_connection_new_sync (
+                G_IO_STREAM (stream), NULL, G_DBUS_CONNECTION_FLAGS_NONE,
+                NULL, cancellable, error);
+        g_object_unref (stream);
+        if (!self->priv->connection) {
+            DBG ("Failed to open connection to plugind");
+            return FALSE;
+        }
+    }
+
+    /* Prefer the multiplexed interface when the loader has it */
+    self->priv->dbus_plugin_proxy_v2 =
+            gsignond_dbus_remote_plugin_v2_proxy_new_sync (
+                    self->priv->connection,
+                    G_DBUS_PROXY_FLAGS_NONE,
+                    NULL,
+                    _get_object_path (self),
+                    cancellable,
+                    NULL);
+    if (self->priv->dbus_plugin_proxy_v2 &&
+        gsignond_dbus_remote_plugin_v2_get_method (
+                self->priv->dbus_plugin_proxy_v2))
+        return _open_session_sync (self, cancellable, error);
+    g_clear_object (&self->priv->dbus_plugin_proxy_v2);
+
+    /* Create dbus proxy */
+    self->priv->dbus_plugin_proxy =
+            gsignond_dbus_remote_plugin_v1_proxy_new_sync (
+                    self->priv->connection,
+                    G_DBUS_PROXY_FLAGS_NONE,
+                    NULL,
+                    _get_object_path (self),
+                    cancellable,
+                    error);
+    if (!self->priv->dbus_plugin_proxy) {
+        DBG ("Failed to register object: %s", error && *error ? (*error)->message : "");
+        return FALSE;
+    }
+
+    _connect_plugin_proxy (self);
+
+    return TRUE;
+}
+
+static gboolean
+gsignond_plugin_remote_initable_init (
+        GInitable *initable,
+        GCancellable *cancellable,
+        GError **error)
+{
+    GSignondPluginRemote *self = GSIGNOND_PLUGIN_REMOTE (initable);
+
+    if (!_initable_init (self, cancellable, error))
+        return FALSE;
+
+    _share_loader (self);
+    return TRUE;
+}
+
+static void
+gsignond_plugin_remote_initable_iface_init (GInitableIface *iface)
+{
+    iface->init = gsignond_plugin_remote_initable_init;
+}
+
+static void
+_on_plugin_proxy_ready (
+        GObject *source,
+        GAsyncResult *res,
+        gpointer user_data)
+{
+    GTask *task = G_TASK (user_data);
+    GSignondPluginRemote *self = GSIGNOND_PLUGIN_REMOTE (
+            g_task_get_source_object (task));
+    GError *error = NULL;
+
+    self->priv->dbus_plugin_proxy =
+            gsignond_dbus_remote_plugin_v1_proxy_new_finish (res, &error);
+    if (!self->priv->dbus_plugin_proxy) {
+        DBG ("Failed to register object: %s", error->message);
+        g_task_return_error (task, error);
+    } else {
+        _connect_plugin_proxy (self);
+        g_task_return_boolean (task, TRUE);
+    }
+    g_object_unref (task);
+}
+
+static void
+_on_session_opened (
+        GObject *source,
+        GAsyncResult *res,
+        gpointer user_data)
+{
+    GTask *task = G_TASK (user_data);
+    GSignondPluginRemote *self = GSIGNOND_PLUGIN_REMOTE (
+            g_task_get_source_object (task));
+    GError *error = NULL;
+
+    if (!gsignond_dbus_remote_plugin_v2_call_open_session_finish (
+                GSIGNOND_DBUS_REMOTE_PLUGIN_V2 (source), &self->priv->session,
+                res, &error)) {
+        DBG ("Failed to open session: %s", error->message);
+        g_task_return_error (task, error);
+    } else {
+        _connect_plugin_proxy_v2 (self);
+        g_task_return_boolean (task, TRUE);
+    }
+    g_object_unref (task);
+}
+
+static void
+_open_session_async (
+        GSignondPluginRemote *self,
+        GTask *task)
+{
+    gsignond_dbus_remote_plugin_v2_call_open_session (
+            self->priv->dbus_plugin_proxy_v2,
+            g_task_get_cancellable (task),
+            _on_session_opened,
+            task);
+}
+
+static void
+_on_plugin_proxy_v2_ready (
+        GObject *source,
+        GAsyncResult *res,
+        gpointer user_data)
+{
+    GTask *task = G_TASK (user_data);
+    GSignondPluginRemote *self = GSIGNOND_PLUGIN_REMOTE (
+            g_task_get_source_object (task));
+
+    self->priv->dbus_plugin_proxy_v2 =
+            gsignond_dbus_remote_plugin_v2_proxy_new_finish (res, NULL);
+    if (self->priv->dbus_plugin_proxy_v2 &&
+        gsignond_dbus_remote_plugin_v2_get_method (
+                self->priv->dbus_plugin_proxy_v2)) {
+        _open_session_async (self, task);
+        return;
+    }
+    g_clear_object (&self->priv->dbus_plugin_proxy_v2);
+
+    /* the loader only implements V1 */
+    gsignond_dbus_remote_plugin_v1_proxy_new (
+            self->priv->connection,
+            G_DBUS_PROXY_FLAGS_NONE,
+            NULL,
+            _get_object_path (self),
+            g_task_get_cancellable (task),
+            _on_plugin_proxy_ready,
+            task);
+}
+
+static void
+_create_plugin_proxy_async (
+        GSignondPluginRemote *self,
+        GTask *task)
+{
+    gsignond_dbus_remote_plugin_v2_proxy_new (
+            self->priv->connection,
+            G_DBUS_PROXY_FLAGS_NONE,
+            NULL,
+            _get_object_path (self),
+            g_task_get_cancellable (task),
+            _on_plugin_proxy_v2_ready,
+            task);
+}
+
+static void
+_on_connection_ready (
+        GObject *source,
+        GAsyncResult *res,
+        gpointer user_data)
+{
+    GTask *task = G_TASK (user_data);
+    GSignondPluginRemote *self = GSIGNOND_PLUGIN_REMOTE (
+            g_task_get_source_object (task));
+    GError *error = NULL;
+
+    self->priv->connection = g_dbus_connection_new_finish (res, &error);
+    if (!self->priv->connection) {
+        DBG ("Failed to open connection to plugind: %s", error->message);
+        g_task_return_error (task, error);
+        g_object_unref (task);
+        return;
+    }
+
+    _create_plugin_proxy_async (self, task);
+}
+
+static void
+_on_standby_plugin_loaded (
+        GObject *source,
+        GAsyncResult *res,
+        gpointer user_data)
+{
+    GTask *task = G_TASK (user_data);
+    GSignondPluginRemote *self = GSIGNOND_PLUGIN_REMOTE (
+            g_task_get_source_object (task));
+    GError *error = NULL;
+
+    if (!gsignond_dbus_remote_plugin_loader_call_load_plugin_finish (
+                GSIGNOND_DBUS_REMOTE_PLUGIN_LOADER (source), res, &error)) {
+        DBG ("Standby loader failed to load plugin %s: %s",
+             self->priv->plugin_type, error->message);
+        g_task_return_error (task, error);
+        g_object_unref (task);
+        return;
+    }
+
+    _create_plugin_proxy_async (self, task);
+}
+
+static void
+_on_plugin_exported (
+        GObject *source,
+        GAsyncResult *res,
+        gpointer user_data)
+{
+    GTask *task = G_TASK (user_data);
+    GSignondPluginRemote *self = GSIGNOND_PLUGIN_REMOTE (
+            g_task_get_source_object (task));
+    GError *error = NULL;
+
+    if (!gsignond_dbus_remote_plugin_loader_call_export_plugin_finish (
+                GSIGNOND_DBUS_REMOTE_PLUGIN_LOADER (source),
+                &self->priv->object_path, res, &error)) {
+        DBG ("Shared loader failed to export plugin %s: %s",
+             self->priv->plugin_type, error->message);
+        g_task_return_error (task, error);
+        g_object_unref (task);
+        return;
+    }
+
+    _create_plugin_proxy_async (self, task);
+}
+
+static void
+_on_host_loader_ready (
+        GObject *source,
+        GAsyncResult *res,
+        gpointer user_data)
+{
+    GTask *task = G_TASK (user_data);
+    GSignondPluginRemote *self = GSIGNOND_PLUGIN_REMOTE (
+            g_task_get_source_object (task));
+    GSignondDbusRemotePluginLoader *loader = NULL;
+    GError *error = NULL;
+
+    loader = gsignond_dbus_remote_plugin_loader_proxy_new_finish (res,
+                                                                  &error);
+    if (!loader) {
+        g_task_return_error (task, error);
+        g_object_unref (task);
+        return;
+    }
+
+    gsignond_dbus_remote_plugin_loader_call_export_plugin (loader,
+            self->priv->plugin_type, g_task_get_cancellable (task),
+            _on_plugin_exported, task);
+    g_object_unref (loader);
+}
+
+static void
+gsignond_plugin_remote_init_async (
+        GAsyncInitable *initable,
+        int io_priority,
+        GCancellable *cancellable,
+        GAsyncReadyCallback callback,
+        gpointer user_data)
+{
+    GSignondPluginRemote *self = GSIGNOND_PLUGIN_REMOTE (initable);
+    GTask *task = g_task_new (self, cancellable, callback, user_data);
+    GSignondDbusRemotePluginLoader *loader = NULL;
+    GSignondPipeStream *stream = NULL;
+    GError *error = NULL;
+
+    g_task_set_priority (task, io_priority);
+
+    if (self->priv->dbus_plugin_proxy || self->priv->session ||
+        self->priv->channel) {
+        g_task_return_boolean (task, TRUE);
+        g_object_unref (task);
+        return;
+    }
+
+    /* the loader announces itself with the first frame once the plugin is
+     * loaded */
+    if (self->priv->framed) {
+        if (!_open_channel (self, &error)) {
+            g_task_return_error (task, error);
+            g_object_unref (task);
+            return;
+        }
+        self->priv->ready_task = task;
+        gsignond_frame_channel_start (self->priv->channel);
+        return;
+    }
+
+    _find_shared_host (self);
+    if (_is_hosted_elsewhere (self)) {
+        self->priv->connection = g_object_ref (
+                self->priv->host->priv->connection);
+        gsignond_dbus_remote_plugin_loader_proxy_new (
+                self->priv->connection,
+                G_DBUS_PROXY_FLAGS_DO_NOT_LOAD_PROPERTIES,
+                NULL,
+                GSIGNOND_PLUGIN_OBJECTPATH,
+                cancellable,
+                _on_host_loader_ready,
+                task);
+        return;
+    }
+
+    if (self->priv->host) {
+        self->priv->connection = g_object_ref (
+                self->priv->host->priv->connection);
+        self->priv->dbus_plugin_proxy_v2 = g_object_ref (
+                self->priv->host->priv->dbus_plugin_proxy_v2);
+        _open_session_async (self, task);
+        return;
+    }
+
+    /* a loader in standby is connected already, it only has to load the
+     * plugin */
+    if (_take_standby (self, &loader)) {
+        gsignond_dbus_remote_plugin_loader_call_load_plugin (loader,
+                self->priv->plugin_type, cancellable,
+                _on_standby_plugin_loaded, task);
+        g_object_unref (loader);
+        return;
+    }
+
+    stream = _spawn_plugind (self, &error);
+    if (!stream) {
+        g_task_return_error (task, error);
+        g_object_unref (task);
+        return;
+    }
+
+    /* the loader answers once the plugin is loaded, which must not hold
+     * the main loop */
+    g_dbus_connection_new (G_IO_STREAM (stream), NULL,
+            G_DBUS_CONNECTION_FLAGS_NONE, NULL, cancellable,
+            _on_connection_ready, task);
+    g_object_unref (stream);
+}
+
+static gboolean
+gsignond_plugin_remote_init_finish (
+        GAsyncInitable *initable,
+        GAsyncResult *res,
+        GError **error)
+{
+    g_return_val_if_fail (g_task_is_valid (res, initable), FALSE);
+
+    if (!g_task_propagate_boolean (G_TASK (res), error))
+        return FALSE;
+
+    _share_loader (GSIGNOND_PLUGIN_REMOTE (initable));
+    return TRUE;
+}
+
+static void
+gsignond_plugin_remote_async_initable_iface_init (GAsyncInitableIface *iface)
+{
+    iface->init_async = gsignond_plugin_remote_init_async;
+    iface->init_finish = gsignond_plugin_remote_init_finish;
+}
+
+GSignondPluginRemote *
+gsignond_plugin_remote_new (
+        const gchar *loader_path,
+        const gchar *plugin_type)
+{
+    GError *error = NULL;
+    GSignondPluginRemote *plugin = g_initable_new (
+            GSIGNOND_TYPE_PLUGIN_REMOTE, NULL, &error,
+            "loaderpath", loader_path,
+            "plugintype", plugin_type,
+            NULL);
+
+    if (!plugin) {
+        DBG ("failed to create remote plugin %s: %s", plugin_type,
+             error ? error->message : "(null)");
+        g_clear_error (&error);
+    }
+
+    return plugin;
+}
+
+/**
+ * gsignond_plugin_remote_new_async:
+ * @loader_path: path of the plugin loader
+ * @plugin_type: type of the plugin to load
+ * @cancellable: (allow-none): a #GCancellable
+ * @callback: called when the plugin is ready to be used
+ * @user_data: user data for @callback
+ *
+ * Starts the plugin loader and connects to the plugin without blocking the
+ * main loop. Use gsignond_plugin_remote_new_finish() in @callback to get the
+ * result.
+ */
+void
+gsignond_plugin_remote_new_async (
+        const gchar *loader_path,
+        const gchar *plugin_type,
+        GCancellable *cancellable,
+        GAsyncReadyCallback callback,
+        gpointer user_data)
+{
+    g_async_initable_new_async (GSIGNOND_TYPE_PLUGIN_REMOTE,
+            G_PRIORITY_DEFAULT, cancellable, callback, user_data,
+            "loaderpath", loader_path,
+            "plugintype", plugin_type,
+            NULL);
+}
+
+/**
+ * gsignond_plugin_remote_new_from_standby_async:
+ * @standby: a #GSignondPluginStandby
+ * @plugin_type: type of the plugin to load
+ * @cancellable: (allow-none): a #GCancellable
+ * @callback: called when the plugin is ready to be used
+ * @user_data: user data for @callback
+ *
+ * Like gsignond_plugin_remote_new_async(), but has a loader process from
+ * @standby load the plugin. A new loader process is started if none is in
+ * standby. Use gsignond_plugin_remote_new_finish() in @callback to get the
+ * result.
+ */
+void
+gsignond_plugin_remote_new_from_standby_async (
+        GSignondPluginStandby *standby,
+        const gchar *plugin_type,
+        GCancellable *cancellable,
+        GAsyncReadyCallback callback,
+        gpointer user_data)
+{
+    g_return_if_fail (standby && GSIGNOND_IS_PLUGIN_STANDBY (standby));
+
+    g_async_initable_new_async (GSIGNOND_TYPE_PLUGIN_REMOTE,
+            G_PRIORITY_DEFAULT, cancellable, callback, user_data,
+            "loaderpath", gsignond_plugin_standby_get_loader_path (standby),
+            "plugintype", plugin_type,
+            "standby", standby,
+            NULL);
+}
+
+/**
+ * gsignond_plugin_remote_new_shared_async:
+ * @shared_loader: a #GSignondPluginSharedLoader
+ * @plugin_type: type of the plugin to load
+ * @cancellable: (allow-none): a #GCancellable
+ * @callback: called when the plugin is ready to be used
+ * @user_data: user data for @callback
+ *
+ * Like gsignond_plugin_remote_new_async(), but has the loader process of
+ * @shared_loader export the plugin if it is running. Otherwise the plugin
+ * is started in a loader process of its own, which then becomes the shared
+ * one. Use gsignond_plugin_remote_new_finish() in @callback to get the
+ * result.
+ */
+void
+gsignond_plugin_remote_new_shared_async (
+        GSignondPluginSharedLoader *shared_loader,
+        const gchar *plugin_type,
+        GCancellable *cancellable,
+        GAsyncReadyCallback callback,
+        gpointer user_data)
+{
+    g_return_if_fail (shared_loader &&
+                      GSIGNOND_IS_PLUGIN_SHARED_LOADER (shared_loader));
+
+    g_async_initable_new_async (GSIGNOND_TYPE_PLUGIN_REMOTE,
+            G_PRIORITY_DEFAULT, cancellable, callback, user_data,
+            "loaderpath",
+            gsignond_plugin_shared_loader_get_loader_path (shared_loader),
+            "plugintype", plugin_type,
+            "standby",
+            gsignond_plugin_shared_loader_get_standby (shared_loader),
+            "shared-loader", shared_loader,
+            NULL);
+}
+
+/**
+ * gsignond_plugin_remote_new_framed_async:
+ * @loader_path: path of the plugin loader
+ * @plugin_type: type of the plugin to load
+ * @standby: (allow-none): a #GSignondPluginStandby whose zygote forks the
+ * loader, if it has one
+ * @cancellable: (allow-none): a #GCancellable
+ * @callback: called when the plugin is ready to be used
+ * @user_data: user data for @callback
+ *
+ * Like gsignond_plugin_remote_new_async(), but starts the loader with
+ * <systemitem>--framed</systemitem> and talks to it with the binary frames
+ * of #GSignondFrameChannel instead of D-Bus. The loader serves a single
+ * session then. Use gsignond_plugin_remote_new_finish() in @callback to get
+ * the result.
+ */
+void
+gsignond_plugin_remote_new_framed_async (
+        const gchar *loader_path,
+        const gchar *plugin_type,
+        GSignondPluginStandby *standby,
+        GCancellable *cancellable,
+        GAsyncReadyCallback callback,
+        gpointer user_data)
+{
+    g_async_initable_new_async (GSIGNOND_TYPE_PLUGIN_REMOTE,
+            G_PRIORITY_DEFAULT, cancellable, callback, user_data,
+            "loaderpath", loader_path,
+            "plugintype", plugin_type,
+            "standby", standby,
+            "framed", TRUE,
+            NULL);
+}
+
+/**
+ * gsignond_plugin_remote_new_finish:
+ * @result: the #GAsyncResult passed to the callback
+ * @error: return location for error
+ *
+ * Returns: (transfer full): the remote plugin, or NULL on error.
+ */
+GSignondPluginRemote *
+gsignond_plugin_remote_new_finish (
+        GAsyncResult *result,
+        GError **error)
+{
+    GObject *source = g_async_result_get_source_object (result);
+    GObject *plugin = g_async_initable_new_finish (G_ASYNC_INITABLE (source),
+                                                   result, error);
+    g_object_unref (source);
+
+    return plugin ? GSIGNOND_PLUGIN_REMOTE (plugin) : NULL;
+}
+
+/**
+ * gsignond_plugin_remote_supports_sessions:
+ * @self: a #GSignondPluginRemote
+ *
+ * Returns: TRUE if the plugin loader multiplexes sessions, so that further
+ * sessions can be opened on it with gsignond_plugin_remote_new_session().
+ */
+gboolean
+gsignond_plugin_remote_supports_sessions (
+        GSignondPluginRemote *self)
+{
+    g_return_val_if_fail (self && GSIGNOND_IS_PLUGIN_REMOTE (self), FALSE);
+
+    return self->priv->dbus_plugin_proxy_v2 != NULL;
+}
+
+/* sessions share the plugin proxy of a host of the same type */
+static GSignondPluginRemote *
+_get_host (GSignondPluginRemote *self)
+{
+    return self->priv->host && !_is_hosted_elsewhere (self) ?
+            self->priv->host : self;
+}
+
+/**
+ * gsignond_plugin_remote_new_session:
+ * @host: a #GSignondPluginRemote supporting sessions
+ *
+ * Opens another session on the plugin loader process of @host. The session
+ * is served by its own plugin instance, and keeps the process running until
+ * it is unreferenced.
+ *
+ * Returns: (transfer full): the remote plugin for the new session, or NULL
+ * on error.
+ */
+GSignondPluginRemote *
+gsignond_plugin_remote_new_session (
+        GSignondPluginRemote *host)
+{
+    g_return_val_if_fail (gsignond_plugin_remote_supports_sessions (host),
+                          NULL);
+
+    GError *error = NULL;
+    GSignondPluginRemote *plugin = NULL;
+
+    host = _get_host (host);
+    plugin = g_initable_new (GSIGNOND_TYPE_PLUGIN_REMOTE, NULL, &error,
+            "loaderpath", host->priv->loader_path,
+            "plugintype", host->priv->plugin_type,
+            "host", host,
+            NULL);
+    if (!plugin) {
+        DBG ("failed to open session on %s: %s", host->priv->plugin_type,
+             error ? error->message : "(null)");
+        g_clear_error (&error);
+    }
 
     return plugin;
 }
 
+/**
+ * gsignond_plugin_remote_new_session_async:
+ * @host: a #GSignondPluginRemote supporting sessions
+ * @cancellable: (allow-none): a #GCancellable
+ * @callback: called when the session is open
+ * @user_data: user data for @callback
+ *
+ * Asynchronous version of gsignond_plugin_remote_new_session(). Use
+ * gsignond_plugin_remote_new_finish() in @callback to get the result.
+ */
+void
+gsignond_plugin_remote_new_session_async (
+        GSignondPluginRemote *host,
+        GCancellable *cancellable,
+        GAsyncReadyCallback callback,
+        gpointer user_data)
+{
+    g_return_if_fail (gsignond_plugin_remote_supports_sessions (host));
+
+    host = _get_host (host);
+    g_async_initable_new_async (GSIGNOND_TYPE_PLUGIN_REMOTE,
+            G_PRIORITY_DEFAULT, cancellable, callback, user_data,
+            "loaderpath", host->priv->loader_path,
+            "plugintype", host->priv->plugin_type,
+            "host", host,
+            NULL);
+}
@@ -29,6 +29,8 @@
 #include <glib.h>
 #include <daemon/dbus/gsignond-dbus-remote-plugin-gen.h>
 #include <gsignond/gsignond-config.h>
+#include "gsignond-plugin-standby.h"
+#include "gsignond-plugin-shared-loader.h"
 
 G_BEGIN_DECLS
 
@@ -72,6 +74,59 @@ gsignond_plugin_remote_new (
         const gchar *loader_path,
         const gchar *plugin_type);
 
+void
+gsignond_plugin_remote_new_async (
+        const gchar *loader_path,
+        const gchar *plugin_type,
+        GCancellable *cancellable,
+        GAsyncReadyCallback callback,
+        gpointer user_data);
+
+void
+gsignond_plugin_remote_new_from_standby_async (
+        GSignondPluginStandby *standby,
+        const gchar *plugin_type,
+        GCancellable *cancellable,
+        GAsyncReadyCallback callback,
+        gpointer user_data);
+
+void
+gsignond_plugin_remote_new_shared_async (
+        GSignondPluginSharedLoader *shared_loader,
+        const gchar *plugin_type,
+        GCancellable *cancellable,
+        GAsyncReadyCallback callback,
+        gpointer user_data);
+
+void
+gsignond_plugin_remote_new_framed_async (
+        const gchar *loader_path,
+        const gchar *plugin_type,
+        GSignondPluginStandby *standby,
+        GCancellable *cancellable,
+        GAsyncReadyCallback callback,
+        gpointer user_data);
+
+GSignondPluginRemote *
+gsignond_plugin_remote_new_finish (
+        GAsyncResult *result,
+        GError **error);
+
+gboolean
+gsignond_plugin_remote_supports_sessions (
+        GSignondPluginRemote *self);
+
+GSignondPluginRemote *
+gsignond_plugin_remote_new_session (
+        GSignondPluginRemote *host);
+
+void
+gsignond_plugin_remote_new_session_async (
+        GSignondPluginRemote *host,
+        GCancellable *cancellable,
+        GAsyncReadyCallback callback,
+        gpointer user_data);
+
 G_END_DECLS
 
 #endif /* __GSIGNOND_PLUGIN_REMOTE_H_ */
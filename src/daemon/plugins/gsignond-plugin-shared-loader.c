@@ -0,0 +1,267 @@
+/* vi: set et sw=4 ts=4 cino=t0,(0: */
+/* -*- Mode: C; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This file is part of gsignond
+ *
+ * Copyright (C) 2012-2014 Intel Corporation.
+ *
+ * Contact: Imran Zaman <imran.zaman@intel.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ */
+
+#include "config.h"
+
+#include "gsignond/gsignond-log.h"
+#include "gsignond-plugin-remote.h"
+#include "gsignond-plugin-shared-loader.h"
+
+/**
+ * SECTION:gsignond-plugin-shared-loader
+ * @short_description: plugin loader process shared by several plugin types
+ *
+ * #GSignondPluginSharedLoader lets remote plugins of different types share
+ * one plugin loader process, instead of each type running its own. The
+ * first remote plugin started with it becomes the host, and keeps its
+ * loader process. Further remote plugins have the host's loader export
+ * their plugin on an object of its own, on the same connection, as long as
+ * the host is alive. This saves the memory of a process per plugin type, at
+ * the cost of isolation between the plugins, so it is meant for trusted
+ * plugins only.
+ */
+
+enum
+{
+    PROP_0,
+    PROP_LOADER_PATH,
+    PROP_STANDBY,
+    N_PROPERTIES
+};
+
+static GParamSpec *properties[N_PROPERTIES] = { NULL, };
+
+struct _GSignondPluginSharedLoaderPrivate
+{
+    gchar *loader_path;
+    GSignondPluginStandby *standby;
+    /* remote plugin owning the shared process, not referenced */
+    GSignondPluginRemote *host;
+};
+
+G_DEFINE_TYPE (GSignondPluginSharedLoader, gsignond_plugin_shared_loader,
+               G_TYPE_OBJECT);
+
+#define GSIGNOND_PLUGIN_SHARED_LOADER_GET_PRIV(obj) \
+        G_TYPE_INSTANCE_GET_PRIVATE ((obj), \
+        GSIGNOND_TYPE_PLUGIN_SHARED_LOADER, GSignondPluginSharedLoaderPrivate)
+
+static void
+gsignond_plugin_shared_loader_set_property (
+        GObject *object,
+        guint property_id,
+        const GValue *value,
+        GParamSpec *pspec)
+{
+    GSignondPluginSharedLoader *self = GSIGNOND_PLUGIN_SHARED_LOADER (object);
+
+    switch (property_id) {
+        case PROP_LOADER_PATH:
+            self->priv->loader_path = g_value_dup_string (value);
+            break;
+        case PROP_STANDBY:
+            self->priv->standby = g_value_dup_object (value);
+            break;
+        default:
+            G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+    }
+}
+
+static void
+gsignond_plugin_shared_loader_get_property (
+        GObject *object,
+        guint property_id,
+        GValue *value,
+        GParamSpec *pspec)
+{
+    GSignondPluginSharedLoader *self = GSIGNOND_PLUGIN_SHARED_LOADER (object);
+
+    switch (property_id) {
+        case PROP_LOADER_PATH:
+            g_value_set_string (value, self->priv->loader_path);
+            break;
+        case PROP_STANDBY:
+            g_value_set_object (value, self->priv->standby);
+            break;
+        default:
+            G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+    }
+}
+
+static void
+gsignond_plugin_shared_loader_dispose (GObject *object)
+{
+    GSignondPluginSharedLoader *self = GSIGNOND_PLUGIN_SHARED_LOADER (object);
+
+    gsignond_plugin_shared_loader_set_host (self, NULL);
+
+    if (self->priv->standby) {
+        g_object_unref (self->priv->standby);
+        self->priv->standby = NULL;
+    }
+
+    G_OBJECT_CLASS (gsignond_plugin_shared_loader_parent_class)->dispose (
+            object);
+}
+
+static void
+gsignond_plugin_shared_loader_finalize (GObject *object)
+{
+    GSignondPluginSharedLoader *self = GSIGNOND_PLUGIN_SHARED_LOADER (object);
+
+    g_free (self->priv->loader_path);
+
+    G_OBJECT_CLASS (gsignond_plugin_shared_loader_parent_class)->finalize (
+            object);
+}
+
+static void
+gsignond_plugin_shared_loader_class_init (
+        GSignondPluginSharedLoaderClass *klass)
+{
+    GObjectClass* object_class = G_OBJECT_CLASS (klass);
+
+    g_type_class_add_private (object_class,
+            sizeof (GSignondPluginSharedLoaderPrivate));
+
+    object_class->get_property = gsignond_plugin_shared_loader_get_property;
+    object_class->set_property = gsignond_plugin_shared_loader_set_property;
+    object_class->dispose = gsignond_plugin_shared_loader_dispose;
+    object_class->finalize = gsignond_plugin_shared_loader_finalize;
+
+    properties[PROP_LOADER_PATH] = g_param_spec_string ("loaderpath",
+            "Path to loader",
+            "Path to the plugin loader to share",
+            NULL,
+            G_PARAM_CONSTRUCT_ONLY | G_PARAM_READWRITE |
+            G_PARAM_STATIC_STRINGS);
+
+    properties[PROP_STANDBY] = g_param_spec_object ("standby",
+            "Standby loaders",
+            "Pool of loader processes to take the shared loader from",
+            GSIGNOND_TYPE_PLUGIN_STANDBY,
+            G_PARAM_CONSTRUCT_ONLY | G_PARAM_READWRITE |
+            G_PARAM_STATIC_STRINGS);
+
+    g_object_class_install_properties (object_class, N_PROPERTIES,
+                                       properties);
+}
+
+static void
+gsignond_plugin_shared_loader_init (GSignondPluginSharedLoader *self)
+{
+    self->priv = GSIGNOND_PLUGIN_SHARED_LOADER_GET_PRIV (self);
+
+    self->priv->loader_path = NULL;
+    self->priv->standby = NULL;
+    self->priv->host = NULL;
+}
+
+/**
+ * gsignond_plugin_shared_loader_new:
+ * @loader_path: path of a plugin loader implementing exportPlugin method
+ * of the Loader interface
+ * @standby: (allow-none): pool of loader processes to take the shared
+ * loader from
+ *
+ * Returns: (transfer full): a new #GSignondPluginSharedLoader. The shared
+ * loader process is started with the first remote plugin using it.
+ */
+GSignondPluginSharedLoader *
+gsignond_plugin_shared_loader_new (
+        const gchar *loader_path,
+        GSignondPluginStandby *standby)
+{
+    g_return_val_if_fail (loader_path != NULL, NULL);
+
+    return GSIGNOND_PLUGIN_SHARED_LOADER (g_object_new (
+            GSIGNOND_TYPE_PLUGIN_SHARED_LOADER,
+            "loaderpath", loader_path,
+            "standby", standby,
+            NULL));
+}
+
+const gchar *
+gsignond_plugin_shared_loader_get_loader_path (
+        GSignondPluginSharedLoader *self)
+{
+    g_return_val_if_fail (self && GSIGNOND_IS_PLUGIN_SHARED_LOADER (self),
+                          NULL);
+
+    return self->priv->loader_path;
+}
+
+GSignondPluginStandby *
+gsignond_plugin_shared_loader_get_standby (
+        GSignondPluginSharedLoader *self)
+{
+    g_return_val_if_fail (self && GSIGNOND_IS_PLUGIN_SHARED_LOADER (self),
+                          NULL);
+
+    return self->priv->standby;
+}
+
+/**
+ * gsignond_plugin_shared_loader_get_host:
+ * @self: a #GSignondPluginSharedLoader
+ *
+ * Returns: (transfer none): the remote plugin whose loader process hosts
+ * the other plugins, or NULL if the shared process is not running.
+ */
+GSignondPluginRemote *
+gsignond_plugin_shared_loader_get_host (
+        GSignondPluginSharedLoader *self)
+{
+    g_return_val_if_fail (self && GSIGNOND_IS_PLUGIN_SHARED_LOADER (self),
+                          NULL);
+
+    return self->priv->host;
+}
+
+/**
+ * gsignond_plugin_shared_loader_set_host:
+ * @self: a #GSignondPluginSharedLoader
+ * @host: (allow-none): a remote plugin owning its loader process
+ *
+ * Makes the loader process of @host the shared process. It is dropped once
+ * @host is finalized.
+ */
+void
+gsignond_plugin_shared_loader_set_host (
+        GSignondPluginSharedLoader *self,
+        GSignondPluginRemote *host)
+{
+    g_return_if_fail (self && GSIGNOND_IS_PLUGIN_SHARED_LOADER (self));
+
+    if (self->priv->host)
+        g_object_remove_weak_pointer (G_OBJECT (self->priv->host),
+                                      (gpointer *) &self->priv->host);
+    self->priv->host = host;
+    if (host) {
+        g_object_add_weak_pointer (G_OBJECT (host),
+                                   (gpointer *) &self->priv->host);
+        DBG ("Loader process of %p is shared", host);
+    }
+}
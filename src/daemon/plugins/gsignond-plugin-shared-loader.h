@@ -0,0 +1,93 @@
+/* vi: set et sw=4 ts=4 cino=t0,(0: */
+/* -*- Mode: C; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This file is part of gsignond
+ *
+ * Copyright (C) 2013 Intel Corporation.
+ *
+ * Contact: Imran Zaman <imran.zaman@intel.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ */
+
+#ifndef __GSIGNOND_PLUGIN_SHARED_LOADER_H_
+#define __GSIGNOND_PLUGIN_SHARED_LOADER_H_
+
+#include <glib-object.h>
+#include "gsignond-plugin-standby.h"
+
+G_BEGIN_DECLS
+
+#define GSIGNOND_TYPE_PLUGIN_SHARED_LOADER \
+    (gsignond_plugin_shared_loader_get_type())
+#define GSIGNOND_PLUGIN_SHARED_LOADER(obj)  (G_TYPE_CHECK_INSTANCE_CAST((obj),\
+    GSIGNOND_TYPE_PLUGIN_SHARED_LOADER, GSignondPluginSharedLoader))
+#define GSIGNOND_PLUGIN_SHARED_LOADER_CLASS(klass)\
+    (G_TYPE_CHECK_CLASS_CAST((klass), GSIGNOND_TYPE_PLUGIN_SHARED_LOADER, \
+    GSignondPluginSharedLoaderClass))
+#define GSIGNOND_IS_PLUGIN_SHARED_LOADER(obj)         \
+    (G_TYPE_CHECK_INSTANCE_TYPE((obj), GSIGNOND_TYPE_PLUGIN_SHARED_LOADER))
+#define GSIGNOND_IS_PLUGIN_SHARED_LOADER_CLASS(klass) \
+    (G_TYPE_CHECK_CLASS_TYPE((klass), GSIGNOND_TYPE_PLUGIN_SHARED_LOADER))
+#define GSIGNOND_PLUGIN_SHARED_LOADER_GET_CLASS(obj)  \
+    (G_TYPE_INSTANCE_GET_CLASS((obj), GSIGNOND_TYPE_PLUGIN_SHARED_LOADER, \
+    GSignondPluginSharedLoaderClass))
+
+typedef struct _GSignondPluginSharedLoader GSignondPluginSharedLoader;
+typedef struct _GSignondPluginSharedLoaderClass GSignondPluginSharedLoaderClass;
+typedef struct _GSignondPluginSharedLoaderPrivate GSignondPluginSharedLoaderPrivate;
+
+struct _GSignondPluginSharedLoader
+{
+    GObject parent;
+
+    /* priv */
+    GSignondPluginSharedLoaderPrivate *priv;
+};
+
+struct _GSignondPluginSharedLoaderClass
+{
+    GObjectClass parent_class;
+};
+
+GType
+gsignond_plugin_shared_loader_get_type (void) G_GNUC_CONST;
+
+GSignondPluginSharedLoader *
+gsignond_plugin_shared_loader_new (
+        const gchar *loader_path,
+        GSignondPluginStandby *standby);
+
+const gchar *
+gsignond_plugin_shared_loader_get_loader_path (
+        GSignondPluginSharedLoader *self);
+
+GSignondPluginStandby *
+gsignond_plugin_shared_loader_get_standby (
+        GSignondPluginSharedLoader *self);
+
+struct _GSignondPluginRemote *
+gsignond_plugin_shared_loader_get_host (
+        GSignondPluginSharedLoader *self);
+
+void
+gsignond_plugin_shared_loader_set_host (
+        GSignondPluginSharedLoader *self,
+        struct _GSignondPluginRemote *host);
+
+G_END_DECLS
+
+#endif /* __GSIGNOND_PLUGIN_SHARED_LOADER_H_ */
@@ -0,0 +1,528 @@
+/* vi: set et sw=4 ts=4 cino=t0,(0: */
+/* -*- Mode: C; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This file is part of gsignond
+ *
+ * Copyright (C) 2012-2014 Intel Corporation.
+ *
+ * Contact: Imran Zaman <imran.zaman@intel.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ */
+
+#include <signal.h>
+
+#include "config.h"
+
+#include "gsignond/gsignond-log.h"
+#include "common/gsignond-pipe-stream.h"
+#include "daemon/dbus/gsignond-dbus.h"
+#include "gsignond-plugin-standby.h"
+
+/**
+ * SECTION:gsignond-plugin-standby
+ * @short_description: pre-started plugin loader processes
+ *
+ * #GSignondPluginStandby keeps a number of plugin loader processes running
+ * that have been started with the --standby command line option and are
+ * connected already, but have not loaded a plugin yet. A remote plugin takes
+ * one of them and only has it load the plugin, instead of starting a loader
+ * process and connecting to it. The pool is topped up in the background.
+ *
+ * When a #GSignondPluginZygote is set, loader processes are forked by the
+ * zygote rather than started from the loader binary, both for the pool and
+ * for remote plugins that find the pool empty.
+ */
+
+/* topping up after a loader died is delayed, so that a broken loader is
+ * not restarted in a tight loop */
+#define GSIGNOND_PLUGIN_STANDBY_RESPAWN_DELAY 1000
+
+enum
+{
+    PROP_0,
+    PROP_LOADER_PATH,
+    PROP_SIZE,
+    PROP_ZYGOTE,
+    N_PROPERTIES
+};
+
+static GParamSpec *properties[N_PROPERTIES] = { NULL, };
+
+struct _GSignondPluginStandbyPrivate
+{
+    gchar *loader_path;
+    guint size;
+    GSignondPluginZygote *zygote;
+    GQueue *ready; /* connected _StandbyProcesses */
+    guint n_starting;
+    guint refill_id;
+};
+
+typedef struct {
+    GSignondPluginStandby *standby; /* referenced while starting */
+    gboolean starting;
+    GPid pid;
+    guint child_watch_id;
+    GDBusConnection *connection;
+    GSignondDbusRemotePluginLoader *loader;
+} _StandbyProcess;
+
+G_DEFINE_TYPE (GSignondPluginStandby, gsignond_plugin_standby, G_TYPE_OBJECT);
+
+#define GSIGNOND_PLUGIN_STANDBY_GET_PRIV(obj) \
+        G_TYPE_INSTANCE_GET_PRIVATE ((obj), GSIGNOND_TYPE_PLUGIN_STANDBY, \
+        GSignondPluginStandbyPrivate)
+
+static void
+_reap_child (
+        GPid  pid,
+        gint  status,
+        gpointer data)
+{
+    g_spawn_close_pid (pid);
+}
+
+static void
+_standby_process_free (_StandbyProcess *process)
+{
+    if (process->child_watch_id > 0)
+        g_source_remove (process->child_watch_id);
+    if (process->pid > 0) {
+        kill (process->pid, SIGTERM);
+        g_child_watch_add (process->pid, _reap_child, NULL);
+    }
+    g_clear_object (&process->loader);
+    g_clear_object (&process->connection);
+    g_slice_free (_StandbyProcess, process);
+}
+
+static gboolean
+_refill (gpointer user_data);
+
+static void
+_schedule_refill (
+        GSignondPluginStandby *self,
+        guint delay)
+{
+    if (self->priv->refill_id || !self->priv->ready)
+        return;
+
+    if (delay)
+        self->priv->refill_id = g_timeout_add (delay, _refill, self);
+    else
+        self->priv->refill_id = g_idle_add (_refill, self);
+}
+
+static void
+_on_process_down (
+        GPid  pid,
+        gint  status,
+        gpointer data)
+{
+    _StandbyProcess *process = (_StandbyProcess *) data;
+    GSignondPluginStandby *self = process->standby;
+
+    g_spawn_close_pid (pid);
+    DBG ("Standby loader with pid (%d) closed with status %d", pid, status);
+
+    process->pid = 0;
+    process->child_watch_id = 0;
+
+    /* a starting process is dropped when its connection fails */
+    if (process->starting)
+        return;
+
+    g_queue_remove (self->priv->ready, process);
+    _standby_process_free (process);
+    _schedule_refill (self, GSIGNOND_PLUGIN_STANDBY_RESPAWN_DELAY);
+}
+
+static void
+_process_started (
+        _StandbyProcess *process,
+        gboolean success)
+{
+    GSignondPluginStandby *self = process->standby;
+
+    process->starting = FALSE;
+    self->priv->n_starting--;
+
+    if (success && process->pid > 0 && self->priv->ready) {
+        g_queue_push_tail (self->priv->ready, process);
+        DBG ("Standby loader with pid (%d) ready, %u ready", process->pid,
+             g_queue_get_length (self->priv->ready));
+    } else {
+        _standby_process_free (process);
+        _schedule_refill (self, GSIGNOND_PLUGIN_STANDBY_RESPAWN_DELAY);
+    }
+    g_object_unref (self);
+}
+
+static void
+_on_loader_ready (
+        GObject *source,
+        GAsyncResult *res,
+        gpointer user_data)
+{
+    _StandbyProcess *process = (_StandbyProcess *) user_data;
+    GError *error = NULL;
+
+    process->loader = gsignond_dbus_remote_plugin_loader_proxy_new_finish (
+            res, &error);
+    if (!process->loader) {
+        DBG ("Failed to create loader proxy: %s", error->message);
+        g_error_free (error);
+    }
+    _process_started (process, process->loader != NULL);
+}
+
+static void
+_on_connection_ready (
+        GObject *source,
+        GAsyncResult *res,
+        gpointer user_data)
+{
+    _StandbyProcess *process = (_StandbyProcess *) user_data;
+    GError *error = NULL;
+
+    process->connection = g_dbus_connection_new_finish (res, &error);
+    if (!process->connection) {
+        DBG ("Failed to open connection to standby loader: %s",
+             error->message);
+        g_error_free (error);
+        _process_started (process, FALSE);
+        return;
+    }
+
+    gsignond_dbus_remote_plugin_loader_proxy_new (
+            process->connection,
+            G_DBUS_PROXY_FLAGS_NONE,
+            NULL,
+            GSIGNOND_PLUGIN_OBJECTPATH,
+            NULL,
+            _on_loader_ready,
+            process);
+}
+
+static gboolean
+_spawn_standby (GSignondPluginStandby *self)
+{
+    _StandbyProcess *process = NULL;
+    GSignondPipeStream *stream = NULL;
+    GError *error = NULL;
+    GPid pid = 0;
+    gint cin_fd, cout_fd;
+    gchar *argv[] = { self->priv->loader_path, (gchar *) "--standby", NULL };
+
+    /* see _spawn_plugind() */
+    signal(SIGPIPE, SIG_IGN);
+
+    if (self->priv->zygote ?
+        !gsignond_plugin_zygote_fork (self->priv->zygote, argv[1], &pid,
+                                      &cin_fd, &cout_fd, &error) :
+        !g_spawn_async_with_pipes (NULL, argv, NULL,
+            G_SPAWN_DO_NOT_REAP_CHILD, NULL, NULL, &pid, &cin_fd, &cout_fd,
+            NULL, &error)) {
+        DBG ("failed to start standby loader: %s", error->message);
+        g_error_free (error);
+        return FALSE;
+    }
+
+    process = g_slice_new0 (_StandbyProcess);
+    process->standby = g_object_ref (self);
+    process->starting = TRUE;
+    process->pid = pid;
+    process->child_watch_id = g_child_watch_add (pid, _on_process_down,
+                                                 process);
+    self->priv->n_starting++;
+
+    stream = gsignond_pipe_stream_new (cout_fd, cin_fd, TRUE);
+    g_dbus_connection_new (G_IO_STREAM (stream), NULL,
+            G_DBUS_CONNECTION_FLAGS_NONE, NULL, NULL,
+            _on_connection_ready, process);
+    g_object_unref (stream);
+
+    return TRUE;
+}
+
+static gboolean
+_refill (gpointer user_data)
+{
+    GSignondPluginStandby *self = GSIGNOND_PLUGIN_STANDBY (user_data);
+    GSignondPluginStandbyPrivate *priv = self->priv;
+
+    priv->refill_id = 0;
+    while (priv->ready &&
+           g_queue_get_length (priv->ready) + priv->n_starting < priv->size) {
+        if (!_spawn_standby (self))
+            break;
+    }
+
+    return FALSE;
+}
+
+static void
+gsignond_plugin_standby_set_property (
+        GObject *object,
+        guint property_id,
+        const GValue *value,
+        GParamSpec *pspec)
+{
+    GSignondPluginStandby *self = GSIGNOND_PLUGIN_STANDBY (object);
+
+    switch (property_id) {
+        case PROP_LOADER_PATH:
+            self->priv->loader_path = g_value_dup_string (value);
+            break;
+        case PROP_SIZE:
+            self->priv->size = g_value_get_uint (value);
+            break;
+        case PROP_ZYGOTE:
+            self->priv->zygote = g_value_dup_object (value);
+            break;
+        default:
+            G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+    }
+}
+
+static void
+gsignond_plugin_standby_get_property (
+        GObject *object,
+        guint property_id,
+        GValue *value,
+        GParamSpec *pspec)
+{
+    GSignondPluginStandby *self = GSIGNOND_PLUGIN_STANDBY (object);
+
+    switch (property_id) {
+        case PROP_LOADER_PATH:
+            g_value_set_string (value, self->priv->loader_path);
+            break;
+        case PROP_SIZE:
+            g_value_set_uint (value, self->priv->size);
+            break;
+        case PROP_ZYGOTE:
+            g_value_set_object (value, self->priv->zygote);
+            break;
+        default:
+            G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+    }
+}
+
+static void
+gsignond_plugin_standby_constructed (GObject *object)
+{
+    GSignondPluginStandby *self = GSIGNOND_PLUGIN_STANDBY (object);
+
+    G_OBJECT_CLASS (gsignond_plugin_standby_parent_class)->constructed (object);
+
+    /* the loaders are started once the daemon is idle */
+    if (self->priv->loader_path)
+        _schedule_refill (self, 0);
+}
+
+static void
+gsignond_plugin_standby_dispose (GObject *object)
+{
+    GSignondPluginStandby *self = GSIGNOND_PLUGIN_STANDBY (object);
+
+    if (self->priv->refill_id) {
+        g_source_remove (self->priv->refill_id);
+        self->priv->refill_id = 0;
+    }
+
+    if (self->priv->ready) {
+        g_queue_free_full (self->priv->ready,
+                           (GDestroyNotify) _standby_process_free);
+        self->priv->ready = NULL;
+    }
+
+    if (self->priv->zygote) {
+        g_object_unref (self->priv->zygote);
+        self->priv->zygote = NULL;
+    }
+
+    G_OBJECT_CLASS (gsignond_plugin_standby_parent_class)->dispose (object);
+}
+
+static void
+gsignond_plugin_standby_finalize (GObject *object)
+{
+    GSignondPluginStandby *self = GSIGNOND_PLUGIN_STANDBY (object);
+
+    g_free (self->priv->loader_path);
+
+    G_OBJECT_CLASS (gsignond_plugin_standby_parent_class)->finalize (object);
+}
+
+static void
+gsignond_plugin_standby_class_init (GSignondPluginStandbyClass *klass)
+{
+    GObjectClass* object_class = G_OBJECT_CLASS (klass);
+
+    g_type_class_add_private (object_class,
+            sizeof (GSignondPluginStandbyPrivate));
+
+    object_class->get_property = gsignond_plugin_standby_get_property;
+    object_class->set_property = gsignond_plugin_standby_set_property;
+    object_class->constructed = gsignond_plugin_standby_constructed;
+    object_class->dispose = gsignond_plugin_standby_dispose;
+    object_class->finalize = gsignond_plugin_standby_finalize;
+
+    properties[PROP_LOADER_PATH] = g_param_spec_string ("loaderpath",
+            "Path to loader",
+            "Path to the plugin loader to keep in standby",
+            NULL,
+            G_PARAM_CONSTRUCT_ONLY | G_PARAM_READWRITE |
+            G_PARAM_STATIC_STRINGS);
+
+    properties[PROP_SIZE] = g_param_spec_uint ("size",
+            "Size",
+            "Number of loader processes to keep in standby",
+            0, G_MAXUINT, 1,
+            G_PARAM_CONSTRUCT_ONLY | G_PARAM_READWRITE |
+            G_PARAM_STATIC_STRINGS);
+
+    properties[PROP_ZYGOTE] = g_param_spec_object ("zygote",
+            "Zygote",
+            "Zygote to fork the loader processes from",
+            GSIGNOND_TYPE_PLUGIN_ZYGOTE,
+            G_PARAM_CONSTRUCT_ONLY | G_PARAM_READWRITE |
+            G_PARAM_STATIC_STRINGS);
+
+    g_object_class_install_properties (object_class, N_PROPERTIES,
+                                       properties);
+}
+
+static void
+gsignond_plugin_standby_init (GSignondPluginStandby *self)
+{
+    self->priv = GSIGNOND_PLUGIN_STANDBY_GET_PRIV (self);
+
+    self->priv->loader_path = NULL;
+    self->priv->size = 1;
+    self->priv->zygote = NULL;
+    self->priv->ready = g_queue_new ();
+    self->priv->n_starting = 0;
+    self->priv->refill_id = 0;
+}
+
+/**
+ * gsignond_plugin_standby_new:
+ * @loader_path: path of a plugin loader supporting the --standby option
+ * @size: number of loader processes to keep in standby
+ *
+ * Returns: (transfer full): a new #GSignondPluginStandby. The loader
+ * processes are started from the main loop.
+ */
+GSignondPluginStandby *
+gsignond_plugin_standby_new (
+        const gchar *loader_path,
+        guint size)
+{
+    g_return_val_if_fail (loader_path != NULL, NULL);
+
+    return GSIGNOND_PLUGIN_STANDBY (g_object_new (
+            GSIGNOND_TYPE_PLUGIN_STANDBY,
+            "loaderpath", loader_path,
+            "size", size,
+            NULL));
+}
+
+const gchar *
+gsignond_plugin_standby_get_loader_path (
+        GSignondPluginStandby *self)
+{
+    g_return_val_if_fail (self && GSIGNOND_IS_PLUGIN_STANDBY (self), NULL);
+
+    return self->priv->loader_path;
+}
+
+/**
+ * gsignond_plugin_standby_get_zygote:
+ * @self: a #GSignondPluginStandby
+ *
+ * Returns: (transfer none): the zygote loader processes are forked from,
+ * or NULL if they are started from the loader binary.
+ */
+GSignondPluginZygote *
+gsignond_plugin_standby_get_zygote (
+        GSignondPluginStandby *self)
+{
+    g_return_val_if_fail (self && GSIGNOND_IS_PLUGIN_STANDBY (self), NULL);
+
+    return self->priv->zygote;
+}
+
+/**
+ * gsignond_plugin_standby_get_n_ready:
+ * @self: a #GSignondPluginStandby
+ *
+ * Returns: the number of loader processes that can be taken right away.
+ */
+guint
+gsignond_plugin_standby_get_n_ready (
+        GSignondPluginStandby *self)
+{
+    g_return_val_if_fail (self && GSIGNOND_IS_PLUGIN_STANDBY (self), 0);
+
+    return self->priv->ready ? g_queue_get_length (self->priv->ready) : 0;
+}
+
+/**
+ * gsignond_plugin_standby_take:
+ * @self: a #GSignondPluginStandby
+ * @pid: (out): the process id of the loader
+ * @connection: (out) (transfer full): the connection to the loader
+ * @loader: (out) (transfer full): the proxy for the Loader interface
+ *
+ * Hands a connected loader process over to the caller, who becomes
+ * responsible for reaping it. Another process is started in its place.
+ *
+ * Returns: TRUE if a process was taken, FALSE if none is ready.
+ */
+gboolean
+gsignond_plugin_standby_take (
+        GSignondPluginStandby *self,
+        GPid *pid,
+        GDBusConnection **connection,
+        GSignondDbusRemotePluginLoader **loader)
+{
+    g_return_val_if_fail (self && GSIGNOND_IS_PLUGIN_STANDBY (self), FALSE);
+    g_return_val_if_fail (pid && connection && loader, FALSE);
+
+    _StandbyProcess *process = NULL;
+
+    if (!self->priv->ready ||
+        (process = g_queue_pop_head (self->priv->ready)) == NULL)
+        return FALSE;
+
+    g_source_remove (process->child_watch_id);
+    process->child_watch_id = 0;
+    *pid = process->pid;
+    process->pid = 0;
+    *connection = process->connection;
+    process->connection = NULL;
+    *loader = process->loader;
+    process->loader = NULL;
+    _standby_process_free (process);
+
+    DBG ("Standby loader with pid (%d) taken", *pid);
+    _schedule_refill (self, 0);
+
+    return TRUE;
+}
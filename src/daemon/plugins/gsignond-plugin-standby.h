@@ -0,0 +1,96 @@
+/* vi: set et sw=4 ts=4 cino=t0,(0: */
+/* -*- Mode: C; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This file is part of gsignond
+ *
+ * Copyright (C) 2013 Intel Corporation.
+ *
+ * Contact: Imran Zaman <imran.zaman@intel.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ */
+
+#ifndef __GSIGNOND_PLUGIN_STANDBY_H_
+#define __GSIGNOND_PLUGIN_STANDBY_H_
+
+#include <glib.h>
+#include <daemon/dbus/gsignond-dbus-remote-plugin-gen.h>
+#include "gsignond-plugin-zygote.h"
+
+G_BEGIN_DECLS
+
+#define GSIGNOND_TYPE_PLUGIN_STANDBY \
+    (gsignond_plugin_standby_get_type())
+#define GSIGNOND_PLUGIN_STANDBY(obj)  (G_TYPE_CHECK_INSTANCE_CAST((obj),\
+    GSIGNOND_TYPE_PLUGIN_STANDBY, GSignondPluginStandby))
+#define GSIGNOND_PLUGIN_STANDBY_CLASS(klass)\
+    (G_TYPE_CHECK_CLASS_CAST((klass), GSIGNOND_TYPE_PLUGIN_STANDBY, \
+    GSignondPluginStandbyClass))
+#define GSIGNOND_IS_PLUGIN_STANDBY(obj)         \
+    (G_TYPE_CHECK_INSTANCE_TYPE((obj), GSIGNOND_TYPE_PLUGIN_STANDBY))
+#define GSIGNOND_IS_PLUGIN_STANDBY_CLASS(klass) \
+    (G_TYPE_CHECK_CLASS_TYPE((klass), GSIGNOND_TYPE_PLUGIN_STANDBY))
+#define GSIGNOND_PLUGIN_STANDBY_GET_CLASS(obj)  \
+    (G_TYPE_INSTANCE_GET_CLASS((obj), GSIGNOND_TYPE_PLUGIN_STANDBY, \
+    GSignondPluginStandbyClass))
+
+typedef struct _GSignondPluginStandby GSignondPluginStandby;
+typedef struct _GSignondPluginStandbyClass GSignondPluginStandbyClass;
+typedef struct _GSignondPluginStandbyPrivate GSignondPluginStandbyPrivate;
+
+struct _GSignondPluginStandby
+{
+    GObject parent;
+
+    /* priv */
+    GSignondPluginStandbyPrivate *priv;
+};
+
+struct _GSignondPluginStandbyClass
+{
+    GObjectClass parent_class;
+};
+
+GType
+gsignond_plugin_standby_get_type (void) G_GNUC_CONST;
+
+GSignondPluginStandby *
+gsignond_plugin_standby_new (
+        const gchar *loader_path,
+        guint size);
+
+const gchar *
+gsignond_plugin_standby_get_loader_path (
+        GSignondPluginStandby *self);
+
+GSignondPluginZygote *
+gsignond_plugin_standby_get_zygote (
+        GSignondPluginStandby *self);
+
+guint
+gsignond_plugin_standby_get_n_ready (
+        GSignondPluginStandby *self);
+
+gboolean
+gsignond_plugin_standby_take (
+        GSignondPluginStandby *self,
+        GPid *pid,
+        GDBusConnection **connection,
+        GSignondDbusRemotePluginLoader **loader);
+
+G_END_DECLS
+
+#endif /* __GSIGNOND_PLUGIN_STANDBY_H_ */
@@ -0,0 +1,494 @@
+/* vi: set et sw=4 ts=4 cino=t0,(0: */
+/* -*- Mode: C; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This file is part of gsignond
+ *
+ * Copyright (C) 2012-2014 Intel Corporation.
+ *
+ * Contact: Imran Zaman <imran.zaman@intel.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <string.h>
+#include <sys/prctl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <glib-unix.h>
+
+#include "config.h"
+
+#include "gsignond/gsignond-log.h"
+#include "gsignond/gsignond-error.h"
+#include "gsignond-plugin-zygote.h"
+
+/**
+ * SECTION:gsignond-plugin-zygote
+ * @short_description: fork server for plugin loader processes
+ *
+ * #GSignondPluginZygote runs one long-lived plugin loader process with the
+ * --zygote command line option. The zygote loads the plugins once, and
+ * then forks a loader process for each request on its control socket,
+ * instead of gsignond starting the loader binary anew. The forked loaders
+ * share the zygote's code and initialized state copy-on-write, and skip
+ * process startup and plugin loading.
+ *
+ * The zygote hands each forked loader over to gsignond, which becomes a
+ * child subreaper for that, so that forked loaders can be watched and
+ * reaped like spawned ones.
+ */
+
+/* how long to wait for the zygote to report the pid of a forked loader */
+#define GSIGNOND_PLUGIN_ZYGOTE_TIMEOUT 5000
+
+enum
+{
+    PROP_0,
+    PROP_LOADER_PATH,
+    N_PROPERTIES
+};
+
+static GParamSpec *properties[N_PROPERTIES] = { NULL, };
+
+struct _GSignondPluginZygotePrivate
+{
+    gchar *loader_path;
+    GPid pid;
+    guint child_watch_id;
+    gint control_fd;
+};
+
+G_DEFINE_TYPE (GSignondPluginZygote, gsignond_plugin_zygote, G_TYPE_OBJECT);
+
+#define GSIGNOND_PLUGIN_ZYGOTE_GET_PRIV(obj) \
+        G_TYPE_INSTANCE_GET_PRIVATE ((obj), GSIGNOND_TYPE_PLUGIN_ZYGOTE, \
+        GSignondPluginZygotePrivate)
+
+static void
+_reap_child (
+        GPid  pid,
+        gint  status,
+        gpointer data)
+{
+    g_spawn_close_pid (pid);
+}
+
+static void
+_stop_zygote (GSignondPluginZygote *self)
+{
+    if (self->priv->control_fd >= 0) {
+        /* the zygote exits when the control socket is closed */
+        close (self->priv->control_fd);
+        self->priv->control_fd = -1;
+    }
+    if (self->priv->child_watch_id > 0) {
+        g_source_remove (self->priv->child_watch_id);
+        self->priv->child_watch_id = 0;
+    }
+    if (self->priv->pid > 0) {
+        g_child_watch_add (self->priv->pid, _reap_child, NULL);
+        self->priv->pid = 0;
+    }
+}
+
+static void
+_on_zygote_down (
+        GPid  pid,
+        gint  status,
+        gpointer data)
+{
+    GSignondPluginZygote *self = GSIGNOND_PLUGIN_ZYGOTE (data);
+
+    g_spawn_close_pid (pid);
+    DBG ("Zygote with pid (%d) closed with status %d", pid, status);
+
+    self->priv->pid = 0;
+    self->priv->child_watch_id = 0;
+    _stop_zygote (self);
+}
+
+static void
+_zygote_child_setup (gpointer user_data)
+{
+    /* the control socket replaces stdin */
+    dup2 (GPOINTER_TO_INT (user_data), 0);
+}
+
+static gboolean
+_start_zygote (
+        GSignondPluginZygote *self,
+        GError **error)
+{
+    gint fds[2];
+    GPid pid = 0;
+    gchar *argv[] = { self->priv->loader_path, (gchar *) "--zygote", NULL };
+
+#ifdef PR_SET_CHILD_SUBREAPER
+    if (prctl (PR_SET_CHILD_SUBREAPER, 1) != 0) {
+        g_set_error (error, GSIGNOND_ERROR, GSIGNOND_ERROR_INTERNAL_SERVER,
+                     "Failed to become child subreaper: %s",
+                     strerror (errno));
+        return FALSE;
+    }
+#else
+    g_set_error (error, GSIGNOND_ERROR, GSIGNOND_ERROR_INTERNAL_SERVER,
+                 "Zygote is not supported on this system");
+    return FALSE;
+#endif
+
+    if (socketpair (AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, fds) != 0) {
+        g_set_error (error, GSIGNOND_ERROR, GSIGNOND_ERROR_INTERNAL_SERVER,
+                     "Failed to create zygote control socket: %s",
+                     strerror (errno));
+        return FALSE;
+    }
+
+    /* see _spawn_plugind() */
+    signal (SIGPIPE, SIG_IGN);
+
+    if (!g_spawn_async (NULL, argv, NULL, G_SPAWN_DO_NOT_REAP_CHILD,
+                        _zygote_child_setup, GINT_TO_POINTER (fds[1]), &pid,
+                        error)) {
+        close (fds[0]);
+        close (fds[1]);
+        return FALSE;
+    }
+    close (fds[1]);
+
+    self->priv->pid = pid;
+    self->priv->control_fd = fds[0];
+    self->priv->child_watch_id = g_child_watch_add (pid, _on_zygote_down,
+                                                    self);
+    DBG ("Zygote started with pid (%d)", pid);
+
+    return TRUE;
+}
+
+static gboolean
+_send_request (
+        gint control_fd,
+        const gchar *option,
+        gint in_fd,
+        gint out_fd)
+{
+    struct msghdr msg;
+    struct iovec iov;
+    struct cmsghdr *cmsg;
+    union {
+        struct cmsghdr align;
+        gchar buf[CMSG_SPACE (2 * sizeof (gint))];
+    } control;
+    gssize n;
+
+    memset (&msg, 0, sizeof (msg));
+    memset (&control, 0, sizeof (control));
+    iov.iov_base = (gpointer) option;
+    iov.iov_len = strlen (option);
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.buf;
+    msg.msg_controllen = sizeof (control.buf);
+
+    cmsg = CMSG_FIRSTHDR (&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN (2 * sizeof (gint));
+    memcpy (CMSG_DATA (cmsg), &in_fd, sizeof (gint));
+    memcpy (CMSG_DATA (cmsg) + sizeof (gint), &out_fd, sizeof (gint));
+
+    do {
+        n = sendmsg (control_fd, &msg, MSG_NOSIGNAL);
+    } while (n < 0 && errno == EINTR);
+
+    return n == (gssize) iov.iov_len;
+}
+
+static gboolean
+_receive_pid (
+        gint control_fd,
+        GPid *pid)
+{
+    struct pollfd pfd = { control_fd, POLLIN, 0 };
+    gint32 reply = -1;
+    gint ret;
+
+    do {
+        ret = poll (&pfd, 1, GSIGNOND_PLUGIN_ZYGOTE_TIMEOUT);
+    } while (ret < 0 && errno == EINTR);
+    if (ret <= 0)
+        return FALSE;
+
+    if (recv (control_fd, &reply, sizeof (reply), 0) != sizeof (reply) ||
+        reply <= 0)
+        return FALSE;
+
+    *pid = (GPid) reply;
+    return TRUE;
+}
+
+static void
+gsignond_plugin_zygote_set_property (
+        GObject *object,
+        guint property_id,
+        const GValue *value,
+        GParamSpec *pspec)
+{
+    GSignondPluginZygote *self = GSIGNOND_PLUGIN_ZYGOTE (object);
+
+    switch (property_id) {
+        case PROP_LOADER_PATH:
+            self->priv->loader_path = g_value_dup_string (value);
+            break;
+        default:
+            G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+    }
+}
+
+static void
+gsignond_plugin_zygote_get_property (
+        GObject *object,
+        guint property_id,
+        GValue *value,
+        GParamSpec *pspec)
+{
+    GSignondPluginZygote *self = GSIGNOND_PLUGIN_ZYGOTE (object);
+
+    switch (property_id) {
+        case PROP_LOADER_PATH:
+            g_value_set_string (value, self->priv->loader_path);
+            break;
+        default:
+            G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+    }
+}
+
+static void
+gsignond_plugin_zygote_dispose (GObject *object)
+{
+    GSignondPluginZygote *self = GSIGNOND_PLUGIN_ZYGOTE (object);
+
+    _stop_zygote (self);
+
+    G_OBJECT_CLASS (gsignond_plugin_zygote_parent_class)->dispose (object);
+}
+
+static void
+gsignond_plugin_zygote_finalize (GObject *object)
+{
+    GSignondPluginZygote *self = GSIGNOND_PLUGIN_ZYGOTE (object);
+
+    g_free (self->priv->loader_path);
+
+    G_OBJECT_CLASS (gsignond_plugin_zygote_parent_class)->finalize (object);
+}
+
+static void
+gsignond_plugin_zygote_class_init (GSignondPluginZygoteClass *klass)
+{
+    GObjectClass* object_class = G_OBJECT_CLASS (klass);
+
+    g_type_class_add_private (object_class,
+            sizeof (GSignondPluginZygotePrivate));
+
+    object_class->get_property = gsignond_plugin_zygote_get_property;
+    object_class->set_property = gsignond_plugin_zygote_set_property;
+    object_class->dispose = gsignond_plugin_zygote_dispose;
+    object_class->finalize = gsignond_plugin_zygote_finalize;
+
+    properties[PROP_LOADER_PATH] = g_param_spec_string ("loaderpath",
+            "Path to loader",
+            "Path to the plugin loader to run as zygote",
+            NULL,
+            G_PARAM_CONSTRUCT_ONLY | G_PARAM_READWRITE |
+            G_PARAM_STATIC_STRINGS);
+
+    g_object_class_install_properties (object_class, N_PROPERTIES,
+                                       properties);
+}
+
+static void
+gsignond_plugin_zygote_init (GSignondPluginZygote *self)
+{
+    self->priv = GSIGNOND_PLUGIN_ZYGOTE_GET_PRIV (self);
+
+    self->priv->loader_path = NULL;
+    self->priv->pid = 0;
+    self->priv->child_watch_id = 0;
+    self->priv->control_fd = -1;
+}
+
+/**
+ * gsignond_plugin_zygote_new:
+ * @loader_path: path of a plugin loader supporting the --zygote option
+ *
+ * Returns: (transfer full): a new #GSignondPluginZygote. The zygote
+ * process is started on the first fork request.
+ */
+GSignondPluginZygote *
+gsignond_plugin_zygote_new (
+        const gchar *loader_path)
+{
+    g_return_val_if_fail (loader_path != NULL, NULL);
+
+    return GSIGNOND_PLUGIN_ZYGOTE (g_object_new (
+            GSIGNOND_TYPE_PLUGIN_ZYGOTE,
+            "loaderpath", loader_path,
+            NULL));
+}
+
+const gchar *
+gsignond_plugin_zygote_get_loader_path (
+        GSignondPluginZygote *self)
+{
+    g_return_val_if_fail (self && GSIGNOND_IS_PLUGIN_ZYGOTE (self), NULL);
+
+    return self->priv->loader_path;
+}
+
+/* has the zygote fork a loader on the given stdin and stdout descriptors,
+ * which are closed here */
+static gboolean
+_fork_loader (
+        GSignondPluginZygote *self,
+        const gchar *option,
+        gint loader_in,
+        gint loader_out,
+        GPid *pid,
+        GError **error)
+{
+    gboolean ret;
+
+    ret = _send_request (self->priv->control_fd, option, loader_in,
+                         loader_out) &&
+          _receive_pid (self->priv->control_fd, pid);
+    close (loader_in);
+    if (loader_out != loader_in)
+        close (loader_out);
+
+    if (!ret) {
+        g_set_error (error, GSIGNOND_ERROR, GSIGNOND_ERROR_INTERNAL_SERVER,
+                     "Zygote failed to fork loader for %s", option);
+        /* a stuck zygote would leave replies out of order, restart it */
+        if (self->priv->pid > 0)
+            kill (self->priv->pid, SIGTERM);
+        _stop_zygote (self);
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+/**
+ * gsignond_plugin_zygote_fork:
+ * @self: a #GSignondPluginZygote
+ * @option: the command line option the forked loader acts on, either
+ * --load-plugin=name or --standby
+ * @pid: (out): the process id of the forked loader
+ * @in_fd: (out): the descriptor to write to the loader's standard input
+ * @out_fd: (out): the descriptor to read the loader's standard output
+ * @error: return location for error
+ *
+ * Has the zygote fork a loader process, which the caller becomes
+ * responsible for reaping, like with g_spawn_async_with_pipes(). The
+ * zygote is (re)started if it is not running.
+ *
+ * Returns: TRUE if a loader was forked, FALSE otherwise.
+ */
+gboolean
+gsignond_plugin_zygote_fork (
+        GSignondPluginZygote *self,
+        const gchar *option,
+        GPid *pid,
+        gint *in_fd,
+        gint *out_fd,
+        GError **error)
+{
+    g_return_val_if_fail (self && GSIGNOND_IS_PLUGIN_ZYGOTE (self), FALSE);
+    g_return_val_if_fail (option && pid && in_fd && out_fd, FALSE);
+
+    gint to_loader[2], from_loader[2];
+
+    if (self->priv->control_fd < 0 && !_start_zygote (self, error))
+        return FALSE;
+
+    if (!g_unix_open_pipe (to_loader, FD_CLOEXEC, error))
+        return FALSE;
+    if (!g_unix_open_pipe (from_loader, FD_CLOEXEC, error)) {
+        close (to_loader[0]);
+        close (to_loader[1]);
+        return FALSE;
+    }
+
+    if (!_fork_loader (self, option, to_loader[0], from_loader[1], pid,
+                       error)) {
+        close (to_loader[1]);
+        close (from_loader[0]);
+        return FALSE;
+    }
+
+    *in_fd = to_loader[1];
+    *out_fd = from_loader[0];
+    return TRUE;
+}
+
+/**
+ * gsignond_plugin_zygote_fork_socket:
+ * @self: a #GSignondPluginZygote
+ * @option: the command line options the forked loader acts on
+ * @pid: (out): the process id of the forked loader
+ * @fd: (out): the end of a unix socket pair whose other end is the
+ * loader's standard input and output
+ * @error: return location for error
+ *
+ * Like gsignond_plugin_zygote_fork(), but connects the loader with a unix
+ * stream socket instead of two pipes, for loaders that pass descriptors.
+ *
+ * Returns: TRUE if a loader was forked, FALSE otherwise.
+ */
+gboolean
+gsignond_plugin_zygote_fork_socket (
+        GSignondPluginZygote *self,
+        const gchar *option,
+        GPid *pid,
+        gint *fd,
+        GError **error)
+{
+    g_return_val_if_fail (self && GSIGNOND_IS_PLUGIN_ZYGOTE (self), FALSE);
+    g_return_val_if_fail (option && pid && fd, FALSE);
+
+    gint sv[2];
+
+    if (self->priv->control_fd < 0 && !_start_zygote (self, error))
+        return FALSE;
+
+    if (socketpair (AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sv) != 0) {
+        g_set_error (error, GSIGNOND_ERROR, GSIGNOND_ERROR_INTERNAL_SERVER,
+                     "Failed to create socket pair: %s", strerror (errno));
+        return FALSE;
+    }
+
+    if (!_fork_loader (self, option, sv[1], sv[1], pid, error)) {
+        close (sv[0]);
+        return FALSE;
+    }
+
+    *fd = sv[0];
+    return TRUE;
+}
@@ -0,0 +1,95 @@
+/* vi: set et sw=4 ts=4 cino=t0,(0: */
+/* -*- Mode: C; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This file is part of gsignond
+ *
+ * Copyright (C) 2013 Intel Corporation.
+ *
+ * Contact: Imran Zaman <imran.zaman@intel.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ */
+
+#ifndef __GSIGNOND_PLUGIN_ZYGOTE_H_
+#define __GSIGNOND_PLUGIN_ZYGOTE_H_
+
+#include <glib-object.h>
+
+G_BEGIN_DECLS
+
+#define GSIGNOND_TYPE_PLUGIN_ZYGOTE \
+    (gsignond_plugin_zygote_get_type())
+#define GSIGNOND_PLUGIN_ZYGOTE(obj)  (G_TYPE_CHECK_INSTANCE_CAST((obj),\
+    GSIGNOND_TYPE_PLUGIN_ZYGOTE, GSignondPluginZygote))
+#define GSIGNOND_PLUGIN_ZYGOTE_CLASS(klass)\
+    (G_TYPE_CHECK_CLASS_CAST((klass), GSIGNOND_TYPE_PLUGIN_ZYGOTE, \
+    GSignondPluginZygoteClass))
+#define GSIGNOND_IS_PLUGIN_ZYGOTE(obj)         \
+    (G_TYPE_CHECK_INSTANCE_TYPE((obj), GSIGNOND_TYPE_PLUGIN_ZYGOTE))
+#define GSIGNOND_IS_PLUGIN_ZYGOTE_CLASS(klass) \
+    (G_TYPE_CHECK_CLASS_TYPE((klass), GSIGNOND_TYPE_PLUGIN_ZYGOTE))
+#define GSIGNOND_PLUGIN_ZYGOTE_GET_CLASS(obj)  \
+    (G_TYPE_INSTANCE_GET_CLASS((obj), GSIGNOND_TYPE_PLUGIN_ZYGOTE, \
+    GSignondPluginZygoteClass))
+
+typedef struct _GSignondPluginZygote GSignondPluginZygote;
+typedef struct _GSignondPluginZygoteClass GSignondPluginZygoteClass;
+typedef struct _GSignondPluginZygotePrivate GSignondPluginZygotePrivate;
+
+struct _GSignondPluginZygote
+{
+    GObject parent;
+
+    /* priv */
+    GSignondPluginZygotePrivate *priv;
+};
+
+struct _GSignondPluginZygoteClass
+{
+    GObjectClass parent_class;
+};
+
+GType
+gsignond_plugin_zygote_get_type (void) G_GNUC_CONST;
+
+GSignondPluginZygote *
+gsignond_plugin_zygote_new (
+        const gchar *loader_path);
+
+const gchar *
+gsignond_plugin_zygote_get_loader_path (
+        GSignondPluginZygote *self);
+
+gboolean
+gsignond_plugin_zygote_fork (
+        GSignondPluginZygote *self,
+        const gchar *option,
+        GPid *pid,
+        gint *in_fd,
+        gint *out_fd,
+        GError **error);
+
+gboolean
+gsignond_plugin_zygote_fork_socket (
+        GSignondPluginZygote *self,
+        const gchar *option,
+        GPid *pid,
+        gint *fd,
+        GError **error);
+
+G_END_DECLS
+
+#endif /* __GSIGNOND_PLUGIN_ZYGOTE_H_ */
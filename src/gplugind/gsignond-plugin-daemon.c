@@ -23,11 +23,16 @@
  * 02110-1301 USA
  */
 
+#include <string.h>
+#include <unistd.h>
+#include <gmodule.h>
+
 #include "gsignond/gsignond-plugin-interface.h"
 #include "gsignond/gsignond-log.h"
 #include "gsignond/gsignond-error.h"
 #include "gsignond-plugin-loader.h"
 #include "common/gsignond-pipe-stream.h"
+#include "common/gsignond-frame-channel.h"
 #include "daemon/dbus/gsignond-dbus-remote-plugin-gen.h"
 #include "daemon/dbus/gsignond-dbus.h"
 #include "gsignond-plugin-daemon.h"
@@ -36,10 +41,28 @@ struct _GSignondPluginDaemonPrivate
 {
     GDBusConnection   *connection;
     GSignondDbusRemotePluginV1 *dbus_remote_plugin;
+    GSignondDbusRemotePluginV2 *dbus_remote_plugin_v2;
+    GSignondDbusRemotePluginLoader *dbus_remote_plugin_loader;
+    gchar *plugin_dir;
+    gchar *object_path; /* NULL for GSIGNOND_PLUGIN_OBJECTPATH */
     GSignondPlugin *plugin;
     gchar *plugin_type;
+    GHashTable *sessions; /* handle -> _PluginSession */
+    guint last_session;
+    /* plugin type -> GSignondPluginDaemon exported on the same connection */
+    GHashTable *hosted;
+    /* set instead of the connection for the framed transport */
+    GSignondFrameChannel *channel;
+    guint32 request_id; /* of the request being served */
 };
 
+/* A plugin instance serving one V2 session */
+typedef struct {
+    GSignondPluginDaemon *daemon; /* not owned */
+    guint handle;
+    GSignondPlugin *plugin;
+} _PluginSession;
+
 G_DEFINE_TYPE (GSignondPluginDaemon, gsignond_plugin_daemon, G_TYPE_OBJECT)
 
 
@@ -47,11 +70,44 @@ G_DEFINE_TYPE (GSignondPluginDaemon, gsignond_plugin_daemon, G_TYPE_OBJECT)
     G_TYPE_INSTANCE_GET_PRIVATE ((obj), GSIGNOND_TYPE_PLUGIN_DAEMON,\
             GSignondPluginDaemonPrivate)
 
+static void
+_plugin_session_free (_PluginSession *session)
+{
+    g_signal_handlers_disconnect_matched (session->plugin, G_SIGNAL_MATCH_DATA,
+            0, 0, NULL, NULL, session);
+    g_object_unref (session->plugin);
+    g_slice_free (_PluginSession, session);
+}
+
 static void
 _dispose (GObject *object)
 {
     GSignondPluginDaemon *self = GSIGNOND_PLUGIN_DAEMON (object);
 
+    if (self->priv->hosted) {
+        g_hash_table_unref (self->priv->hosted);
+        self->priv->hosted = NULL;
+    }
+
+    if (self->priv->sessions) {
+        g_hash_table_unref (self->priv->sessions);
+        self->priv->sessions = NULL;
+    }
+
+    if (self->priv->dbus_remote_plugin_loader) {
+        g_dbus_interface_skeleton_unexport (G_DBUS_INTERFACE_SKELETON (
+                self->priv->dbus_remote_plugin_loader));
+        g_object_unref (self->priv->dbus_remote_plugin_loader);
+        self->priv->dbus_remote_plugin_loader = NULL;
+    }
+
+    if (self->priv->dbus_remote_plugin_v2) {
+        g_dbus_interface_skeleton_unexport (G_DBUS_INTERFACE_SKELETON (
+                self->priv->dbus_remote_plugin_v2));
+        g_object_unref (self->priv->dbus_remote_plugin_v2);
+        self->priv->dbus_remote_plugin_v2 = NULL;
+    }
+
     if (self->priv->dbus_remote_plugin) {
         g_dbus_interface_skeleton_unexport (G_DBUS_INTERFACE_SKELETON (
                 self->priv->dbus_remote_plugin));
@@ -64,6 +120,13 @@ _dispose (GObject *object)
         self->priv->connection = NULL;
     }
 
+    if (self->priv->channel) {
+        g_signal_handlers_disconnect_matched (self->priv->channel,
+                G_SIGNAL_MATCH_DATA, 0, 0, NULL, NULL, self);
+        g_object_unref (self->priv->channel);
+        self->priv->channel = NULL;
+    }
+
     if (self->priv->plugin) {
         g_object_unref (self->priv->plugin);
         self->priv->plugin = NULL;
@@ -82,6 +145,16 @@ _finalize (GObject *object)
         self->priv->plugin_type = NULL;
     }
 
+    if (self->priv->plugin_dir) {
+        g_free (self->priv->plugin_dir);
+        self->priv->plugin_dir = NULL;
+    }
+
+    if (self->priv->object_path) {
+        g_free (self->priv->object_path);
+        self->priv->object_path = NULL;
+    }
+
     G_OBJECT_CLASS (gsignond_plugin_daemon_parent_class)->finalize (object);
 }
 
@@ -106,8 +179,19 @@ gsignond_plugin_daemon_init (
     self->priv = GSIGNOND_PLUGIN_DAEMON_GET_PRIV(self);
     self->priv->connection = NULL;
     self->priv->dbus_remote_plugin = NULL;
+    self->priv->dbus_remote_plugin_v2 = NULL;
+    self->priv->dbus_remote_plugin_loader = NULL;
+    self->priv->plugin_dir = NULL;
+    self->priv->object_path = NULL;
     self->priv->plugin_type = NULL;
     self->priv->plugin = NULL;
+    self->priv->sessions = g_hash_table_new_full (g_direct_hash,
+            g_direct_equal, NULL, (GDestroyNotify) _plugin_session_free);
+    self->priv->last_session = 0;
+    self->priv->hosted = g_hash_table_new_full (g_str_hash, g_str_equal,
+            g_free, g_object_unref);
+    self->priv->channel = NULL;
+    self->priv->request_id = 0;
 }
 
 static void
@@ -370,39 +454,318 @@ _handle_status_changed_from_plugin (
             (const gchar *)message);
 }
 
-GSignondPluginDaemon *
-gsignond_plugin_daemon_new (
-        const gchar* filename,
-        const gchar* plugin_type,
-        gint in_fd,
-        gint out_fd)
+/* V2: the same plugin API, multiplexed over sessions */
+
+static void
+_session_response_from_plugin (
+        GSignondPlugin *plugin,
+        GSignondSessionData *session_data,
+        gpointer user_data)
 {
-    GError *error = NULL;
-    GSignondPipeStream *stream = NULL;
+    _PluginSession *session = (_PluginSession *) user_data;
 
-    g_return_val_if_fail (filename != NULL && plugin_type != NULL, NULL);
+    gsignond_dbus_remote_plugin_v2_emit_response (
+            session->daemon->priv->dbus_remote_plugin_v2, session->handle,
+            gsignond_dictionary_to_variant (session_data));
+}
 
-    GSignondPluginDaemon *daemon = GSIGNOND_PLUGIN_DAEMON (g_object_new (
-            GSIGNOND_TYPE_PLUGIN_DAEMON, NULL));
+static void
+_session_response_final_from_plugin (
+        GSignondPlugin *plugin,
+        GSignondSessionData *session_data,
+        gpointer user_data)
+{
+    _PluginSession *session = (_PluginSession *) user_data;
+
+    gsignond_dbus_remote_plugin_v2_emit_response_final (
+            session->daemon->priv->dbus_remote_plugin_v2, session->handle,
+            gsignond_dictionary_to_variant (session_data));
+}
+
+static void
+_session_store_from_plugin (
+        GSignondPlugin *plugin,
+        GSignondSessionData *session_data,
+        gpointer user_data)
+{
+    _PluginSession *session = (_PluginSession *) user_data;
+
+    gsignond_dbus_remote_plugin_v2_emit_store (
+            session->daemon->priv->dbus_remote_plugin_v2, session->handle,
+            gsignond_dictionary_to_variant (session_data));
+}
+
+static void
+_session_error_from_plugin (
+        GSignondPlugin *plugin,
+        GError *gerror,
+        gpointer user_data)
+{
+    _PluginSession *session = (_PluginSession *) user_data;
+
+    DBG ("session %u: %s", session->handle, gerror->message);
+    gsignond_dbus_remote_plugin_v2_emit_error (
+            session->daemon->priv->dbus_remote_plugin_v2, session->handle,
+            gsignond_error_to_variant (gerror));
+}
+
+static void
+_session_user_action_required_from_plugin (
+        GSignondPlugin *plugin,
+        GSignondSignonuiData *ui_data,
+        gpointer user_data)
+{
+    _PluginSession *session = (_PluginSession *) user_data;
+
+    gsignond_dbus_remote_plugin_v2_emit_user_action_required (
+            session->daemon->priv->dbus_remote_plugin_v2, session->handle,
+            gsignond_dictionary_to_variant (ui_data));
+}
+
+static void
+_session_refreshed_from_plugin (
+        GSignondPlugin *plugin,
+        GSignondSignonuiData *ui_data,
+        gpointer user_data)
+{
+    _PluginSession *session = (_PluginSession *) user_data;
+
+    gsignond_dbus_remote_plugin_v2_emit_refreshed (
+            session->daemon->priv->dbus_remote_plugin_v2, session->handle,
+            gsignond_dictionary_to_variant (ui_data));
+}
+
+static void
+_session_status_changed_from_plugin (
+        GSignondPlugin *plugin,
+        GSignondPluginState status,
+        gchar *message,
+        gpointer user_data)
+{
+    _PluginSession *session = (_PluginSession *) user_data;
+
+    DBG ("session %u: Status: %d Message: %s", session->handle, status,
+         message);
+    gsignond_dbus_remote_plugin_v2_emit_status_changed (
+            session->daemon->priv->dbus_remote_plugin_v2, session->handle,
+            (gint)status, (const gchar *)message);
+}
+
+static gboolean
+_handle_open_session_from_dbus (
+        GSignondPluginDaemon *self,
+        GDBusMethodInvocation *invocation,
+        gpointer user_data)
+{
+    g_return_val_if_fail (self && GSIGNOND_IS_PLUGIN_DAEMON (self), FALSE);
+
+    _PluginSession *session = g_slice_new0 (_PluginSession);
+    session->daemon = self;
+    session->handle = ++self->priv->last_session;
+    /* the module is resident already, only the instance is new */
+    session->plugin = GSIGNOND_PLUGIN (g_object_new (
+            G_OBJECT_TYPE (self->priv->plugin), NULL));
+
+    g_signal_connect (session->plugin, "response",
+            G_CALLBACK (_session_response_from_plugin), session);
+    g_signal_connect (session->plugin, "response-final",
+            G_CALLBACK (_session_response_final_from_plugin), session);
+    g_signal_connect (session->plugin, "store",
+            G_CALLBACK (_session_store_from_plugin), session);
+    g_signal_connect (session->plugin, "error",
+            G_CALLBACK (_session_error_from_plugin), session);
+    g_signal_connect (session->plugin, "user-action-required",
+            G_CALLBACK (_session_user_action_required_from_plugin), session);
+    g_signal_connect (session->plugin, "refreshed",
+            G_CALLBACK (_session_refreshed_from_plugin), session);
+    g_signal_connect (session->plugin, "status-changed",
+            G_CALLBACK (_session_status_changed_from_plugin), session);
+
+    g_hash_table_insert (self->priv->sessions,
+                         GUINT_TO_POINTER (session->handle), session);
+    DBG ("opened session %u, %u open", session->handle,
+         g_hash_table_size (self->priv->sessions));
+
+    gsignond_dbus_remote_plugin_v2_complete_open_session (
+            self->priv->dbus_remote_plugin_v2, invocation, session->handle);
+    return TRUE;
+}
+
+/* returns the plugin serving the session, or fails the invocation */
+static GSignondPlugin *
+_get_session_plugin (
+        GSignondPluginDaemon *self,
+        GDBusMethodInvocation *invocation,
+        guint handle)
+{
+    _PluginSession *session = g_hash_table_lookup (self->priv->sessions,
+                                                   GUINT_TO_POINTER (handle));
+    if (!session) {
+        g_dbus_method_invocation_return_error (invocation, GSIGNOND_ERROR,
+                GSIGNOND_ERROR_WRONG_STATE, "Unknown session %u", handle);
+        return NULL;
+    }
+    return session->plugin;
+}
+
+static gboolean
+_handle_close_session_from_dbus (
+        GSignondPluginDaemon *self,
+        GDBusMethodInvocation *invocation,
+        guint handle,
+        gpointer user_data)
+{
+    g_return_val_if_fail (self && GSIGNOND_IS_PLUGIN_DAEMON (self), FALSE);
+
+    if (!_get_session_plugin (self, invocation, handle))
+        return TRUE;
+
+    g_hash_table_remove (self->priv->sessions, GUINT_TO_POINTER (handle));
+    DBG ("closed session %u, %u open", handle,
+         g_hash_table_size (self->priv->sessions));
 
-    /* Load plugin */
+    gsignond_dbus_remote_plugin_v2_complete_close_session (
+            self->priv->dbus_remote_plugin_v2, invocation);
+    return TRUE;
+}
+
+static gboolean
+_handle_session_cancel_from_dbus (
+        GSignondPluginDaemon *self,
+        GDBusMethodInvocation *invocation,
+        guint handle,
+        gpointer user_data)
+{
+    g_return_val_if_fail (self && GSIGNOND_IS_PLUGIN_DAEMON (self), FALSE);
+
+    GSignondPlugin *plugin = _get_session_plugin (self, invocation, handle);
+    if (!plugin)
+        return TRUE;
+
+    gsignond_dbus_remote_plugin_v2_complete_cancel (
+            self->priv->dbus_remote_plugin_v2, invocation);
+    gsignond_plugin_cancel (plugin);
+    return TRUE;
+}
+
+static gboolean
+_handle_session_request_from_dbus (
+        GSignondPluginDaemon *self,
+        GDBusMethodInvocation *invocation,
+        guint handle,
+        GVariant *session_data,
+        gpointer user_data)
+{
+    g_return_val_if_fail (self && GSIGNOND_IS_PLUGIN_DAEMON (self), FALSE);
+
+    GSignondPlugin *plugin = _get_session_plugin (self, invocation, handle);
+    if (!plugin)
+        return TRUE;
+
+    gsignond_dbus_remote_plugin_v2_complete_request (
+            self->priv->dbus_remote_plugin_v2, invocation);
+
+    GSignondSessionData *data = (GSignondSessionData *)
+            gsignond_dictionary_new_from_variant (session_data);
+    gsignond_plugin_request (plugin, data);
+    gsignond_dictionary_unref (data);
+    return TRUE;
+}
+
+static gboolean
+_handle_session_request_initial_from_dbus (
+        GSignondPluginDaemon *self,
+        GDBusMethodInvocation *invocation,
+        guint handle,
+        GVariant *session_data,
+        GVariant *identity_method_cache,
+        const gchar *mechanism,
+        gpointer user_data)
+{
+    g_return_val_if_fail (self && GSIGNOND_IS_PLUGIN_DAEMON (self), FALSE);
+
+    GSignondPlugin *plugin = _get_session_plugin (self, invocation, handle);
+    if (!plugin)
+        return TRUE;
+
+    gsignond_dbus_remote_plugin_v2_complete_request_initial (
+            self->priv->dbus_remote_plugin_v2, invocation);
+
+    DBG ("session %u, mechanism: %s", handle, mechanism);
+    GSignondSessionData *data = (GSignondSessionData *)
+            gsignond_dictionary_new_from_variant (session_data);
+    GSignondSessionData *cache =
+            gsignond_dictionary_new_from_variant (identity_method_cache);
+    gsignond_plugin_request_initial (plugin, data, cache, mechanism);
+    gsignond_dictionary_unref (data);
+    gsignond_dictionary_unref (cache);
+    return TRUE;
+}
+
+static gboolean
+_handle_session_user_action_finished_from_dbus (
+        GSignondPluginDaemon *self,
+        GDBusMethodInvocation *invocation,
+        guint handle,
+        GVariant *ui_data,
+        gpointer user_data)
+{
+    g_return_val_if_fail (self && GSIGNOND_IS_PLUGIN_DAEMON (self), FALSE);
+
+    GSignondPlugin *plugin = _get_session_plugin (self, invocation, handle);
+    if (!plugin)
+        return TRUE;
+
+    gsignond_dbus_remote_plugin_v2_complete_user_action_finished (
+            self->priv->dbus_remote_plugin_v2, invocation);
+
+    GSignondSignonuiData *data = (GSignondSignonuiData *)
+            gsignond_dictionary_new_from_variant (ui_data);
+    gsignond_plugin_user_action_finished (plugin, data);
+    gsignond_dictionary_unref (data);
+    return TRUE;
+}
+
+static gboolean
+_handle_session_refresh_from_dbus (
+        GSignondPluginDaemon *self,
+        GDBusMethodInvocation *invocation,
+        guint handle,
+        GVariant *ui_data,
+        gpointer user_data)
+{
+    g_return_val_if_fail (self && GSIGNOND_IS_PLUGIN_DAEMON (self), FALSE);
+
+    GSignondPlugin *plugin = _get_session_plugin (self, invocation, handle);
+    if (!plugin)
+        return TRUE;
+
+    gsignond_dbus_remote_plugin_v2_complete_refresh (
+            self->priv->dbus_remote_plugin_v2, invocation);
+
+    GSignondSignonuiData *data = (GSignondSignonuiData *)
+            gsignond_dictionary_new_from_variant (ui_data);
+    gsignond_plugin_refresh (plugin, data);
+    gsignond_dictionary_unref (data);
+    return TRUE;
+}
+
+/* loads the plugin and creates the dbus objects for it */
+static gboolean
+_load_plugin (
+        GSignondPluginDaemon *daemon,
+        const gchar* filename,
+        const gchar* plugin_type)
+{
     daemon->priv->plugin = gsignond_load_plugin_with_filename (plugin_type,
                                                                filename);
     if (!daemon->priv->plugin) {
         DBG ("failed to load plugin");
-        g_object_unref (daemon);
-        return NULL;
+        return FALSE;
     }
 
     daemon->priv->plugin_type = g_strdup (plugin_type);
 
-    /* Create dbus connection */
-    stream = gsignond_pipe_stream_new (in_fd, out_fd, TRUE);
-    daemon->priv->connection = g_dbus_connection_new_sync (G_IO_STREAM (stream),
-            NULL, G_DBUS_CONNECTION_FLAGS_DELAY_MESSAGE_PROCESSING, NULL, NULL,
-            NULL);
-    g_object_unref (stream);
-
     /* Create dbus object */
     daemon->priv->dbus_remote_plugin =
             gsignond_dbus_remote_plugin_v1_skeleton_new ();
@@ -437,8 +800,32 @@ gsignond_plugin_daemon_new (
     g_signal_connect_swapped (daemon->priv->plugin, "status-changed",
             G_CALLBACK(_handle_status_changed_from_plugin), daemon);
 
-    g_signal_connect (daemon->priv->connection, "closed",
-            G_CALLBACK(_on_connection_closed), daemon);
+    /* Create V2 dbus object */
+    daemon->priv->dbus_remote_plugin_v2 =
+            gsignond_dbus_remote_plugin_v2_skeleton_new ();
+
+    g_signal_connect_swapped (daemon->priv->dbus_remote_plugin_v2,
+            "handle-open-session",
+            G_CALLBACK (_handle_open_session_from_dbus), daemon);
+    g_signal_connect_swapped (daemon->priv->dbus_remote_plugin_v2,
+            "handle-close-session",
+            G_CALLBACK (_handle_close_session_from_dbus), daemon);
+    g_signal_connect_swapped (daemon->priv->dbus_remote_plugin_v2,
+            "handle-cancel",
+            G_CALLBACK (_handle_session_cancel_from_dbus), daemon);
+    g_signal_connect_swapped (daemon->priv->dbus_remote_plugin_v2,
+            "handle-request",
+            G_CALLBACK (_handle_session_request_from_dbus), daemon);
+    g_signal_connect_swapped (daemon->priv->dbus_remote_plugin_v2,
+            "handle-request-initial",
+            G_CALLBACK (_handle_session_request_initial_from_dbus), daemon);
+    g_signal_connect_swapped (daemon->priv->dbus_remote_plugin_v2,
+            "handle-user-action-finished",
+            G_CALLBACK (_handle_session_user_action_finished_from_dbus),
+            daemon);
+    g_signal_connect_swapped (daemon->priv->dbus_remote_plugin_v2,
+            "handle-refresh",
+            G_CALLBACK (_handle_session_refresh_from_dbus), daemon);
 
     /* Set DBus properties */
     gchar* type;
@@ -447,24 +834,511 @@ gsignond_plugin_daemon_new (
     g_object_get(daemon->priv->plugin, "type", &type, "mechanisms", &mechanisms, NULL);
     gsignond_dbus_remote_plugin_v1_set_method(daemon->priv->dbus_remote_plugin, type);
     gsignond_dbus_remote_plugin_v1_set_mechanisms(daemon->priv->dbus_remote_plugin, (const gchar* const*) mechanisms);
+    gsignond_dbus_remote_plugin_v2_set_method(daemon->priv->dbus_remote_plugin_v2, type);
+    gsignond_dbus_remote_plugin_v2_set_mechanisms(daemon->priv->dbus_remote_plugin_v2, (const gchar* const*) mechanisms);
 
     g_free(type);
     g_strfreev(mechanisms);
 
+    return TRUE;
+}
+
+static gboolean
+_export_plugin (GSignondPluginDaemon *daemon)
+{
+    GError *error = NULL;
+    const gchar *path = daemon->priv->object_path ?
+            daemon->priv->object_path : GSIGNOND_PLUGIN_OBJECTPATH;
+
     g_dbus_interface_skeleton_export (
                 G_DBUS_INTERFACE_SKELETON(daemon->priv->dbus_remote_plugin),
-                daemon->priv->connection, GSIGNOND_PLUGIN_OBJECTPATH, &error);
+                daemon->priv->connection, path, &error);
     if (error) {
         DBG ("failed to register object: %s", error->message);
         g_error_free (error);
-        g_object_unref (daemon);
-        return NULL;
+        return FALSE;
+    }
+    g_dbus_interface_skeleton_export (
+                G_DBUS_INTERFACE_SKELETON(daemon->priv->dbus_remote_plugin_v2),
+                daemon->priv->connection, path, &error);
+    if (error) {
+        DBG ("failed to register V2 object: %s", error->message);
+        g_error_free (error);
+        return FALSE;
     }
     DBG("Started plugin daemon '%p' at path '%s' on conneciton '%p'",
-            daemon, GSIGNOND_PLUGIN_OBJECTPATH, daemon->priv->connection);
+            daemon, path, daemon->priv->connection);
+
+    return TRUE;
+}
+
+static gboolean
+_handle_load_plugin_from_dbus (
+        GSignondPluginDaemon *self,
+        GDBusMethodInvocation *invocation,
+        const gchar *plugin_type,
+        gpointer user_data)
+{
+    g_return_val_if_fail (self && GSIGNOND_IS_PLUGIN_DAEMON (self), FALSE);
+
+    gchar *filename = NULL;
+
+    if (self->priv->plugin) {
+        g_dbus_method_invocation_return_error (invocation, GSIGNOND_ERROR,
+                GSIGNOND_ERROR_WRONG_STATE, "Plugin %s is loaded already",
+                self->priv->plugin_type);
+        return TRUE;
+    }
+    if (!plugin_type || !*plugin_type || strchr (plugin_type, '/')) {
+        g_dbus_method_invocation_return_error (invocation, GSIGNOND_ERROR,
+                GSIGNOND_ERROR_METHOD_NOT_AVAILABLE, "Invalid plugin name");
+        return TRUE;
+    }
+
+    filename = g_module_build_path (self->priv->plugin_dir, plugin_type);
+    if (!_load_plugin (self, filename, plugin_type) ||
+        !_export_plugin (self)) {
+        g_dbus_method_invocation_return_error (invocation, GSIGNOND_ERROR,
+                GSIGNOND_ERROR_METHOD_NOT_AVAILABLE,
+                "Plugin %s could not be loaded", plugin_type);
+    } else {
+        gsignond_dbus_remote_plugin_loader_complete_load_plugin (
+                self->priv->dbus_remote_plugin_loader, invocation);
+    }
+    g_free (filename);
+    return TRUE;
+}
+
+/* builds the object path of a hosted plugin, escaping the characters that
+ * are not allowed in object paths as _xx */
+static gchar *
+_build_object_path (const gchar *plugin_type)
+{
+    GString *path = g_string_new (GSIGNOND_PLUGIN_OBJECTPATH);
+    const gchar *c;
+
+    for (c = plugin_type; *c; c++) {
+        if (g_ascii_isalnum (*c))
+            g_string_append_c (path, *c);
+        else
+            g_string_append_printf (path, "_%02x", (guchar) *c);
+    }
+    return g_string_free (path, FALSE);
+}
+
+static gboolean
+_handle_export_plugin_from_dbus (
+        GSignondPluginDaemon *self,
+        GDBusMethodInvocation *invocation,
+        const gchar *plugin_type,
+        gpointer user_data)
+{
+    g_return_val_if_fail (self && GSIGNOND_IS_PLUGIN_DAEMON (self), FALSE);
+
+    GSignondPluginDaemon *hosted = NULL;
+    gchar *filename = NULL;
+
+    if (!plugin_type || !*plugin_type || strchr (plugin_type, '/')) {
+        g_dbus_method_invocation_return_error (invocation, GSIGNOND_ERROR,
+                GSIGNOND_ERROR_METHOD_NOT_AVAILABLE, "Invalid plugin name");
+        return TRUE;
+    }
+
+    if (g_strcmp0 (plugin_type, self->priv->plugin_type) == 0) {
+        gsignond_dbus_remote_plugin_loader_complete_export_plugin (
+                self->priv->dbus_remote_plugin_loader, invocation,
+                GSIGNOND_PLUGIN_OBJECTPATH);
+        return TRUE;
+    }
+
+    hosted = g_hash_table_lookup (self->priv->hosted, plugin_type);
+    if (!hosted) {
+        /* the hosted plugin shares the connection, which stays with this
+         * daemon */
+        hosted = GSIGNOND_PLUGIN_DAEMON (g_object_new (
+                GSIGNOND_TYPE_PLUGIN_DAEMON, NULL));
+        hosted->priv->connection = g_object_ref (self->priv->connection);
+        hosted->priv->object_path = _build_object_path (plugin_type);
+
+        filename = g_module_build_path (self->priv->plugin_dir, plugin_type);
+        if (!_load_plugin (hosted, filename, plugin_type) ||
+            !_export_plugin (hosted)) {
+            g_dbus_method_invocation_return_error (invocation,
+                    GSIGNOND_ERROR, GSIGNOND_ERROR_METHOD_NOT_AVAILABLE,
+                    "Plugin %s could not be loaded", plugin_type);
+            g_object_unref (hosted);
+            g_free (filename);
+            return TRUE;
+        }
+        g_free (filename);
+
+        g_hash_table_insert (self->priv->hosted, g_strdup (plugin_type),
+                             hosted);
+        DBG ("hosting plugin %s, %u hosted", plugin_type,
+             g_hash_table_size (self->priv->hosted));
+    }
+
+    gsignond_dbus_remote_plugin_loader_complete_export_plugin (
+            self->priv->dbus_remote_plugin_loader, invocation,
+            hosted->priv->object_path);
+    return TRUE;
+}
+
+static gboolean
+_export_loader (GSignondPluginDaemon *daemon)
+{
+    GError *error = NULL;
+
+    daemon->priv->dbus_remote_plugin_loader =
+            gsignond_dbus_remote_plugin_loader_skeleton_new ();
+    g_signal_connect_swapped (daemon->priv->dbus_remote_plugin_loader,
+            "handle-load-plugin",
+            G_CALLBACK (_handle_load_plugin_from_dbus), daemon);
+    g_signal_connect_swapped (daemon->priv->dbus_remote_plugin_loader,
+            "handle-export-plugin",
+            G_CALLBACK (_handle_export_plugin_from_dbus), daemon);
+
+    g_dbus_interface_skeleton_export (
+                G_DBUS_INTERFACE_SKELETON(daemon->priv->dbus_remote_plugin_loader),
+                daemon->priv->connection, GSIGNOND_PLUGIN_OBJECTPATH, &error);
+    if (error) {
+        DBG ("failed to register loader object: %s", error->message);
+        g_error_free (error);
+        return FALSE;
+    }
+    return TRUE;
+}
+
+/* creates the dbus connection on the given streams, messages are processed
+ * once the objects are exported and _start_processing() is called */
+static void
+_open_connection (
+        GSignondPluginDaemon *daemon,
+        gint in_fd,
+        gint out_fd)
+{
+    GSignondPipeStream *stream = NULL;
+
+    stream = gsignond_pipe_stream_new (in_fd, out_fd, TRUE);
+    daemon->priv->connection = g_dbus_connection_new_sync (G_IO_STREAM (stream),
+            NULL, G_DBUS_CONNECTION_FLAGS_DELAY_MESSAGE_PROCESSING, NULL, NULL,
+            NULL);
+    g_object_unref (stream);
+}
+
+static void
+_start_processing (GSignondPluginDaemon *daemon)
+{
+    g_signal_connect (daemon->priv->connection, "closed",
+            G_CALLBACK(_on_connection_closed), daemon);
 
     g_dbus_connection_start_message_processing (daemon->priv->connection);
+}
+
+/* Framed transport: the plugin API as frames on the stdio channel */
+
+static void
+_send_frame (
+        GSignondPluginDaemon *self,
+        GSignondFrameOpcode opcode,
+        GVariant *payload)
+{
+    gsignond_frame_channel_send (self->priv->channel, self->priv->request_id,
+                                 opcode, payload);
+}
+
+static void
+_frame_response_from_plugin (
+        GSignondPluginDaemon *self,
+        GSignondSessionData *session_data,
+        gpointer user_data)
+{
+    _send_frame (self, GSIGNOND_FRAME_OP_RESPONSE,
+                 gsignond_dictionary_to_variant (session_data));
+}
+
+static void
+_frame_response_final_from_plugin (
+        GSignondPluginDaemon *self,
+        GSignondSessionData *session_data,
+        gpointer user_data)
+{
+    _send_frame (self, GSIGNOND_FRAME_OP_RESPONSE_FINAL,
+                 gsignond_dictionary_to_variant (session_data));
+}
+
+static void
+_frame_store_from_plugin (
+        GSignondPluginDaemon *self,
+        GSignondSessionData *session_data,
+        gpointer user_data)
+{
+    _send_frame (self, GSIGNOND_FRAME_OP_STORE,
+                 gsignond_dictionary_to_variant (session_data));
+}
+
+static void
+_frame_error_from_plugin (
+        GSignondPluginDaemon *self,
+        GError *gerror,
+        gpointer user_data)
+{
+    _send_frame (self, GSIGNOND_FRAME_OP_ERROR,
+                 gsignond_error_to_variant (gerror));
+}
+
+static void
+_frame_user_action_required_from_plugin (
+        GSignondPluginDaemon *self,
+        GSignondSignonuiData *ui_data,
+        gpointer user_data)
+{
+    _send_frame (self, GSIGNOND_FRAME_OP_USER_ACTION_REQUIRED,
+                 gsignond_dictionary_to_variant (ui_data));
+}
+
+static void
+_frame_refreshed_from_plugin (
+        GSignondPluginDaemon *self,
+        GSignondSignonuiData *ui_data,
+        gpointer user_data)
+{
+    _send_frame (self, GSIGNOND_FRAME_OP_REFRESHED,
+                 gsignond_dictionary_to_variant (ui_data));
+}
+
+static void
+_frame_status_changed_from_plugin (
+        GSignondPluginDaemon *self,
+        GSignondPluginState status,
+        gchar *message,
+        gpointer user_data)
+{
+    _send_frame (self, GSIGNOND_FRAME_OP_STATUS_CHANGED,
+                 g_variant_new ("(is)", (gint)status, message ? message : ""));
+}
+
+static void
+_handle_frame (
+        GSignondPluginDaemon *self,
+        guint id,
+        guint opcode,
+        GVariant *payload,
+        gpointer user_data)
+{
+    GSignondPlugin *plugin = self->priv->plugin;
+    GVariant *data_var = NULL, *cache_var = NULL;
+    const gchar *mechanism = NULL;
+    GSignondDictionary *data, *cache;
+    GError *error = NULL;
+
+    self->priv->request_id = id;
+
+    switch (opcode) {
+        case GSIGNOND_FRAME_OP_CANCEL:
+            gsignond_plugin_cancel (plugin);
+            return;
+        case GSIGNOND_FRAME_OP_REQUEST_INITIAL:
+            if (!payload || !g_variant_is_of_type (payload,
+                        G_VARIANT_TYPE ("(a{sv}a{sv}s)")))
+                break;
+            g_variant_get (payload, "(@a{sv}@a{sv}&s)", &data_var,
+                           &cache_var, &mechanism);
+            DBG ("request %u, mechanism: %s", id, mechanism);
+            data = gsignond_dictionary_new_from_variant (data_var);
+            cache = gsignond_dictionary_new_from_variant (cache_var);
+            gsignond_plugin_request_initial (plugin, data, cache, mechanism);
+            gsignond_dictionary_unref (data);
+            gsignond_dictionary_unref (cache);
+            g_variant_unref (data_var);
+            g_variant_unref (cache_var);
+            return;
+        case GSIGNOND_FRAME_OP_REQUEST:
+        case GSIGNOND_FRAME_OP_USER_ACTION_FINISHED:
+        case GSIGNOND_FRAME_OP_REFRESH:
+            if (!payload || !g_variant_is_of_type (payload,
+                        G_VARIANT_TYPE_VARDICT))
+                break;
+            data = gsignond_dictionary_new_from_variant (payload);
+            if (opcode == GSIGNOND_FRAME_OP_REQUEST)
+                gsignond_plugin_request (plugin, data);
+            else if (opcode == GSIGNOND_FRAME_OP_USER_ACTION_FINISHED)
+                gsignond_plugin_user_action_finished (plugin, data);
+            else
+                gsignond_plugin_refresh (plugin, data);
+            gsignond_dictionary_unref (data);
+            return;
+        default:
+            break;
+    }
+
+    DBG ("invalid request %u with opcode %u", id, opcode);
+    error = g_error_new (GSIGNOND_ERROR, GSIGNOND_ERROR_INTERNAL_COMMUNICATION,
+                         "Invalid request with opcode %u", opcode);
+    _frame_error_from_plugin (self, error, NULL);
+    g_error_free (error);
+}
+
+static void
+_on_channel_closed (
+        GSignondPluginDaemon *self,
+        gpointer user_data)
+{
+    DBG ("frame channel(%p) closed", self->priv->channel);
+    g_signal_handlers_disconnect_by_func (self->priv->channel,
+            _on_channel_closed, user_data);
+    g_object_unref (self);
+}
+
+GSignondPluginDaemon *
+gsignond_plugin_daemon_new (
+        const gchar* filename,
+        const gchar* plugin_type,
+        gint in_fd,
+        gint out_fd)
+{
+    g_return_val_if_fail (filename != NULL && plugin_type != NULL, NULL);
+
+    GSignondPluginDaemon *daemon = GSIGNOND_PLUGIN_DAEMON (g_object_new (
+            GSIGNOND_TYPE_PLUGIN_DAEMON, NULL));
+
+    if (!_load_plugin (daemon, filename, plugin_type)) {
+        g_object_unref (daemon);
+        return NULL;
+    }
+
+    daemon->priv->plugin_dir = g_path_get_dirname (filename);
+
+    _open_connection (daemon, in_fd, out_fd);
+
+    /* the loader interface hosts further plugins on request */
+    if (!_export_plugin (daemon) || !_export_loader (daemon)) {
+        g_object_unref (daemon);
+        return NULL;
+    }
+
+    _start_processing (daemon);
 
     return daemon;
 }
 
+/**
+ * gsignond_plugin_daemon_new_framed:
+ * @filename: path of the GLib plugin
+ * @plugin_type: type of the plugin
+ * @in_fd: unix stream socket connected to gsignond
+ * @out_fd: the same socket as @in_fd, or a duplicate of it
+ *
+ * Loads the plugin and serves it with the framed transport of
+ * #GSignondFrameChannel instead of D-Bus. The plugin type and mechanisms are
+ * announced with a first frame once the plugin is loaded.
+ *
+ * Returns: the plugin daemon, or NULL on error.
+ */
+GSignondPluginDaemon *
+gsignond_plugin_daemon_new_framed (
+        const gchar* filename,
+        const gchar* plugin_type,
+        gint in_fd,
+        gint out_fd)
+{
+    g_return_val_if_fail (filename != NULL && plugin_type != NULL, NULL);
+
+    GSignondPluginDaemon *daemon = NULL;
+    GSignondFrameChannel *channel = NULL;
+    GSignondPlugin *plugin = NULL;
+    GError *error = NULL;
+    gchar *type = NULL;
+    gchar **mechanisms = NULL;
+
+    if (out_fd != in_fd)
+        close (out_fd);
+    channel = gsignond_frame_channel_new (in_fd, &error);
+    if (!channel) {
+        WARN ("failed to open frame channel: %s", error->message);
+        g_error_free (error);
+        return NULL;
+    }
+
+    plugin = gsignond_load_plugin_with_filename (plugin_type, filename);
+    if (!plugin) {
+        DBG ("failed to load plugin");
+        g_object_unref (channel);
+        return NULL;
+    }
+
+    daemon = GSIGNOND_PLUGIN_DAEMON (g_object_new (
+            GSIGNOND_TYPE_PLUGIN_DAEMON, NULL));
+    daemon->priv->plugin = plugin;
+    daemon->priv->plugin_type = g_strdup (plugin_type);
+
+    g_signal_connect_swapped (plugin, "response",
+            G_CALLBACK (_frame_response_from_plugin), daemon);
+    g_signal_connect_swapped (plugin, "response-final",
+            G_CALLBACK (_frame_response_final_from_plugin), daemon);
+    g_signal_connect_swapped (plugin, "store",
+            G_CALLBACK (_frame_store_from_plugin), daemon);
+    g_signal_connect_swapped (plugin, "error",
+            G_CALLBACK (_frame_error_from_plugin), daemon);
+    g_signal_connect_swapped (plugin, "user-action-required",
+            G_CALLBACK (_frame_user_action_required_from_plugin), daemon);
+    g_signal_connect_swapped (plugin, "refreshed",
+            G_CALLBACK (_frame_refreshed_from_plugin), daemon);
+    g_signal_connect_swapped (plugin, "status-changed",
+            G_CALLBACK (_frame_status_changed_from_plugin), daemon);
+
+    daemon->priv->channel = channel;
+    g_signal_connect_swapped (daemon->priv->channel, "frame",
+            G_CALLBACK (_handle_frame), daemon);
+    g_signal_connect_swapped (daemon->priv->channel, "closed",
+            G_CALLBACK (_on_channel_closed), daemon);
+
+    g_object_get (plugin, "type", &type, "mechanisms", &mechanisms, NULL);
+    _send_frame (daemon, GSIGNOND_FRAME_OP_READY,
+                 g_variant_new ("(s^as)", type ? type : "", mechanisms));
+    g_free (type);
+    g_strfreev (mechanisms);
+
+    gsignond_frame_channel_start (daemon->priv->channel);
+    DBG ("Started framed plugin daemon '%p' for %s", daemon, plugin_type);
+
+    return daemon;
+}
+
+/**
+ * gsignond_plugin_daemon_new_standby:
+ * @plugin_dir: directory of the GLib plugins
+ * @in_fd: input stream of the connection to gsignond
+ * @out_fd: output stream of the connection to gsignond
+ *
+ * Connects to gsignond without loading a plugin yet. gsignond keeps such
+ * loaders in standby, and has them load a plugin with the loadPlugin method
+ * of the Loader interface when one is needed.
+ *
+ * Returns: the plugin daemon, or NULL on error.
+ */
+GSignondPluginDaemon *
+gsignond_plugin_daemon_new_standby (
+        const gchar* plugin_dir,
+        gint in_fd,
+        gint out_fd)
+{
+    g_return_val_if_fail (plugin_dir != NULL, NULL);
+
+    GSignondPluginDaemon *daemon = GSIGNOND_PLUGIN_DAEMON (g_object_new (
+            GSIGNOND_TYPE_PLUGIN_DAEMON, NULL));
+    daemon->priv->plugin_dir = g_strdup (plugin_dir);
+
+    _open_connection (daemon, in_fd, out_fd);
+
+    if (!_export_loader (daemon)) {
+        g_object_unref (daemon);
+        return NULL;
+    }
+    DBG("Plugin daemon '%p' in standby on connection '%p'", daemon,
+        daemon->priv->connection);
+
+    _start_processing (daemon);
+
+    return daemon;
+}
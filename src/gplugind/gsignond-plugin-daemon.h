@@ -69,4 +69,17 @@ gsignond_plugin_daemon_new (
         gint in_fd,
         gint out_fd);
 
+GSignondPluginDaemon *
+gsignond_plugin_daemon_new_framed (
+        const gchar* filename,
+        const gchar* plugin_type,
+        gint in_fd,
+        gint out_fd);
+
+GSignondPluginDaemon *
+gsignond_plugin_daemon_new_standby (
+        const gchar* plugin_dir,
+        gint in_fd,
+        gint out_fd);
+
 #endif /* __GSIGNOND_PLUGIN_DAEMON_H_ */
@@ -32,13 +32,19 @@
 #include <glib.h>
 #include <gio/gio.h>
 #include <sys/prctl.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
 
 #include "gsignond/gsignond-log.h"
+#include "daemon/dbus/gsignond-dbus-remote-plugin-gen.h"
 #include "daemon/dbus/gsignond-dbus.h"
 #include "gsignond-plugin-daemon.h"
+#include "gsignond-plugin-loader.h"
 
 static GSignondPluginDaemon *_daemon = NULL;
 static guint _sig_source_id[3];
+static gint _adopted_fd = -1; /* zygote signals the hand-over on it */
 
 static void
 _on_daemon_closed (gpointer data, GObject *server)
@@ -87,11 +93,23 @@ _install_sighandlers (GMainLoop *main_loop)
                            NULL);
     _sig_source_id[2] = g_source_attach (source, ctx);
 
+    /* a loader forked by the zygote is handed over to gsignond once its
+     * intermediate parent exits, and the parent death signal refers to
+     * whichever process is the parent when it is set. The zygote writes
+     * to the pipe, or closes it, after it has reaped that parent. */
+    if (_adopted_fd >= 0) {
+        gchar adopted;
+        while (read (_adopted_fd, &adopted, 1) < 0 && errno == EINTR)
+            ;
+        close (_adopted_fd);
+        _adopted_fd = -1;
+    }
+
     if (prctl(PR_SET_PDEATHSIG, SIGHUP))
         WARN ("failed to set parent death signal");
 }
 
-static void _list_plugins()
+static const gchar* _get_plugin_path()
 {
     const gchar *plugin_path = GSIGNOND_GPLUGINS_DIR;
 
@@ -100,6 +118,14 @@ static void _list_plugins()
     if (env_val)
         plugin_path = env_val;
 #   endif
+    return plugin_path;
+}
+
+/* calls func with plugin name and module filename for each plugin */
+static void _foreach_plugin(void (*func)(const gchar*, const gchar*, gpointer),
+                            gpointer user_data)
+{
+    const gchar *plugin_path = _get_plugin_path();
     GDir* plugin_dir = g_dir_open(plugin_path, 0, NULL);
     if (plugin_dir == NULL) {
         return;
@@ -113,13 +139,239 @@ static void _list_plugins()
             g_str_has_suffix(plugin_soname, ".so")) {
             gchar* plugin_name = g_strndup(plugin_soname+3,
                 strlen(plugin_soname) - 6);
-            g_print("%s\n", plugin_name);
+            gchar* filename = g_build_filename(plugin_path, plugin_soname,
+                NULL);
+            func(plugin_name, filename, user_data);
+            g_free(filename);
             g_free(plugin_name);
         }
     }
     g_dir_close(plugin_dir);
 }
 
+static void _print_plugin_name(const gchar *plugin_name,
+                               const gchar *filename,
+                               gpointer user_data)
+{
+    g_print("%s\n", plugin_name);
+}
+
+static void _list_plugins()
+{
+    _foreach_plugin(_print_plugin_name, NULL);
+}
+
+static void _describe_plugin(const gchar *plugin_name,
+                             const gchar *filename,
+                             gpointer user_data)
+{
+    GVariantBuilder **builders = (GVariantBuilder **) user_data;
+    GSignondPlugin *plugin = NULL;
+    gchar *type = NULL;
+    gchar **mechanisms = NULL;
+
+    g_variant_builder_add (builders[0], "s", filename);
+
+    plugin = gsignond_load_plugin_with_filename (plugin_name, filename);
+    if (!plugin)
+        return;
+
+    g_object_get (plugin, "type", &type, "mechanisms", &mechanisms, NULL);
+    if (g_strcmp0 (type, plugin_name) == 0 && mechanisms) {
+        g_variant_builder_add (builders[1], "(s^as)", type, mechanisms);
+    } else {
+        WARN ("Plugin %s reports type %s", plugin_name, type);
+    }
+    g_free (type);
+    g_strfreev (mechanisms);
+    g_object_unref (plugin);
+}
+
+/* Prints the files the plugin list depends on, and type and mechanisms of
+ * each plugin, as a "(asa(sas))" variant. gsignond caches the result until
+ * any of the files change, instead of starting every plugin to query it. */
+static void _describe_plugins(gint out_fd)
+{
+    GVariantBuilder files, plugins;
+    GVariantBuilder *builders[] = { &files, &plugins };
+    GVariant *manifest;
+    gchar *text;
+    gsize len, written = 0;
+
+    g_variant_builder_init (&files, G_VARIANT_TYPE ("as"));
+    g_variant_builder_init (&plugins, G_VARIANT_TYPE ("a(sas)"));
+    g_variant_builder_add (&files, "s", _get_plugin_path ());
+
+    _foreach_plugin (_describe_plugin, builders);
+
+    manifest = g_variant_ref_sink (g_variant_new ("(asa(sas))", &files,
+                                                  &plugins));
+    text = g_variant_print (manifest, FALSE);
+    len = strlen (text);
+    while (written < len) {
+        gssize n = write (out_fd, text + written, len - written);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            WARN ("Failed to write plugin description : %s", strerror(errno));
+            break;
+        }
+        written += n;
+    }
+    g_free (text);
+    g_variant_unref (manifest);
+}
+
+static void _preload_plugin(const gchar *plugin_name,
+                            const gchar *filename,
+                            gpointer user_data)
+{
+    GSignondPlugin *plugin = gsignond_load_plugin_with_filename (plugin_name,
+                                                                 filename);
+    if (plugin)
+        g_object_unref (plugin);
+}
+
+/* Receives a request of up to len - 1 bytes and the loader's stdin and
+ * stdout descriptors that come with it. Returns FALSE once gsignond
+ * closed the control socket. */
+static gboolean _receive_request(gint control_fd, gchar *request, gsize len,
+                                 gint *in_fd, gint *out_fd)
+{
+    struct msghdr msg;
+    struct iovec iov;
+    struct cmsghdr *cmsg;
+    union {
+        struct cmsghdr align;
+        gchar buf[CMSG_SPACE (2 * sizeof (gint))];
+    } control;
+    gssize n;
+
+    memset (&msg, 0, sizeof (msg));
+    iov.iov_base = request;
+    iov.iov_len = len - 1;
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.buf;
+    msg.msg_controllen = sizeof (control.buf);
+
+    do {
+        n = recvmsg (control_fd, &msg, MSG_CMSG_CLOEXEC);
+    } while (n < 0 && errno == EINTR);
+    if (n <= 0)
+        return FALSE;
+    request[n] = '\0';
+
+    *in_fd = *out_fd = -1;
+    cmsg = CMSG_FIRSTHDR (&msg);
+    if (cmsg && cmsg->cmsg_level == SOL_SOCKET &&
+        cmsg->cmsg_type == SCM_RIGHTS &&
+        cmsg->cmsg_len == CMSG_LEN (2 * sizeof (gint))) {
+        memcpy (in_fd, CMSG_DATA (cmsg), sizeof (gint));
+        memcpy (out_fd, CMSG_DATA (cmsg) + sizeof (gint), sizeof (gint));
+    }
+    return TRUE;
+}
+
+/* Forks a loader for the request, in two steps so that the loader is
+ * adopted by gsignond, which is a child subreaper, and can be watched
+ * and reaped there like a spawned loader. Returns the loader's pid in
+ * the zygote, 0 in the loader and -1 on failure. */
+static pid_t _fork_loader(void)
+{
+    gint pid_pipe[2], adopted_pipe[2];
+    pid_t child, loader = -1;
+    const gchar adopted = 1;
+
+    if (pipe (pid_pipe) != 0)
+        return -1;
+    if (pipe (adopted_pipe) != 0) {
+        close (pid_pipe[0]);
+        close (pid_pipe[1]);
+        return -1;
+    }
+
+    child = fork ();
+    if (child == 0) {
+        close (pid_pipe[0]);
+        close (adopted_pipe[1]);
+        loader = fork ();
+        if (loader == 0) {
+            close (pid_pipe[1]);
+            _adopted_fd = adopted_pipe[0];
+            return 0;
+        }
+        if (write (pid_pipe[1], &loader, sizeof (loader)) < 0)
+            _exit (1);
+        _exit (0);
+    }
+
+    close (pid_pipe[1]);
+    close (adopted_pipe[0]);
+    if (child > 0) {
+        if (read (pid_pipe[0], &loader, sizeof (loader)) !=
+                sizeof (loader))
+            loader = -1;
+        waitpid (child, NULL, 0);
+        /* the loader has a new parent now */
+        if (write (adopted_pipe[1], &adopted, 1) < 0)
+            WARN ("Failed to notify loader (%d) of its adoption", loader);
+    }
+    close (pid_pipe[0]);
+    close (adopted_pipe[1]);
+
+    return loader;
+}
+
+/* Serves fork requests of gsignond on the control socket. Plugins are
+ * loaded once up front so that the forked loaders share their code and
+ * initialized types copy-on-write. The zygote must stay single-threaded
+ * for fork to be safe, so it does not run a main loop. Returns FALSE in
+ * the zygote when gsignond goes away, and TRUE in a forked loader with
+ * the command line option it should act on in @request. */
+static gboolean _run_zygote(gint control_fd, gchar *request, gsize len)
+{
+    gint in_fd, out_fd;
+    pid_t loader;
+
+    if (prctl(PR_SET_PDEATHSIG, SIGTERM))
+        WARN ("failed to set parent death signal");
+
+#if !GLIB_CHECK_VERSION (2, 36, 0)
+    g_type_init ();
+#endif
+    g_type_ensure (G_TYPE_DBUS_CONNECTION);
+    g_type_ensure (GSIGNOND_DBUS_TYPE_REMOTE_PLUGIN_V1_SKELETON);
+    g_type_ensure (GSIGNOND_DBUS_TYPE_REMOTE_PLUGIN_V2_SKELETON);
+    g_type_ensure (GSIGNOND_DBUS_TYPE_REMOTE_PLUGIN_LOADER_SKELETON);
+    _foreach_plugin (_preload_plugin, NULL);
+
+    DBG ("Zygote ready");
+    while (_receive_request (control_fd, request, len, &in_fd, &out_fd)) {
+        if (in_fd < 0 || out_fd < 0) {
+            WARN ("Zygote request without descriptors");
+            loader = -1;
+        } else {
+            loader = _fork_loader ();
+            if (loader == 0) {
+                close (control_fd);
+                dup2 (in_fd, 0);
+                dup2 (out_fd, 1);
+                close (in_fd);
+                close (out_fd);
+                return TRUE;
+            }
+            DBG ("Zygote forked loader (%d) for %s", loader, request);
+        }
+        if (in_fd >= 0) close (in_fd);
+        if (out_fd >= 0) close (out_fd);
+        if (send (control_fd, &loader, sizeof (loader), MSG_NOSIGNAL) < 0)
+            break;
+    }
+
+    DBG ("Zygote closed");
+    return FALSE;
+}
+
 int main (int argc, char **argv)
 {
     GError *error = NULL;
@@ -128,11 +380,19 @@ int main (int argc, char **argv)
     gint in_fd = 0, out_fd = 1;
 
     gboolean list_plugins = FALSE;
+    gboolean describe_plugins = FALSE;
+    gboolean standby = FALSE;
+    gboolean zygote = FALSE;
+    gboolean framed = FALSE;
     gchar* plugin_name = NULL;
     GOptionEntry main_entries[] =
     {
         { "list-plugins", 0, 0, G_OPTION_ARG_NONE, &list_plugins, "List available plugins", NULL},
+        { "describe", 0, 0, G_OPTION_ARG_NONE, &describe_plugins, "Print types and mechanisms of available plugins", NULL},
         { "load-plugin", 0, 0, G_OPTION_ARG_STRING, &plugin_name, "Load a plugin and start a d-bus connection with it on stdio channel", "name"},
+        { "standby", 0, 0, G_OPTION_ARG_NONE, &standby, "Start a d-bus connection on stdio channel and wait for a request to load a plugin", NULL},
+        { "zygote", 0, 0, G_OPTION_ARG_NONE, &zygote, "Fork loaders on requests that come with their stdio channels on a control socket on stdin", NULL},
+        { "framed", 0, 0, G_OPTION_ARG_NONE, &framed, "Serve the loaded plugin with binary frames instead of d-bus on a unix socket on stdio", NULL},
         { NULL }
     };
 
@@ -152,7 +412,54 @@ int main (int argc, char **argv)
         return 0;
     }
 
-    if (!plugin_name) {
+    if (describe_plugins) {
+        /* plugins may log to stdout while being loaded, keep it for the
+         * description only */
+        out_fd = dup(1);
+        if (out_fd == -1) {
+            WARN ("Failed to dup stdout : %s(%d)", strerror(errno), errno);
+            return -1;
+        }
+        dup2 (2, 1);
+#if !GLIB_CHECK_VERSION (2, 36, 0)
+        g_type_init ();
+#endif
+        _describe_plugins (out_fd);
+        close (out_fd);
+        return 0;
+    }
+
+    if (zygote) {
+        gchar request[256];
+        gchar **options, **option;
+        gint control_fd = dup(0);
+
+        if (control_fd == -1) {
+            WARN ("Failed to dup stdin : %s(%d)", strerror(errno), errno);
+            return -1;
+        }
+        if (!freopen("/dev/null", "r+", stdin)) {
+            WARN ("Unable to redirect stdin to /dev/null");
+        }
+        dup2 (2, 1);
+
+        if (!_run_zygote (control_fd, request, sizeof (request)))
+            return 0;
+
+        /* a forked loader acts on the requested options */
+        options = g_strsplit (request, " ", -1);
+        for (option = options; *option; option++) {
+            if (g_str_has_prefix (*option, "--load-plugin="))
+                plugin_name = g_strdup (*option + strlen ("--load-plugin="));
+            else if (g_strcmp0 (*option, "--standby") == 0)
+                standby = TRUE;
+            else if (g_strcmp0 (*option, "--framed") == 0)
+                framed = TRUE;
+        }
+        g_strfreev (options);
+    }
+
+    if (!plugin_name && !standby) {
         g_print("Use --help to list command line options\n");
         return -1;
     }
@@ -184,18 +491,22 @@ int main (int argc, char **argv)
     g_type_init ();
 #endif
 
-    const gchar *plugin_path = GSIGNOND_GPLUGINS_DIR;
-#   ifdef ENABLE_DEBUG
-    const gchar *env_val = g_getenv("SSO_GPLUGINS_DIR");
-    if (env_val)
-        plugin_path = env_val;
-#   endif
-    gchar* filename = g_module_build_path (plugin_path, plugin_name);
-
-    _daemon = gsignond_plugin_daemon_new (filename, plugin_name, in_fd,
-            out_fd);
-    g_free(filename);
-    g_free(plugin_name);
+    if (plugin_name) {
+        gchar* filename = g_module_build_path (_get_plugin_path (),
+                                               plugin_name);
+
+        if (framed)
+            _daemon = gsignond_plugin_daemon_new_framed (filename,
+                    plugin_name, in_fd, out_fd);
+        else
+            _daemon = gsignond_plugin_daemon_new (filename, plugin_name,
+                    in_fd, out_fd);
+        g_free(filename);
+        g_free(plugin_name);
+    } else {
+        _daemon = gsignond_plugin_daemon_new_standby (_get_plugin_path (),
+                in_fd, out_fd);
+    }
     if (_daemon == NULL) {
         return -1;
     }
@@ -22,6 +22,7 @@
  * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
  * 02110-1301 USA
  */
+#include <stdarg.h>
 #include <string.h>
 #include <time.h>
 #include <fcntl.h>
@@ -53,6 +54,19 @@
  * #GSignondPlugin::response-final signal. @session_data in that signal contains
  * the username, "CNonce" item and the digest value under the "Response" key.
  * 
+ * Several digests for the same user and realm can be requested at once by
+ * passing a "Requests" item, an array of dictionaries ("aa{sv}") holding the
+ * per-request items listed above. Items missing from a dictionary are taken
+ * from @session_data. The "Responses" item of the response then holds a
+ * dictionary with "CNonce" and "Response" for each request, in the same
+ * order.
+ * 
+ * HA1 (the hash of the username, realm and secret) is kept in the plugin
+ * between requests for the same user and realm. The secret itself is not
+ * kept: a change of it is detected with its HMAC under a random key of the
+ * plugin instance. Both are wiped when the session is cancelled and when the
+ * plugin is unloaded.
+ * 
  * If some of the data is incorrect or not available, #GSignondPlugin::error
  * signal is issued instead.
  * 
@@ -90,85 +104,170 @@ G_DEFINE_TYPE_WITH_CODE (GSignondDigestPlugin, gsignond_digest_plugin,
     }
 #define TO_GUCHAR(data) ((const guchar*)data)
 
+/* number of users whose HA1 is kept */
+#define GSIGNOND_DIGEST_PLUGIN_HA1_CACHE_SIZE 8
+
+/* HA1 of a user in a realm, valid as long as the secret has the same MAC */
+typedef struct {
+    gchar *username;
+    gchar *realm;
+    gchar *secret_mac;
+    gchar ha1[33];
+} _Ha1Entry;
+
 struct _GSignondDigestPluginPrivate
 {
     GSignondSessionData *session_data;
+    GChecksum *checksum;
+    GPtrArray *ha1_cache; /* of _Ha1Entry, least recently used first */
+    gchar mac_key[GSIGNOND_NONCE_LENGTH + 1]; /* empty if the cache is off */
+    gchar ha1[33]; /* HA1 of the last request when the cache is off */
 };
 
-static gchar *
+/* overwrites secrets before their memory is released */
+static void
+_wipe (gpointer mem, gsize len)
+{
+    volatile guchar *p = (volatile guchar *) mem;
+
+    while (len--)
+        *p++ = 0;
+}
+
+static void
+_wipe_string (gchar *str)
+{
+    if (str) {
+        _wipe (str, strlen (str));
+        g_free (str);
+    }
+}
+
+static void
+_ha1_entry_free (gpointer data)
+{
+    _Ha1Entry *entry = (_Ha1Entry *) data;
+
+    g_free (entry->username);
+    g_free (entry->realm);
+    _wipe_string (entry->secret_mac);
+    _wipe (entry->ha1, sizeof (entry->ha1));
+    g_slice_free (_Ha1Entry, entry);
+}
+
+/* hex MD5 of @first and the following strings joined with ':', the list
+ * ends with NULL. @checksum is reset for the next use. */
+static void
+_md5_hex (GChecksum *checksum, gchar hex[33], const gchar *first, ...)
+{
+    const gchar *field;
+    va_list args;
+
+    g_checksum_update (checksum, TO_GUCHAR(first), strlen (first));
+    va_start (args, first);
+    while ((field = va_arg (args, const gchar *)) != NULL) {
+        g_checksum_update (checksum, TO_GUCHAR(":"), 1);
+        g_checksum_update (checksum, TO_GUCHAR(field), strlen (field));
+    }
+    va_end (args);
+
+    g_strlcpy (hex, g_checksum_get_string (checksum), 33);
+    g_checksum_reset (checksum);
+}
+
+/* HA1 = MD5(username:realm:secret) does not depend on the request, so it is
+ * computed once per user and realm */
+static const gchar *
+_gsignond_digest_plugin_get_ha1 (
+        GSignondDigestPluginPrivate *priv,
+        const gchar *username,
+        const gchar *realm,
+        const gchar *secret)
+{
+    _Ha1Entry *entry;
+    gchar *secret_mac;
+    guint i;
+
+    if (priv->mac_key[0] == '\0') {
+        _md5_hex (priv->checksum, priv->ha1, username, realm, secret, NULL);
+        return priv->ha1;
+    }
+
+    secret_mac = g_compute_hmac_for_string (G_CHECKSUM_SHA256,
+                                            TO_GUCHAR(priv->mac_key),
+                                            GSIGNOND_NONCE_LENGTH, secret, -1);
+    for (i = 0; i < priv->ha1_cache->len; i++) {
+        entry = g_ptr_array_index (priv->ha1_cache, i);
+        if (g_strcmp0 (entry->username, username) != 0 ||
+            g_strcmp0 (entry->realm, realm) != 0)
+            continue;
+        if (g_strcmp0 (entry->secret_mac, secret_mac) != 0) {
+            g_ptr_array_remove_index (priv->ha1_cache, i);
+            break;
+        }
+        _wipe_string (secret_mac);
+        if (i + 1 < priv->ha1_cache->len) {
+            g_ptr_array_remove_index (priv->ha1_cache, i);
+            g_ptr_array_add (priv->ha1_cache, entry);
+        }
+        return entry->ha1;
+    }
+
+    if (priv->ha1_cache->len >= GSIGNOND_DIGEST_PLUGIN_HA1_CACHE_SIZE)
+        g_ptr_array_remove_index (priv->ha1_cache, 0);
+
+    entry = g_slice_new0 (_Ha1Entry);
+    entry->username = g_strdup (username);
+    entry->realm = g_strdup (realm);
+    entry->secret_mac = secret_mac;
+    _md5_hex (priv->checksum, entry->ha1, username, realm, secret, NULL);
+    g_ptr_array_add (priv->ha1_cache, entry);
+
+    return entry->ha1;
+}
+
+static void
 _gsignond_digest_plugin_compute_md5_digest (
+        GChecksum *checksum,
         const gchar* algo,
-        const gchar* username,
-        const gchar* realm,
-        const gchar* secret,
+        const gchar* ha1,
         const gchar* nonce,
         const gchar* nonce_count,
         const gchar* cnonce,
         const gchar* qop,
         const gchar* method,
         const gchar* digest_uri,
-        const gchar* hentity)
+        const gchar* hentity,
+        gchar hresponse[33])
 {
-    GChecksum *a1 = NULL, *a2 = NULL, *response = NULL;
-    const gchar *ha1 = NULL, *ha2 = NULL;
-    gchar *hresponse = NULL;
-
-    a1 = g_checksum_new (G_CHECKSUM_MD5);
-    g_checksum_update (a1, TO_GUCHAR(username), strlen(username));
-    g_checksum_update (a1, TO_GUCHAR(":"), 1);
-    g_checksum_update (a1, TO_GUCHAR(realm), strlen(realm));
-    g_checksum_update (a1, TO_GUCHAR(":"), 1);
-    g_checksum_update (a1, TO_GUCHAR(secret), strlen(secret));
+    gchar ha1_sess[33], ha2[33];
 
     if (g_strcmp0 (algo, "md5-sess") == 0) {
-        GChecksum *a1_sess = NULL;
-        a1_sess = g_checksum_new (G_CHECKSUM_MD5);
-        ha1 = g_checksum_get_string (a1);
-        g_checksum_update (a1_sess, TO_GUCHAR(ha1), strlen(ha1));
-        g_checksum_update (a1_sess, TO_GUCHAR(":"), 1);
-        g_checksum_update (a1_sess, TO_GUCHAR(nonce), strlen(nonce));
-        g_checksum_update (a1_sess, TO_GUCHAR(":"), 1);
-        g_checksum_update (a1_sess, TO_GUCHAR(cnonce), strlen(cnonce));
-        g_checksum_free (a1);
-        a1 = a1_sess;
+        _md5_hex (checksum, ha1_sess, ha1, nonce, cnonce, NULL);
+        ha1 = ha1_sess;
     }
 
-    a2 = g_checksum_new (G_CHECKSUM_MD5);
-    g_checksum_update (a2, TO_GUCHAR(method), strlen(method));
-    g_checksum_update (a2, TO_GUCHAR(":"), 1);
-    g_checksum_update (a2, TO_GUCHAR(digest_uri), strlen(digest_uri));
-    if (qop && g_strcmp0 (qop, "auth-int") == 0 && hentity) {
-        g_checksum_update (a2, TO_GUCHAR(":"), 1);
-        g_checksum_update (a2, TO_GUCHAR(hentity), strlen(hentity));
-    }
-    ha1 = g_checksum_get_string (a1);
-    ha2 = g_checksum_get_string (a2);
-
-    response = g_checksum_new (G_CHECKSUM_MD5);
-    g_checksum_update (response, TO_GUCHAR(ha1), strlen(ha1));
-    g_checksum_update (response, TO_GUCHAR(":"), 1);
-    g_checksum_update (response, TO_GUCHAR(nonce), strlen(nonce));
-    g_checksum_update (response, TO_GUCHAR(":"), 1);
-    if (qop) {
-        g_checksum_update (response, TO_GUCHAR(nonce_count),
-                strlen(nonce_count));
-        g_checksum_update (response, TO_GUCHAR(":"), 1);
-        g_checksum_update (response, TO_GUCHAR(cnonce), strlen(cnonce));
-        g_checksum_update (response, TO_GUCHAR(":"), 1);
-        g_checksum_update (response, TO_GUCHAR(qop), strlen(qop));
-        g_checksum_update (response, TO_GUCHAR(":"), 1);
-    }
-    g_checksum_update (response, TO_GUCHAR(ha2), strlen(ha2));
-    hresponse = g_strdup(g_checksum_get_string (response));
-    g_checksum_free (response);
-    g_checksum_free (a2);
-    g_checksum_free (a1);
-    return hresponse;
+    if (qop && g_strcmp0 (qop, "auth-int") == 0 && hentity)
+        _md5_hex (checksum, ha2, method, digest_uri, hentity, NULL);
+    else
+        _md5_hex (checksum, ha2, method, digest_uri, NULL);
+
+    if (qop)
+        _md5_hex (checksum, hresponse, ha1, nonce, nonce_count, cnonce, qop,
+                  ha2, NULL);
+    else
+        _md5_hex (checksum, hresponse, ha1, nonce, ha2, NULL);
+
+    _wipe (ha1_sess, sizeof (ha1_sess));
 }
 
 static void
 gsignond_digest_plugin_cancel (GSignondPlugin *self)
 {
+    GSignondDigestPluginPrivate *priv = GSIGNOND_DIGEST_PLUGIN (self)->priv;
+    g_ptr_array_set_size (priv->ha1_cache, 0);
+    _wipe (priv->ha1, sizeof (priv->ha1));
+
     GError* error = g_error_new(GSIGNOND_ERROR,
                                 GSIGNOND_ERROR_SESSION_CANCELED,
                                 "Session cancelled");
@@ -198,6 +297,65 @@ _compare_realm (gconstpointer a, gconstpointer b, gpointer user_data)
     return g_strcmp0 (realm1, realm2);
 }
 
+/* string item of a request, falling back to the shared session data */
+static const gchar *
+_get_request_item (GVariant *request,
+                   GSignondSessionData *session_data,
+                   const gchar *key)
+{
+    const gchar *value = NULL;
+
+    if (request && g_variant_lookup (request, key, "&s", &value))
+        return value;
+    return gsignond_dictionary_get_string (session_data, key);
+}
+
+/* sets "CNonce" and "Response" of one request in @response */
+static gboolean
+_gsignond_digest_plugin_add_response (GSignondDigestPlugin *self,
+                                      const gchar *ha1,
+                                      GVariant *request,
+                                      GSignondSessionData *session_data,
+                                      GSignondDictionary *response,
+                                      GError **error)
+{
+    const gchar* algo = _get_request_item (request, session_data, "Algo");
+    const gchar* nonce = _get_request_item (request, session_data, "Nonce");
+    const gchar* nonce_count = _get_request_item (request, session_data,
+                "NonceCount");
+    const gchar* qop = _get_request_item (request, session_data, "Qop");
+    const gchar* method = _get_request_item (request, session_data, "Method");
+    const gchar* digest_uri = _get_request_item (request, session_data,
+                "DigestUri");
+    const gchar* hentity = _get_request_item (request, session_data,
+                "HEntity");
+    gchar digest[33];
+    gchar cnonce[GSIGNOND_NONCE_LENGTH + 1];
+
+    if ((!algo  || !nonce  || !method  || !digest_uri)
+        || (qop && g_strcmp0 (qop, "auth-int") == 0 && !hentity)
+        || (qop && !nonce_count)) {
+        *error = g_error_new (GSIGNOND_ERROR,
+                GSIGNOND_ERROR_MISSING_DATA, "Missing Session Data");
+        return FALSE;
+    }
+
+    if (!gsignond_generate_nonce_into (cnonce)) {
+        *error = g_error_new (GSIGNOND_ERROR,
+                              GSIGNOND_ERROR_MISSING_DATA,
+                              "Error in generating nonce");
+        return FALSE;
+    }
+
+    _gsignond_digest_plugin_compute_md5_digest (self->priv->checksum, algo,
+            ha1, nonce, nonce_count, cnonce, qop, method, digest_uri, hentity,
+            digest);
+
+    gsignond_dictionary_set_string (response, "CNonce", cnonce);
+    gsignond_dictionary_set_string (response, "Response", digest);
+    return TRUE;
+}
+
 static void
 _gsignond_digest_plugin_return_digest (GSignondPlugin *plugin,
                                        const gchar *username,
@@ -207,25 +365,15 @@ _gsignond_digest_plugin_return_digest (GSignondPlugin *plugin,
     g_return_if_fail (plugin != NULL);
     g_return_if_fail (GSIGNOND_IS_DIGEST_PLUGIN (plugin));
 
+    GSignondDigestPlugin *self = GSIGNOND_DIGEST_PLUGIN (plugin);
     GSignondSessionData *response = NULL;
     GSequenceIter *iter;
     GSequence* allowed_realms =
         gsignond_session_data_get_allowed_realms (session_data);
     const gchar* realm = gsignond_session_data_get_realm (session_data);
-    const gchar* algo = gsignond_dictionary_get_string (session_data,
-                "Algo");
-    const gchar* nonce = gsignond_dictionary_get_string (session_data,
-                "Nonce");
-    const gchar* nonce_count = gsignond_dictionary_get_string (session_data,
-                "NonceCount");
-    const gchar* qop = gsignond_dictionary_get_string (session_data,
-                "Qop");
-    const gchar* method = gsignond_dictionary_get_string (session_data,
-                "Method");
-    const gchar* digest_uri = gsignond_dictionary_get_string (session_data,
-                "DigestUri");
-    const gchar* hentity = gsignond_dictionary_get_string (session_data,
-                "HEntity");
+    GVariant *requests = gsignond_dictionary_get (session_data, "Requests");
+    GError *error = NULL;
+    const gchar *ha1;
 
     if (!allowed_realms) {
         GError* error = g_error_new (GSIGNOND_ERROR,
@@ -249,37 +397,55 @@ _gsignond_digest_plugin_return_digest (GSignondPlugin *plugin,
         return;
     }
 
-    gchar *cnonce = gsignond_generate_nonce ();
-    if (!cnonce) {
+    if (requests &&
+        !g_variant_is_of_type (requests, G_VARIANT_TYPE ("aa{sv}"))) {
         GError* error = g_error_new (GSIGNOND_ERROR,
                                      GSIGNOND_ERROR_MISSING_DATA,
-                                     "Error in generating nonce");
+                                     "Invalid request list");
         gsignond_plugin_error (plugin, error);
         g_error_free (error);
         return;
     }
 
-    if ((!realm || !algo  || !nonce  || !method  || !digest_uri)
-        || (qop && g_strcmp0 (qop, "auth-int") == 0 && !hentity)
-        || (qop && !nonce_count)) {
-        GError* error = g_error_new (GSIGNOND_ERROR,
-        		GSIGNOND_ERROR_MISSING_DATA, "Missing Session Data");
-        gsignond_plugin_error (plugin, error);
-        g_error_free (error);
-        return;
-    }
-    gchar *digest = _gsignond_digest_plugin_compute_md5_digest(algo,
-            username, realm, secret, nonce, nonce_count, cnonce, qop, method,
-            digest_uri, hentity);
-
+    ha1 = _gsignond_digest_plugin_get_ha1 (self->priv, username, realm,
+                                           secret);
     response = gsignond_dictionary_new();
     gsignond_session_data_set_username(response, username);
-    gsignond_dictionary_set_string(response, "CNonce", cnonce);
-    g_free (cnonce);
-    gsignond_dictionary_set_string(response, "Response", digest);
-    g_free(digest);
 
-    gsignond_plugin_response_final(plugin, response);
+    if (requests) {
+        GVariantBuilder responses;
+        GVariantIter request_iter;
+        GVariant *request;
+
+        /* all the requests share HA1 and the checksum state */
+        g_variant_builder_init (&responses, G_VARIANT_TYPE ("aa{sv}"));
+        g_variant_iter_init (&request_iter, requests);
+        while (!error &&
+               (request = g_variant_iter_next_value (&request_iter))) {
+            GSignondDictionary *item = gsignond_dictionary_new ();
+            if (_gsignond_digest_plugin_add_response (self, ha1, request,
+                        session_data, item, &error))
+                g_variant_builder_add_value (&responses,
+                        gsignond_dictionary_to_variant (item));
+            gsignond_dictionary_unref (item);
+            g_variant_unref (request);
+        }
+        if (!error)
+            gsignond_dictionary_set (response, "Responses",
+                                     g_variant_builder_end (&responses));
+        else
+            g_variant_builder_clear (&responses);
+    } else {
+        _gsignond_digest_plugin_add_response (self, ha1, NULL, session_data,
+                                              response, &error);
+    }
+
+    if (error) {
+        gsignond_plugin_error (plugin, error);
+        g_error_free (error);
+    } else {
+        gsignond_plugin_response_final(plugin, response);
+    }
     gsignond_dictionary_unref(response);
 }
 
@@ -395,7 +561,10 @@ gsignond_digest_plugin_init (GSignondDigestPlugin *self)
     self->priv = priv;
 
     priv->session_data = NULL;
-
+    priv->checksum = g_checksum_new (G_CHECKSUM_MD5);
+    priv->ha1_cache = g_ptr_array_new_with_free_func (_ha1_entry_free);
+    if (!gsignond_generate_nonce_into (priv->mac_key))
+        priv->mac_key[0] = '\0';
 }
 
 enum
@@ -457,6 +626,18 @@ gsignond_digest_plugin_dispose (GObject *gobject)
         self->priv->session_data = NULL;
     }
 
+    if (self->priv->ha1_cache) {
+        g_ptr_array_unref (self->priv->ha1_cache);
+        self->priv->ha1_cache = NULL;
+    }
+
+    if (self->priv->checksum) {
+        g_checksum_free (self->priv->checksum);
+        self->priv->checksum = NULL;
+    }
+    _wipe (self->priv->ha1, sizeof (self->priv->ha1));
+    _wipe (self->priv->mac_key, sizeof (self->priv->mac_key));
+
     /* Chain up to the parent class */
     G_OBJECT_CLASS (gsignond_digest_plugin_parent_class)->dispose (
             gobject);
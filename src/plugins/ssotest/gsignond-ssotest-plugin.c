@@ -23,6 +23,8 @@
  * 02110-1301 USA
  */
 
+#include <unistd.h>
+
 #include <gsignond/gsignond-plugin-interface.h>
 #include <gsignond/gsignond-error.h>
 #include <gsignond/gsignond-log.h>
@@ -66,6 +68,10 @@ struct _GSignondSsoTestPluginPrivate
     gboolean is_canceled;
 };
 
+/* numbers the requests, so that tests can tell whether a response came
+ * from the plugin or was shared by the daemon */
+static guint request_count = 0;
+
 static const gchar *method = "ssotest";
 static const gchar *mechanisms[] = { "mech1", "mech2", "mech3", "BLOB", NULL };
 
@@ -96,6 +102,14 @@ static void gsignond_ssotest_plugin_request_initial (
     GSignondSessionData *response = gsignond_dictionary_copy (session_data);
     DBG ("response=%p", response);
     gsignond_session_data_set_realm (response, "testRealm_after_test");
+    gchar *request_id = g_strdup_printf ("%d:%u", (gint) getpid (),
+                                         ++request_count);
+    gsignond_dictionary_set_string (response, "TestRequestId", request_id);
+    g_free (request_id);
+    guint32 cache_ttl;
+    if (gsignond_dictionary_get_uint32 (session_data, "TestCacheTtl",
+                                        &cache_ttl))
+        gsignond_session_data_set_cache_ttl (response, cache_ttl);
 
     for (i = 0; i < 10; i++) {
         if (!self->priv->is_canceled) {
@@ -25,16 +25,23 @@
 
 #include <check.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 #include <fcntl.h>
+#include <sys/socket.h>
 #include <glib.h>
 #include <glib-unix.h>
 #include "gsignond/gsignond-session-data.h"
 #include "gsignond/gsignond-error.h"
 #include "gsignond/gsignond-log.h"
 #include "gsignond/gsignond-utils.h"
+#include "gsignond/gsignond-access-control-manager.h"
 #include "common/gsignond-identity-info.h"
+#include "common/gsignond-identity-info-internal.h"
 #include "common/gsignond-pipe-stream.h"
+#include "common/gsignond-frame-channel.h"
+#include "common/gsignond-timer-wheel.h"
+#include "common/gsignond-refresh-schedule.h"
 #include "gplugind/gsignond-plugin-loader.h"
 
 static GSequence*
@@ -90,6 +97,187 @@ START_TEST (test_pipe_stream)
 }
 END_TEST
 
+static void
+_on_channel_closed (GSignondFrameChannel *channel, gpointer user_data)
+{
+    *((gboolean *) user_data) = TRUE;
+}
+
+START_TEST (test_frame_channel)
+{
+    GSignondFrameChannel *sender = NULL, *receiver = NULL;
+    GVariant *small, *large, *payload = NULL;
+    GError *error = NULL;
+    guint32 id = 0, opcode = 0;
+    gboolean closed = FALSE;
+    gchar *blob;
+    gint fds[2];
+
+    /* pipes cannot carry descriptors */
+    fail_unless (pipe (fds) == 0);
+    fail_unless (gsignond_frame_channel_new (fds[0], &error) == NULL);
+    fail_if (error == NULL);
+    g_clear_error (&error);
+    close (fds[1]);
+
+    fail_unless (socketpair (AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+    sender = gsignond_frame_channel_new (fds[0], NULL);
+    receiver = gsignond_frame_channel_new (fds[1], NULL);
+    fail_if (sender == NULL || receiver == NULL);
+    gsignond_frame_channel_set_fd_threshold (sender, 1024);
+
+    blob = g_malloc (256 * 1024);
+    memset (blob, 'x', 256 * 1024 - 1);
+    blob[256 * 1024 - 1] = '\0';
+    small = g_variant_ref_sink (g_variant_new ("(us)", 7, "small"));
+    large = g_variant_ref_sink (g_variant_new_string (blob));
+    g_free (blob);
+
+    /* the large payload is passed in a memfd, in order with the others */
+    gsignond_frame_channel_send (sender, 1, GSIGNOND_FRAME_OP_REQUEST, small);
+    gsignond_frame_channel_send (sender, 2, GSIGNOND_FRAME_OP_REQUEST, large);
+    gsignond_frame_channel_send (sender, 3, GSIGNOND_FRAME_OP_CANCEL, NULL);
+    while (g_main_context_iteration (NULL, FALSE));
+
+    fail_unless (gsignond_frame_channel_receive_sync (receiver, &id, &opcode,
+                                                      &payload, NULL, NULL));
+    fail_unless (id == 1 && opcode == GSIGNOND_FRAME_OP_REQUEST);
+    fail_unless (payload && g_variant_equal (payload, small));
+    g_variant_unref (payload);
+
+    fail_unless (gsignond_frame_channel_receive_sync (receiver, &id, &opcode,
+                                                      &payload, NULL, NULL));
+    fail_unless (id == 2 && opcode == GSIGNOND_FRAME_OP_REQUEST);
+    fail_unless (payload && g_variant_equal (payload, large));
+    g_variant_unref (payload);
+
+    fail_unless (gsignond_frame_channel_receive_sync (receiver, &id, &opcode,
+                                                      &payload, NULL, NULL));
+    fail_unless (id == 3 && opcode == GSIGNOND_FRAME_OP_CANCEL);
+    fail_unless (payload == NULL);
+
+    g_variant_unref (small);
+    g_variant_unref (large);
+
+    /* the peer going away is reported */
+    g_signal_connect (receiver, "closed", G_CALLBACK (_on_channel_closed),
+                      &closed);
+    gsignond_frame_channel_start (receiver);
+    g_object_unref (sender);
+    while (!closed)
+        g_main_context_iteration (NULL, TRUE);
+    g_object_unref (receiver);
+}
+END_TEST
+
+static GString *wheel_fired = NULL;
+static gint64 wheel_started = 0;
+
+static void
+_on_wheel_timer (gpointer user_data)
+{
+    const gchar *name = (const gchar *) user_data;
+    gint64 elapsed = g_get_monotonic_time () - wheel_started;
+
+    /* the name carries the delay in ticks of 10 ms */
+    fail_unless (elapsed >= (name[1] - '0') * 10 * G_TIME_SPAN_MILLISECOND);
+    g_string_append_c (wheel_fired, name[0]);
+}
+
+static void
+_on_wheel_timer_freed (gpointer user_data)
+{
+    g_string_append_c (wheel_fired, '-');
+}
+
+START_TEST (test_timer_wheel)
+{
+    GSignondTimerWheel *wheel = gsignond_timer_wheel_new (10, 4);
+    guint id;
+
+    wheel_fired = g_string_new (NULL);
+    wheel_started = g_get_monotonic_time ();
+
+    /* c and d are further away than the ring is long */
+    gsignond_timer_wheel_add (wheel, 90, _on_wheel_timer, "d9", NULL);
+    gsignond_timer_wheel_add (wheel, 20, _on_wheel_timer, "a2", NULL);
+    gsignond_timer_wheel_add (wheel, 60, _on_wheel_timer, "c6", NULL);
+    id = gsignond_timer_wheel_add (wheel, 30, _on_wheel_timer, "x3",
+                                   _on_wheel_timer_freed);
+    gsignond_timer_wheel_add (wheel, 40, _on_wheel_timer, "b4", NULL);
+    fail_unless (gsignond_timer_wheel_get_size (wheel) == 5);
+
+    fail_unless (gsignond_timer_wheel_remove (wheel, id) == TRUE);
+    fail_unless (gsignond_timer_wheel_remove (wheel, id) == FALSE);
+    fail_unless (g_strcmp0 (wheel_fired->str, "-") == 0);
+    fail_unless (gsignond_timer_wheel_get_size (wheel) == 4);
+
+    while (gsignond_timer_wheel_get_size (wheel) > 0)
+        g_main_context_iteration (NULL, TRUE);
+    fail_unless (g_strcmp0 (wheel_fired->str, "-abcd") == 0);
+
+    /* pending timers are dropped without firing */
+    gsignond_timer_wheel_add (wheel, 10, _on_wheel_timer, "e1",
+                              _on_wheel_timer_freed);
+    gsignond_timer_wheel_free (wheel);
+    fail_unless (g_strcmp0 (wheel_fired->str, "-abcd-") == 0);
+
+    g_string_free (wheel_fired, TRUE);
+    wheel_fired = NULL;
+}
+END_TEST
+
+static void
+_on_refresh (gpointer key, gpointer owner, gpointer user_data)
+{
+    g_string_append (user_data, key);
+}
+
+START_TEST (test_refresh_schedule)
+{
+    GString *refreshed = g_string_new (NULL);
+    GSignondRefreshSchedule *schedule = gsignond_refresh_schedule_new (10,
+            20, 2, _on_refresh, refreshed);
+    gchar *owner1 = "owner1", *owner2 = "owner2";
+    gint64 started;
+
+    /* a and b are cancelled with their owner, c on its own */
+    fail_unless (gsignond_refresh_schedule_add (schedule, "a", owner1, 50));
+    fail_unless (gsignond_refresh_schedule_add (schedule, "b", owner1, 50));
+    fail_unless (gsignond_refresh_schedule_add (schedule, "c", owner2, 50));
+    fail_unless (gsignond_refresh_schedule_add (schedule, "d", owner2, 30));
+    fail_unless (gsignond_refresh_schedule_is_pending (schedule, "a"));
+    fail_unless (gsignond_refresh_schedule_remove_owner (schedule, owner1) == 2);
+    fail_if (gsignond_refresh_schedule_is_pending (schedule, "a"));
+    fail_if (gsignond_refresh_schedule_is_pending (schedule, "b"));
+    fail_unless (gsignond_refresh_schedule_remove (schedule, "c"));
+    fail_if (gsignond_refresh_schedule_remove (schedule, "c"));
+
+    started = g_get_monotonic_time ();
+    while (g_get_monotonic_time () - started < 100 * G_TIME_SPAN_MILLISECOND)
+        g_main_context_iteration (NULL, FALSE);
+    fail_unless (g_strcmp0 (refreshed->str, "d") == 0);
+    fail_if (gsignond_refresh_schedule_is_pending (schedule, "d"));
+
+    /* a key that keeps being due right away is given up on */
+    fail_unless (gsignond_refresh_schedule_add (schedule, "d", owner2, 0));
+    fail_unless (gsignond_refresh_schedule_add (schedule, "d", owner2, 5));
+    fail_if (gsignond_refresh_schedule_add (schedule, "d", owner2, 0));
+    fail_if (gsignond_refresh_schedule_is_pending (schedule, "d"));
+    /* and a longer delay starts the count over */
+    fail_unless (gsignond_refresh_schedule_add (schedule, "d", owner2, 0));
+    fail_unless (gsignond_refresh_schedule_add (schedule, "d", owner2, 50));
+    fail_unless (gsignond_refresh_schedule_add (schedule, "d", owner2, 0));
+    fail_unless (gsignond_refresh_schedule_add (schedule, "d", owner2, 0));
+    fail_unless (gsignond_refresh_schedule_is_pending (schedule, "d"));
+
+    /* pending refreshes are dropped without running */
+    gsignond_refresh_schedule_free (schedule);
+    fail_unless (g_strcmp0 (refreshed->str, "d") == 0);
+    g_string_free (refreshed, TRUE);
+}
+END_TEST
+
 START_TEST (test_session_data)
 {
     GSignondSessionData* data;
@@ -268,7 +456,9 @@ START_TEST (test_identity_info)
     seq1 = gsignond_identity_info_get_realms (identity);
     fail_if (seq1 == NULL);
     fail_unless (_compare_sequences (seq1, seq_realms) == TRUE);
-    g_sequence_free (seq1); seq1 = NULL;
+    /* accessors are borrowed and do not rebuild the data */
+    fail_unless (gsignond_identity_info_get_realms (identity) == seq1);
+    seq1 = NULL;
     g_sequence_free (seq_realms);
 
     /*methods*/
@@ -291,7 +481,7 @@ START_TEST (test_identity_info)
     seq21 = g_hash_table_lookup (methods, "method1");
     fail_if (seq21 == NULL);
     fail_unless (_compare_sequences (seq1, seq21) == TRUE);
-    g_hash_table_unref (methods2);
+    fail_unless (gsignond_identity_info_get_methods (identity) == methods2);
     g_hash_table_unref (methods);
 
     fail_unless (gsignond_identity_info_get_mechanisms (
@@ -300,7 +490,9 @@ START_TEST (test_identity_info)
     mechs = gsignond_identity_info_get_mechanisms (
             identity, "method1");
     fail_if (mechs == NULL);
-    g_sequence_free (mechs);
+    fail_unless (mechs == g_hash_table_lookup (methods2, "method1"));
+    fail_unless (g_strcmp0 (g_sequence_get (g_sequence_get_begin_iter (mechs)),
+                            "mech11") == 0);
 
     fail_unless (gsignond_identity_info_remove_method (
                 identity, "method20") == FALSE);
@@ -328,7 +520,7 @@ START_TEST (test_identity_info)
     list2 = g_list_nth (list, 2);
     ctx = (GSignondSecurityContext *) list2->data;
     fail_unless (gsignond_security_context_compare (ctx, ctx3) == 0);
-    gsignond_security_context_list_free (list); list = NULL;
+    list = NULL;
 
     /*owners*/
     fail_unless (gsignond_identity_info_set_owner (
@@ -336,7 +528,8 @@ START_TEST (test_identity_info)
     ctx = gsignond_identity_info_get_owner (identity);
     fail_if (ctx == NULL);
     fail_unless (gsignond_security_context_compare (ctx, ctx1) == 0);
-    gsignond_security_context_free (ctx); ctx = NULL;
+    fail_unless (ctx != ctx1);
+    ctx = NULL;
 
     fail_unless (gsignond_identity_info_set_validated (
                 identity, FALSE) == TRUE);
@@ -355,9 +548,115 @@ START_TEST (test_identity_info)
     gsignond_identity_info_unref (identity2);
     fail_unless (gsignond_identity_info_compare (identity, identity) == TRUE);
 
+    /* ACL entries are compared with wildcards */
+    identity2 = gsignond_identity_info_copy (identity);
+    list = g_list_append (NULL,
+            gsignond_security_context_new_from_values ("sysctx1", "*"));
+    list = g_list_append (list,
+            gsignond_security_context_new_from_values ("sysctx2", "appctx2"));
+    list = g_list_append (list,
+            gsignond_security_context_new_from_values ("sysctx3", "*"));
+    fail_unless (gsignond_identity_info_set_access_control_list (
+                identity2, list) == TRUE);
+    fail_unless (gsignond_identity_info_compare (identity, identity2) == TRUE);
+    gsignond_security_context_list_free (list); list = NULL;
+    gsignond_identity_info_unref (identity2);
+
     gsignond_security_context_list_free (ctx_list); ctx_list = NULL;
 
     gsignond_identity_info_unref (identity);
+
+    /* keys that are not identity properties are passed on */
+    {
+        GVariantBuilder builder;
+        GVariant *variant = NULL, *value = NULL;
+
+        g_variant_builder_init (&builder, G_VARIANT_TYPE_VARDICT);
+        g_variant_builder_add (&builder, "{sv}", "Caption",
+                               g_variant_new_string (caption));
+        g_variant_builder_add (&builder, "{sv}", "Vendor.Extra",
+                               g_variant_new_int64 (42));
+        identity = gsignond_identity_info_new_from_variant (
+                g_variant_builder_end (&builder));
+        identity2 = gsignond_identity_info_copy (identity);
+        gsignond_identity_info_unref (identity);
+
+        variant = g_variant_ref_sink (
+                gsignond_identity_info_to_variant (identity2));
+        value = g_variant_lookup_value (variant, "Vendor.Extra",
+                                        G_VARIANT_TYPE_INT64);
+        fail_if (value == NULL);
+        fail_unless (g_variant_get_int64 (value) == 42);
+        g_variant_unref (value);
+        g_variant_unref (variant);
+        gsignond_identity_info_unref (identity2);
+    }
+}
+END_TEST
+
+START_TEST (test_access_control_cache)
+{
+    GSignondConfig *config = gsignond_config_new ();
+    GSignondAccessControlManager *acm = NULL;
+    GSignondIdentityInfo *info = NULL;
+    GSignondSecurityContext *peer, *other;
+    GSignondSecurityContextList *acl = NULL;
+    gboolean allowed = FALSE;
+    guint generation;
+
+    acm = g_object_new (GSIGNOND_TYPE_ACCESS_CONTROL_MANAGER,
+                        "config", config, NULL);
+    fail_if (acm == NULL);
+
+    peer = gsignond_security_context_new_from_values ("sysctx1", "appctx1");
+    other = gsignond_security_context_new_from_values ("sysctx2", "appctx2");
+
+    info = gsignond_identity_info_new ();
+    generation = gsignond_identity_info_get_acl_generation (info);
+    fail_unless (generation != 0);
+
+    fail_unless (gsignond_access_control_manager_lookup_identity_decision (
+                acm, peer, 1, generation, &allowed) == FALSE);
+    gsignond_access_control_manager_cache_identity_decision (
+                acm, peer, 1, generation, TRUE);
+    fail_unless (gsignond_access_control_manager_lookup_identity_decision (
+                acm, peer, 1, generation, &allowed) == TRUE);
+    fail_unless (allowed == TRUE);
+    fail_unless (gsignond_access_control_manager_lookup_identity_decision (
+                acm, other, 1, generation, &allowed) == FALSE);
+    fail_unless (gsignond_access_control_manager_lookup_identity_decision (
+                acm, peer, 2, generation, &allowed) == FALSE);
+
+    /* changing the acl must not hit the old decision */
+    acl = g_list_append (acl, other);
+    fail_unless (gsignond_identity_info_set_access_control_list (
+                info, acl) == TRUE);
+    g_list_free (acl);
+    fail_unless (gsignond_identity_info_get_acl_generation (info) !=
+                 generation);
+    generation = gsignond_identity_info_get_acl_generation (info);
+    fail_unless (gsignond_access_control_manager_lookup_identity_decision (
+                acm, peer, 1, generation, &allowed) == FALSE);
+
+    /* so must changing the owner */
+    fail_unless (gsignond_identity_info_set_owner (info, peer) == TRUE);
+    fail_unless (gsignond_identity_info_get_acl_generation (info) !=
+                 generation);
+
+    gsignond_access_control_manager_cache_identity_decision (
+                acm, peer, 1, generation, FALSE);
+    fail_unless (gsignond_access_control_manager_lookup_identity_decision (
+                acm, peer, 1, generation, &allowed) == TRUE);
+    fail_unless (allowed == FALSE);
+    gsignond_access_control_manager_clear_decision_cache (acm);
+    fail_unless (gsignond_access_control_manager_lookup_identity_decision (
+                acm, peer, 1, generation, &allowed) == FALSE);
+
+    gsignond_identity_info_unref (info);
+    gsignond_security_context_free (peer);
+    gsignond_security_context_free (other);
+    g_object_unref (acm);
+    g_object_unref (config);
 }
 END_TEST
 
@@ -379,6 +678,102 @@ START_TEST (test_is_host_in_domain)
 }
 END_TEST
 
+START_TEST (test_str_intern)
+{
+    gchar *value = g_strdup ("appctx1");
+    const gchar *str1, *str2;
+    GSignondSecurityContext *ctx1, *ctx2;
+
+    fail_unless (gsignond_str_intern (NULL) == NULL);
+
+    str1 = gsignond_str_intern (value);
+    str2 = gsignond_str_intern ("appctx1");
+    fail_unless (str1 != value);
+    fail_unless (str1 == str2);
+    fail_unless (g_strcmp0 (str1, value) == 0);
+    gsignond_str_unintern (str2);
+    /* still referenced once */
+    fail_unless (gsignond_str_intern ("appctx1") == str1);
+    gsignond_str_unintern (str1);
+    gsignond_str_unintern (str1);
+    g_free (value);
+
+    /* security contexts own their public strings, which callers may free
+     * and replace */
+    ctx1 = gsignond_security_context_new_from_values ("sysctx1", "appctx1");
+    ctx2 = gsignond_security_context_copy (ctx1);
+    fail_unless (gsignond_security_context_compare (ctx1, ctx2) == 0);
+    g_free (ctx2->app_ctx);
+    ctx2->app_ctx = g_strdup ("appctx1");
+    fail_unless (gsignond_security_context_compare (ctx1, ctx2) == 0);
+    gsignond_security_context_set_application_context (ctx2, "appctx2");
+    fail_unless (gsignond_security_context_compare (ctx1, ctx2) < 0);
+    gsignond_security_context_free (ctx1);
+    gsignond_security_context_free (ctx2);
+}
+END_TEST
+
+#define NONCE_THREADS 4
+#define NONCES_PER_THREAD 20000
+
+static gpointer
+_generate_nonces (gpointer data)
+{
+    gchar *nonces = (gchar *) data;
+    guint i;
+
+    /* checked by the main thread, check cannot fail from other threads */
+    for (i = 0; i < NONCES_PER_THREAD; i++)
+        if (!gsignond_generate_nonce_into (
+                nonces + i * (GSIGNOND_NONCE_LENGTH + 1)))
+            break;
+    return GUINT_TO_POINTER (i);
+}
+
+/* checks that threads get distinct nonces, and prints the throughput
+ * without failing on it */
+START_TEST (test_generate_nonce)
+{
+    GThread *threads[NONCE_THREADS];
+    GHashTable *seen;
+    gchar *nonces, *nonce;
+    gint64 elapsed;
+    guint i;
+
+    nonce = gsignond_generate_nonce ();
+    fail_unless (nonce != NULL);
+    fail_unless (strlen (nonce) == GSIGNOND_NONCE_LENGTH);
+    fail_unless (strspn (nonce, "0123456789abcdef") == GSIGNOND_NONCE_LENGTH);
+
+    nonces = g_malloc (NONCE_THREADS * NONCES_PER_THREAD *
+                       (GSIGNOND_NONCE_LENGTH + 1));
+    elapsed = g_get_monotonic_time ();
+    for (i = 0; i < NONCE_THREADS; i++)
+        threads[i] = g_thread_new ("nonce", _generate_nonces,
+                nonces + i * NONCES_PER_THREAD * (GSIGNOND_NONCE_LENGTH + 1));
+    for (i = 0; i < NONCE_THREADS; i++)
+        fail_unless (GPOINTER_TO_UINT (g_thread_join (threads[i])) ==
+                     NONCES_PER_THREAD);
+    elapsed = g_get_monotonic_time () - elapsed;
+
+    seen = g_hash_table_new (g_str_hash, g_str_equal);
+    g_hash_table_add (seen, nonce);
+    for (i = 0; i < NONCE_THREADS * NONCES_PER_THREAD; i++) {
+        gchar *str = nonces + i * (GSIGNOND_NONCE_LENGTH + 1);
+        fail_unless (strlen (str) == GSIGNOND_NONCE_LENGTH);
+        fail_if (g_hash_table_contains (seen, str));
+        g_hash_table_add (seen, str);
+    }
+    g_hash_table_unref (seen);
+    g_free (nonces);
+    g_free (nonce);
+
+    g_print ("%u threads generated %.0f nonces/s\n", NONCE_THREADS,
+             (gdouble) NONCE_THREADS * NONCES_PER_THREAD * G_USEC_PER_SEC /
+             MAX (elapsed, 1));
+}
+END_TEST
+
 Suite* common_suite (void)
 {
     Suite *s = suite_create ("Common library");
@@ -387,9 +782,15 @@ Suite* common_suite (void)
     TCase *tc_core = tcase_create ("Tests");
     tcase_add_test (tc_core, test_identity_info);
     tcase_add_test (tc_core, test_pipe_stream);
+    tcase_add_test (tc_core, test_frame_channel);
+    tcase_add_test (tc_core, test_timer_wheel);
+    tcase_add_test (tc_core, test_refresh_schedule);
     tcase_add_test (tc_core, test_session_data);
     tcase_add_test (tc_core, test_plugin_loader);
     tcase_add_test (tc_core, test_is_host_in_domain);
+    tcase_add_test (tc_core, test_access_control_cache);
+    tcase_add_test (tc_core, test_str_intern);
+    tcase_add_test (tc_core, test_generate_nonce);
     suite_add_tcase (s, tc_core);
     return s;
 }
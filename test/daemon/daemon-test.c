@@ -32,12 +32,14 @@
 #include <glib.h>
 #include <string.h>
 #include <unistd.h>
+#include <sys/stat.h>
 
 #include "daemon/dbus/gsignond-dbus.h"
 #include "daemon/dbus/gsignond-dbus-auth-service-gen.h"
 #include "daemon/dbus/gsignond-dbus-identity-gen.h"
 #include "daemon/dbus/gsignond-dbus-auth-session-gen.h"
 #include "common/gsignond-identity-info.h"
+#include "gsignond/gsignond-error.h"
 #include "gsignond/gsignond-log.h"
 
 #ifdef USE_P2P
@@ -86,6 +88,50 @@ static gchar* _get_executable_name()
     return path;
 }
 
+#define TEST_LOADERS_DIR "/tmp/gsignond-loaders"
+
+/* a plugin loader that lists a plugin it can not start */
+static const gchar *broken_loader =
+    "#!/bin/sh\n"
+    "if [ \"$1\" = \"--describe\" ]; then\n"
+    "    echo \"([], [('broken', ['mech1'])])\"\n"
+    "    exit 0\n"
+    "fi\n"
+    "exit 1\n";
+
+/* the daemon takes every file in SSO_BIN_DIR for a plugin loader, so the
+ * test loader is put next to links to the real ones */
+static void
+_setup_loaders_dir (void)
+{
+    const gchar *bin_dir = g_getenv ("SSO_BIN_DIR");
+    const gchar *name;
+    gchar *path = NULL;
+    GDir *dir = NULL;
+
+    fail_if (bin_dir == NULL, "No SSO bin dir found");
+    fail_if (g_mkdir_with_parents (TEST_LOADERS_DIR, 0700) != 0);
+
+    dir = g_dir_open (bin_dir, 0, NULL);
+    fail_if (dir == NULL, "Failed to open %s", bin_dir);
+    while ((name = g_dir_read_name (dir)) != NULL) {
+        gchar *target = g_build_filename (bin_dir, name, NULL);
+        path = g_build_filename (TEST_LOADERS_DIR, name, NULL);
+        fail_if (symlink (target, path) != 0, "Failed to link %s : %s",
+                 target, strerror (errno));
+        g_free (target);
+        g_free (path);
+    }
+    g_dir_close (dir);
+
+    path = g_build_filename (TEST_LOADERS_DIR, "gsignond-broken-plugind", NULL);
+    fail_if (g_file_set_contents (path, broken_loader, -1, NULL) == FALSE);
+    fail_if (chmod (path, 0700) != 0);
+    g_free (path);
+
+    fail_if (g_setenv ("SSO_BIN_DIR", TEST_LOADERS_DIR, TRUE) == FALSE);
+}
+
 static void
 setup_daemon (void)
 {
@@ -99,9 +145,10 @@ setup_daemon (void)
     DBG ("Programe pid %d, name : %s\n", getpid(), exe_name);
     free(exe_name);
 
-    if (system("rm -rf /tmp/gsignond") != 0) {
+    if (system("rm -rf /tmp/gsignond " TEST_LOADERS_DIR) != 0) {
         DBG("Failed to clean db path : %s\n", strerror(errno));
     }
+    _setup_loaders_dir ();
 #if HAVE_GTESTDBUS
     dbus = g_test_dbus_new (G_TEST_DBUS_NONE);
     fail_unless (dbus != NULL, "could not create test dbus");
@@ -492,6 +539,115 @@ START_TEST(test_identity_get_identity)
 }
 END_TEST
 
+START_TEST(test_identity_get_info)
+{
+    GError *error = NULL; gboolean res = FALSE;
+    GSignondDbusAuthService *auth_service = 0;
+    GSignondDbusIdentity *identity = 0;
+    GSignondIdentityInfo *info = NULL;
+    GVariant *identity_info = NULL;
+    const gchar *methods[] = { "ssotest", NULL };
+    const gchar *mechanisms1[] = { "mech1", NULL };
+    const gchar **mechanisms[] = { mechanisms1 };
+    guint id;
+
+    GDBusConnection *connection = _get_bus_connection (&error);
+    fail_if (connection == NULL, "failed to get bus connection : %s", error ? error->message : "(null)");
+
+    auth_service = _get_auth_service (connection, &error);
+    fail_if (auth_service == NULL, "failed to get auth_service : %s", error ? error->message : "");
+
+    identity = _register_identity (auth_service, "test_app", &error);
+    fail_if (identity == NULL, "Failed to register identity : %s", error ? error->message : "");
+
+    res = gsignond_dbus_identity_call_store_sync (identity,
+            _get_test_identity_data (), &id, NULL, &error);
+    fail_if (res == FALSE, "Failed to store identity : %s", error ? error->message : "");
+
+    /* repeated calls are answered from the cached reply */
+    res = gsignond_dbus_identity_call_get_info_sync (identity, &identity_info,
+                                                     NULL, &error);
+    fail_if (res == FALSE, "Failed to get info : %s", error ? error->message : "");
+    fail_if (_validate_identity_info (identity_info) == FALSE);
+    g_variant_unref (identity_info);
+
+    res = gsignond_dbus_identity_call_get_info_sync (identity, &identity_info,
+                                                     NULL, &error);
+    fail_if (res == FALSE, "Failed to get info : %s", error ? error->message : "");
+    fail_if (_validate_identity_info (identity_info) == FALSE);
+    g_variant_unref (identity_info);
+
+    /* and the cached reply follows identity updates */
+    res = gsignond_dbus_identity_call_store_sync (identity,
+            _create_identity_info_with_data ("test_user", "new_caption", 0,
+                                             methods, mechanisms),
+            &id, NULL, &error);
+    fail_if (res == FALSE, "Failed to store identity : %s", error ? error->message : "");
+
+    res = gsignond_dbus_identity_call_get_info_sync (identity, &identity_info,
+                                                     NULL, &error);
+    fail_if (res == FALSE, "Failed to get info : %s", error ? error->message : "");
+    info = gsignond_identity_info_new_from_variant (identity_info);
+    fail_if (info == NULL);
+    fail_if (g_strcmp0 (gsignond_identity_info_get_caption (info), "new_caption") != 0);
+    fail_if (gsignond_identity_info_get_id (info) != id);
+    gsignond_identity_info_unref (info);
+    g_variant_unref (identity_info);
+
+    g_object_unref (identity);
+    g_object_unref (auth_service);
+    g_object_unref (connection);
+}
+END_TEST
+
+static gboolean _strv_contains (gchar **strv, const gchar *str)
+{
+    for (; strv && *strv; strv++)
+        if (g_strcmp0 (*strv, str) == 0) return TRUE;
+    return FALSE;
+}
+
+START_TEST(test_query_methods_and_mechanisms)
+{
+    GError *error = NULL; gboolean res = FALSE;
+    GSignondDbusAuthService *auth_service = 0;
+    gchar **methods = NULL;
+    gchar **mechanisms = NULL;
+    gint i;
+
+    GDBusConnection *connection = _get_bus_connection (&error);
+    fail_if (connection == NULL, "failed to get bus connection : %s", error ? error->message : "(null)");
+
+    auth_service = _get_auth_service (connection, &error);
+    fail_if (auth_service == NULL, "failed to get auth_service : %s", error ? error->message : "");
+
+    for (i = 0; i < 2; i++) {
+        res = gsignond_dbus_auth_service_call_query_methods_sync (auth_service,
+                &methods, NULL, &error);
+        fail_if (res == FALSE, "Failed to query methods : %s", error ? error->message : "");
+        fail_if (methods == NULL);
+        fail_if (!_strv_contains (methods, "ssotest"));
+        g_strfreev (methods);
+
+        res = gsignond_dbus_auth_service_call_query_mechanisms_sync (auth_service,
+                "ssotest", &mechanisms, NULL, &error);
+        fail_if (res == FALSE, "Failed to query mechanisms : %s", error ? error->message : "");
+        fail_if (mechanisms == NULL);
+        fail_if (!_strv_contains (mechanisms, "mech1"));
+        g_strfreev (mechanisms);
+    }
+
+    res = gsignond_dbus_auth_service_call_query_mechanisms_sync (auth_service,
+            "unknown", &mechanisms, NULL, &error);
+    fail_if (res == TRUE);
+    fail_if (error == NULL);
+    g_clear_error (&error);
+
+    g_object_unref (auth_service);
+    g_object_unref (connection);
+}
+END_TEST
+
 START_TEST(test_clear_database)
 {
     GError *error = 0;
@@ -614,6 +770,472 @@ START_TEST(test_identity_signout)
 }
 END_TEST
 
+typedef struct {
+    GMainLoop *loop;
+    gint pending;
+    gchar *request_ids[2]; /* as numbered by the test plugin */
+    gint n_replies;
+    gchar *other_request_id; /* of the reply to other data */
+} _ProcessReplies;
+
+static void _on_process_reply (GSignondDbusAuthSession *sender, GAsyncResult *reply, gpointer data)
+{
+    _ProcessReplies *replies = (_ProcessReplies *) data;
+    GError *error = NULL;
+    GVariant *result = NULL;
+    gchar *realm = NULL;
+    const gchar *caption = NULL;
+    gchar **id = NULL;
+    gboolean ret;
+
+    ret = gsignond_dbus_auth_session_call_process_finish (sender, &result, reply, &error);
+    fail_if (ret == FALSE, "failed to finish process, %s", error ? error->message : "");
+    fail_if (g_variant_lookup (result, "Realm", "s", &realm) == FALSE);
+    fail_if (g_strcmp0 (realm, "testRealm_after_test") != 0);
+    g_free (realm);
+    /* the test plugin echoes the caption */
+    fail_if (g_variant_lookup (result, "Caption", "&s", &caption) == FALSE);
+    if (g_strcmp0 (caption, "not coalesced") == 0) {
+        fail_if (replies->other_request_id != NULL);
+        id = &replies->other_request_id;
+    } else {
+        fail_if (replies->n_replies >= (gint) G_N_ELEMENTS (replies->request_ids));
+        id = &replies->request_ids[replies->n_replies++];
+    }
+    fail_if (g_variant_lookup (result, "TestRequestId", "s", id) == FALSE);
+    g_variant_unref (result);
+
+    if (--replies->pending == 0)
+        g_main_loop_quit (replies->loop);
+}
+
+START_TEST(test_auth_session_process_coalesced)
+{
+    GError *error = 0;
+    gboolean res;
+    GSignondDbusAuthService *auth_service = 0;
+    GSignondDbusIdentity *identity = 0;
+    GSignondDbusAuthSession *auth_sessions[2] = { 0, 0 };
+    GVariant *identity_info = NULL;
+    GVariantBuilder builder;
+    GVariant *session_data = NULL;
+    gchar *session_path = NULL;
+    guint id;
+    gint i;
+    GVariant *other_data = NULL;
+    _ProcessReplies replies = { NULL, 3, { NULL, NULL }, 0, NULL };
+    GDBusConnection *connection = _get_bus_connection (&error);
+    fail_if (connection == NULL, "failed to get bus connection : %s", error ? error->message : "(null)");
+
+    replies.loop = g_main_loop_new (NULL, FALSE);
+
+    auth_service = _get_auth_service (connection, &error);
+    fail_if (auth_service == NULL, "failed to get auth_service : %s", error ? error->message : "");
+
+    identity = _register_identity (auth_service, "", &error);
+    fail_if (identity == NULL, "Failed to register new identity : %s", error ? error->message : "");
+
+    identity_info = _get_test_identity_data ();
+    res = gsignond_dbus_identity_call_store_sync (identity, identity_info,
+                                                  &id, NULL, &error);
+    fail_if (res == FALSE, "Failed to store identity");
+
+    /* both sessions are served by the same request to the plugin, and both
+     * get its answer; a request with other data runs on its own */
+    g_variant_builder_init (&builder, G_VARIANT_TYPE_VARDICT);
+    g_variant_builder_add (&builder, "{sv}", "Caption", g_variant_new_string ("coalesced"));
+    session_data = g_variant_ref_sink (g_variant_builder_end (&builder));
+    g_variant_builder_init (&builder, G_VARIANT_TYPE_VARDICT);
+    g_variant_builder_add (&builder, "{sv}", "Caption", g_variant_new_string ("not coalesced"));
+    other_data = g_variant_ref_sink (g_variant_builder_end (&builder));
+
+    for (i = 0; i < 2; i++) {
+        res = gsignond_dbus_identity_call_get_auth_session_sync (
+                identity, "ssotest", &session_path, NULL, &error);
+        fail_if (res == FALSE, "Failed to create authentication session : %s",
+            error ? error->message : "");
+        auth_sessions[i] = _get_auth_session_for_path (connection, session_path, &error);
+        fail_if (auth_sessions[i] == NULL, "(null) session object");
+        g_free (session_path);
+        session_path = NULL;
+    }
+    for (i = 0; i < 2; i++)
+        gsignond_dbus_auth_session_call_process (auth_sessions[i], session_data,
+                "mech1", NULL, (GAsyncReadyCallback)_on_process_reply, &replies);
+    gsignond_dbus_auth_session_call_process (auth_sessions[0], other_data,
+            "mech1", NULL, (GAsyncReadyCallback)_on_process_reply, &replies);
+
+    g_main_loop_run (replies.loop);
+    fail_unless (replies.pending == 0);
+
+    /* the plugin ran once for the two equal requests and once for the
+     * other one */
+    fail_unless (replies.n_replies == 2);
+    fail_unless (g_strcmp0 (replies.request_ids[0], replies.request_ids[1]) == 0,
+                 "equal requests were not coalesced");
+    fail_if (g_strcmp0 (replies.request_ids[0], replies.other_request_id) == 0,
+             "a request with other data was coalesced");
+
+    for (i = 0; i < replies.n_replies; i++)
+        g_free (replies.request_ids[i]);
+    g_free (replies.other_request_id);
+    g_variant_unref (session_data);
+    g_variant_unref (other_data);
+    g_main_loop_unref (replies.loop);
+    for (i = 0; i < 2; i++)
+        g_object_unref (auth_sessions[i]);
+    g_object_unref (auth_service);
+    g_object_unref (identity);
+    g_object_unref (connection);
+}
+END_TEST
+
+static void _on_state_changed (GSignondDbusAuthSession *sender, gint state, const gchar *message, gpointer data)
+{
+    (*(gint *) data)++;
+}
+
+typedef struct {
+    GMainLoop *loop;
+    gchar *request_id; /* as numbered by the test plugin */
+} _CachedReplies;
+
+static void _on_cached_process_reply (GSignondDbusAuthSession *sender, GAsyncResult *reply, gpointer data)
+{
+    _CachedReplies *replies = (_CachedReplies *) data;
+    GError *error = NULL;
+    GVariant *result = NULL;
+    gboolean ret;
+
+    ret = gsignond_dbus_auth_session_call_process_finish (sender, &result, reply, &error);
+    fail_if (ret == FALSE, "failed to finish process, %s", error ? error->message : "");
+    /* the cache hint of the plugin is not passed on */
+    fail_if (g_variant_lookup_value (result, "CacheTtl", NULL) != NULL);
+    g_free (replies->request_id);
+    fail_if (g_variant_lookup (result, "TestRequestId", "s", &replies->request_id) == FALSE);
+    g_variant_unref (result);
+
+    g_main_loop_quit (replies->loop);
+}
+
+START_TEST(test_auth_session_process_cached)
+{
+    GError *error = 0;
+    gboolean res;
+    GSignondDbusAuthService *auth_service = 0;
+    GSignondDbusIdentity *identity = 0;
+    GSignondDbusAuthSession *auth_session = 0;
+    GVariantBuilder builder;
+    GVariant *session_data = NULL;
+    gchar *session_path = NULL;
+    gchar *request_id = NULL;
+    guint id;
+    gint n_state_changes = 0, n_first_state_changes = 0;
+    _CachedReplies replies = { NULL, NULL };
+    GDBusConnection *connection = _get_bus_connection (&error);
+    fail_if (connection == NULL, "failed to get bus connection : %s", error ? error->message : "(null)");
+
+    replies.loop = g_main_loop_new (NULL, FALSE);
+
+    auth_service = _get_auth_service (connection, &error);
+    fail_if (auth_service == NULL, "failed to get auth_service : %s", error ? error->message : "");
+
+    identity = _register_identity (auth_service, "", &error);
+    fail_if (identity == NULL, "Failed to register new identity : %s", error ? error->message : "");
+
+    res = gsignond_dbus_identity_call_store_sync (identity,
+            _get_test_identity_data (), &id, NULL, &error);
+    fail_if (res == FALSE, "Failed to store identity");
+
+    res = gsignond_dbus_identity_call_get_auth_session_sync (
+            identity, "ssotest", &session_path, NULL, &error);
+    fail_if (res == FALSE, "Failed to create authentication session : %s",
+        error ? error->message : "");
+    auth_session = _get_auth_session_for_path (connection, session_path, &error);
+    fail_if (auth_session == NULL, "(null) session object");
+    g_free (session_path);
+
+    g_signal_connect (auth_session, "state-changed", G_CALLBACK (_on_state_changed), &n_state_changes);
+
+    /* a cache hint from the client is dropped, and mech1 of the test
+     * plugin, which echoes the session data, runs every time */
+    g_variant_builder_init (&builder, G_VARIANT_TYPE_VARDICT);
+    g_variant_builder_add (&builder, "{sv}", "CacheTtl", g_variant_new_uint32 (60));
+    session_data = g_variant_ref_sink (g_variant_builder_end (&builder));
+
+    gsignond_dbus_auth_session_call_process (auth_session, session_data,
+            "mech1", NULL, (GAsyncReadyCallback)_on_cached_process_reply, &replies);
+    g_main_loop_run (replies.loop);
+    request_id = g_strdup (replies.request_id);
+    gsignond_dbus_auth_session_call_process (auth_session, session_data,
+            "mech1", NULL, (GAsyncReadyCallback)_on_cached_process_reply, &replies);
+    g_main_loop_run (replies.loop);
+    fail_if (g_strcmp0 (request_id, replies.request_id) == 0,
+             "response was cached on a hint of the client");
+    g_free (request_id);
+    g_variant_unref (session_data);
+
+    /* TestCacheTtl makes the test plugin set the cache hint itself */
+    g_variant_builder_init (&builder, G_VARIANT_TYPE_VARDICT);
+    g_variant_builder_add (&builder, "{sv}", "TestCacheTtl", g_variant_new_uint32 (60));
+    session_data = g_variant_ref_sink (g_variant_builder_end (&builder));
+
+    n_state_changes = 0;
+    gsignond_dbus_auth_session_call_process (auth_session, session_data,
+            "mech1", NULL, (GAsyncReadyCallback)_on_cached_process_reply, &replies);
+    g_main_loop_run (replies.loop);
+    n_first_state_changes = n_state_changes;
+    fail_unless (n_first_state_changes > 0);
+    request_id = g_strdup (replies.request_id);
+
+    /* answered by the daemon, without running the plugin */
+    gsignond_dbus_auth_session_call_process (auth_session, session_data,
+            "mech1", NULL, (GAsyncReadyCallback)_on_cached_process_reply, &replies);
+    g_main_loop_run (replies.loop);
+    fail_unless (n_state_changes == n_first_state_changes);
+    fail_unless (g_strcmp0 (request_id, replies.request_id) == 0,
+                 "response was not cached");
+    g_free (request_id);
+
+    g_free (replies.request_id);
+    g_variant_unref (session_data);
+    g_main_loop_unref (replies.loop);
+    g_object_unref (auth_session);
+    g_object_unref (auth_service);
+    g_object_unref (identity);
+    g_object_unref (connection);
+}
+END_TEST
+
+START_TEST(test_authenticate)
+{
+    GError *error = 0;
+    gboolean res;
+    GSignondDbusAuthService *auth_service = 0;
+    GSignondDbusIdentity *identity = 0;
+    GVariantBuilder builder;
+    GVariant *session_data = NULL;
+    GVariant *result = NULL;
+    gchar *session_path = NULL;
+    const gchar *caption = NULL;
+    guint id;
+    GDBusConnection *connection = _get_bus_connection (&error);
+    fail_if (connection == NULL, "failed to get bus connection : %s", error ? error->message : "(null)");
+
+    auth_service = _get_auth_service (connection, &error);
+    fail_if (auth_service == NULL, "failed to get auth_service : %s", error ? error->message : "");
+
+    identity = _register_identity (auth_service, "", &error);
+    fail_if (identity == NULL, "Failed to register new identity : %s", error ? error->message : "");
+
+    res = gsignond_dbus_identity_call_store_sync (identity,
+            _get_test_identity_data (), &id, NULL, &error);
+    fail_if (res == FALSE, "Failed to store identity");
+    g_object_unref (identity);
+
+    /* mech1 of the test plugin echoes the session data */
+    g_variant_builder_init (&builder, G_VARIANT_TYPE_VARDICT);
+    g_variant_builder_add (&builder, "{sv}", "Caption", g_variant_new_string ("one-shot"));
+    session_data = g_variant_ref_sink (g_variant_builder_end (&builder));
+
+    res = gsignond_dbus_auth_service_call_authenticate_sync (auth_service,
+            id, "ssotest", "mech1", session_data, "",
+            &result, &session_path, NULL, &error);
+    fail_if (res == FALSE, "Failed to authenticate : %s", error ? error->message : "");
+    fail_if (g_variant_lookup (result, "Caption", "&s", &caption) == FALSE);
+    fail_if (g_strcmp0 (caption, "one-shot") != 0);
+    /* no session is exported without user interaction */
+    fail_if (g_strcmp0 (session_path, "/") != 0);
+    g_variant_unref (result);
+    g_free (session_path);
+
+    res = gsignond_dbus_auth_service_call_authenticate_sync (auth_service,
+            id, "nonexisting", "mech1", session_data, "",
+            &result, &session_path, NULL, &error);
+    fail_if (res == TRUE, "Authenticated with an unknown method");
+    fail_if (error == NULL);
+    g_error_free (error);
+
+    g_variant_unref (session_data);
+    g_object_unref (auth_service);
+    g_object_unref (connection);
+}
+END_TEST
+
+typedef struct {
+    GMainLoop *loop;
+    gchar *signalled_path;
+    gchar *session_path;
+    gboolean finished;
+    GError *error;
+} _AuthenticateReply;
+
+static void _on_authenticate_user_action (GSignondDbusAuthService *sender,
+                                          guint id,
+                                          const gchar *method,
+                                          const gchar *session_path,
+                                          gpointer data)
+{
+    _AuthenticateReply *reply = (_AuthenticateReply *) data;
+
+    /* the session is announced before the request is answered */
+    fail_if (reply->finished);
+    fail_if (g_strcmp0 (method, "ssotest") != 0);
+    g_free (reply->signalled_path);
+    reply->signalled_path = g_strdup (session_path);
+}
+
+static void _on_authenticate_reply (GSignondDbusAuthService *sender, GAsyncResult *res, gpointer data)
+{
+    _AuthenticateReply *reply = (_AuthenticateReply *) data;
+    GVariant *result = NULL;
+
+    if (gsignond_dbus_auth_service_call_authenticate_finish (sender, &result,
+            &reply->session_path, res, &reply->error))
+        g_variant_unref (result);
+    reply->finished = TRUE;
+    g_main_loop_quit (reply->loop);
+}
+
+START_TEST(test_authenticate_user_action)
+{
+    GError *error = 0;
+    gboolean res;
+    GSignondDbusAuthService *auth_service = 0;
+    GSignondDbusIdentity *identity = 0;
+    GSignondDbusAuthSession *auth_session = 0;
+    GVariantBuilder builder;
+    GVariant *session_data = NULL;
+    gchar **mechanisms = NULL;
+    const gchar *wanted[] = { "mech2", NULL };
+    _AuthenticateReply reply = { NULL, NULL, NULL, FALSE, NULL };
+    gulong handler_id;
+    guint id;
+    GDBusConnection *connection = _get_bus_connection (&error);
+    fail_if (connection == NULL, "failed to get bus connection : %s", error ? error->message : "(null)");
+
+    reply.loop = g_main_loop_new (NULL, FALSE);
+
+    auth_service = _get_auth_service (connection, &error);
+    fail_if (auth_service == NULL, "failed to get auth_service : %s", error ? error->message : "");
+
+    identity = _register_identity (auth_service, "", &error);
+    fail_if (identity == NULL, "Failed to register new identity : %s", error ? error->message : "");
+    res = gsignond_dbus_identity_call_store_sync (identity,
+            _get_test_identity_data (), &id, NULL, &error);
+    fail_if (res == FALSE, "Failed to store identity");
+    g_object_unref (identity);
+
+    /* mech2 of the test plugin asks for the user's password */
+    handler_id = g_signal_connect (auth_service,
+            "authenticate-user-action-required",
+            G_CALLBACK (_on_authenticate_user_action), &reply);
+    g_variant_builder_init (&builder, G_VARIANT_TYPE_VARDICT);
+    session_data = g_variant_ref_sink (g_variant_builder_end (&builder));
+    gsignond_dbus_auth_service_call_authenticate (auth_service,
+            id, "ssotest", "mech2", session_data, "", NULL,
+            (GAsyncReadyCallback) _on_authenticate_reply, &reply);
+    g_main_loop_run (reply.loop);
+    g_signal_handler_disconnect (auth_service, handler_id);
+
+    fail_if (reply.signalled_path == NULL, "No session for the user action");
+    fail_if (g_strcmp0 (reply.signalled_path, "/") == 0);
+    /* there is no UI in the test, so the request may fail, but a
+     * successful one names the same session */
+    if (reply.error)
+        g_clear_error (&reply.error);
+    else
+        fail_if (g_strcmp0 (reply.session_path, reply.signalled_path) != 0);
+
+    /* the announced session can be used by the caller */
+    auth_session = _get_auth_session_for_path (connection, reply.signalled_path, &error);
+    fail_if (auth_session == NULL, "(null) session object");
+    res = gsignond_dbus_auth_session_call_query_available_mechanisms_sync (
+            auth_session, wanted, &mechanisms, NULL, &error);
+    fail_if (res == FALSE, "Failed to query the announced session : %s",
+        error ? error->message : "");
+    fail_if (!_strv_contains (mechanisms, "mech2"));
+    g_strfreev (mechanisms);
+
+    g_free (reply.signalled_path);
+    g_free (reply.session_path);
+    g_main_loop_unref (reply.loop);
+    g_variant_unref (session_data);
+    g_object_unref (auth_session);
+    g_object_unref (auth_service);
+    g_object_unref (connection);
+}
+END_TEST
+
+START_TEST(test_authenticate_broken_plugin)
+{
+    GError *error = 0;
+    gboolean res;
+    GSignondDbusAuthService *auth_service = 0;
+    GSignondDbusIdentity *identity = 0;
+    GSignondDbusAuthSession *auth_session = 0;
+    GVariant *identity_info = NULL;
+    GVariantBuilder builder;
+    GVariant *session_data = NULL;
+    GVariant *result = NULL;
+    gchar *session_path = NULL;
+    const gchar *methods[] = { "broken", NULL };
+    const gchar *mech[] = { "mech1", NULL };
+    const gchar **mechanisms[] = { mech };
+    guint id;
+    gint i;
+    GDBusConnection *connection = _get_bus_connection (&error);
+    fail_if (connection == NULL, "failed to get bus connection : %s", error ? error->message : "(null)");
+
+    auth_service = _get_auth_service (connection, &error);
+    fail_if (auth_service == NULL, "failed to get auth_service : %s", error ? error->message : "");
+
+    identity = _register_identity (auth_service, "", &error);
+    fail_if (identity == NULL, "Failed to register new identity : %s", error ? error->message : "");
+
+    identity_info = _create_identity_info_with_data ("user1", "broken", 1,
+                                                     methods, mechanisms);
+    res = gsignond_dbus_identity_call_store_sync (identity, identity_info,
+                                                  &id, NULL, &error);
+    fail_if (res == FALSE, "Failed to store identity : %s", error ? error->message : "");
+
+    g_variant_builder_init (&builder, G_VARIANT_TYPE_VARDICT);
+    g_variant_builder_add (&builder, "{sv}", "Caption", g_variant_new_string ("broken"));
+    session_data = g_variant_ref_sink (g_variant_builder_end (&builder));
+
+    /* the session is kept, so its plugin fails to start only once */
+    res = gsignond_dbus_identity_call_get_auth_session_sync (
+            identity, "broken", &session_path, NULL, &error);
+    fail_if (res == FALSE, "Failed to create authentication session : %s",
+        error ? error->message : "");
+    auth_session = _get_auth_session_for_path (connection, session_path, &error);
+    fail_if (auth_session == NULL, "(null) session object");
+    g_free (session_path);
+
+    res = gsignond_dbus_auth_session_call_process_sync (auth_session,
+            session_data, "mech1", &result, NULL, &error);
+    fail_if (res == TRUE, "Processed with a plugin that can not start");
+    fail_if (error == NULL);
+    g_clear_error (&error);
+
+    /* the session now answers at once, before the caller got it back */
+    for (i = 0; i < 2; i++) {
+        res = gsignond_dbus_auth_service_call_authenticate_sync (auth_service,
+                id, "broken", "mech1", session_data, "",
+                &result, &session_path, NULL, &error);
+        fail_if (res == TRUE, "Authenticated with a plugin that can not start");
+        fail_if (error == NULL);
+        g_clear_error (&error);
+    }
+
+    g_variant_unref (session_data);
+    g_object_unref (auth_session);
+    g_object_unref (identity);
+    g_object_unref (auth_service);
+    g_object_unref (connection);
+}
+END_TEST
+
 START_TEST(test_query_identities)
 {
     GDBusConnection *connection = NULL;
@@ -755,6 +1377,144 @@ START_TEST(test_query_identities)
 }
 END_TEST
 
+static gboolean
+_has_identity_error (GVariant *errors, guint32 id, gint code)
+{
+    /* registers the error names of the domain */
+    GQuark domain = GSIGNOND_ERROR;
+    GVariantIter iter;
+    guint32 err_id;
+    const gchar *name;
+    gboolean found = FALSE;
+
+    g_variant_iter_init (&iter, errors);
+    while (!found && g_variant_iter_next (&iter, "{u&s}", &err_id, &name)) {
+        GError *error;
+
+        if (err_id != id) continue;
+        error = g_dbus_error_new_for_dbus_error (name, "");
+        found = g_error_matches (error, domain, code);
+        g_error_free (error);
+    }
+
+    return found;
+}
+
+START_TEST(test_get_identities_info)
+{
+    GDBusConnection *connection = NULL;
+    GSignondDbusAuthService *auth_service = NULL;
+    GSignondDbusIdentity *identity = NULL;
+    GVariant *v_info = NULL;
+    GVariant *v_infos = NULL;
+    GVariant *v_errors = NULL;
+    GVariantBuilder ids;
+    GSignondIdentityInfo *info = NULL, *tmp_info = NULL;
+    const gchar *methods[] = { "ssotest", NULL };
+    const gchar *mech[] = {"mech1", "mech2", NULL};
+    const gchar **mechanisms[] = { mech };
+    gboolean res;
+    guint32 id_c = 0, id_d = 0, id_e = 0;
+    GVariantBuilder acl, builder;
+    gchar *exe_name = NULL;
+    GError *error = NULL;
+
+    connection = _get_bus_connection (&error);
+    fail_if (connection == NULL, "Failed to get bus connection : %s", error ? error->message : "");
+
+    auth_service = _get_auth_service (connection, &error);
+    fail_if (auth_service == NULL, "Failed to get auth_service : %s", error ? error->message : "");
+
+    identity = _register_identity (auth_service, "app_context_C", &error);
+    fail_if (identity == NULL, "Failed to register new identity : %s", error ? error->message : "");
+    v_info = _create_identity_info_with_data ("user1", "caption1", 1, methods, mechanisms);
+    res = gsignond_dbus_identity_call_store_sync (identity, v_info, &id_c, NULL, &error);
+    fail_if (res == FALSE || id_c == 0, "Failed to store identity : %s", error ? error->message : "");
+    g_object_unref (identity);
+
+    identity = _get_identity (auth_service, id_c, "app_context_C", &v_info, &error);
+    fail_if (identity == NULL || v_info == NULL, "Failed to load identity for id '%d' : %s", id_c, error ? error->message : "");
+    g_object_unref (identity);
+    info = gsignond_identity_info_new_from_variant (v_info);
+
+    identity = _register_identity (auth_service, "app_context_D", &error);
+    fail_if (identity == NULL, "Failed to register new identity : %s", error ? error->message : "");
+    v_info = _create_identity_info_with_data ("user2", "caption2", 1, methods, mechanisms);
+    res = gsignond_dbus_identity_call_store_sync (identity, v_info, &id_d, NULL, &error);
+    fail_if (res == FALSE || id_d == 0, "Failed to store identity : %s", error ? error->message : "");
+    g_object_unref (identity);
+
+    /* duplicate ids are answered once */
+    g_variant_builder_init (&ids, G_VARIANT_TYPE ("au"));
+    g_variant_builder_add (&ids, "u", id_c);
+    g_variant_builder_add (&ids, "u", id_d);
+    g_variant_builder_add (&ids, "u", G_MAXUINT32);
+    g_variant_builder_add (&ids, "u", 0);
+    g_variant_builder_add (&ids, "u", id_c);
+    res = gsignond_dbus_auth_service_call_get_identities_info_sync (auth_service,
+            g_variant_builder_end (&ids), "app_context_C",
+            &v_infos, &v_errors, NULL, &error);
+    fail_if (res == FALSE, "Failed to get identities info : %s", error ? error->message : "");
+
+    fail_if (g_variant_n_children (v_infos) != 1,
+        "Expected no of identities '%d', got '%d'", 1,
+        g_variant_n_children (v_infos));
+    tmp_info = gsignond_identity_info_new_from_variant (
+                            g_variant_get_child_value (v_infos, 0));
+    fail_if (gsignond_identity_info_compare (info, tmp_info) == FALSE);
+    gsignond_identity_info_unref (tmp_info);
+    gsignond_identity_info_unref (info);
+
+    fail_if (g_variant_n_children (v_errors) != 3,
+        "Expected no of errors '%d', got '%d'", 3,
+        g_variant_n_children (v_errors));
+    fail_if (!_has_identity_error (v_errors, id_d, GSIGNOND_ERROR_PERMISSION_DENIED));
+    fail_if (!_has_identity_error (v_errors, G_MAXUINT32, GSIGNOND_ERROR_IDENTITY_NOT_FOUND));
+    fail_if (!_has_identity_error (v_errors, 0, GSIGNOND_ERROR_IDENTITY_ERR));
+    g_variant_unref (v_infos);
+    g_variant_unref (v_errors);
+
+    /* a peer on the ACL may use the identity, but not read its info */
+    exe_name = _get_executable_name ();
+    fail_if (exe_name == NULL);
+    g_variant_builder_init (&acl, G_VARIANT_TYPE ("a(ss)"));
+    g_variant_builder_add (&acl, "(ss)", exe_name, "app_context_C");
+    g_variant_builder_add (&acl, "(ss)", exe_name, "app_context_E");
+    g_free (exe_name);
+    g_variant_builder_init (&builder, G_VARIANT_TYPE_VARDICT);
+    g_variant_builder_add (&builder, "{sv}", "UserName", g_variant_new_string ("user3"));
+    g_variant_builder_add (&builder, "{sv}", "Caption", g_variant_new_string ("caption3"));
+    g_variant_builder_add (&builder, "{sv}", "ACL", g_variant_builder_end (&acl));
+
+    identity = _register_identity (auth_service, "app_context_C", &error);
+    fail_if (identity == NULL, "Failed to register new identity : %s", error ? error->message : "");
+    res = gsignond_dbus_identity_call_store_sync (identity,
+            g_variant_builder_end (&builder), &id_e, NULL, &error);
+    fail_if (res == FALSE || id_e == 0, "Failed to store identity : %s", error ? error->message : "");
+    g_object_unref (identity);
+
+    identity = _get_identity (auth_service, id_e, "app_context_E", &v_info, &error);
+    fail_if (identity == NULL, "Failed to use identity on its ACL : %s", error ? error->message : "");
+    g_object_unref (identity);
+    if (v_info) g_variant_unref (v_info);
+
+    g_variant_builder_init (&ids, G_VARIANT_TYPE ("au"));
+    g_variant_builder_add (&ids, "u", id_e);
+    res = gsignond_dbus_auth_service_call_get_identities_info_sync (auth_service,
+            g_variant_builder_end (&ids), "app_context_E",
+            &v_infos, &v_errors, NULL, &error);
+    fail_if (res == FALSE, "Failed to get identities info : %s", error ? error->message : "");
+    fail_if (g_variant_n_children (v_infos) != 0,
+        "Read the info of an identity the peer does not own");
+    fail_if (!_has_identity_error (v_errors, id_e, GSIGNOND_ERROR_PERMISSION_DENIED));
+
+    g_variant_unref (v_infos);
+    g_variant_unref (v_errors);
+    g_object_unref (auth_service);
+    g_object_unref (connection);
+}
+END_TEST
+
 Suite* daemon_suite (void)
 {
     Suite *s = suite_create ("Gsignon daemon");
@@ -768,9 +1528,17 @@ Suite* daemon_suite (void)
     tcase_add_test (tc, test_register_new_identity_with_no_app_context);
     tcase_add_test (tc, test_identity_store);
     tcase_add_test (tc, test_identity_get_identity);
+    tcase_add_test (tc, test_identity_get_info);
+    tcase_add_test (tc, test_query_methods_and_mechanisms);
     tcase_add_test (tc, test_clear_database);
     tcase_add_test (tc, test_identity_signout);
+    tcase_add_test (tc, test_auth_session_process_coalesced);
+    tcase_add_test (tc, test_auth_session_process_cached);
+    tcase_add_test (tc, test_authenticate);
+    tcase_add_test (tc, test_authenticate_user_action);
+    tcase_add_test (tc, test_authenticate_broken_plugin);
     tcase_add_test (tc, test_query_identities);
+    tcase_add_test (tc, test_get_identities_info);
 
     suite_add_tcase (s, tc);
 
@@ -299,6 +299,222 @@ START_TEST (test_digestplugin_refresh)
 }
 END_TEST
 
+static gchar *
+_md5_hex (const gchar *str)
+{
+    return g_compute_checksum_for_string (G_CHECKSUM_MD5, str, -1);
+}
+
+/* the response of RFC 2617 section 3.2.2, computed the slow way */
+static gchar *
+_expected_response (const gchar *secret,
+                    const gchar *algo,
+                    const gchar *nonce,
+                    const gchar *cnonce)
+{
+    gchar *str, *ha1, *ha2, *response;
+
+    str = g_strjoin (":", "Mufasa", "testrealm@host.com", secret, NULL);
+    ha1 = _md5_hex (str);
+    g_free (str);
+    if (g_strcmp0 (algo, "md5-sess") == 0) {
+        str = g_strjoin (":", ha1, nonce, cnonce, NULL);
+        g_free (ha1);
+        ha1 = _md5_hex (str);
+        g_free (str);
+    }
+    ha2 = _md5_hex ("GET:/dir/index.html");
+    str = g_strjoin (":", ha1, nonce, "00000001", cnonce, "auth", ha2, NULL);
+    response = _md5_hex (str);
+    g_free (str);
+    g_free (ha1);
+    g_free (ha2);
+
+    return response;
+}
+
+static GSignondSessionData *
+_rfc_session_data (const gchar *secret)
+{
+    GSignondSessionData* data = gsignond_dictionary_new();
+    const gchar *realms[] = { "testrealm@host.com", NULL };
+    GSequence *allowed_realms = gsignond_copy_array_to_sequence(realms);
+
+    gsignond_session_data_set_username(data, "Mufasa");
+    gsignond_session_data_set_secret(data, secret);
+    gsignond_session_data_set_realm(data, "testrealm@host.com");
+    gsignond_session_data_set_allowed_realms(data, allowed_realms);
+    g_sequence_free(allowed_realms);
+    gsignond_dictionary_set_string(data, "Algo", "md5");
+    gsignond_dictionary_set_string(data, "Nonce",
+            "dcd98b7102dd2f0e8b11d0f600bfb0c093");
+    gsignond_dictionary_set_string(data, "Method", "GET");
+    gsignond_dictionary_set_string(data, "DigestUri", "/dir/index.html");
+    gsignond_dictionary_set_string(data, "Qop", "auth");
+    gsignond_dictionary_set_string(data, "NonceCount", "00000001");
+
+    return data;
+}
+
+static void
+_check_response (GSignondSessionData *result,
+                 const gchar *secret,
+                 const gchar *algo,
+                 const gchar *nonce)
+{
+    gchar *expected;
+
+    fail_if(result == NULL);
+    expected = _expected_response (secret, algo, nonce,
+            gsignond_dictionary_get_string(result, "CNonce"));
+    fail_unless(g_strcmp0(gsignond_dictionary_get_string(result, "Response"),
+            expected) == 0);
+    g_free(expected);
+}
+
+START_TEST (test_digestplugin_digest)
+{
+    gpointer plugin;
+    GSignondSessionData *result = NULL, *data, *item;
+    GError* error = NULL;
+    GVariantBuilder builder;
+    GVariant *responses, *child;
+
+    plugin = g_object_new(GSIGNOND_TYPE_DIGEST_PLUGIN, NULL);
+    fail_if(plugin == NULL);
+    g_signal_connect(plugin, "response-final", G_CALLBACK(response_callback),
+            &result);
+    g_signal_connect(plugin, "error", G_CALLBACK(error_callback), &error);
+
+    data = _rfc_session_data ("Circle Of Life");
+    gsignond_plugin_request_initial(plugin, data, NULL, "digest");
+    fail_if(error != NULL);
+    _check_response (result, "Circle Of Life", "md5",
+            "dcd98b7102dd2f0e8b11d0f600bfb0c093");
+    gsignond_dictionary_unref(result);
+    result = NULL;
+
+    // served with the cached HA1
+    gsignond_dictionary_set_string(data, "Algo", "md5-sess");
+    gsignond_plugin_request_initial(plugin, data, NULL, "digest");
+    fail_if(error != NULL);
+    _check_response (result, "Circle Of Life", "md5-sess",
+            "dcd98b7102dd2f0e8b11d0f600bfb0c093");
+    gsignond_dictionary_unref(result);
+    result = NULL;
+    gsignond_dictionary_unref(data);
+
+    // a new secret is not answered with the old HA1
+    data = _rfc_session_data ("Circle Of Death");
+    gsignond_plugin_request_initial(plugin, data, NULL, "digest");
+    fail_if(error != NULL);
+    _check_response (result, "Circle Of Death", "md5",
+            "dcd98b7102dd2f0e8b11d0f600bfb0c093");
+    gsignond_dictionary_unref(result);
+    result = NULL;
+
+    // batch, the second request overrides the nonce
+    g_variant_builder_init (&builder, G_VARIANT_TYPE ("aa{sv}"));
+    g_variant_builder_open (&builder, G_VARIANT_TYPE_VARDICT);
+    g_variant_builder_close (&builder);
+    g_variant_builder_open (&builder, G_VARIANT_TYPE_VARDICT);
+    g_variant_builder_add (&builder, "{sv}", "Nonce",
+            g_variant_new_string ("0a4f113b"));
+    g_variant_builder_close (&builder);
+    gsignond_dictionary_set(data, "Requests", g_variant_builder_end (&builder));
+    gsignond_plugin_request_initial(plugin, data, NULL, "digest");
+    fail_if(error != NULL);
+    fail_if(result == NULL);
+    fail_unless(g_strcmp0(gsignond_session_data_get_username(result),
+            "Mufasa") == 0);
+    responses = gsignond_dictionary_get(result, "Responses");
+    fail_if(responses == NULL);
+    fail_unless(g_variant_n_children (responses) == 2);
+    child = g_variant_get_child_value (responses, 0);
+    item = gsignond_dictionary_new_from_variant (child);
+    g_variant_unref (child);
+    _check_response (item, "Circle Of Death", "md5",
+            "dcd98b7102dd2f0e8b11d0f600bfb0c093");
+    gsignond_dictionary_unref(item);
+    child = g_variant_get_child_value (responses, 1);
+    item = gsignond_dictionary_new_from_variant (child);
+    g_variant_unref (child);
+    _check_response (item, "Circle Of Death", "md5", "0a4f113b");
+    gsignond_dictionary_unref(item);
+    gsignond_dictionary_unref(result);
+    result = NULL;
+
+    // a request in the batch missing data fails the batch
+    g_variant_builder_init (&builder, G_VARIANT_TYPE ("aa{sv}"));
+    g_variant_builder_open (&builder, G_VARIANT_TYPE_VARDICT);
+    g_variant_builder_add (&builder, "{sv}", "Qop",
+            g_variant_new_string ("auth-int"));
+    g_variant_builder_close (&builder);
+    gsignond_dictionary_set(data, "Requests", g_variant_builder_end (&builder));
+    gsignond_plugin_request_initial(plugin, data, NULL, "digest");
+    fail_if(result != NULL);
+    fail_unless(g_error_matches(error, GSIGNOND_ERROR,
+                                GSIGNOND_ERROR_MISSING_DATA));
+    g_error_free(error);
+    error = NULL;
+
+    gsignond_dictionary_unref(data);
+    g_object_unref(plugin);
+}
+END_TEST
+
+static void
+_count_response_callback (
+        GSignondPlugin* plugin,
+        GSignondSessionData* result,
+        gpointer user_data)
+{
+    (*(guint *) user_data)++;
+}
+
+/* compares digests computed one per request and in a batch, it does not
+ * fail on the numbers */
+START_TEST (test_digestplugin_benchmark)
+{
+    const guint n_requests = 10000;
+    gpointer plugin;
+    GSignondSessionData *data;
+    GVariantBuilder builder;
+    guint responses = 0, i;
+    gint64 single_us, batch_us;
+
+    plugin = g_object_new(GSIGNOND_TYPE_DIGEST_PLUGIN, NULL);
+    fail_if(plugin == NULL);
+    g_signal_connect(plugin, "response-final",
+            G_CALLBACK(_count_response_callback), &responses);
+    data = _rfc_session_data ("Circle Of Life");
+
+    single_us = g_get_monotonic_time ();
+    for (i = 0; i < n_requests; i++)
+        gsignond_plugin_request_initial(plugin, data, NULL, "digest");
+    single_us = g_get_monotonic_time () - single_us;
+    fail_unless(responses == n_requests);
+
+    g_variant_builder_init (&builder, G_VARIANT_TYPE ("aa{sv}"));
+    for (i = 0; i < n_requests; i++) {
+        g_variant_builder_open (&builder, G_VARIANT_TYPE_VARDICT);
+        g_variant_builder_close (&builder);
+    }
+    gsignond_dictionary_set(data, "Requests", g_variant_builder_end (&builder));
+    batch_us = g_get_monotonic_time ();
+    gsignond_plugin_request_initial(plugin, data, NULL, "digest");
+    batch_us = g_get_monotonic_time () - batch_us;
+    fail_unless(responses == n_requests + 1);
+
+    g_print ("digest over %u requests: single %.2f us, batch %.2f us\n",
+             n_requests, (gdouble) single_us / n_requests,
+             (gdouble) batch_us / n_requests);
+
+    gsignond_dictionary_unref(data);
+    g_object_unref(plugin);
+}
+END_TEST
+
 Suite* digestplugin_suite (void)
 {
     Suite *s = suite_create ("Digest plugin");
@@ -309,6 +525,8 @@ Suite* digestplugin_suite (void)
     tcase_add_test (tc_core, test_digestplugin_request);
     tcase_add_test (tc_core, test_digestplugin_user_action_finished);
     tcase_add_test (tc_core, test_digestplugin_refresh);
+    tcase_add_test (tc_core, test_digestplugin_digest);
+    tcase_add_test (tc_core, test_digestplugin_benchmark);
     suite_add_tcase (s, tc_core);
     return s;
 }
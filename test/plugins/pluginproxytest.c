@@ -27,6 +27,7 @@
 #include <stdlib.h>
 #include <glib-object.h>
 #include <string.h>
+#include <glib/gstdio.h>
 
 #include "gsignond-plugin-proxy.h"
 #include "gsignond-plugin-proxy-factory.h"
@@ -105,6 +106,12 @@ gint proxy_process_queue_results = 0;
 gboolean testing_proxy_process_queue_cancel = FALSE;
 gint proxy_process_queue_cancel_results = 0;
 gboolean testing_proxy_process_cancel_triggered = FALSE;
+gboolean testing_proxy_process_pool = FALSE;
+gboolean testing_proxy_process_deadline = FALSE;
+gint proxy_process_deadline_errors = 0;
+gboolean testing_proxy_process_priority = FALSE;
+gint proxy_process_priority_results[3];
+gint proxy_process_priority_n_results = 0;
 
 void
 gsignond_auth_session_notify_process_result (
@@ -134,10 +141,10 @@ gsignond_auth_session_notify_process_result (
             gsignond_session_data_set_secret(data, "megapassword");
 
             gsignond_plugin_proxy_process(proxy, iface, data, NULL, "password",
-                    proxy);
+                    0, proxy);
 
             gsignond_plugin_proxy_process(proxy, iface, data, NULL, "password",
-                    proxy);
+                    0, proxy);
     
             gsignond_dictionary_unref(data);
         }
@@ -154,7 +161,7 @@ gsignond_auth_session_notify_process_result (
 
             for (i = 0; i < 9; i++) {
                 gsignond_plugin_proxy_process(proxy, iface, data, NULL, "mech1",
-                        proxy);
+                        0, proxy);
             }
             gsignond_dictionary_unref(data);
         }
@@ -162,6 +169,23 @@ gsignond_auth_session_notify_process_result (
             testing_proxy_process_queue_cancel = FALSE;
             _stop_mainloop ();
         }
+    } else if (testing_proxy_process_pool) {
+        testing_proxy_process_pool = FALSE;
+        fail_if(g_strcmp0(
+            gsignond_session_data_get_realm(result), "testRealm_after_test") != 0);
+        _stop_mainloop ();
+    } else if (testing_proxy_process_deadline) {
+        /* served by the worker that replaced the hung one */
+        testing_proxy_process_deadline = FALSE;
+        fail_unless(proxy_process_deadline_errors == 2);
+        _stop_mainloop ();
+    } else if (testing_proxy_process_priority) {
+        proxy_process_priority_results[proxy_process_priority_n_results++] =
+            GPOINTER_TO_INT (user_data);
+        if (proxy_process_priority_n_results == 3) {
+            testing_proxy_process_priority = FALSE;
+            _stop_mainloop ();
+        }
     } else 
         fail_if(TRUE);    
 }
@@ -181,6 +205,9 @@ gsignond_auth_session_notify_process_error (
     } else if (testing_proxy_process_queue_cancel) {
         fail_if(error->code != GSIGNOND_ERROR_SESSION_CANCELED);
         proxy_process_queue_cancel_results++;
+    } else if (testing_proxy_process_deadline) {
+        fail_if(error->code != GSIGNOND_ERROR_TIMED_OUT);
+        proxy_process_deadline_errors++;
     }
 
 }
@@ -188,7 +215,8 @@ gsignond_auth_session_notify_process_error (
 void 
 gsignond_auth_session_notify_store (
         GSignondAuthSession *self,
-        GSignondSessionData *session_data)
+        GSignondSessionData *session_data,
+        gpointer userdata)
 {
     DBG ("");
     fail_if(TRUE);
@@ -313,7 +341,98 @@ START_TEST (test_pluginproxy_process)
     testing_proxy_process = TRUE;
 
     gsignond_plugin_proxy_process(proxy, test_auth_session, data, NULL, "password",
-            proxy);
+            0, proxy);
+
+    _run_mainloop ();
+
+    fail_if(testing_proxy_process);
+    
+    gsignond_dictionary_unref(data);
+    g_object_unref(test_auth_session);
+    g_object_unref(proxy);
+    g_object_unref(config);
+}
+END_TEST
+
+static void
+_on_proxy_new_ready (GObject *source, GAsyncResult *res, gpointer user_data)
+{
+    GSignondPluginProxy **proxy = (GSignondPluginProxy **) user_data;
+
+    *proxy = gsignond_plugin_proxy_new_finish (res, NULL);
+    _stop_mainloop ();
+}
+
+static void
+_on_proxy_init_ready (GObject *source, GAsyncResult *res, gpointer user_data)
+{
+    fail_unless (g_async_initable_init_finish (G_ASYNC_INITABLE (source),
+                                               res, NULL));
+    _stop_mainloop ();
+}
+
+static void
+_wait_for_proxy (GSignondPluginProxy *proxy)
+{
+    g_async_initable_init_async (G_ASYNC_INITABLE (proxy), G_PRIORITY_DEFAULT,
+                                 NULL, _on_proxy_init_ready, NULL);
+    _run_mainloop ();
+}
+
+START_TEST (test_pluginproxy_create_async)
+{
+    DBG("test_pluginproxy_create_async\n");
+
+    gchar *pass_mechs[] = {"password", NULL};
+    GSignondPluginProxy* proxy = NULL;
+    gchar* loader_path = g_build_filename (g_getenv("SSO_BIN_DIR"),
+                                           "gsignond-plugind", NULL);
+
+    gsignond_plugin_proxy_new_async (loader_path, "absentplugin", 0, NULL,
+                                     _on_proxy_new_ready, &proxy);
+    _run_mainloop ();
+    fail_if (proxy != NULL);
+
+    gsignond_plugin_proxy_new_async (loader_path, "password", 0, NULL,
+                                     _on_proxy_new_ready, &proxy);
+    _run_mainloop ();
+    fail_if (proxy == NULL);
+    check_plugin_proxy(proxy, "password", pass_mechs);
+
+    g_object_unref(proxy);
+    g_free(loader_path);
+}
+END_TEST
+
+START_TEST (test_pluginproxy_process_during_startup)
+{
+    DBG("test_pluginproxy_process_during_startup\n");
+
+    GSignondConfig* config = gsignond_config_new();
+    fail_if(config == NULL);
+    gsignond_config_set_string(config,
+            GSIGNOND_CONFIG_GENERAL_IN_PROCESS_PLUGINS, "");
+    GSignondPluginProxyFactory* factory = gsignond_plugin_proxy_factory_new(
+            config);
+    fail_if(factory == NULL);
+
+    /* the plugin is still being started, the request gets queued */
+    GSignondPluginProxy* proxy = gsignond_plugin_proxy_factory_get_plugin(
+            factory, "password");
+    fail_if (proxy == NULL);
+    
+    GSignondSessionData* data = gsignond_dictionary_new();
+    fail_if(data == NULL);
+    gsignond_session_data_set_username(data, "megauser");
+    gsignond_session_data_set_secret(data, "megapassword");
+    
+    GSignondAuthSession* test_auth_session =
+            g_object_new(gsignond_auth_session_get_type(), NULL);
+
+    testing_proxy_process = TRUE;
+
+    gsignond_plugin_proxy_process(proxy, test_auth_session, data, NULL, "password",
+            0, proxy);
 
     _run_mainloop ();
 
@@ -322,6 +441,7 @@ START_TEST (test_pluginproxy_process)
     gsignond_dictionary_unref(data);
     g_object_unref(test_auth_session);
     g_object_unref(proxy);
+    g_object_unref(factory);
     g_object_unref(config);
 }
 END_TEST
@@ -345,7 +465,7 @@ START_TEST (test_pluginproxy_process_cancel)
     testing_proxy_process_cancel = TRUE;
     
     gsignond_plugin_proxy_process(proxy, test_auth_session, data, NULL, "mech1",
-            proxy);
+            0, proxy);
 
     _run_mainloop ();
 
@@ -379,7 +499,7 @@ START_TEST (test_pluginproxy_process_queue)
     testing_proxy_process_queue = TRUE;
     
     gsignond_plugin_proxy_process(proxy, test_auth_session, data, NULL, "password",
-            proxy);
+            0, proxy);
     _run_mainloop ();
 
     fail_if(testing_proxy_process_queue);
@@ -409,7 +529,7 @@ START_TEST (test_pluginproxy_process_queue_cancel)
     testing_proxy_process_queue_cancel = TRUE;
     
     gsignond_plugin_proxy_process(proxy, test_auth_session, data, NULL, "mech1",
-            proxy);
+            0, proxy);
 
     _run_mainloop ();
 
@@ -423,6 +543,173 @@ START_TEST (test_pluginproxy_process_queue_cancel)
 }
 END_TEST
 
+START_TEST (test_pluginproxy_process_pool)
+{
+    DBG("test_pluginproxy_process_pool\n");
+
+    guint max_workers = 0;
+    gchar* loader_path = g_build_filename (g_getenv("SSO_BIN_DIR"),
+                                           "gsignond-plugind", NULL);
+    GSignondPluginProxy* proxy = g_initable_new (GSIGNOND_TYPE_PLUGIN_PROXY,
+                                                 NULL, NULL,
+                                                 "loaderpath", loader_path,
+                                                 "type", "ssotest",
+                                                 "auto-dispose", FALSE,
+                                                 "timeout", 0,
+                                                 "max-workers", 2,
+                                                 NULL);
+    fail_if (proxy == NULL);
+    g_object_get (proxy, "max-workers", &max_workers, NULL);
+    fail_if (max_workers != 2);
+
+    GSignondSessionData* data = gsignond_dictionary_new();
+    fail_if(data == NULL);
+
+    GSignondAuthSession* stuck_session =
+            g_object_new(gsignond_auth_session_get_type(), NULL);
+    GSignondAuthSession* test_auth_session =
+            g_object_new(gsignond_auth_session_get_type(), NULL);
+
+    testing_proxy_process_pool = TRUE;
+
+    /* mech3 never responds and keeps the first worker busy, the second
+     * session gets served by an extra worker */
+    gsignond_plugin_proxy_process(proxy, stuck_session, data, NULL, "mech3",
+            0, proxy);
+    gsignond_plugin_proxy_process(proxy, test_auth_session, data, NULL, "mech1",
+            0, proxy);
+
+    _run_mainloop ();
+
+    fail_if(testing_proxy_process_pool);
+
+    gsignond_dictionary_unref(data);
+    g_object_unref(stuck_session);
+    g_object_unref(test_auth_session);
+    g_object_unref(proxy);
+    g_free(loader_path);
+}
+END_TEST
+
+START_TEST (test_pluginproxy_process_deadline)
+{
+    DBG("test_pluginproxy_process_deadline\n");
+
+    gint64 now = g_get_monotonic_time ();
+    gchar* loader_path = g_build_filename (g_getenv("SSO_BIN_DIR"),
+                                           "gsignond-plugind", NULL);
+    GSignondPluginProxy* proxy = gsignond_plugin_proxy_new(loader_path,
+                                                           "ssotest", 0);
+    fail_if (proxy == NULL);
+
+    GSignondSessionData* data = gsignond_dictionary_new();
+    fail_if(data == NULL);
+
+    GSignondAuthSession* stuck_session =
+            g_object_new(gsignond_auth_session_get_type(), NULL);
+    GSignondAuthSession* expiring_session =
+            g_object_new(gsignond_auth_session_get_type(), NULL);
+    GSignondAuthSession* test_auth_session =
+            g_object_new(gsignond_auth_session_get_type(), NULL);
+
+    testing_proxy_process_deadline = TRUE;
+    proxy_process_deadline_errors = 0;
+
+    /* mech3 never responds and ignores cancellation, so its plugin is
+     * stopped once its deadline has passed. The request queued behind it
+     * expires before it can be dispatched, the one without a deadline is
+     * served by a new plugin */
+    gsignond_plugin_proxy_process(proxy, stuck_session, data, NULL, "mech3",
+            now + 300 * G_TIME_SPAN_MILLISECOND, proxy);
+    gsignond_plugin_proxy_process(proxy, expiring_session, data, NULL, "mech1",
+            now + 100 * G_TIME_SPAN_MILLISECOND, proxy);
+    gsignond_plugin_proxy_process(proxy, test_auth_session, data, NULL, "mech1",
+            0, proxy);
+
+    _run_mainloop ();
+
+    fail_if(testing_proxy_process_deadline);
+
+    gsignond_dictionary_unref(data);
+    g_object_unref(stuck_session);
+    g_object_unref(expiring_session);
+    g_object_unref(test_auth_session);
+    g_object_unref(proxy);
+    g_free(loader_path);
+}
+END_TEST
+
+START_TEST (test_pluginproxy_process_priority)
+{
+    DBG("test_pluginproxy_process_priority\n");
+
+    guint n_dispatched = 0;
+    gint64 total_wait = 0;
+    gint64 max_wait = 0;
+    gint i;
+    gchar* loader_path = g_build_filename (g_getenv("SSO_BIN_DIR"),
+                                           "gsignond-plugind", NULL);
+    GSignondPluginProxy* proxy = gsignond_plugin_proxy_new(loader_path,
+                                                           "ssotest", 0);
+    fail_if (proxy == NULL);
+
+    GSignondSessionData* data = gsignond_dictionary_new();
+    GSignondSessionData* background_data = gsignond_dictionary_new();
+    GSignondSessionData* interactive_data = gsignond_dictionary_new();
+    gsignond_session_data_set_ui_policy(background_data,
+            GSIGNOND_UI_POLICY_NO_USER_INTERACTION);
+    gsignond_session_data_set_process_priority(interactive_data,
+            GSIGNOND_PROCESS_PRIORITY_INTERACTIVE);
+
+    GSignondAuthSession* sessions[3];
+    for (i = 0; i < 3; i++)
+        sessions[i] = g_object_new(gsignond_auth_session_get_type(), NULL);
+
+    testing_proxy_process_priority = TRUE;
+    proxy_process_priority_n_results = 0;
+
+    /* the first request keeps the only worker busy, the interactive one
+     * queued after the background one is served before it */
+    gsignond_plugin_proxy_process(proxy, sessions[0], data, NULL, "mech1",
+            0, GINT_TO_POINTER (GSIGNOND_PROCESS_PRIORITY_NORMAL));
+    gsignond_plugin_proxy_process(proxy, sessions[1], background_data, NULL,
+            "mech1", 0, GINT_TO_POINTER (GSIGNOND_PROCESS_PRIORITY_BACKGROUND));
+    gsignond_plugin_proxy_process(proxy, sessions[2], interactive_data, NULL,
+            "mech1", 0, GINT_TO_POINTER (GSIGNOND_PROCESS_PRIORITY_INTERACTIVE));
+
+    _run_mainloop ();
+
+    fail_if(testing_proxy_process_priority);
+    fail_unless(proxy_process_priority_results[0] ==
+            GSIGNOND_PROCESS_PRIORITY_NORMAL);
+    fail_unless(proxy_process_priority_results[1] ==
+            GSIGNOND_PROCESS_PRIORITY_INTERACTIVE);
+    fail_unless(proxy_process_priority_results[2] ==
+            GSIGNOND_PROCESS_PRIORITY_BACKGROUND);
+
+    for (i = GSIGNOND_PROCESS_PRIORITY_BACKGROUND;
+         i <= GSIGNOND_PROCESS_PRIORITY_INTERACTIVE; i++) {
+        gsignond_plugin_proxy_get_wait_stats(proxy, i, &n_dispatched,
+                &total_wait, &max_wait);
+        fail_unless(n_dispatched == 1);
+        fail_unless(total_wait == max_wait);
+    }
+    gsignond_plugin_proxy_get_wait_stats(proxy,
+            GSIGNOND_PROCESS_PRIORITY_BACKGROUND, NULL, &total_wait, NULL);
+    gsignond_plugin_proxy_get_wait_stats(proxy,
+            GSIGNOND_PROCESS_PRIORITY_INTERACTIVE, NULL, NULL, &max_wait);
+    fail_unless(total_wait > max_wait);
+
+    gsignond_dictionary_unref(data);
+    gsignond_dictionary_unref(background_data);
+    gsignond_dictionary_unref(interactive_data);
+    for (i = 0; i < 3; i++)
+        g_object_unref(sessions[i]);
+    g_object_unref(proxy);
+    g_free(loader_path);
+}
+END_TEST
+
 START_TEST (test_pluginproxyfactory_methods_and_mechanisms)
 {
     DBG("");
@@ -458,6 +745,158 @@ START_TEST (test_pluginproxyfactory_methods_and_mechanisms)
 }
 END_TEST
 
+START_TEST (test_pluginproxyfactory_mechanism_set)
+{
+    DBG("");
+    GSignondConfig* config = gsignond_config_new();
+    fail_if(config == NULL);
+
+    GSignondPluginProxyFactory* factory = gsignond_plugin_proxy_factory_new(
+            config);
+    fail_if(factory == NULL);
+
+    const gchar** mechanisms =
+            gsignond_plugin_proxy_factory_get_plugin_mechanisms(factory,
+                    "ssotest");
+    fail_if(mechanisms == NULL);
+    gint i;
+    for (i = 0; mechanisms[i] != NULL; i++)
+        fail_if(gsignond_plugin_proxy_factory_get_mechanism_id(factory,
+                "ssotest", mechanisms[i]) != i);
+    fail_if(i != 4);
+
+    fail_if(gsignond_plugin_proxy_factory_get_mechanism_id(factory,
+            "ssotest", "unknown") != -1);
+    fail_if(gsignond_plugin_proxy_factory_get_mechanism_id(factory,
+            "unknown", "mech1") != -1);
+
+    fail_if(gsignond_plugin_proxy_factory_get_mechanism_set(factory,
+            "ssotest", NULL) != 0xF);
+
+    /* the registry is enumerated once, so its generation stays put */
+    guint generation = gsignond_plugin_proxy_factory_get_generation(factory);
+    fail_if(generation == 0);
+    gsignond_plugin_proxy_factory_get_plugin_types(factory);
+    fail_if(gsignond_plugin_proxy_factory_get_generation(factory) != generation);
+
+    GSequence *seq = g_sequence_new(NULL);
+    g_sequence_append(seq, "mech2");
+    g_sequence_append(seq, "unknown");
+    fail_if(gsignond_plugin_proxy_factory_get_mechanism_set(factory,
+            "ssotest", seq) != 0x2);
+    g_sequence_append(seq, "*");
+    fail_if(gsignond_plugin_proxy_factory_get_mechanism_set(factory,
+            "ssotest", seq) != 0xF);
+    g_sequence_free(seq);
+
+    g_object_unref(factory);
+    g_object_unref(config);
+}
+END_TEST
+
+START_TEST (test_pluginproxyfactory_manifest_cache)
+{
+    DBG("");
+    gchar* cache_path = g_build_filename(g_get_tmp_dir(),
+            "gsignond-pluginproxytest.cache", NULL);
+    g_unlink(cache_path);
+
+    GSignondConfig* config = gsignond_config_new();
+    fail_if(config == NULL);
+    gsignond_config_set_string(config, GSIGNOND_CONFIG_GENERAL_PLUGIN_CACHE,
+            cache_path);
+
+    /* first enumeration describes the loaders and fills the cache */
+    GSignondPluginProxyFactory* factory = gsignond_plugin_proxy_factory_new(
+            config);
+    fail_if(factory == NULL);
+    const gchar** mechanisms =
+            gsignond_plugin_proxy_factory_get_plugin_mechanisms(factory,
+                    "password");
+    fail_if(mechanisms == NULL);
+    fail_if(g_strcmp0(mechanisms[0], "password") != 0);
+    guint n_types = g_strv_length((gchar**)
+            gsignond_plugin_proxy_factory_get_plugin_types(factory));
+    g_object_unref(factory);
+    fail_unless(g_file_test(cache_path, G_FILE_TEST_EXISTS));
+
+    /* second one is served from the cache */
+    factory = gsignond_plugin_proxy_factory_new(config);
+    fail_if(factory == NULL);
+    fail_if(g_strv_length((gchar**)
+            gsignond_plugin_proxy_factory_get_plugin_types(factory)) != n_types);
+    mechanisms = gsignond_plugin_proxy_factory_get_plugin_mechanisms(factory,
+            "ssotest");
+    fail_if(mechanisms == NULL || g_strv_length((gchar**)mechanisms) != 4);
+    g_object_unref(factory);
+
+    /* a broken cache file is ignored */
+    fail_unless(g_file_set_contents(cache_path, "garbage", -1, NULL));
+    factory = gsignond_plugin_proxy_factory_new(config);
+    fail_if(g_strv_length((gchar**)
+            gsignond_plugin_proxy_factory_get_plugin_types(factory)) != n_types);
+    g_object_unref(factory);
+
+    g_unlink(cache_path);
+    g_free(cache_path);
+    g_object_unref(config);
+}
+END_TEST
+
+static void
+_on_plugins_enumerated (GObject *factory, GAsyncResult *res, gpointer data)
+{
+    gboolean *enumerated = data;
+
+    *enumerated = gsignond_plugin_proxy_factory_enumerate_finish (
+            GSIGNOND_PLUGIN_PROXY_FACTORY (factory), res, NULL);
+    _stop_mainloop ();
+}
+
+START_TEST (test_pluginproxyfactory_enumerate)
+{
+    DBG("");
+    gchar* cache_path = g_build_filename(g_get_tmp_dir(),
+            "gsignond-pluginproxytest-enumerate.cache", NULL);
+    gboolean enumerated = FALSE;
+    g_unlink(cache_path);
+
+    GSignondConfig* config = gsignond_config_new();
+    fail_if(config == NULL);
+    gsignond_config_set_string(config, GSIGNOND_CONFIG_GENERAL_PLUGIN_CACHE,
+            cache_path);
+
+    /* the loaders are described in the background and the main loop
+     * completes the registry, so no query has to wait for them */
+    GSignondPluginProxyFactory* factory = gsignond_plugin_proxy_factory_new(
+            config);
+    fail_if(factory == NULL);
+    gsignond_plugin_proxy_factory_enumerate(factory, _on_plugins_enumerated,
+            &enumerated);
+    _run_mainloop();
+    fail_unless(enumerated);
+    fail_if(factory->loader_probes != NULL);
+    fail_if(factory->methods == NULL);
+    guint generation = gsignond_plugin_proxy_factory_get_generation(factory);
+    fail_if(generation == 0);
+    fail_if(gsignond_plugin_proxy_factory_get_plugin_mechanisms(factory,
+            "ssotest") == NULL);
+    fail_if(gsignond_plugin_proxy_factory_get_generation(factory) != generation);
+
+    /* waiting again completes right away */
+    enumerated = FALSE;
+    gsignond_plugin_proxy_factory_enumerate(factory, _on_plugins_enumerated,
+            &enumerated);
+    _run_mainloop();
+    fail_unless(enumerated);
+    g_object_unref(factory);
+
+    g_unlink(cache_path);
+    g_free(cache_path);
+    g_object_unref(config);
+}
+END_TEST
+
 START_TEST (test_pluginproxyfactory_get)
 {
     DBG("");
@@ -480,6 +919,7 @@ START_TEST (test_pluginproxyfactory_get)
         factory, "password");
     fail_if(proxy1 == NULL || proxy2 == NULL || proxy3 == NULL);
     fail_if(proxy1 != proxy3 || proxy1 != proxy2);
+    _wait_for_proxy(proxy1);
     check_plugin_proxy(proxy1, "password", pass_mechs);
 
     g_object_unref(proxy1);
@@ -491,6 +931,62 @@ START_TEST (test_pluginproxyfactory_get)
 }
 END_TEST
 
+START_TEST (test_pluginproxyfactory_in_process)
+{
+    DBG("");
+    gchar *pass_mechs[] = {"password", NULL};
+    gboolean in_process = FALSE;
+    GSignondConfig* config = gsignond_config_new();
+    fail_if(config == NULL);
+    gsignond_config_set_string(config,
+            GSIGNOND_CONFIG_GENERAL_IN_PROCESS_PLUGINS, "digest; password");
+
+    GSignondPluginProxyFactory* factory = gsignond_plugin_proxy_factory_new(
+            config);
+    fail_if(factory == NULL);
+
+    /* plugins that are not on the list keep running out of process */
+    GSignondPluginProxy* proxy = gsignond_plugin_proxy_factory_get_plugin(
+            factory, "ssotest");
+    fail_if(proxy == NULL);
+    g_object_get(proxy, "in-process", &in_process, NULL);
+    fail_if(in_process);
+    g_object_unref(proxy);
+
+    proxy = gsignond_plugin_proxy_factory_get_plugin(factory, "password");
+    fail_if(proxy == NULL);
+    g_object_get(proxy, "in-process", &in_process, NULL);
+    fail_unless(in_process);
+    _wait_for_proxy(proxy);
+    check_plugin_proxy(proxy, "password", pass_mechs);
+
+    GSignondSessionData* data = gsignond_dictionary_new();
+    fail_if(data == NULL);
+    gsignond_session_data_set_username(data, "megauser");
+    gsignond_session_data_set_secret(data, "megapassword");
+
+    GSignondAuthSession* test_auth_session =
+            g_object_new(gsignond_auth_session_get_type(), NULL);
+
+    /* the result is delivered from the main loop, like for plugin
+     * processes */
+    testing_proxy_process = TRUE;
+    gsignond_plugin_proxy_process(proxy, test_auth_session, data, NULL,
+            "password", 0, proxy);
+    fail_unless(testing_proxy_process);
+
+    _run_mainloop ();
+
+    fail_if(testing_proxy_process);
+
+    gsignond_dictionary_unref(data);
+    g_object_unref(test_auth_session);
+    g_object_unref(proxy);
+    g_object_unref(factory);
+    g_object_unref(config);
+}
+END_TEST
+
 typedef struct {
     GSignondPluginProxyFactory *factory;
     GSignondPluginProxy *proxy;
@@ -618,6 +1114,67 @@ START_TEST (test_pluginproxyfactory_proxy_timeout)
 }
 END_TEST
 
+static gboolean
+_validate_adapted_timeout (gpointer userdata)
+{
+    ProxyTimeoutData *data = (ProxyTimeoutData *)userdata;
+    guint timeout = 0;
+
+    /* torn down after PluginTimeout, as there is no history yet */
+    fail_if (g_hash_table_size (data->factory->plugins) != 0);
+
+    GSignondPluginProxy *proxy = gsignond_plugin_proxy_factory_get_plugin (
+            data->factory, "ssotest");
+    fail_if (proxy == NULL);
+    g_object_unref (proxy);
+
+    /* kept idle long enough to cover the gap of about 2 seconds */
+    fail_if (g_hash_table_size (data->factory->plugins) != 1);
+    g_object_get (proxy, "timeout", &timeout, NULL);
+    fail_unless (timeout > 2 && timeout <= 10,
+                 "unexpected adapted timeout %u", timeout);
+
+    g_free (userdata);
+
+    _stop_mainloop ();
+
+    return FALSE;
+}
+
+START_TEST (test_pluginproxyfactory_adaptive_timeout)
+{
+    DBG("test_pluginproxyfactory_adaptive_timeout\n");
+    GSignondPluginProxyFactory *factory = NULL;
+    GSignondPluginProxy *proxy = NULL;
+    GSignondConfig *config = NULL;
+
+    config = gsignond_config_new ();
+    fail_if (config == NULL);
+    gsignond_config_set_integer (config, GSIGNOND_CONFIG_PLUGIN_TIMEOUT, 1);
+    gsignond_config_set_integer (config, GSIGNOND_CONFIG_PLUGIN_TIMEOUT_MAX,
+                                 10);
+    gsignond_config_set_string (config,
+                                GSIGNOND_CONFIG_GENERAL_PLUGIN_USAGE_CACHE,
+                                "");
+
+    factory = gsignond_plugin_proxy_factory_new (config);
+    fail_if (factory == NULL);
+
+    proxy = gsignond_plugin_proxy_factory_get_plugin (factory, "ssotest");
+    fail_if (proxy == NULL);
+    g_object_unref (proxy);
+
+    ProxyTimeoutData *data = g_new0 (ProxyTimeoutData, 1);
+    data->factory = factory;
+    g_timeout_add (2000, _validate_adapted_timeout, (gpointer)data);
+
+    _run_mainloop ();
+
+    g_object_unref (config);
+    g_object_unref (factory);
+}
+END_TEST
+
 Suite* pluginproxy_suite (void)
 {
     Suite *s = suite_create ("Plugin proxy");
@@ -628,13 +1185,23 @@ Suite* pluginproxy_suite (void)
 
     tcase_set_timeout (tc_core, 10);
     tcase_add_test (tc_core, test_pluginproxy_create);
+    tcase_add_test (tc_core, test_pluginproxy_create_async);
     tcase_add_test (tc_core, test_pluginproxy_process);
+    tcase_add_test (tc_core, test_pluginproxy_process_during_startup);
     tcase_add_test (tc_core, test_pluginproxy_process_cancel);
     tcase_add_test (tc_core, test_pluginproxy_process_queue);
     tcase_add_test (tc_core, test_pluginproxy_process_queue_cancel);
+    tcase_add_test (tc_core, test_pluginproxy_process_pool);
+    tcase_add_test (tc_core, test_pluginproxy_process_deadline);
+    tcase_add_test (tc_core, test_pluginproxy_process_priority);
     tcase_add_test (tc_core, test_pluginproxyfactory_methods_and_mechanisms);
+    tcase_add_test (tc_core, test_pluginproxyfactory_mechanism_set);
+    tcase_add_test (tc_core, test_pluginproxyfactory_manifest_cache);
+    tcase_add_test (tc_core, test_pluginproxyfactory_enumerate);
     tcase_add_test (tc_core, test_pluginproxyfactory_get);
+    tcase_add_test (tc_core, test_pluginproxyfactory_in_process);
     tcase_add_test (tc_core, test_pluginproxyfactory_proxy_timeout);
+    tcase_add_test (tc_core, test_pluginproxyfactory_adaptive_timeout);
 
     suite_add_tcase (s, tc_core);
     return s;
@@ -25,7 +25,10 @@
 
 #include <check.h>
 #include <stdlib.h>
+#include <string.h>
 #include <errno.h>
+#include <sys/wait.h>
+#include <unistd.h>
 
 #include "daemon/gsignond-types.h"
 #include "gsignond-plugin-remote-private.h"
@@ -132,7 +135,8 @@ gsignond_auth_session_notify_process_error (
 void
 gsignond_auth_session_notify_store (
         GSignondAuthSession *self,
-        GSignondSessionData *session_data)
+        GSignondSessionData *session_data,
+        gpointer userdata)
 {
 }
 
@@ -541,6 +545,419 @@ START_TEST (test_pluginremote_refresh)
 }
 END_TEST
 
+START_TEST (test_pluginremote_sessions)
+{
+    DBG ("");
+    GSignondPluginRemote *host = NULL, *session = NULL;
+    GSignondPluginRemotePrivate* priv = NULL;
+    GSignondSessionData* host_result = NULL;
+    GSignondSessionData* result = NULL;
+
+    gchar* loader_path = g_build_filename (g_getenv("SSO_BIN_DIR"), "gsignond-plugind", NULL);
+    host = gsignond_plugin_remote_new (loader_path, "password");
+    g_free(loader_path);
+    fail_if (host == NULL);
+    fail_unless (gsignond_plugin_remote_supports_sessions (host));
+
+    session = gsignond_plugin_remote_new_session (host);
+    fail_if (session == NULL);
+    check_plugin (GSIGNOND_PLUGIN (session));
+
+    /* the session runs in the loader process of the host */
+    priv = (GSignondPluginRemotePrivate *) session->priv;
+    fail_unless (priv->cpid == 0);
+    fail_unless (priv->host == host);
+    fail_unless (priv->session != 0);
+    fail_if (priv->session == host->priv->session);
+
+    g_signal_connect(host, "response-final", G_CALLBACK(response_callback),
+            &host_result);
+    g_signal_connect(session, "response-final", G_CALLBACK(response_callback),
+            &result);
+
+    GSignondSessionData* data = gsignond_dictionary_new ();
+    gsignond_session_data_set_username(data, "megauser");
+    gsignond_session_data_set_secret(data, "megapassword");
+    gsignond_plugin_request_initial(GSIGNOND_PLUGIN (session), data, NULL,
+            "password");
+    _run_mainloop ();
+
+    fail_if(result == NULL);
+    fail_if(host_result != NULL);
+    fail_if(g_strcmp0(
+        gsignond_session_data_get_username(result), "megauser") != 0);
+    gsignond_dictionary_unref(result);
+    gsignond_dictionary_unref(data);
+
+    /* closing the session keeps the loader running for the host */
+    g_object_unref (session);
+    fail_unless (kill (host->priv->cpid, 0) == 0);
+    check_plugin (GSIGNOND_PLUGIN (host));
+
+    g_object_unref (host);
+}
+END_TEST
+
+static void
+_on_remote_new_ready (
+        GObject *source,
+        GAsyncResult *res,
+        gpointer user_data)
+{
+    GSignondPluginRemote **plugin = (GSignondPluginRemote **) user_data;
+
+    *plugin = gsignond_plugin_remote_new_finish (res, NULL);
+    _stop_mainloop ();
+}
+
+static gboolean
+_check_standby_ready (gpointer data)
+{
+    if (gsignond_plugin_standby_get_n_ready (
+                GSIGNOND_PLUGIN_STANDBY (data)) == 0)
+        return TRUE;
+    _stop_mainloop ();
+    return FALSE;
+}
+
+static void
+_wait_for_standby (GSignondPluginStandby *standby)
+{
+    g_timeout_add (10, _check_standby_ready, standby);
+    _run_mainloop ();
+}
+
+START_TEST (test_pluginremote_standby)
+{
+    DBG ("");
+    GSignondPluginRemote *plugin = NULL;
+    GSignondPluginRemote *absent = NULL;
+
+    gchar* loader_path = g_build_filename (g_getenv("SSO_BIN_DIR"), "gsignond-plugind", NULL);
+    GSignondPluginStandby *standby = gsignond_plugin_standby_new (loader_path, 1);
+    g_free(loader_path);
+    fail_if (standby == NULL);
+
+    _wait_for_standby (standby);
+    fail_unless (gsignond_plugin_standby_get_n_ready (standby) == 1);
+
+    /* the loader in standby loads the plugin */
+    gsignond_plugin_remote_new_from_standby_async (standby, "password", NULL,
+            _on_remote_new_ready, &plugin);
+    fail_unless (gsignond_plugin_standby_get_n_ready (standby) == 0);
+    _run_mainloop ();
+    fail_if (plugin == NULL);
+    fail_unless (plugin->priv->cpid > 0);
+    fail_unless (kill (plugin->priv->cpid, 0) == 0);
+    check_plugin (GSIGNOND_PLUGIN (plugin));
+
+    /* the taken loader is replaced */
+    _wait_for_standby (standby);
+    fail_unless (gsignond_plugin_standby_get_n_ready (standby) == 1);
+
+    gsignond_plugin_remote_new_from_standby_async (standby, "absentplugin",
+            NULL, _on_remote_new_ready, &absent);
+    _run_mainloop ();
+    fail_if (absent != NULL);
+
+    g_object_unref (plugin);
+    g_object_unref (standby);
+}
+END_TEST
+
+START_TEST (test_pluginremote_zygote)
+{
+    DBG ("");
+    GSignondPluginRemote *plugin = NULL;
+    GPid pid = 0;
+    gint in_fd = -1, out_fd = -1;
+
+    gchar* loader_path = g_build_filename (g_getenv("SSO_BIN_DIR"), "gsignond-plugind", NULL);
+    GSignondPluginZygote *zygote = gsignond_plugin_zygote_new (loader_path);
+    fail_if (zygote == NULL);
+
+    /* a forked loader is a child of this process */
+    fail_unless (gsignond_plugin_zygote_fork (zygote, "--load-plugin=password",
+                                              &pid, &in_fd, &out_fd, NULL));
+    fail_unless (pid > 0);
+    close (in_fd);
+    close (out_fd);
+    fail_unless (waitpid (pid, NULL, 0) == pid);
+
+    /* loaders of the standby pool and remote plugins are forked */
+    GSignondPluginStandby *standby = GSIGNOND_PLUGIN_STANDBY (g_object_new (
+            GSIGNOND_TYPE_PLUGIN_STANDBY,
+            "loaderpath", loader_path,
+            "size", 1,
+            "zygote", zygote,
+            NULL));
+    g_free(loader_path);
+    fail_unless (gsignond_plugin_standby_get_zygote (standby) == zygote);
+
+    _wait_for_standby (standby);
+    gsignond_plugin_remote_new_from_standby_async (standby, "password", NULL,
+            _on_remote_new_ready, &plugin);
+    _run_mainloop ();
+    fail_if (plugin == NULL);
+    fail_unless (kill (plugin->priv->cpid, 0) == 0);
+    check_plugin (GSIGNOND_PLUGIN (plugin));
+    g_object_unref (plugin);
+    plugin = NULL;
+
+    g_object_unref (standby);
+
+    /* without loaders in standby, the remote plugin forks one itself */
+    standby = GSIGNOND_PLUGIN_STANDBY (g_object_new (
+            GSIGNOND_TYPE_PLUGIN_STANDBY,
+            "loaderpath", gsignond_plugin_zygote_get_loader_path (zygote),
+            "size", 0,
+            "zygote", zygote,
+            NULL));
+    g_object_unref (zygote);
+    plugin = GSIGNOND_PLUGIN_REMOTE (g_initable_new (
+            GSIGNOND_TYPE_PLUGIN_REMOTE, NULL, NULL,
+            "loaderpath", gsignond_plugin_standby_get_loader_path (standby),
+            "plugintype", "password",
+            "standby", standby,
+            NULL));
+    fail_if (plugin == NULL);
+    fail_unless (kill (plugin->priv->cpid, 0) == 0);
+    check_plugin (GSIGNOND_PLUGIN (plugin));
+    g_object_unref (plugin);
+
+    g_object_unref (standby);
+}
+END_TEST
+
+START_TEST (test_pluginremote_shared_loader)
+{
+    DBG ("");
+    GSignondPluginRemote *host = NULL;
+    GSignondPluginRemote *plugin = NULL;
+    GSignondPluginRemote *session = NULL;
+    gchar *type = NULL;
+
+    gchar* loader_path = g_build_filename (g_getenv("SSO_BIN_DIR"), "gsignond-plugind", NULL);
+    GSignondPluginSharedLoader *shared = gsignond_plugin_shared_loader_new (
+            loader_path, NULL);
+    g_free(loader_path);
+    fail_if (shared == NULL);
+    fail_unless (gsignond_plugin_shared_loader_get_host (shared) == NULL);
+
+    /* the first plugin starts the shared process */
+    gsignond_plugin_remote_new_shared_async (shared, "password", NULL,
+            _on_remote_new_ready, &host);
+    _run_mainloop ();
+    fail_if (host == NULL);
+    fail_unless (host->priv->cpid > 0);
+    fail_unless (gsignond_plugin_shared_loader_get_host (shared) == host);
+    check_plugin (GSIGNOND_PLUGIN (host));
+
+    /* a plugin of another type is exported on the same process */
+    gsignond_plugin_remote_new_shared_async (shared, "digest", NULL,
+            _on_remote_new_ready, &plugin);
+    _run_mainloop ();
+    fail_if (plugin == NULL);
+    fail_unless (plugin->priv->cpid == 0);
+    fail_unless (plugin->priv->connection == host->priv->connection);
+    fail_unless (g_strcmp0 (plugin->priv->object_path, "/digest") == 0);
+    g_object_get (plugin, "type", &type, NULL);
+    fail_unless (g_strcmp0 (type, "digest") == 0);
+    g_free (type);
+
+    /* its sessions are of its own type */
+    session = gsignond_plugin_remote_new_session (plugin);
+    fail_if (session == NULL);
+    fail_unless (session->priv->host == plugin);
+    g_object_unref (session);
+
+    /* the process stays up as long as a hosted plugin uses it */
+    g_object_unref (host);
+    fail_unless (gsignond_plugin_shared_loader_get_host (shared) != NULL);
+    g_object_unref (plugin);
+    fail_unless (gsignond_plugin_shared_loader_get_host (shared) == NULL);
+
+    g_object_unref (shared);
+}
+END_TEST
+
+START_TEST (test_pluginremote_framed)
+{
+    DBG ("");
+    GSignondPluginRemote *plugin = NULL;
+    GSignondSessionData* result = NULL;
+    GSignondSignonuiData* ui_action = NULL;
+    GError* error = NULL;
+    gboolean framed = FALSE;
+
+    gchar* loader_path = g_build_filename (g_getenv("SSO_BIN_DIR"), "gsignond-plugind", NULL);
+    plugin = GSIGNOND_PLUGIN_REMOTE (g_initable_new (
+            GSIGNOND_TYPE_PLUGIN_REMOTE, NULL, NULL,
+            "loaderpath", loader_path,
+            "plugintype", "password",
+            "framed", TRUE,
+            NULL));
+    fail_if (plugin == NULL);
+    fail_if (plugin->priv->channel == NULL);
+    fail_unless (plugin->priv->connection == NULL);
+    fail_if (gsignond_plugin_remote_supports_sessions (plugin));
+    g_object_get (plugin, "framed", &framed, NULL);
+    fail_unless (framed);
+    check_plugin (GSIGNOND_PLUGIN (plugin));
+
+    g_signal_connect(plugin, "response-final", G_CALLBACK(response_callback),
+            &result);
+    g_signal_connect(plugin, "user-action-required",
+                     G_CALLBACK(user_action_required_callback), &ui_action);
+    g_signal_connect(plugin, "error", G_CALLBACK(error_callback), &error);
+
+    GSignondSessionData* data = gsignond_dictionary_new ();
+    gsignond_session_data_set_username(data, "megauser");
+    gsignond_session_data_set_secret(data, "megapassword");
+    gsignond_plugin_request_initial(GSIGNOND_PLUGIN (plugin), data, NULL,
+            "password");
+    _run_mainloop ();
+    fail_if(result == NULL);
+    fail_if(ui_action != NULL);
+    fail_if(error != NULL);
+    fail_if(g_strcmp0(
+        gsignond_session_data_get_username(result), "megauser") != 0);
+    fail_if(g_strcmp0(
+        gsignond_session_data_get_secret(result), "megapassword") != 0);
+    gsignond_dictionary_unref(result);
+    result = NULL;
+
+    /* large session data is passed in a memfd both ways */
+    gchar *blob = g_malloc (512 * 1024);
+    memset (blob, 's', 512 * 1024 - 1);
+    blob[512 * 1024 - 1] = '\0';
+    gsignond_session_data_set_secret(data, blob);
+    gsignond_plugin_request_initial(GSIGNOND_PLUGIN (plugin), data, NULL,
+            "password");
+    _run_mainloop ();
+    fail_if(result == NULL);
+    fail_if(error != NULL);
+    fail_if(g_strcmp0(gsignond_session_data_get_secret(result), blob) != 0);
+    gsignond_dictionary_unref(result);
+    result = NULL;
+    g_free (blob);
+    gsignond_dictionary_unref(data);
+
+    /* the loader going away is reported as an error */
+    kill (plugin->priv->cpid, SIGKILL);
+    _run_mainloop ();
+    fail_if (error == NULL);
+    fail_unless (error->code == GSIGNOND_ERROR_INTERNAL_COMMUNICATION);
+    g_clear_error (&error);
+    g_object_unref (plugin);
+    plugin = NULL;
+
+    /* asynchronously */
+    gsignond_plugin_remote_new_framed_async (loader_path, "password", NULL,
+            NULL, _on_remote_new_ready, &plugin);
+    _run_mainloop ();
+    fail_if (plugin == NULL);
+    check_plugin (GSIGNOND_PLUGIN (plugin));
+    g_object_unref (plugin);
+    plugin = NULL;
+
+    gsignond_plugin_remote_new_framed_async (loader_path, "absentplugin",
+            NULL, NULL, _on_remote_new_ready, &plugin);
+    _run_mainloop ();
+    fail_if (plugin != NULL);
+    g_free (loader_path);
+}
+END_TEST
+
+static void
+_count_response_callback (
+        GSignondPlugin* plugin,
+        GSignondSessionData* result,
+        gpointer user_data)
+{
+    guint *pending = user_data;
+
+    if (--(*pending) == 0)
+        _stop_mainloop ();
+}
+
+/* mean time of a request_initial round trip, in microseconds */
+static gdouble
+_measure_round_trip (GSignondPlugin *plugin, guint n_requests)
+{
+    GSignondSessionData* data = gsignond_dictionary_new ();
+    guint pending;
+    gint64 start;
+    guint i;
+
+    gsignond_session_data_set_username(data, "megauser");
+    gsignond_session_data_set_secret(data, "megapassword");
+    g_signal_connect(plugin, "response-final",
+            G_CALLBACK(_count_response_callback), &pending);
+
+    start = g_get_monotonic_time ();
+    for (i = 0; i < n_requests; i++) {
+        pending = 1;
+        gsignond_plugin_request_initial(plugin, data, NULL, "password");
+        _run_mainloop ();
+        fail_unless (pending == 0, "request %u got no response", i);
+    }
+    start = g_get_monotonic_time () - start;
+
+    g_signal_handlers_disconnect_by_func (plugin, _count_response_callback,
+            &pending);
+    gsignond_dictionary_unref(data);
+
+    return (gdouble) start / n_requests;
+}
+
+/* runs the same requests over the D-Bus and the framed transports and
+ * prints the best round trip of a few rounds for each. With
+ * SSO_TEST_BENCHMARK set, the framed one also has to be faster, which is
+ * the point of having it. */
+START_TEST (test_pluginremote_transport_latency)
+{
+    DBG ("");
+    const guint n_requests = 200;
+    const guint n_rounds = 3;
+    GSignondPlugin *dbus_plugin = NULL, *framed_plugin = NULL;
+    gdouble dbus_us = G_MAXDOUBLE, framed_us = G_MAXDOUBLE;
+    guint i;
+
+    gchar* loader_path = g_build_filename (g_getenv("SSO_BIN_DIR"), "gsignond-plugind", NULL);
+    dbus_plugin = GSIGNOND_PLUGIN (gsignond_plugin_remote_new (loader_path,
+            "password"));
+    fail_if (dbus_plugin == NULL);
+    framed_plugin = GSIGNOND_PLUGIN (g_initable_new (
+            GSIGNOND_TYPE_PLUGIN_REMOTE, NULL, NULL,
+            "loaderpath", loader_path,
+            "plugintype", "password",
+            "framed", TRUE,
+            NULL));
+    g_free (loader_path);
+    fail_if (framed_plugin == NULL);
+
+    _measure_round_trip (dbus_plugin, 10);
+    _measure_round_trip (framed_plugin, 10);
+    for (i = 0; i < n_rounds; i++) {
+        dbus_us = MIN (dbus_us, _measure_round_trip (dbus_plugin, n_requests));
+        framed_us = MIN (framed_us,
+                         _measure_round_trip (framed_plugin, n_requests));
+    }
+    g_object_unref (dbus_plugin);
+    g_object_unref (framed_plugin);
+
+    g_print ("request round trip over %u requests: d-bus %.1f us, "
+             "framed %.1f us\n", n_requests, dbus_us, framed_us);
+    /* wall-clock timings are noisy on loaded machines and under valgrind,
+     * so they are only compared when asked for */
+    if (g_getenv ("SSO_TEST_BENCHMARK"))
+        fail_unless (framed_us < dbus_us,
+                     "framed round trip %.1f us is not below d-bus %.1f us",
+                     framed_us, dbus_us);
+}
+END_TEST
+
 START_TEST (test_plugind_daemon)
 {
     DBG ("");
@@ -580,6 +997,12 @@ Suite* pluginremote_suite (void)
     tcase_add_test (tc_core, test_pluginremote_request);
     tcase_add_test (tc_core, test_pluginremote_user_action_finished);
     tcase_add_test (tc_core, test_pluginremote_refresh);
+    tcase_add_test (tc_core, test_pluginremote_sessions);
+    tcase_add_test (tc_core, test_pluginremote_standby);
+    tcase_add_test (tc_core, test_pluginremote_zygote);
+    tcase_add_test (tc_core, test_pluginremote_shared_loader);
+    tcase_add_test (tc_core, test_pluginremote_framed);
+    tcase_add_test (tc_core, test_pluginremote_transport_latency);
     tcase_add_test (tc_core, test_plugind_daemon);
 
     suite_add_tcase (s, tc_core);